@@ -73,6 +73,12 @@ typedef enum {
     EXPR_DIV,           /* / */
     EXPR_MOD,           /* % */
 
+    /* Lowered arithmetic (introduced by strength reduction, never parsed) */
+    EXPR_SHL,           /* << */
+    EXPR_SHR,           /* >> (arithmetic) */
+    EXPR_USHR,          /* >> (logical) */
+    EXPR_MULHI,         /* High 32 bits of the signed 64-bit product */
+
     /* Comparison operations */
     EXPR_EQ,            /* == */
     EXPR_NE,            /* != */
@@ -87,7 +93,10 @@ typedef enum {
     EXPR_NOT,           /* ! */
 
     /* Function call */
-    EXPR_CALL
+    EXPR_CALL,
+
+    /* Branchless conditional (introduced by if-conversion, never parsed) */
+    EXPR_SELECT         /* cond ? a : b */
 } ExprKind;
 
 /* Integer literal */
@@ -123,10 +132,19 @@ typedef struct {
     size_t arg_count;
 } CallExpr;
 
+/* Conditional select */
+typedef struct {
+    ASTExpr *condition;
+    ASTExpr *then_expr;
+    ASTExpr *else_expr;
+} SelectExpr;
+
 /* Main expression structure */
 struct ASTExpr {
     ExprKind kind;
     Type type;           /* Type of this expression (filled by type checker) */
+    bool overflow_safe;  /* Range analysis proved the operation cannot overflow */
+    bool wraps;          /* Regrouped by reassociation: must wrap, not overflow */
 
     union {
         IntLiteral int_lit;
@@ -135,6 +153,7 @@ struct ASTExpr {
         BinaryExpr binary;
         UnaryExpr unary;
         CallExpr call;
+        SelectExpr select;
     } data;
 };
 
@@ -177,6 +196,7 @@ typedef struct {
 typedef struct {
     ASTExpr *condition;
     ASTStmt *body;
+    bool rotated;         /* Emit as `if (cond) do body while (cond)` (loop rotation) */
 } WhileStmt;
 
 /* Return statement: return expr; */
@@ -228,6 +248,11 @@ struct ASTFunc {
     size_t param_count;
     Type return_type;
     ASTStmt *body;  /* Should be a STMT_BLOCK */
+
+    /* Memoization (set by the optimizer): when non-zero, the body is
+     * `return impl(params...);` and backends may cache results in a
+     * direct-mapped table with this many entries */
+    size_t memo_slots;
 };
 
 /* Program (collection of functions) */
@@ -248,6 +273,7 @@ ASTExpr *ast_expr_var(const char *name);
 ASTExpr *ast_expr_binary(ExprKind kind, ASTExpr *left, ASTExpr *right);
 ASTExpr *ast_expr_unary(ExprKind kind, ASTExpr *operand);
 ASTExpr *ast_expr_call(const char *func_name, ASTExpr **args, size_t arg_count);
+ASTExpr *ast_expr_select(ASTExpr *condition, ASTExpr *then_expr, ASTExpr *else_expr);
 
 /* Statement constructors */
 ASTStmt *ast_stmt_var_decl(const char *name, Type type, ASTExpr *init_expr);
@@ -275,6 +301,22 @@ void ast_stmt_destroy(ASTStmt *stmt);
 void ast_func_destroy(ASTFunc *func);
 void ast_program_destroy(ASTProgram *program);
 
+/* ==============================================================================
+ * AST Copy & Query Functions
+ * ==============================================================================
+ */
+
+/* Deep copies (NULL on allocation failure) */
+ASTExpr *ast_expr_clone(const ASTExpr *expr);
+ASTStmt *ast_stmt_clone(const ASTStmt *stmt);
+
+/* Node counts, used as a size measure by optimization cost models */
+size_t ast_expr_node_count(const ASTExpr *expr);
+size_t ast_stmt_node_count(const ASTStmt *stmt);
+
+/* True for the binary operator kinds (EXPR_ADD .. EXPR_OR) */
+bool ast_expr_is_binary(ExprKind kind);
+
 /* ==============================================================================
  * AST Printing (for debugging)
  * ==============================================================================
@@ -0,0 +1,167 @@
+/**
+ * ==============================================================================
+ * TinyLLVM Compiler - Stack Bytecode & VM
+ * ==============================================================================
+ *
+ * A compact stack bytecode for running CoreTiny without a C toolchain.
+ * Every instruction is a type and one int operand. Locals (parameters
+ * first) live in numbered slots of the function's frame; expressions
+ * work on an operand stack above them.
+ *
+ * Common sequences are fused into superinstructions after code
+ * generation: two loads (optionally followed by an add) become one
+ * instruction, and a comparison followed by a conditional jump becomes a
+ * compare-and-branch. Nothing is fused across a jump target.
+ *
+ * The ByteCode layout and the first five instruction types are shared
+ * with the middleware in include/ (integer_overflow_fuzzer.h,
+ * buffer_overflow_detector.h), which inspect context["bytecode"].
+ *
+ * Copyright (c) 2025 TinyLLVM Project
+ * Licensed under the MIT License
+ * ==============================================================================
+ */
+
+#ifndef TINYLLVM_BYTECODE_H
+#define TINYLLVM_BYTECODE_H
+
+#include "tinyllvm_ast.h"
+#include "eventchains.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ==============================================================================
+ * Instructions
+ * ==============================================================================
+ *
+ * Binary operators pop b then a and push a op b. Jump operands are
+ * absolute instruction indices.
+ */
+
+typedef enum {
+    /* Shared with the middleware: keep these first and in this order */
+    INSTR_PUSH,             /* push operand */
+    INSTR_ADD,
+    INSTR_SUB,
+    INSTR_MUL,
+    INSTR_DIV,
+
+    INSTR_MOD,
+    INSTR_SHL,
+    INSTR_SHR,              /* Arithmetic shift */
+    INSTR_USHR,             /* Logical shift */
+    INSTR_MULHI,            /* High 32 bits of the 64-bit product */
+
+    INSTR_EQ,
+    INSTR_NE,
+    INSTR_LT,
+    INSTR_LE,
+    INSTR_GT,
+    INSTR_GE,
+    INSTR_NOT,              /* Boolean negation of the top of stack */
+    INSTR_SELECT,           /* pop else, then, cond; push cond ? then : else */
+
+    INSTR_LOAD,             /* push slot[operand] */
+    INSTR_STORE,            /* pop into slot[operand] */
+    INSTR_POP,
+
+    INSTR_JUMP,
+    INSTR_JUMP_IF_FALSE,    /* pop; jump if zero */
+    INSTR_JUMP_IF_TRUE,     /* pop; jump if non-zero */
+
+    INSTR_CALL,             /* operand = function index; args are on the stack */
+    INSTR_RETURN,           /* operand = 1 to return the popped value, 0 for none */
+    INSTR_PRINT,            /* pop and print */
+
+    /* Superinstructions (operand packs slots as a | b << 16) */
+    INSTR_LOAD2,            /* push slot[a], slot[b] */
+    INSTR_LOAD2_ADD,        /* push slot[a] + slot[b] */
+
+    /* Compare and branch: pop b, a; jump to operand if a op b */
+    INSTR_JUMP_IF_EQ,
+    INSTR_JUMP_IF_NE,
+    INSTR_JUMP_IF_LT,
+    INSTR_JUMP_IF_LE,
+    INSTR_JUMP_IF_GT,
+    INSTR_JUMP_IF_GE,
+
+    INSTR_COUNT
+} InstructionType;
+
+typedef struct {
+    InstructionType type;
+    int operand;
+} Instruction;
+
+typedef struct {
+    char *name;
+    size_t entry;               /* Index of the first instruction */
+    size_t param_count;
+    size_t local_count;         /* Slots, parameters included */
+    size_t frame_size;          /* Slots plus the deepest operand stack */
+} ByteCodeFunction;
+
+typedef struct {
+    /* Shared with the middleware: keep these first */
+    Instruction *instructions;
+    size_t count;
+    size_t capacity;
+
+    ByteCodeFunction *functions;
+    size_t func_count;
+} ByteCode;
+
+/* ==============================================================================
+ * Compilation
+ * ==============================================================================
+ */
+
+/* Compile a typed AST (NULL on failure) */
+ByteCode *bytecode_compile(const ASTProgram *program);
+void bytecode_destroy(ByteCode *code);
+
+/* Index of the named function, or (size_t)-1 */
+size_t bytecode_find_function(const ByteCode *code, const char *name);
+
+/**
+ * Bytecode Event - Compiles the typed AST to stack bytecode
+ * Input:  context["ast"] : ASTProgram*
+ * Output: context["bytecode"] : ByteCode*
+ */
+EventResult compiler_bytecode_event(EventContext *context, void *user_data);
+
+/* ==============================================================================
+ * Virtual Machine
+ * ==============================================================================
+ *
+ * The VM keeps its stacks between runs, so a VM reused for many calls
+ * allocates only on the first.
+ */
+
+typedef struct ByteCodeVM ByteCodeVM;
+
+/* Receives each printed value; the default writes "%d\n" to stdout */
+typedef void (*ByteCodePrintFunction)(int32_t value, void *user_data);
+
+/* The bytecode must outlive the VM */
+ByteCodeVM *bytecode_vm_create(const ByteCode *code);
+void bytecode_vm_destroy(ByteCodeVM *vm);
+
+void bytecode_vm_set_print(ByteCodeVM *vm, ByteCodePrintFunction print, void *user_data);
+
+/* Call a function and store its return value (0 for void) in *result.
+ * Fails on runtime errors such as division by zero or stack overflow */
+bool bytecode_vm_run(ByteCodeVM *vm, const char *function,
+                     const int32_t *args, size_t arg_count, int32_t *result,
+                     char *error, size_t error_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TINYLLVM_BYTECODE_H */
@@ -11,6 +11,7 @@
  *   - Lexer Event: source_code → tokens
  *   - Parser Event: tokens → AST
  *   - Type Checker Event: AST → typed AST (validates)
+ *   - Optimizer Event: typed AST → optimized AST (optional)
  *   - CodeGen Event: AST → target code (C/Rust/Go/etc.)
  * 
  * Middleware (wraps all phases):
@@ -30,6 +31,7 @@
 #include "eventchains.h"
 #include "tinyllvm_ast.h"
 #include <stddef.h>
+#include <stdint.h>
 #include <stdbool.h>
 
 #ifdef __cplusplus
@@ -48,7 +50,9 @@ typedef enum {
     TARGET_GO,              /* Go code generation */
     TARGET_RUBY,            /* Ruby code generation */
     TARGET_HASKELL,         /* Haskell code generation */
-    TARGET_ASM_X86_64       /* x86-64 assembly */
+    TARGET_ASM_X86_64,      /* x86-64 assembly (GNU as, System V ABI) */
+    TARGET_ELF_X86_64,      /* x86-64 ELF64 relocatable object (.o) */
+    TARGET_LLVM             /* LLVM textual IR (.ll) for clang, opt and llc */
 } CodeGenTarget;
 
 /* ==============================================================================
@@ -63,11 +67,20 @@ typedef struct {
     /* Optimization settings */
     bool enable_optimization;
     int optimization_level;     /* 0-3: none, basic, moderate, aggressive */
+    size_t inline_threshold;    /* Max callee body size in AST nodes (0 = default) */
+    size_t inline_growth_budget; /* Max AST nodes inlined per caller (0 = default) */
+    size_t unroll_threshold;    /* Max trip count for full unrolling (0 = default) */
+    size_t unroll_factor;       /* Partial unrolling factor (0 = default, 1 = off) */
+    size_t memo_cache_size;     /* Entries per memoization cache (0 = default) */
+    size_t specialize_budget;   /* Max specialized clones per program (0 = default) */
+    size_t if_convert_threshold; /* Max AST nodes per speculated select arm (0 = default) */
     
     /* Code generation options */
     bool emit_debug_info;
     bool emit_comments;
     bool pretty_print;
+    bool overflow_checks;       /* Trap on int overflow and division by zero (C target) */
+    bool jit;                   /* Compile to native code in-process instead (x86-64) */
     
     /* Memory management */
     bool track_memory;
@@ -86,12 +99,18 @@ typedef struct {
 typedef struct {
     bool success;
     char *output_code;          /* Generated code (must be freed by caller) */
-    size_t output_length;
+    size_t output_length;       /* Binary for TARGET_ELF_X86_64: use this, not strlen */
     
     /* Statistics */
     size_t tokens_count;
-    size_t ast_node_count;
+    size_t ast_node_count;      /* After optimization */
     size_t memory_used;
+    size_t functions_removed;   /* Unreachable from main() */
+    
+    /* Native code when config->jit is set (see tinyllvm_jit.h) */
+    struct JitModule *jit;
+    int32_t (*main_function)(void);     /* Runs main(); NULL if it takes parameters */
+    RefCountedValue *jit_ref;           /* Keeps jit alive until the result is destroyed */
     
     /* Errors/warnings */
     char **errors;
@@ -207,6 +226,15 @@ EventResult compiler_parser_event(EventContext *context, void *user_data);
  */
 EventResult compiler_type_checker_event(EventContext *context, void *user_data);
 
+/**
+ * Optimizer Event - Runs the AST optimization pipeline
+ * Input:  context["ast"] : ASTProgram* (typed)
+ *         user_data : CompilerConfig*
+ * Output: context["ast"] : ASTProgram* (modified in-place)
+ *         context["opt_stats"] : OptimizationStats*
+ */
+EventResult compiler_optimizer_event(EventContext *context, void *user_data);
+
 /**
  * Code Generator Event - Generates target language code
  * Input:  context["ast"] : ASTProgram*
@@ -294,25 +322,199 @@ EventChainErrorCode compiler_compile(
 void compilation_result_destroy(CompilationResult *result);
 
 /* ==============================================================================
- * Optimization Passes (Applied by Middleware)
+ * Optimization Statistics
+ * ==============================================================================
+ */
+
+typedef struct {
+    /* Per-pass counters */
+    size_t calls_inlined;
+    size_t tail_calls_eliminated;
+    size_t expressions_hoisted;
+    size_t loops_unrolled;
+    size_t strength_reductions;
+    size_t constants_propagated;
+    size_t copies_propagated;
+    size_t expressions_folded;
+    size_t statements_removed;
+    size_t functions_removed;
+    size_t functions_memoized;
+    size_t calls_evaluated;
+    size_t functions_specialized;
+    size_t overflow_checks_elided;
+    size_t branches_converted;
+    size_t loops_rotated;
+    size_t expressions_reassociated;
+
+    /* Human-readable remarks describing individual transformations */
+    char **remarks;
+    size_t remark_count;
+    size_t remark_capacity;
+} OptimizationStats;
+
+/**
+ * Create empty optimization statistics
+ * @return New statistics (free with optimization_stats_destroy)
+ */
+OptimizationStats *optimization_stats_create(void);
+
+/**
+ * Free optimization statistics and all remarks
+ */
+void optimization_stats_destroy(OptimizationStats *stats);
+
+/**
+ * Append a printf-style remark (no-op when stats is NULL)
+ */
+void optimization_stats_remark(OptimizationStats *stats, const char *format, ...);
+
+/* ==============================================================================
+ * Optimization Passes (Applied by the Optimizer Event)
  * ==============================================================================
  */
 
 /**
- * Constant folding - Evaluate constant expressions at compile time
+ * Constant folding - Evaluate constant expressions at compile time with
+ * 32-bit wrapping arithmetic and simplify algebraic identities. Operations
+ * that would trap (division by zero, INT_MIN / -1, and overflow when
+ * config->overflow_checks is set) are left in place.
+ */
+void optimize_constant_folding(ASTProgram *program, const CompilerConfig *config,
+                               OptimizationStats *stats);
+
+/**
+ * Constant and copy propagation - Forward dataflow over each function's
+ * statements that replaces uses of variables holding a known constant or a
+ * copy of another variable, folding as it goes. Values assigned in a while
+ * loop are unknown inside it; if branches are joined conservatively.
  */
-void optimize_constant_folding(ASTProgram *program);
+void optimize_constant_propagation(ASTProgram *program, const CompilerConfig *config,
+                                   OptimizationStats *stats);
 
 /**
- * Dead code elimination - Remove unreachable code
+ * Dead code elimination - Remove unreachable code, branches on literal
+ * conditions, side-effect-free expression statements and stores to
+ * variables that are never read. Under config->overflow_checks, arithmetic
+ * that may overflow counts as a side effect.
  */
-void optimize_dead_code_elimination(ASTProgram *program);
+void optimize_dead_code_elimination(ASTProgram *program, const CompilerConfig *config,
+                                    OptimizationStats *stats);
 
 /**
  * Common subexpression elimination
  */
 void optimize_cse(ASTProgram *program);
 
+/**
+ * Dead function elimination - Remove functions that are not reachable
+ * from main() through the call graph (no-op for programs without main)
+ */
+void optimize_dead_functions(ASTProgram *program, OptimizationStats *stats);
+
+/**
+ * Function inlining - Substitute small non-recursive callees into callers.
+ * Callees larger than config->inline_threshold nodes are skipped and each
+ * caller grows by at most config->inline_growth_budget nodes.
+ */
+void optimize_inline_functions(ASTProgram *program, const CompilerConfig *config,
+                               OptimizationStats *stats);
+
+/**
+ * Tail recursion elimination - Rewrite self tail calls (`return f(...)`)
+ * into a loop that reassigns the parameters. Returns of the form
+ * `e * f(...)` or `e + f(...)` are handled by introducing an accumulator,
+ * except under config->overflow_checks, where regrouping could trap.
+ */
+void optimize_tail_recursion(ASTProgram *program, const CompilerConfig *config,
+                             OptimizationStats *stats);
+
+/**
+ * Loop-invariant code motion - Hoist expressions whose operands are not
+ * assigned in a while loop into temporaries before the loop. Only
+ * expressions that cannot trap or cause side effects are moved.
+ */
+void optimize_loop_invariants(ASTProgram *program, OptimizationStats *stats);
+
+/**
+ * Loop unrolling - Recognize counted loops `var i = C1; while (i < C2) {
+ * ...; i = i + C3; }` with constant bounds. Loops of at most
+ * config->unroll_threshold iterations are fully unrolled with i replaced
+ * by constants; longer loops are unrolled by config->unroll_factor with a
+ * remainder loop.
+ */
+void optimize_loop_unrolling(ASTProgram *program, const CompilerConfig *config,
+                             OptimizationStats *stats);
+
+/**
+ * Strength reduction - Replace `i * C` in while loops with an induction
+ * variable advanced alongside i. For the IR and native targets, also lower
+ * multiplication by constants to shifts and signed division and modulo by
+ * constants to multiply-high and shifts.
+ */
+void optimize_strength_reduction(ASTProgram *program, const CompilerConfig *config,
+                                 OptimizationStats *stats);
+
+/**
+ * Compile-time evaluation - Replace calls to pure functions whose arguments
+ * are all literals with their result, computed by a fuel-limited AST
+ * interpreter. Calls that would trap (including overflow under
+ * config->overflow_checks) or exceed the step or depth limits are left in
+ * place.
+ */
+void optimize_compile_time_calls(ASTProgram *program, const CompilerConfig *config,
+                                 OptimizationStats *stats);
+
+/**
+ * Reassociation - Flatten +/- and * chains, group loop-invariant operands
+ * ahead of variant ones and fold the constants into one trailing literal:
+ * `(a + 3) + (b + 4) - 2` becomes `(a + b) + 5`. Relies on wrapping
+ * arithmetic, so it does nothing when config->overflow_checks is set.
+ */
+void optimize_reassociation(ASTProgram *program, const CompilerConfig *config,
+                            OptimizationStats *stats);
+
+/**
+ * Function specialization - Clone functions for call sites passing literal
+ * arguments, with those parameters bound to the constants, and redirect
+ * matching calls to the clone. At most config->specialize_budget clones
+ * are created.
+ */
+void optimize_function_specialization(ASTProgram *program, const CompilerConfig *config,
+                                      OptimizationStats *stats);
+
+/**
+ * If-conversion - Replace conditionals that assign one variable on either
+ * arm (`if (c) { x = a; } else { x = b; }`, or a single guarded assignment)
+ * with `x = c ? a : b`. Both arms become speculated, so each must be free of
+ * calls and trapping arithmetic and at most config->if_convert_threshold
+ * AST nodes.
+ */
+void optimize_if_conversion(ASTProgram *program, const CompilerConfig *config,
+                            OptimizationStats *stats);
+
+/**
+ * Loop rotation - Mark while loops to be emitted as a guarded do-while
+ * (`if (c) do body while (c)`), one conditional branch per iteration.
+ * Conditions larger than OPT_ROTATE_MAX_COND_NODES are not duplicated.
+ */
+void optimize_loop_rotation(ASTProgram *program, OptimizationStats *stats);
+
+/**
+ * Range analysis - Infer integer intervals through branches and loops (with
+ * widening) and set overflow_safe on +, -, *, / and % nodes proven unable
+ * to overflow or trap, so checked code generation can skip them.
+ */
+void optimize_range_analysis(ASTProgram *program, OptimizationStats *stats);
+
+/**
+ * Memoization - Give pure recursive functions (no print reachable) with up
+ * to three int/bool parameters a direct-mapped result cache of
+ * config->memo_cache_size entries, keyed by the arguments. Applies to the
+ * C target only.
+ */
+void optimize_memoization(ASTProgram *program, const CompilerConfig *config,
+                          OptimizationStats *stats);
+
 /* ==============================================================================
  * Utility Functions
  * ==============================================================================
@@ -0,0 +1,52 @@
+/**
+ * ==============================================================================
+ * TinyLLVM Compiler - ELF Object Writer
+ * ==============================================================================
+ *
+ * Turns the x86-64 assembly emitted for TARGET_ASM_X86_64 into an ELF64
+ * relocatable object without an external assembler, for
+ * TARGET_ELF_X86_64. The object links with the system linker
+ * (`cc prog.o`), which supplies printf.
+ *
+ * Copyright (c) 2025 TinyLLVM Project
+ * Licensed under the MIT License
+ * ==============================================================================
+ */
+
+#ifndef TINYLLVM_ELF_H
+#define TINYLLVM_ELF_H
+
+#include "eventchains.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint8_t *data;
+    size_t size;
+} ElfObject;
+
+/* Assemble the backend's assembly into an object (NULL on failure, with
+ * the offending line in error). Only the instructions and directives the
+ * backend emits are understood */
+ElfObject *elf_assemble_x86_64(const char *assembly, char *error, size_t error_size);
+void elf_object_destroy(ElfObject *object);
+
+bool elf_object_write(const ElfObject *object, const char *path);
+
+/**
+ * Object Event - Assembles generated x86-64 assembly
+ * Input:  context["output_code"] : char* (x86-64 assembly)
+ * Output: context["object_code"] : ElfObject*
+ */
+EventResult compiler_object_event(EventContext *context, void *user_data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TINYLLVM_ELF_H */
@@ -0,0 +1,300 @@
+/**
+ * ==============================================================================
+ * TinyLLVM Compiler - In-Memory IR
+ * ==============================================================================
+ *
+ * TinyLLVM IR as data: a module of functions, each a list of basic blocks
+ * holding instructions, with explicit predecessor and successor lists.
+ * Everything a module owns (functions, blocks, instruction arrays, names)
+ * is allocated from the module's arena and released in one go.
+ *
+ * Values are numbered temporaries (%t0, %t1, ...) defined by exactly one
+ * instruction, plus the incoming parameters (%name.param). Variables live
+ * in named stack slots (alloca/load/store) until ir_module_to_ssa promotes
+ * them to values. Blocks are referred to by label: IR_LABEL_ENTRY for the
+ * entry block, L<n> for the others.
+ *
+ * The AST→IR builder lives in tinyllvm_codegen_ir.c; ir_print_module
+ * writes the textual form emitted for TARGET_TINYLLVM and ir_parse_module
+ * reads it back.
+ *
+ * Copyright (c) 2025 TinyLLVM Project
+ * Licensed under the MIT License
+ * ==============================================================================
+ */
+
+#ifndef TINYLLVM_IR_H
+#define TINYLLVM_IR_H
+
+#include "tinyllvm_ast.h"
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ==============================================================================
+ * Arena
+ * ==============================================================================
+ */
+
+typedef struct IRArenaChunk IRArenaChunk;
+
+typedef struct {
+    IRArenaChunk *chunks;   /* Most recent first */
+} IRArena;
+
+void *ir_arena_alloc(IRArena *arena, size_t size);   /* Zeroed, NULL on failure */
+char *ir_arena_strdup(IRArena *arena, const char *str);
+void ir_arena_free(IRArena *arena);
+
+/* ==============================================================================
+ * Instructions
+ * ==============================================================================
+ */
+
+#define IR_LABEL_ENTRY  (-1)        /* Label of a function's entry block */
+#define IR_LABEL_NONE   (-2)        /* Unlabeled block following a terminator */
+#define IR_NO_TEMP      (-1)
+
+typedef enum {
+    IR_TYPE_VOID,
+    IR_TYPE_I1,
+    IR_TYPE_I32
+} IRType;
+
+typedef enum {
+    IR_CONST,           /* %t = const T imm */
+    IR_LOAD,            /* %t = load %var */
+    IR_STORE,           /* store i32 src, %var */
+    IR_ALLOCA,          /* %var = alloca i32 */
+
+    /* i32 arithmetic: %t = op i32 a, b */
+    IR_ADD,
+    IR_SUB,
+    IR_MUL,
+    IR_DIV,
+    IR_MOD,
+    IR_SHL,
+    IR_ASHR,
+    IR_LSHR,
+    IR_MULHI,
+
+    IR_ICMP,            /* %t = icmp cmp i32 a, b */
+    IR_AND,             /* %t = and i1 a, b */
+    IR_OR,              /* %t = or i1 a, b */
+    IR_NOT,             /* %t = xor i1 a, 1 */
+    IR_SELECT,          /* %t = select i1 c, T a, T b */
+    IR_PHI,             /* %t = phi T [ v, %B ], ... */
+
+    IR_CALL,            /* %t = call i32 @callee(i32 a, ...) */
+    IR_PRINT,           /* call void @print(i32 a) */
+
+    /* Terminators */
+    IR_BR,              /* br label %L */
+    IR_COND_BR,         /* br i1 c, label %L, label %L' */
+    IR_RET              /* ret i32 a, or ret void */
+} IROpcode;
+
+typedef enum {
+    IR_CMP_EQ,
+    IR_CMP_NE,
+    IR_CMP_LT,
+    IR_CMP_LE,
+    IR_CMP_GT,
+    IR_CMP_GE
+} IRCmp;
+
+typedef enum {
+    IR_VALUE_TEMP,      /* %t<index> */
+    IR_VALUE_PARAM,     /* %<name>.param of parameter <index> */
+    IR_VALUE_UNDEF      /* undef: a variable read before any write reaches it */
+} IRValueKind;
+
+typedef struct {
+    IRValueKind kind;
+    int index;
+} IRValue;
+
+typedef struct {
+    IROpcode op;
+    IRType type;            /* Result type, or the operand type of stores */
+    IRCmp cmp;              /* IR_ICMP */
+    int dest;               /* Defined temporary, IR_NO_TEMP if none */
+    int32_t imm;            /* IR_CONST */
+    const char *name;       /* Variable (load, store, alloca) or callee (call) */
+
+    IRValue *operands;      /* Phi: one per incoming edge */
+    size_t operand_count;   /* 0 for ret void */
+    int *labels;            /* Branch targets, or phi incoming blocks */
+    size_t label_count;
+
+    int depth;              /* Statement nesting, for printing */
+} IRInstr;
+
+/* ==============================================================================
+ * Blocks, Functions & Modules
+ * ==============================================================================
+ */
+
+typedef struct {
+    int label;              /* IR_LABEL_ENTRY, IR_LABEL_NONE or L<label> */
+    IRInstr *instrs;
+    size_t instr_count;
+    size_t instr_capacity;
+
+    /* Control flow graph (block indices), filled by ir_function_compute_cfg */
+    size_t *preds;
+    size_t pred_count;
+    size_t *succs;
+    size_t succ_count;
+} IRBlock;
+
+typedef struct {
+    const char *name;
+    IRType type;
+} IRParam;
+
+typedef struct {
+    const char *name;
+    IRType return_type;
+    IRParam *params;
+    size_t param_count;
+
+    IRBlock **blocks;       /* Entry first, then in layout order */
+    size_t block_count;
+    size_t block_capacity;
+} IRFunction;
+
+typedef struct {
+    IRArena arena;
+    IRFunction **functions;
+    size_t func_count;
+    size_t func_capacity;
+    int temp_count;         /* Temporaries are numbered module-wide */
+    int label_count;        /* As are labels */
+} IRModule;
+
+IRModule *ir_module_create(void);
+void ir_module_destroy(IRModule *module);
+
+IRFunction *ir_module_add_function(IRModule *module, const char *name, IRType return_type,
+                                   size_t param_count);
+IRBlock *ir_function_add_block(IRModule *module, IRFunction *func, int label);
+
+/* Append a copy of instr; operands, labels and name are copied into the arena */
+IRInstr *ir_block_append(IRModule *module, IRBlock *block, const IRInstr *instr);
+
+int ir_module_new_temp(IRModule *module);
+int ir_module_new_label(IRModule *module);
+
+/* ==============================================================================
+ * Queries & Control Flow
+ * ==============================================================================
+ */
+
+bool ir_opcode_is_terminator(IROpcode op);
+bool ir_block_is_terminated(const IRBlock *block);
+
+/* Index of the block with the given label, or (size_t)-1 */
+size_t ir_function_find_block(const IRFunction *func, int label);
+
+/* Rebuild every block's predecessor and successor lists from its terminator */
+bool ir_function_compute_cfg(IRModule *module, IRFunction *func);
+
+/* ==============================================================================
+ * SSA Construction
+ * ==============================================================================
+ */
+
+/* Promote the function's variables from alloca/load/store to SSA values
+ * joined by phi nodes, dropping unreachable blocks first (mem2reg) */
+bool ir_function_to_ssa(IRModule *module, IRFunction *func);
+bool ir_module_to_ssa(IRModule *module);
+
+/* ==============================================================================
+ * Binary Bytecode
+ * ==============================================================================
+ *
+ * A compact encoding of a module for shipping and caching IR between build
+ * stages: a fixed header, a per-function index (name, offset, size), a
+ * string table, then each function's blocks and instructions with operands
+ * as LEB128 varints. The reader maps the file and decodes functions only
+ * when they are asked for.
+ */
+
+#define IR_BYTECODE_MAGIC    "TLIR"
+#define IR_BYTECODE_VERSION  1
+
+/* Encode a module (malloc'd, NULL on failure) */
+uint8_t *ir_bytecode_encode(const IRModule *module, size_t *size);
+bool ir_bytecode_write(const IRModule *module, const char *path);
+
+typedef struct IRBytecode IRBytecode;
+
+/* Open a bytecode file (memory-mapped where supported), or wrap a buffer
+ * that must outlive the reader; NULL when the header or index is invalid */
+IRBytecode *ir_bytecode_open(const char *path);
+IRBytecode *ir_bytecode_from_memory(const uint8_t *data, size_t size);
+void ir_bytecode_close(IRBytecode *bytecode);
+
+size_t ir_bytecode_function_count(const IRBytecode *bytecode);
+const char *ir_bytecode_function_name(IRBytecode *bytecode, size_t index);
+size_t ir_bytecode_find_function(IRBytecode *bytecode, const char *name);
+
+/* Decode one function on first use (NULL if it is corrupt). Functions are
+ * owned by the reader and stay valid until it is closed */
+const IRFunction *ir_bytecode_function(IRBytecode *bytecode, size_t index);
+
+/* Decode every function; the module is owned by the reader */
+const IRModule *ir_bytecode_module(IRBytecode *bytecode);
+
+/* ==============================================================================
+ * Interpreter
+ * ==============================================================================
+ *
+ * Runs a module without a C toolchain. The module is decoded once into a
+ * register-machine program (labels resolved to instruction indices, values
+ * to frame registers, phis to edge moves) that stays valid after the
+ * module is destroyed.
+ */
+
+typedef struct IRProgram IRProgram;
+
+/* Receives each printed value; the default writes "%d\n" to stdout */
+typedef void (*IRPrintFunction)(int32_t value, void *user_data);
+
+/* NULL on failure, with error describing the first problem */
+IRProgram *ir_program_create(const IRModule *module, char *error, size_t error_size);
+void ir_program_destroy(IRProgram *program);
+
+void ir_program_set_print(IRProgram *program, IRPrintFunction print, void *user_data);
+
+/* Call a function and store its return value (0 for void) in *result.
+ * Fails on runtime errors such as division by zero or call stack overflow */
+bool ir_program_run(const IRProgram *program, const char *function,
+                    const int32_t *args, size_t arg_count, int32_t *result,
+                    char *error, size_t error_size);
+
+/* ==============================================================================
+ * Construction from the AST & Printing
+ * ==============================================================================
+ */
+
+/* Lower a typed AST to IR (NULL on failure) */
+IRModule *ir_build_module(const ASTProgram *program);
+
+/* Textual TinyLLVM IR (malloc'd, NULL on failure) */
+char *ir_print_module(const IRModule *module, bool emit_comments);
+
+/* Parse textual TinyLLVM IR as printed by ir_print_module. On failure
+ * returns NULL and, if error is non-NULL, describes the first problem */
+IRModule *ir_parse_module(const char *text, char *error, size_t error_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TINYLLVM_IR_H */
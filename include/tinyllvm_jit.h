@@ -0,0 +1,67 @@
+/**
+ * ==============================================================================
+ * TinyLLVM Compiler - x86-64 JIT
+ * ==============================================================================
+ *
+ * Compiles the stack bytecode of tinyllvm_bytecode.h to x86-64 machine
+ * code in memory, so CoreTiny programs run natively without writing
+ * files or invoking a C compiler. Available on x86-64 POSIX systems;
+ * elsewhere jit_module_create fails with an explanatory error.
+ *
+ * Copyright (c) 2025 TinyLLVM Project
+ * Licensed under the MIT License
+ * ==============================================================================
+ */
+
+#ifndef TINYLLVM_JIT_H
+#define TINYLLVM_JIT_H
+
+#include "tinyllvm_bytecode.h"
+#include "eventchains.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct JitModule JitModule;
+
+/* Native entry point for a parameterless main */
+typedef int32_t (*JitMainFunction)(void);
+
+/* Compile every function of the bytecode (NULL on failure, with a
+ * message in error). The module does not reference the bytecode */
+JitModule *jit_module_create(const ByteCode *code, char *error, size_t error_size);
+void jit_module_destroy(JitModule *jit);
+
+/* Receives each printed value; the default writes "%d\n" to stdout */
+void jit_module_set_print(JitModule *jit, ByteCodePrintFunction print, void *user_data);
+
+/* Call a function and store its return value (0 for void) in *result.
+ * Fails on runtime errors such as division by zero or stack overflow.
+ * Not reentrant: the print function must not call back into the module */
+bool jit_module_run(JitModule *jit, const char *function,
+                    const int32_t *args, size_t arg_count, int32_t *result,
+                    char *error, size_t error_size);
+
+/* Directly callable main, or NULL if there is no parameterless main.
+ * After a runtime error it returns 0 and jit_module_error says why */
+JitMainFunction jit_module_main(const JitModule *jit);
+
+/* Runtime error of the last call, or NULL if it succeeded */
+const char *jit_module_error(const JitModule *jit);
+
+/**
+ * JIT Event - Compiles bytecode to native code
+ * Input:  context["bytecode"] : ByteCode*
+ * Output: context["jit"] : JitModule*
+ */
+EventResult compiler_jit_event(EventContext *context, void *user_data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TINYLLVM_JIT_H */
@@ -0,0 +1,245 @@
+/**
+ * ==============================================================================
+ * TinyLLVM Compiler - Optimizer Internals
+ * ==============================================================================
+ *
+ * Helpers shared by the AST optimization passes: identifier sets for fresh
+ * name generation, scoped renaming, call graph construction and small AST
+ * queries. The passes themselves are declared in tinyllvm_compiler.h.
+ *
+ * Copyright (c) 2025 TinyLLVM Project
+ * Licensed under the MIT License
+ * ==============================================================================
+ */
+
+#ifndef TINYLLVM_OPTIMIZER_H
+#define TINYLLVM_OPTIMIZER_H
+
+#include "tinyllvm_compiler.h"
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ==============================================================================
+ * Default Tuning Parameters
+ * ==============================================================================
+ */
+
+#define OPT_DEFAULT_INLINE_THRESHOLD      40    /* AST nodes per callee */
+#define OPT_DEFAULT_INLINE_GROWTH_BUDGET  400   /* AST nodes per caller */
+#define OPT_DEFAULT_UNROLL_THRESHOLD      8     /* Trip count for full unrolling */
+#define OPT_DEFAULT_UNROLL_FACTOR         4
+#define OPT_UNROLL_MAX_NODES              512   /* AST nodes in an unrolled body */
+#define OPT_DEFAULT_MEMO_SLOTS            1024  /* Entries per memoization cache */
+#define OPT_MEMO_MAX_PARAMS               3     /* Arguments in a cache key */
+#define OPT_EVAL_FUEL                     100000 /* Interpreter steps per evaluated call */
+#define OPT_EVAL_MAX_DEPTH                256   /* Nested calls per evaluated call */
+#define OPT_DEFAULT_SPECIALIZE_BUDGET     8     /* Clones per program */
+#define OPT_SPECIALIZE_MAX_NODES          200   /* AST nodes in a cloned function */
+#define OPT_SPECIALIZE_MAX_ROUNDS         8
+#define OPT_DEFAULT_IF_CONVERT_THRESHOLD  6     /* AST nodes per speculated arm */
+#define OPT_ROTATE_MAX_COND_NODES         16    /* AST nodes in a duplicated loop test */
+
+#define OPT_NOT_FOUND ((size_t)-1)
+
+/* ==============================================================================
+ * Identifier Sets
+ * ==============================================================================
+ */
+
+/* Open-addressing hash set of identifiers (strings owned by the set) */
+typedef struct {
+    char **slots;
+    size_t capacity;
+    size_t count;
+    unsigned int next_suffix;   /* Shared counter for opt_fresh_name */
+} OptNameSet;
+
+bool opt_name_set_init(OptNameSet *set);
+void opt_name_set_free(OptNameSet *set);
+bool opt_name_set_contains(const OptNameSet *set, const char *name);
+bool opt_name_set_add(OptNameSet *set, const char *name);
+
+/* Add every function, parameter and variable name used in the program */
+bool opt_name_set_add_program(OptNameSet *set, const ASTProgram *program);
+
+/**
+ * Produce a new identifier "<base>_<tag><n>" that is not in the set.
+ * The name is added to the set; the returned copy is owned by the caller.
+ */
+char *opt_fresh_name(OptNameSet *set, const char *base, const char *tag);
+
+/* ==============================================================================
+ * Scoped Renaming
+ * ==============================================================================
+ */
+
+/* Stack of (from -> to) bindings; later bindings shadow earlier ones */
+typedef struct {
+    char **from;
+    char **to;
+    size_t count;
+    size_t capacity;
+} OptRenameMap;
+
+bool opt_rename_map_push(OptRenameMap *map, const char *from, const char *to);
+void opt_rename_map_pop_to(OptRenameMap *map, size_t count);
+void opt_rename_map_free(OptRenameMap *map);
+const char *opt_rename_map_lookup(const OptRenameMap *map, const char *name);
+
+/* Rewrite variable references in place according to the map */
+bool opt_rename_expr(ASTExpr *expr, const OptRenameMap *map);
+
+/**
+ * Give every variable declared inside stmt a fresh name and rewrite all
+ * references, respecting block scoping. Bindings already in the map (e.g.
+ * renamed parameters) are honoured; the map is restored on return.
+ */
+bool opt_freshen_locals(ASTStmt *stmt, OptRenameMap *map, OptNameSet *names,
+                        const char *tag);
+
+/* ==============================================================================
+ * Call Graph
+ * ==============================================================================
+ */
+
+typedef struct {
+    size_t func_count;
+    size_t **callees;         /* Per function: indices of distinct callees */
+    size_t *callee_counts;
+    bool *recursive;          /* Function lies on a call cycle */
+    bool *pure;               /* Neither it nor any callee prints */
+} OptCallGraph;
+
+bool opt_call_graph_build(OptCallGraph *graph, const ASTProgram *program);
+void opt_call_graph_free(OptCallGraph *graph);
+
+/* Index of the named function, or OPT_NOT_FOUND (e.g. for the print builtin) */
+size_t opt_find_function(const ASTProgram *program, const char *name);
+
+/* ==============================================================================
+ * AST Queries & Builders
+ * ==============================================================================
+ */
+
+bool opt_expr_has_call(const ASTExpr *expr);
+bool opt_stmt_has_return(const ASTStmt *stmt);
+
+/* Structural equality (same operators, names and literals) */
+bool opt_expr_equal(const ASTExpr *a, const ASTExpr *b);
+
+/* Render an expression as CoreTiny source for remarks (truncated to size) */
+void opt_expr_format(const ASTExpr *expr, char *buffer, size_t size);
+
+/* Number of references to the named variable */
+size_t opt_expr_count_var(const ASTExpr *expr, const char *name);
+
+/* The statement declares or assigns the named variable somewhere inside */
+bool opt_stmt_writes_var(const ASTStmt *stmt, const char *name);
+
+/**
+ * Replace every reference to name with a copy of replacement. The caller
+ * guarantees the statement neither declares nor assigns name.
+ */
+bool opt_expr_substitute_var(ASTExpr **slot, const char *name, const ASTExpr *replacement);
+bool opt_stmt_substitute_var(ASTStmt *stmt, const char *name, const ASTExpr *replacement);
+
+/* Typed leaf constructors (ast_expr_var defaults to int) */
+ASTExpr *opt_make_var(const char *name, Type type);
+ASTExpr *opt_make_default_value(Type type);
+
+/* Insert count statements into a STMT_BLOCK before index (takes ownership) */
+bool opt_block_insert(ASTStmt *block, size_t index, ASTStmt **stmts, size_t count);
+
+/* Evaluating the expression has no side effects and cannot trap. With
+ * checked (config->overflow_checks), +, - and * not marked overflow_safe
+ * can trap too. */
+bool opt_expr_removable(const ASTExpr *expr, bool checked);
+
+/**
+ * Evaluate an integer operator with the backends' 32-bit wrapping semantics.
+ * Returns false when the operation traps (division by zero, INT_MIN / -1)
+ * or is not an integer operator.
+ */
+bool opt_evaluate_int(ExprKind kind, int32_t l, int32_t r, int32_t *result);
+
+/**
+ * As opt_evaluate_int, but with config->overflow_checks semantics: +, - and
+ * * whose result does not fit in 32 bits trap too, so they return false.
+ */
+bool opt_evaluate_int_checked(ExprKind kind, int32_t l, int32_t r, int32_t *result);
+
+/* Evaluate a comparison operator (EXPR_EQ .. EXPR_GE) */
+bool opt_evaluate_comparison(ExprKind kind, int32_t l, int32_t r);
+
+/* Fold constant subexpressions in place; returns the number of folds. With
+ * checked set, operations that would trap an overflow check are kept. */
+size_t opt_fold_expr(ASTExpr **slot, bool checked);
+
+/* Every path through the statement ends in a return */
+bool opt_stmt_always_returns(const ASTStmt *stmt);
+
+/* Remove `name = ...;` statements anywhere inside stmt */
+void opt_remove_assignments(ASTStmt *stmt, const char *name);
+
+/* ==============================================================================
+ * Function Cloning
+ * ==============================================================================
+ */
+
+/* Deep copy of func under a new name (NULL on allocation failure) */
+ASTFunc *opt_func_clone(const ASTFunc *func, const char *name);
+
+/* Insert func into the function list before index (takes ownership on success) */
+bool opt_program_insert_function(ASTProgram *program, size_t index, ASTFunc *func);
+
+/* ==============================================================================
+ * Statement Lists
+ * ==============================================================================
+ */
+
+typedef struct {
+    ASTStmt **items;
+    size_t count;
+    size_t capacity;
+} OptStmtVec;
+
+/* Append stmt (destroyed on failure; a NULL stmt counts as failure) */
+bool opt_stmt_vec_push(OptStmtVec *vec, ASTStmt *stmt);
+void opt_stmt_vec_destroy(OptStmtVec *vec);
+
+/* ==============================================================================
+ * Return Lowering
+ * ==============================================================================
+ */
+
+/**
+ * Rewrites the returns of a body so it can run without leaving the
+ * function: each return is replaced by the statements produced by
+ * lower_return followed by `done = true;`, code that may run after a
+ * return is guarded by `if (!done)`, and loops that contain returns get
+ * `!done &&` prepended to their condition.
+ */
+typedef struct OptReturnLowering {
+    const char *done;           /* Flag variable set when a return executes */
+
+    /* Append replacement statements for `return value;` (takes value) */
+    bool (*lower_return)(struct OptReturnLowering *rl, ASTExpr *value, OptStmtVec *out);
+    void *user_data;
+
+    bool done_used;             /* Some guard reads the flag */
+    bool failed;
+} OptReturnLowering;
+
+/* Lower the returns of a STMT_BLOCK in place; check rl->failed afterwards */
+void opt_lower_returns(OptReturnLowering *rl, ASTStmt *block);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TINYLLVM_OPTIMIZER_H */
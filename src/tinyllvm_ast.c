@@ -67,6 +67,8 @@ ASTExpr *ast_expr_int_literal(int value) {
     if (!expr) return NULL;
 
     expr->kind = EXPR_INT_LITERAL;
+    expr->overflow_safe = false;
+    expr->wraps = false;
     expr->type = type_int();
     expr->data.int_lit.value = value;
 
@@ -78,6 +80,8 @@ ASTExpr *ast_expr_bool_literal(bool value) {
     if (!expr) return NULL;
 
     expr->kind = EXPR_BOOL_LITERAL;
+    expr->overflow_safe = false;
+    expr->wraps = false;
     expr->type = type_bool();
     expr->data.bool_lit.value = value;
 
@@ -91,6 +95,8 @@ ASTExpr *ast_expr_var(const char *name) {
     if (!expr) return NULL;
 
     expr->kind = EXPR_VAR;
+    expr->overflow_safe = false;
+    expr->wraps = false;
     expr->type = type_int();  /* Will be fixed by type checker */
     expr->data.var.name = str_duplicate(name);
 
@@ -109,6 +115,8 @@ ASTExpr *ast_expr_binary(ExprKind kind, ASTExpr *left, ASTExpr *right) {
     if (!expr) return NULL;
 
     expr->kind = kind;
+    expr->overflow_safe = false;
+    expr->wraps = false;
     expr->data.binary.left = left;
     expr->data.binary.right = right;
 
@@ -139,6 +147,8 @@ ASTExpr *ast_expr_unary(ExprKind kind, ASTExpr *operand) {
     if (!expr) return NULL;
 
     expr->kind = kind;
+    expr->overflow_safe = false;
+    expr->wraps = false;
     expr->data.unary.operand = operand;
     expr->type = type_bool();  /* Only ! operator for now */
 
@@ -152,6 +162,8 @@ ASTExpr *ast_expr_call(const char *func_name, ASTExpr **args, size_t arg_count)
     if (!expr) return NULL;
 
     expr->kind = EXPR_CALL;
+    expr->overflow_safe = false;
+    expr->wraps = false;
     expr->type = type_int();  /* Will be fixed by type checker */
     expr->data.call.func_name = str_duplicate(func_name);
     expr->data.call.args = args;
@@ -165,6 +177,23 @@ ASTExpr *ast_expr_call(const char *func_name, ASTExpr **args, size_t arg_count)
     return expr;
 }
 
+ASTExpr *ast_expr_select(ASTExpr *condition, ASTExpr *then_expr, ASTExpr *else_expr) {
+    if (!condition || !then_expr || !else_expr) return NULL;
+
+    ASTExpr *expr = malloc(sizeof(ASTExpr));
+    if (!expr) return NULL;
+
+    expr->kind = EXPR_SELECT;
+    expr->overflow_safe = false;
+    expr->wraps = false;
+    expr->type = then_expr->type;
+    expr->data.select.condition = condition;
+    expr->data.select.then_expr = then_expr;
+    expr->data.select.else_expr = else_expr;
+
+    return expr;
+}
+
 /* ==============================================================================
  * Statement Constructors
  * ==============================================================================
@@ -230,6 +259,7 @@ ASTStmt *ast_stmt_while(ASTExpr *condition, ASTStmt *body) {
     stmt->kind = STMT_WHILE;
     stmt->data.while_stmt.condition = condition;
     stmt->data.while_stmt.body = body;
+    stmt->data.while_stmt.rotated = false;
 
     return stmt;
 }
@@ -284,6 +314,7 @@ ASTFunc *ast_func_create(const char *name, Param *params, size_t param_count,
     func->param_count = param_count;
     func->return_type = return_type;
     func->body = body;
+    func->memo_slots = 0;
 
     if (!func->name) {
         free(func);
@@ -321,6 +352,10 @@ void ast_expr_destroy(ASTExpr *expr) {
         case EXPR_MUL:
         case EXPR_DIV:
         case EXPR_MOD:
+        case EXPR_SHL:
+        case EXPR_SHR:
+        case EXPR_USHR:
+        case EXPR_MULHI:
         case EXPR_EQ:
         case EXPR_NE:
         case EXPR_LT:
@@ -345,6 +380,12 @@ void ast_expr_destroy(ASTExpr *expr) {
             free(expr->data.call.args);
             break;
 
+        case EXPR_SELECT:
+            ast_expr_destroy(expr->data.select.condition);
+            ast_expr_destroy(expr->data.select.then_expr);
+            ast_expr_destroy(expr->data.select.else_expr);
+            break;
+
         default:
             /* Literals have no dynamic memory */
             break;
@@ -423,6 +464,248 @@ void ast_program_destroy(ASTProgram *program) {
     free(program);
 }
 
+/* ==============================================================================
+ * AST Copy & Query Functions
+ * ==============================================================================
+ */
+
+bool ast_expr_is_binary(ExprKind kind) {
+    return kind >= EXPR_ADD && kind <= EXPR_OR;
+}
+
+ASTExpr *ast_expr_clone(const ASTExpr *expr) {
+    if (!expr) return NULL;
+
+    ASTExpr *copy = NULL;
+
+    switch (expr->kind) {
+        case EXPR_INT_LITERAL:
+            copy = ast_expr_int_literal(expr->data.int_lit.value);
+            break;
+
+        case EXPR_BOOL_LITERAL:
+            copy = ast_expr_bool_literal(expr->data.bool_lit.value);
+            break;
+
+        case EXPR_VAR:
+            copy = ast_expr_var(expr->data.var.name);
+            break;
+
+        case EXPR_NOT: {
+            ASTExpr *operand = ast_expr_clone(expr->data.unary.operand);
+            copy = ast_expr_unary(expr->kind, operand);
+            if (!copy) ast_expr_destroy(operand);
+            break;
+        }
+
+        case EXPR_CALL: {
+            size_t count = expr->data.call.arg_count;
+            ASTExpr **args = NULL;
+            if (count > 0) {
+                args = calloc(count, sizeof(ASTExpr *));
+                if (!args) return NULL;
+                for (size_t i = 0; i < count; i++) {
+                    args[i] = ast_expr_clone(expr->data.call.args[i]);
+                    if (!args[i]) {
+                        for (size_t j = 0; j < i; j++) ast_expr_destroy(args[j]);
+                        free(args);
+                        return NULL;
+                    }
+                }
+            }
+            copy = ast_expr_call(expr->data.call.func_name, args, count);
+            if (!copy) {
+                for (size_t i = 0; i < count; i++) ast_expr_destroy(args[i]);
+                free(args);
+            }
+            break;
+        }
+
+        case EXPR_SELECT: {
+            ASTExpr *condition = ast_expr_clone(expr->data.select.condition);
+            ASTExpr *then_expr = ast_expr_clone(expr->data.select.then_expr);
+            ASTExpr *else_expr = ast_expr_clone(expr->data.select.else_expr);
+            copy = ast_expr_select(condition, then_expr, else_expr);
+            if (!copy) {
+                ast_expr_destroy(condition);
+                ast_expr_destroy(then_expr);
+                ast_expr_destroy(else_expr);
+            }
+            break;
+        }
+
+        default:
+            if (ast_expr_is_binary(expr->kind)) {
+                ASTExpr *left = ast_expr_clone(expr->data.binary.left);
+                ASTExpr *right = ast_expr_clone(expr->data.binary.right);
+                copy = ast_expr_binary(expr->kind, left, right);
+                if (!copy) {
+                    ast_expr_destroy(left);
+                    ast_expr_destroy(right);
+                }
+            }
+            break;
+    }
+
+    if (copy) {
+        copy->type = expr->type;
+        copy->overflow_safe = expr->overflow_safe;
+        copy->wraps = expr->wraps;
+    }
+    return copy;
+}
+
+ASTStmt *ast_stmt_clone(const ASTStmt *stmt) {
+    if (!stmt) return NULL;
+
+    switch (stmt->kind) {
+        case STMT_VAR_DECL: {
+            ASTExpr *init = ast_expr_clone(stmt->data.var_decl.init_expr);
+            ASTStmt *copy = ast_stmt_var_decl(stmt->data.var_decl.name,
+                                              stmt->data.var_decl.type, init);
+            if (!copy) ast_expr_destroy(init);
+            return copy;
+        }
+
+        case STMT_ASSIGN: {
+            ASTExpr *expr = ast_expr_clone(stmt->data.assign.expr);
+            ASTStmt *copy = ast_stmt_assign(stmt->data.assign.name, expr);
+            if (!copy) ast_expr_destroy(expr);
+            return copy;
+        }
+
+        case STMT_IF: {
+            ASTExpr *cond = ast_expr_clone(stmt->data.if_stmt.condition);
+            ASTStmt *then_block = ast_stmt_clone(stmt->data.if_stmt.then_block);
+            ASTStmt *else_block = ast_stmt_clone(stmt->data.if_stmt.else_block);
+            ASTStmt *copy = NULL;
+            if (!stmt->data.if_stmt.else_block || else_block) {
+                copy = ast_stmt_if(cond, then_block, else_block);
+            }
+            if (!copy) {
+                ast_expr_destroy(cond);
+                ast_stmt_destroy(then_block);
+                ast_stmt_destroy(else_block);
+            }
+            return copy;
+        }
+
+        case STMT_WHILE: {
+            ASTExpr *cond = ast_expr_clone(stmt->data.while_stmt.condition);
+            ASTStmt *body = ast_stmt_clone(stmt->data.while_stmt.body);
+            ASTStmt *copy = ast_stmt_while(cond, body);
+            if (!copy) {
+                ast_expr_destroy(cond);
+                ast_stmt_destroy(body);
+                return NULL;
+            }
+            copy->data.while_stmt.rotated = stmt->data.while_stmt.rotated;
+            return copy;
+        }
+
+        case STMT_RETURN: {
+            ASTExpr *expr = ast_expr_clone(stmt->data.return_stmt.expr);
+            if (stmt->data.return_stmt.expr && !expr) return NULL;
+            ASTStmt *copy = ast_stmt_return(expr);
+            if (!copy) ast_expr_destroy(expr);
+            return copy;
+        }
+
+        case STMT_EXPR: {
+            ASTExpr *expr = ast_expr_clone(stmt->data.expr_stmt.expr);
+            ASTStmt *copy = ast_stmt_expr(expr);
+            if (!copy) ast_expr_destroy(expr);
+            return copy;
+        }
+
+        case STMT_BLOCK: {
+            size_t count = stmt->data.block.stmt_count;
+            ASTStmt **statements = NULL;
+            if (count > 0) {
+                statements = calloc(count, sizeof(ASTStmt *));
+                if (!statements) return NULL;
+                for (size_t i = 0; i < count; i++) {
+                    statements[i] = ast_stmt_clone(stmt->data.block.statements[i]);
+                    if (!statements[i]) {
+                        for (size_t j = 0; j < i; j++) ast_stmt_destroy(statements[j]);
+                        free(statements);
+                        return NULL;
+                    }
+                }
+            }
+            ASTStmt *copy = ast_stmt_block(statements, count);
+            if (!copy) {
+                for (size_t i = 0; i < count; i++) ast_stmt_destroy(statements[i]);
+                free(statements);
+            }
+            return copy;
+        }
+    }
+
+    return NULL;
+}
+
+size_t ast_expr_node_count(const ASTExpr *expr) {
+    if (!expr) return 0;
+
+    if (ast_expr_is_binary(expr->kind)) {
+        return 1 + ast_expr_node_count(expr->data.binary.left) +
+                   ast_expr_node_count(expr->data.binary.right);
+    }
+
+    switch (expr->kind) {
+        case EXPR_NOT:
+            return 1 + ast_expr_node_count(expr->data.unary.operand);
+
+        case EXPR_CALL: {
+            size_t count = 1;
+            for (size_t i = 0; i < expr->data.call.arg_count; i++) {
+                count += ast_expr_node_count(expr->data.call.args[i]);
+            }
+            return count;
+        }
+
+        case EXPR_SELECT:
+            return 1 + ast_expr_node_count(expr->data.select.condition) +
+                       ast_expr_node_count(expr->data.select.then_expr) +
+                       ast_expr_node_count(expr->data.select.else_expr);
+
+        default:
+            return 1;
+    }
+}
+
+size_t ast_stmt_node_count(const ASTStmt *stmt) {
+    if (!stmt) return 0;
+
+    switch (stmt->kind) {
+        case STMT_VAR_DECL:
+            return 1 + ast_expr_node_count(stmt->data.var_decl.init_expr);
+        case STMT_ASSIGN:
+            return 1 + ast_expr_node_count(stmt->data.assign.expr);
+        case STMT_IF:
+            return 1 + ast_expr_node_count(stmt->data.if_stmt.condition) +
+                       ast_stmt_node_count(stmt->data.if_stmt.then_block) +
+                       ast_stmt_node_count(stmt->data.if_stmt.else_block);
+        case STMT_WHILE:
+            return 1 + ast_expr_node_count(stmt->data.while_stmt.condition) +
+                       ast_stmt_node_count(stmt->data.while_stmt.body);
+        case STMT_RETURN:
+            return 1 + ast_expr_node_count(stmt->data.return_stmt.expr);
+        case STMT_EXPR:
+            return 1 + ast_expr_node_count(stmt->data.expr_stmt.expr);
+        case STMT_BLOCK: {
+            size_t count = 1;
+            for (size_t i = 0; i < stmt->data.block.stmt_count; i++) {
+                count += ast_stmt_node_count(stmt->data.block.statements[i]);
+            }
+            return count;
+        }
+    }
+
+    return 0;
+}
+
 /* ==============================================================================
  * AST Printing Functions (for debugging)
  * ==============================================================================
@@ -444,6 +727,10 @@ static const char *expr_kind_to_string(ExprKind kind) {
         case EXPR_MUL:          return "*";
         case EXPR_DIV:          return "/";
         case EXPR_MOD:          return "%";
+        case EXPR_SHL:          return "<<";
+        case EXPR_SHR:          return ">>";
+        case EXPR_USHR:         return ">>>";
+        case EXPR_MULHI:        return "MULHI";
         case EXPR_EQ:           return "==";
         case EXPR_NE:           return "!=";
         case EXPR_LT:           return "<";
@@ -454,6 +741,7 @@ static const char *expr_kind_to_string(ExprKind kind) {
         case EXPR_OR:           return "||";
         case EXPR_NOT:          return "!";
         case EXPR_CALL:         return "CALL";
+        case EXPR_SELECT:       return "SELECT";
         default:                return "UNKNOWN";
     }
 }
@@ -481,6 +769,10 @@ void ast_expr_print(const ASTExpr *expr, int indent) {
         case EXPR_MUL:
         case EXPR_DIV:
         case EXPR_MOD:
+        case EXPR_SHL:
+        case EXPR_SHR:
+        case EXPR_USHR:
+        case EXPR_MULHI:
         case EXPR_EQ:
         case EXPR_NE:
         case EXPR_LT:
@@ -505,6 +797,13 @@ void ast_expr_print(const ASTExpr *expr, int indent) {
                 ast_expr_print(expr->data.call.args[i], indent + 1);
             }
             break;
+
+        case EXPR_SELECT:
+            printf("SELECT\n");
+            ast_expr_print(expr->data.select.condition, indent + 1);
+            ast_expr_print(expr->data.select.then_expr, indent + 1);
+            ast_expr_print(expr->data.select.else_expr, indent + 1);
+            break;
     }
 }
 
@@ -0,0 +1,624 @@
+/**
+ * ==============================================================================
+ * TinyLLVM Compiler - Stack Bytecode Generation
+ * ==============================================================================
+ *
+ * Compiles the typed AST to the stack bytecode of tinyllvm_bytecode.h,
+ * one function at a time:
+ *
+ *   1. Statements and expressions are emitted into a raw buffer whose
+ *      jumps name labels. Variables get slots by scope depth, so sibling
+ *      blocks reuse slots and a shadowing declaration gets a fresh one.
+ *      Conditions compile straight to jumps (&&, || and ! never
+ *      materialize a value), and loops test at the bottom.
+ *   2. A peephole pass fuses load pairs, load-load-add and
+ *      compare-then-jump into superinstructions, leaving alone any
+ *      sequence that a jump lands in the middle of.
+ *   3. Labels are resolved to absolute instruction indices.
+ *
+ * The deepest operand stack is tracked while emitting so the VM can
+ * check for room once per call.
+ */
+
+#include "include/tinyllvm_bytecode.h"
+#include "include/tinyllvm_compiler.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define BYTECODE_SLOT_LIMIT 0x7FFF      /* Largest slot a superinstruction packs */
+
+typedef struct {
+    ByteCode *code;
+    const ASTProgram *program;
+
+    /* Current function, jumps holding label numbers */
+    Instruction *raw;
+    size_t raw_count;
+    size_t raw_capacity;
+
+    size_t *labels;             /* Label -> raw index */
+    size_t label_count;
+    size_t label_capacity;
+
+    /* Variables by slot; visible ones are the first scope_count */
+    const char **scope;
+    size_t scope_count;
+    size_t scope_capacity;
+    size_t local_count;
+
+    int depth;                  /* Operand stack depth at this point */
+    int max_depth;
+
+    bool failed;
+} BytecodeCompiler;
+
+static bool grow(void **items, size_t *capacity, size_t needed, size_t item_size) {
+    if (needed <= *capacity) return true;
+
+    size_t new_capacity = *capacity == 0 ? 64 : *capacity;
+    while (new_capacity < needed) {
+        new_capacity *= 2;
+    }
+
+    void *new_items = realloc(*items, new_capacity * item_size);
+    if (!new_items) return false;
+
+    *items = new_items;
+    *capacity = new_capacity;
+    return true;
+}
+
+static bool is_jump(InstructionType type) {
+    return type == INSTR_JUMP || type == INSTR_JUMP_IF_FALSE || type == INSTR_JUMP_IF_TRUE ||
+           (type >= INSTR_JUMP_IF_EQ && type <= INSTR_JUMP_IF_GE);
+}
+
+/* Operand stack change; calls are adjusted by their caller */
+static int stack_effect(InstructionType type, int operand) {
+    switch (type) {
+        case INSTR_PUSH:
+        case INSTR_LOAD:
+        case INSTR_LOAD2_ADD:
+        case INSTR_CALL:
+            return 1;
+        case INSTR_LOAD2:
+            return 2;
+        case INSTR_NOT:
+        case INSTR_JUMP:
+            return 0;
+        case INSTR_SELECT:
+        case INSTR_JUMP_IF_EQ:
+        case INSTR_JUMP_IF_NE:
+        case INSTR_JUMP_IF_LT:
+        case INSTR_JUMP_IF_LE:
+        case INSTR_JUMP_IF_GT:
+        case INSTR_JUMP_IF_GE:
+            return -2;
+        case INSTR_RETURN:
+            return -operand;
+        default:
+            return -1;
+    }
+}
+
+/* ==============================================================================
+ * Emission
+ * ==============================================================================
+ */
+
+static void emit(BytecodeCompiler *c, InstructionType type, int operand) {
+    if (c->failed) return;
+    if (!grow((void **)&c->raw, &c->raw_capacity, c->raw_count + 1, sizeof(Instruction))) {
+        c->failed = true;
+        return;
+    }
+
+    c->raw[c->raw_count].type = type;
+    c->raw[c->raw_count].operand = operand;
+    c->raw_count++;
+
+    c->depth += stack_effect(type, operand);
+    if (c->depth > c->max_depth) c->max_depth = c->depth;
+}
+
+static int new_label(BytecodeCompiler *c) {
+    if (!grow((void **)&c->labels, &c->label_capacity, c->label_count + 1, sizeof(size_t))) {
+        c->failed = true;
+        return 0;
+    }
+    c->labels[c->label_count] = (size_t)-1;
+    return (int)c->label_count++;
+}
+
+static void place_label(BytecodeCompiler *c, int label) {
+    if (!c->failed) c->labels[label] = c->raw_count;
+}
+
+static int lookup_slot(const BytecodeCompiler *c, const char *name) {
+    for (size_t i = c->scope_count; i-- > 0;) {
+        if (strcmp(c->scope[i], name) == 0) return (int)i;
+    }
+    return -1;
+}
+
+/* Bring a variable into scope in the next free slot */
+static int declare_slot(BytecodeCompiler *c, const char *name) {
+    if (!grow((void **)&c->scope, &c->scope_capacity, c->scope_count + 1,
+              sizeof(const char *))) {
+        c->failed = true;
+        return 0;
+    }
+
+    c->scope[c->scope_count] = name;
+    int slot = (int)c->scope_count++;
+    if (c->scope_count > c->local_count) c->local_count = c->scope_count;
+    return slot;
+}
+
+static size_t find_callee(const ASTProgram *program, const char *name) {
+    for (size_t i = 0; i < program->func_count; i++) {
+        if (strcmp(program->functions[i]->name, name) == 0) return i;
+    }
+    return (size_t)-1;
+}
+
+/* ==============================================================================
+ * Expressions & Conditions
+ * ==============================================================================
+ */
+
+static void compile_expression(BytecodeCompiler *c, const ASTExpr *expr);
+
+/* Jump to label when expr evaluates to `when`; fall through otherwise */
+static void compile_branch(BytecodeCompiler *c, const ASTExpr *expr, bool when, int label) {
+    switch (expr->kind) {
+        case EXPR_BOOL_LITERAL:
+            if (expr->data.bool_lit.value == when) emit(c, INSTR_JUMP, label);
+            return;
+
+        case EXPR_NOT:
+            compile_branch(c, expr->data.unary.operand, !when, label);
+            return;
+
+        case EXPR_AND:
+        case EXPR_OR: {
+            /* a && b jumps on false if either is false, on true only if
+             * both are; || is the mirror image */
+            bool short_circuit = expr->kind == EXPR_OR;
+            if (when == short_circuit) {
+                compile_branch(c, expr->data.binary.left, when, label);
+                compile_branch(c, expr->data.binary.right, when, label);
+            } else {
+                int skip = new_label(c);
+                compile_branch(c, expr->data.binary.left, short_circuit, skip);
+                compile_branch(c, expr->data.binary.right, when, label);
+                place_label(c, skip);
+            }
+            return;
+        }
+
+        default:
+            compile_expression(c, expr);
+            emit(c, when ? INSTR_JUMP_IF_TRUE : INSTR_JUMP_IF_FALSE, label);
+            return;
+    }
+}
+
+static void compile_call(BytecodeCompiler *c, const ASTExpr *expr) {
+    const CallExpr *call = &expr->data.call;
+
+    if (strcmp(call->func_name, "print") == 0 && call->arg_count == 1) {
+        compile_expression(c, call->args[0]);
+        emit(c, INSTR_PRINT, 0);
+        emit(c, INSTR_PUSH, 0);
+        return;
+    }
+
+    size_t callee = find_callee(c->program, call->func_name);
+    if (callee == (size_t)-1 ||
+        c->program->functions[callee]->param_count != call->arg_count) {
+        c->failed = true;
+        return;
+    }
+
+    for (size_t i = 0; i < call->arg_count; i++) {
+        compile_expression(c, call->args[i]);
+    }
+    emit(c, INSTR_CALL, (int)callee);
+    c->depth -= (int)call->arg_count;
+}
+
+static InstructionType binary_instruction(ExprKind kind) {
+    switch (kind) {
+        case EXPR_ADD:   return INSTR_ADD;
+        case EXPR_SUB:   return INSTR_SUB;
+        case EXPR_MUL:   return INSTR_MUL;
+        case EXPR_DIV:   return INSTR_DIV;
+        case EXPR_MOD:   return INSTR_MOD;
+        case EXPR_SHL:   return INSTR_SHL;
+        case EXPR_SHR:   return INSTR_SHR;
+        case EXPR_USHR:  return INSTR_USHR;
+        case EXPR_MULHI: return INSTR_MULHI;
+        case EXPR_EQ:    return INSTR_EQ;
+        case EXPR_NE:    return INSTR_NE;
+        case EXPR_LT:    return INSTR_LT;
+        case EXPR_LE:    return INSTR_LE;
+        case EXPR_GT:    return INSTR_GT;
+        default:         return INSTR_GE;
+    }
+}
+
+static void compile_expression(BytecodeCompiler *c, const ASTExpr *expr) {
+    if (c->failed) return;
+    if (!expr) {
+        c->failed = true;
+        return;
+    }
+
+    switch (expr->kind) {
+        case EXPR_INT_LITERAL:
+            emit(c, INSTR_PUSH, expr->data.int_lit.value);
+            return;
+
+        case EXPR_BOOL_LITERAL:
+            emit(c, INSTR_PUSH, expr->data.bool_lit.value ? 1 : 0);
+            return;
+
+        case EXPR_VAR: {
+            int slot = lookup_slot(c, expr->data.var.name);
+            if (slot < 0) {
+                c->failed = true;
+                return;
+            }
+            emit(c, INSTR_LOAD, slot);
+            return;
+        }
+
+        case EXPR_AND:
+        case EXPR_OR: {
+            int if_false = new_label(c);
+            int end = new_label(c);
+            compile_branch(c, expr, false, if_false);
+            emit(c, INSTR_PUSH, 1);
+            emit(c, INSTR_JUMP, end);
+            c->depth--;
+            place_label(c, if_false);
+            emit(c, INSTR_PUSH, 0);
+            place_label(c, end);
+            return;
+        }
+
+        case EXPR_NOT:
+            compile_expression(c, expr->data.unary.operand);
+            emit(c, INSTR_NOT, 0);
+            return;
+
+        case EXPR_CALL:
+            compile_call(c, expr);
+            return;
+
+        case EXPR_SELECT:
+            /* If-conversion only builds selects whose arms cannot trap */
+            compile_expression(c, expr->data.select.condition);
+            compile_expression(c, expr->data.select.then_expr);
+            compile_expression(c, expr->data.select.else_expr);
+            emit(c, INSTR_SELECT, 0);
+            return;
+
+        default:
+            compile_expression(c, expr->data.binary.left);
+            compile_expression(c, expr->data.binary.right);
+            emit(c, binary_instruction(expr->kind), 0);
+            return;
+    }
+}
+
+/* ==============================================================================
+ * Statements
+ * ==============================================================================
+ */
+
+static bool is_print_call(const ASTExpr *expr) {
+    return expr && expr->kind == EXPR_CALL && expr->data.call.arg_count == 1 &&
+           strcmp(expr->data.call.func_name, "print") == 0;
+}
+
+static void compile_statement(BytecodeCompiler *c, const ASTStmt *stmt) {
+    if (c->failed) return;
+    if (!stmt) {
+        c->failed = true;
+        return;
+    }
+
+    switch (stmt->kind) {
+        case STMT_VAR_DECL: {
+            /* The initializer still sees any variable this one shadows */
+            compile_expression(c, stmt->data.var_decl.init_expr);
+            emit(c, INSTR_STORE, declare_slot(c, stmt->data.var_decl.name));
+            return;
+        }
+
+        case STMT_ASSIGN: {
+            int slot = lookup_slot(c, stmt->data.assign.name);
+            if (slot < 0) {
+                c->failed = true;
+                return;
+            }
+            compile_expression(c, stmt->data.assign.expr);
+            emit(c, INSTR_STORE, slot);
+            return;
+        }
+
+        case STMT_IF: {
+            int else_label = new_label(c);
+            compile_branch(c, stmt->data.if_stmt.condition, false, else_label);
+            compile_statement(c, stmt->data.if_stmt.then_block);
+
+            if (stmt->data.if_stmt.else_block) {
+                int end = new_label(c);
+                emit(c, INSTR_JUMP, end);
+                place_label(c, else_label);
+                compile_statement(c, stmt->data.if_stmt.else_block);
+                place_label(c, end);
+            } else {
+                place_label(c, else_label);
+            }
+            return;
+        }
+
+        case STMT_WHILE: {
+            /* Test at the bottom: one branch per iteration */
+            int body = new_label(c);
+            int test = new_label(c);
+            emit(c, INSTR_JUMP, test);
+            place_label(c, body);
+            compile_statement(c, stmt->data.while_stmt.body);
+            place_label(c, test);
+            compile_branch(c, stmt->data.while_stmt.condition, true, body);
+            return;
+        }
+
+        case STMT_RETURN:
+            if (stmt->data.return_stmt.expr) {
+                compile_expression(c, stmt->data.return_stmt.expr);
+                emit(c, INSTR_RETURN, 1);
+            } else {
+                emit(c, INSTR_RETURN, 0);
+            }
+            return;
+
+        case STMT_EXPR: {
+            const ASTExpr *expr = stmt->data.expr_stmt.expr;
+            if (is_print_call(expr)) {
+                compile_expression(c, expr->data.call.args[0]);
+                emit(c, INSTR_PRINT, 0);
+            } else {
+                compile_expression(c, expr);
+                emit(c, INSTR_POP, 0);
+            }
+            return;
+        }
+
+        case STMT_BLOCK: {
+            size_t scope_start = c->scope_count;
+            for (size_t i = 0; i < stmt->data.block.stmt_count; i++) {
+                compile_statement(c, stmt->data.block.statements[i]);
+            }
+            c->scope_count = scope_start;
+            return;
+        }
+    }
+
+    c->failed = true;
+}
+
+/* ==============================================================================
+ * Superinstructions & Label Resolution
+ * ==============================================================================
+ */
+
+static bool is_comparison(InstructionType type) {
+    return type >= INSTR_EQ && type <= INSTR_GE;
+}
+
+/* The compare-and-branch taken when the comparison is (or is not) true */
+static InstructionType compare_branch(InstructionType cmp, bool when) {
+    static const InstructionType taken[] = {
+        INSTR_JUMP_IF_EQ, INSTR_JUMP_IF_NE, INSTR_JUMP_IF_LT,
+        INSTR_JUMP_IF_LE, INSTR_JUMP_IF_GT, INSTR_JUMP_IF_GE
+    };
+    static const InstructionType negated[] = {
+        INSTR_JUMP_IF_NE, INSTR_JUMP_IF_EQ, INSTR_JUMP_IF_GE,
+        INSTR_JUMP_IF_GT, INSTR_JUMP_IF_LE, INSTR_JUMP_IF_LT
+    };
+    return when ? taken[cmp - INSTR_EQ] : negated[cmp - INSTR_EQ];
+}
+
+static bool packable_loads(const Instruction *a, const Instruction *b) {
+    return a->type == INSTR_LOAD && b->type == INSTR_LOAD &&
+           a->operand <= BYTECODE_SLOT_LIMIT && b->operand <= BYTECODE_SLOT_LIMIT;
+}
+
+/* Fuse the function's raw code and append it to the program, resolving
+ * labels. Returns the entry index */
+static size_t finish_function(BytecodeCompiler *c) {
+    ByteCode *code = c->code;
+    size_t n = c->raw_count;
+    size_t entry = code->count;
+
+    bool *target = calloc(n + 1, sizeof(bool));
+    size_t *map = malloc((n + 1) * sizeof(size_t));
+    if (!target || !map ||
+        !grow((void **)&code->instructions, &code->capacity, code->count + n,
+              sizeof(Instruction))) {
+        free(target);
+        free(map);
+        c->failed = true;
+        return entry;
+    }
+
+    for (size_t l = 0; l < c->label_count; l++) {
+        if (c->labels[l] <= n) target[c->labels[l]] = true;
+    }
+
+    const Instruction *raw = c->raw;
+    size_t i = 0;
+    while (i < n) {
+        Instruction out = raw[i];
+        size_t used = 1;
+
+        if (i + 2 < n && packable_loads(&raw[i], &raw[i + 1]) && raw[i + 2].type == INSTR_ADD &&
+            !target[i + 1] && !target[i + 2]) {
+            out.type = INSTR_LOAD2_ADD;
+            out.operand = raw[i].operand | (raw[i + 1].operand << 16);
+            used = 3;
+        } else if (i + 1 < n && packable_loads(&raw[i], &raw[i + 1]) && !target[i + 1]) {
+            out.type = INSTR_LOAD2;
+            out.operand = raw[i].operand | (raw[i + 1].operand << 16);
+            used = 2;
+        } else if (i + 1 < n && is_comparison(raw[i].type) && !target[i + 1] &&
+                   (raw[i + 1].type == INSTR_JUMP_IF_TRUE ||
+                    raw[i + 1].type == INSTR_JUMP_IF_FALSE)) {
+            out.type = compare_branch(raw[i].type, raw[i + 1].type == INSTR_JUMP_IF_TRUE);
+            out.operand = raw[i + 1].operand;
+            used = 2;
+        }
+
+        for (size_t k = 0; k < used; k++) {
+            map[i + k] = code->count;
+        }
+        code->instructions[code->count++] = out;
+        i += used;
+    }
+    map[n] = code->count;
+
+    for (size_t k = entry; k < code->count; k++) {
+        Instruction *instr = &code->instructions[k];
+        if (!is_jump(instr->type)) continue;
+
+        size_t label = (size_t)instr->operand;
+        if (label >= c->label_count || c->labels[label] > n) {
+            c->failed = true;
+            break;
+        }
+        instr->operand = (int)map[c->labels[label]];
+    }
+
+    free(target);
+    free(map);
+    return entry;
+}
+
+static void compile_function(BytecodeCompiler *c, const ASTFunc *func, ByteCodeFunction *out) {
+    c->raw_count = 0;
+    c->label_count = 0;
+    c->scope_count = 0;
+    c->local_count = 0;
+    c->depth = 0;
+    c->max_depth = 0;
+
+    for (size_t i = 0; i < func->param_count; i++) {
+        declare_slot(c, func->params[i].name);
+    }
+
+    compile_statement(c, func->body);
+    emit(c, INSTR_RETURN, 0);
+    if (c->failed) return;
+
+    out->entry = finish_function(c);
+    out->param_count = func->param_count;
+    out->local_count = c->local_count;
+    out->frame_size = c->local_count + (size_t)c->max_depth;
+}
+
+/* ==============================================================================
+ * Public API
+ * ==============================================================================
+ */
+
+ByteCode *bytecode_compile(const ASTProgram *program) {
+    if (!program) return NULL;
+
+    ByteCode *code = calloc(1, sizeof(ByteCode));
+    if (!code) return NULL;
+
+    BytecodeCompiler c;
+    memset(&c, 0, sizeof(c));
+    c.code = code;
+    c.program = program;
+
+    if (program->func_count > 0) {
+        code->functions = calloc(program->func_count, sizeof(ByteCodeFunction));
+        if (!code->functions) c.failed = true;
+        else code->func_count = program->func_count;
+    }
+
+    for (size_t i = 0; !c.failed && i < program->func_count; i++) {
+        const ASTFunc *func = program->functions[i];
+        code->functions[i].name = strdup(func->name);
+        if (!code->functions[i].name) c.failed = true;
+        compile_function(&c, func, &code->functions[i]);
+    }
+
+    free(c.raw);
+    free(c.labels);
+    free(c.scope);
+
+    if (c.failed) {
+        bytecode_destroy(code);
+        return NULL;
+    }
+    return code;
+}
+
+void bytecode_destroy(ByteCode *code) {
+    if (!code) return;
+    for (size_t i = 0; i < code->func_count; i++) {
+        free(code->functions[i].name);
+    }
+    free(code->functions);
+    free(code->instructions);
+    free(code);
+}
+
+size_t bytecode_find_function(const ByteCode *code, const char *name) {
+    if (!code || !name) return (size_t)-1;
+    for (size_t i = 0; i < code->func_count; i++) {
+        if (strcmp(code->functions[i].name, name) == 0) return i;
+    }
+    return (size_t)-1;
+}
+
+EventResult compiler_bytecode_event(EventContext *context, void *user_data) {
+    (void)user_data;
+
+    EventResult result;
+
+    ASTProgram *program;
+    EventChainErrorCode err = event_context_get(context, "ast", (void **)&program);
+
+    if (err != EC_SUCCESS || !program) {
+        event_result_failure(&result, "No AST provided to bytecode compiler",
+                             EC_ERROR_INVALID_PARAMETER, ERROR_DETAIL_FULL);
+        return result;
+    }
+
+    ByteCode *code = bytecode_compile(program);
+    if (!code) {
+        event_result_failure(&result, "Bytecode compilation failed",
+                             EC_ERROR_OUT_OF_MEMORY, ERROR_DETAIL_FULL);
+        return result;
+    }
+
+    err = event_context_set_with_cleanup(context, "bytecode", code,
+                                         (ValueCleanupFunc)bytecode_destroy);
+    if (err != EC_SUCCESS) {
+        bytecode_destroy(code);
+        event_result_failure(&result, "Failed to store bytecode in context",
+                             err, ERROR_DETAIL_FULL);
+        return result;
+    }
+
+    event_result_success(&result);
+    return result;
+}
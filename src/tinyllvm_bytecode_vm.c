@@ -0,0 +1,360 @@
+/**
+ * ==============================================================================
+ * TinyLLVM Compiler - Bytecode Virtual Machine
+ * ==============================================================================
+ *
+ * Runs the stack bytecode of tinyllvm_bytecode.h. A frame is the callee's
+ * slots followed by its operand stack, all on one value stack: a call's
+ * arguments, already pushed by the caller, become the callee's first
+ * slots, and a return drops the frame and pushes the result in their
+ * place. Each call checks for room for the callee's whole frame
+ * (frame_size), so pushes within a function need no bounds checks.
+ *
+ * Dispatch uses computed goto under GCC and Clang and a switch
+ * elsewhere, as in the IR interpreter.
+ */
+
+#include "include/tinyllvm_bytecode.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define BYTECODE_COMPUTED_GOTO 1
+#else
+#define BYTECODE_COMPUTED_GOTO 0
+#endif
+
+#define BYTECODE_MAX_CALL_DEPTH  1000000
+#define BYTECODE_MAX_STACK       ((size_t)1 << 26)   /* Values */
+
+typedef struct {
+    const Instruction *return_pc;
+    size_t fp;                  /* Caller's frame, as an offset into the stack */
+} VMFrame;
+
+struct ByteCodeVM {
+    const ByteCode *code;
+
+    int32_t *stack;
+    size_t stack_capacity;
+    VMFrame *frames;
+    size_t frame_capacity;
+
+    ByteCodePrintFunction print;
+    void *print_data;
+};
+
+static void set_error(char *error, size_t error_size, const char *format, ...) {
+    if (!error || error_size == 0) return;
+
+    va_list args;
+    va_start(args, format);
+    vsnprintf(error, error_size, format, args);
+    va_end(args);
+}
+
+static void default_print(int32_t value, void *user_data) {
+    (void)user_data;
+    printf("%d\n", value);
+}
+
+ByteCodeVM *bytecode_vm_create(const ByteCode *code) {
+    if (!code) return NULL;
+
+    ByteCodeVM *vm = calloc(1, sizeof(ByteCodeVM));
+    if (!vm) return NULL;
+
+    vm->code = code;
+    vm->print = default_print;
+    return vm;
+}
+
+void bytecode_vm_destroy(ByteCodeVM *vm) {
+    if (!vm) return;
+    free(vm->stack);
+    free(vm->frames);
+    free(vm);
+}
+
+void bytecode_vm_set_print(ByteCodeVM *vm, ByteCodePrintFunction print, void *user_data) {
+    if (!vm) return;
+    vm->print = print ? print : default_print;
+    vm->print_data = user_data;
+}
+
+/* Make the stack hold at least needed values */
+static bool reserve_stack(ByteCodeVM *vm, size_t needed) {
+    if (needed <= vm->stack_capacity) return true;
+    if (needed > BYTECODE_MAX_STACK) return false;
+
+    size_t new_capacity = vm->stack_capacity == 0 ? 1024 : vm->stack_capacity;
+    while (new_capacity < needed) {
+        new_capacity *= 2;
+    }
+
+    int32_t *stack = realloc(vm->stack, new_capacity * sizeof(int32_t));
+    if (!stack) return false;
+
+    vm->stack = stack;
+    vm->stack_capacity = new_capacity;
+    return true;
+}
+
+static bool reserve_frames(ByteCodeVM *vm, size_t needed) {
+    if (needed <= vm->frame_capacity) return true;
+
+    size_t new_capacity = vm->frame_capacity == 0 ? 64 : vm->frame_capacity * 2;
+    while (new_capacity < needed) {
+        new_capacity *= 2;
+    }
+
+    VMFrame *frames = realloc(vm->frames, new_capacity * sizeof(VMFrame));
+    if (!frames) return false;
+
+    vm->frames = frames;
+    vm->frame_capacity = new_capacity;
+    return true;
+}
+
+static int32_t arith_shr(int32_t value, int32_t shift) {
+    uint32_t bits = (uint32_t)value;
+    shift &= 31;
+    return value < 0 ? (int32_t)~(~bits >> shift) : (int32_t)(bits >> shift);
+}
+
+#if BYTECODE_COMPUTED_GOTO
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#endif
+
+static bool execute(ByteCodeVM *vm, size_t entry, int32_t *result,
+                    char *error, size_t error_size) {
+    const Instruction *code = vm->code->instructions;
+    const ByteCodeFunction *functions = vm->code->functions;
+    const Instruction *pc = code + functions[entry].entry;
+
+    int32_t *fp = vm->stack;
+    int32_t *sp = fp + functions[entry].local_count;
+    size_t depth = 0;
+    int32_t a, b;
+
+#if BYTECODE_COMPUTED_GOTO
+    static const void *const dispatch[INSTR_COUNT] = {
+        [INSTR_PUSH] = &&do_PUSH,           [INSTR_ADD] = &&do_ADD,
+        [INSTR_SUB] = &&do_SUB,             [INSTR_MUL] = &&do_MUL,
+        [INSTR_DIV] = &&do_DIV,             [INSTR_MOD] = &&do_MOD,
+        [INSTR_SHL] = &&do_SHL,             [INSTR_SHR] = &&do_SHR,
+        [INSTR_USHR] = &&do_USHR,           [INSTR_MULHI] = &&do_MULHI,
+        [INSTR_EQ] = &&do_EQ,               [INSTR_NE] = &&do_NE,
+        [INSTR_LT] = &&do_LT,               [INSTR_LE] = &&do_LE,
+        [INSTR_GT] = &&do_GT,               [INSTR_GE] = &&do_GE,
+        [INSTR_NOT] = &&do_NOT,             [INSTR_SELECT] = &&do_SELECT,
+        [INSTR_LOAD] = &&do_LOAD,           [INSTR_STORE] = &&do_STORE,
+        [INSTR_POP] = &&do_POP,             [INSTR_JUMP] = &&do_JUMP,
+        [INSTR_JUMP_IF_FALSE] = &&do_JUMP_IF_FALSE,
+        [INSTR_JUMP_IF_TRUE] = &&do_JUMP_IF_TRUE,
+        [INSTR_CALL] = &&do_CALL,           [INSTR_RETURN] = &&do_RETURN,
+        [INSTR_PRINT] = &&do_PRINT,         [INSTR_LOAD2] = &&do_LOAD2,
+        [INSTR_LOAD2_ADD] = &&do_LOAD2_ADD,
+        [INSTR_JUMP_IF_EQ] = &&do_JUMP_IF_EQ, [INSTR_JUMP_IF_NE] = &&do_JUMP_IF_NE,
+        [INSTR_JUMP_IF_LT] = &&do_JUMP_IF_LT, [INSTR_JUMP_IF_LE] = &&do_JUMP_IF_LE,
+        [INSTR_JUMP_IF_GT] = &&do_JUMP_IF_GT, [INSTR_JUMP_IF_GE] = &&do_JUMP_IF_GE
+    };
+#define CASE(name)    do_##name:
+#define NEXT()        { pc++; goto *dispatch[pc->type]; }
+#define JUMP(target)  { pc = code + (target); goto *dispatch[pc->type]; }
+    goto *dispatch[pc->type];
+    {
+#else
+#define CASE(name)    case INSTR_##name:
+#define NEXT()        { pc++; continue; }
+#define JUMP(target)  { pc = code + (target); continue; }
+    for (;;) {
+        switch (pc->type) {
+#endif
+
+/* Pop b then a, for binary operators */
+#define POP2()        { b = *--sp; a = *--sp; }
+#define SLOT_A()      fp[pc->operand & 0xFFFF]
+#define SLOT_B()      fp[pc->operand >> 16]
+
+        CASE(PUSH)   *sp++ = pc->operand; NEXT();
+
+        CASE(ADD)    POP2(); *sp++ = (int32_t)((uint32_t)a + (uint32_t)b); NEXT();
+        CASE(SUB)    POP2(); *sp++ = (int32_t)((uint32_t)a - (uint32_t)b); NEXT();
+        CASE(MUL)    POP2(); *sp++ = (int32_t)((uint32_t)a * (uint32_t)b); NEXT();
+
+        CASE(DIV)
+            POP2();
+            if (b == 0) goto division_by_zero;
+            if (a == INT32_MIN && b == -1) goto division_overflow;
+            *sp++ = a / b;
+            NEXT();
+
+        CASE(MOD)
+            POP2();
+            if (b == 0) goto division_by_zero;
+            if (a == INT32_MIN && b == -1) goto division_overflow;
+            *sp++ = a % b;
+            NEXT();
+
+        CASE(SHL)    POP2(); *sp++ = (int32_t)((uint32_t)a << (b & 31)); NEXT();
+        CASE(SHR)    POP2(); *sp++ = arith_shr(a, b); NEXT();
+        CASE(USHR)   POP2(); *sp++ = (int32_t)((uint32_t)a >> (b & 31)); NEXT();
+        CASE(MULHI)  POP2(); *sp++ = (int32_t)(((int64_t)a * b) >> 32); NEXT();
+
+        CASE(EQ)     POP2(); *sp++ = a == b; NEXT();
+        CASE(NE)     POP2(); *sp++ = a != b; NEXT();
+        CASE(LT)     POP2(); *sp++ = a <  b; NEXT();
+        CASE(LE)     POP2(); *sp++ = a <= b; NEXT();
+        CASE(GT)     POP2(); *sp++ = a >  b; NEXT();
+        CASE(GE)     POP2(); *sp++ = a >= b; NEXT();
+        CASE(NOT)    sp[-1] = !sp[-1]; NEXT();
+
+        CASE(SELECT)
+            POP2();
+            sp[-1] = sp[-1] ? a : b;
+            NEXT();
+
+        CASE(LOAD)   *sp++ = fp[pc->operand]; NEXT();
+        CASE(STORE)  fp[pc->operand] = *--sp; NEXT();
+        CASE(POP)    sp--; NEXT();
+
+        CASE(JUMP)   JUMP(pc->operand);
+        CASE(JUMP_IF_FALSE)
+            if (!*--sp) JUMP(pc->operand);
+            NEXT();
+        CASE(JUMP_IF_TRUE)
+            if (*--sp) JUMP(pc->operand);
+            NEXT();
+
+        CASE(PRINT)
+            vm->print(*--sp, vm->print_data);
+            NEXT();
+
+        CASE(LOAD2)
+            sp[0] = SLOT_A();
+            sp[1] = SLOT_B();
+            sp += 2;
+            NEXT();
+
+        CASE(LOAD2_ADD)
+            *sp++ = (int32_t)((uint32_t)SLOT_A() + (uint32_t)SLOT_B());
+            NEXT();
+
+        CASE(JUMP_IF_EQ) POP2(); if (a == b) JUMP(pc->operand); NEXT();
+        CASE(JUMP_IF_NE) POP2(); if (a != b) JUMP(pc->operand); NEXT();
+        CASE(JUMP_IF_LT) POP2(); if (a <  b) JUMP(pc->operand); NEXT();
+        CASE(JUMP_IF_LE) POP2(); if (a <= b) JUMP(pc->operand); NEXT();
+        CASE(JUMP_IF_GT) POP2(); if (a >  b) JUMP(pc->operand); NEXT();
+        CASE(JUMP_IF_GE) POP2(); if (a >= b) JUMP(pc->operand); NEXT();
+
+        CASE(CALL) {
+            const ByteCodeFunction *callee = &functions[pc->operand];
+            int32_t *callee_fp = sp - callee->param_count;
+            size_t offset = (size_t)(callee_fp - vm->stack);
+            size_t caller_fp = (size_t)(fp - vm->stack);
+
+            if (depth + 1 >= BYTECODE_MAX_CALL_DEPTH ||
+                !reserve_stack(vm, offset + callee->frame_size)) {
+                set_error(error, error_size, "stack overflow in %s", callee->name);
+                return false;
+            }
+            if (!reserve_frames(vm, depth + 1)) {
+                set_error(error, error_size, "out of memory");
+                return false;
+            }
+
+            VMFrame *frame = &vm->frames[depth++];
+            frame->return_pc = pc + 1;
+            frame->fp = caller_fp;
+
+            /* The stack may have moved */
+            fp = vm->stack + offset;
+            sp = fp + callee->param_count;
+            for (size_t i = callee->param_count; i < callee->local_count; i++) {
+                *sp++ = 0;
+            }
+            JUMP(callee->entry);
+        }
+
+        CASE(RETURN)
+            a = pc->operand ? *--sp : 0;
+            if (depth == 0) {
+                if (result) *result = a;
+                return true;
+            }
+            {
+                const VMFrame *frame = &vm->frames[--depth];
+                sp = fp;
+                *sp++ = a;
+                fp = vm->stack + frame->fp;
+                pc = frame->return_pc;
+            }
+#if BYTECODE_COMPUTED_GOTO
+            goto *dispatch[pc->type];
+    }
+#else
+            continue;
+
+        case INSTR_COUNT:
+            break;
+        }
+        break;
+    }
+    set_error(error, error_size, "invalid instruction");
+    return false;
+#endif
+
+#undef CASE
+#undef NEXT
+#undef JUMP
+#undef POP2
+#undef SLOT_A
+#undef SLOT_B
+
+division_by_zero:
+    set_error(error, error_size, "division by zero");
+    return false;
+
+division_overflow:
+    set_error(error, error_size, "division overflow");
+    return false;
+}
+
+#if BYTECODE_COMPUTED_GOTO
+#pragma GCC diagnostic pop
+#endif
+
+bool bytecode_vm_run(ByteCodeVM *vm, const char *function,
+                     const int32_t *args, size_t arg_count, int32_t *result,
+                     char *error, size_t error_size) {
+    if (!vm || !function) {
+        set_error(error, error_size, "no virtual machine");
+        return false;
+    }
+
+    size_t entry = bytecode_find_function(vm->code, function);
+    if (entry == (size_t)-1) {
+        set_error(error, error_size, "no function %s", function);
+        return false;
+    }
+
+    const ByteCodeFunction *func = &vm->code->functions[entry];
+    if (func->param_count != arg_count) {
+        set_error(error, error_size, "%s takes %zu argument(s), got %zu", function,
+                  func->param_count, arg_count);
+        return false;
+    }
+    if (!reserve_stack(vm, func->frame_size)) {
+        set_error(error, error_size, "out of memory");
+        return false;
+    }
+
+    for (size_t i = 0; i < func->local_count; i++) {
+        vm->stack[i] = i < arg_count ? args[i] : 0;
+    }
+    return execute(vm, entry, result, error, error_size);
+}
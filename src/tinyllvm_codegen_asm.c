@@ -0,0 +1,1165 @@
+/**
+ * ==============================================================================
+ * TinyLLVM Compiler - x86-64 Assembly Generator
+ * ==============================================================================
+ *
+ * Emits GNU assembler (AT&T syntax) for x86-64 System V from the SSA form
+ * of the IR, for TARGET_ASM_X86_64. print calls printf, so `cc out.s`
+ * links a program whose main returns the CoreTiny main's value.
+ *
+ *   - Registers are allocated by linear scan over one live interval per
+ *     SSA value, built from block liveness in layout order. Values live
+ *     across a call get callee-saved registers; the rest prefer
+ *     caller-saved ones. When registers run out, the interval ending last
+ *     is spilled to a stack slot for its whole lifetime.
+ *   - Constants take no register; each use becomes an immediate.
+ *   - Phis become parallel moves on each incoming edge, in a stub after
+ *     the branch when the edge is conditional.
+ *   - An icmp feeding only the branch after it becomes cmp/jcc. Adds of
+ *     two registers or a constant, and multiplies by 2, 3, 4, 5, 8 or 9,
+ *     use lea; other constant products use the three-operand imul.
+ *   - rax, rcx, rdx and r11 are never allocated: division, shifts,
+ *     selects and memory-to-memory moves go through them.
+ *
+ * Division traps in hardware (SIGFPE) on zero and INT_MIN / -1, as the
+ * C backend's output does.
+ */
+
+#include "include/tinyllvm_compiler.h"
+#include "include/tinyllvm_ir.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <limits.h>
+
+/* ==============================================================================
+ * Registers & Locations
+ * ==============================================================================
+ */
+
+typedef enum {
+    REG_RAX, REG_RCX, REG_RDX, REG_RBX, REG_RSI, REG_RDI, REG_R8, REG_R9,
+    REG_R10, REG_R11, REG_R12, REG_R13, REG_R14, REG_R15,
+    REG_COUNT
+} AsmReg;
+
+static const char *const reg64_names[REG_COUNT] = {
+    "%rax", "%rcx", "%rdx", "%rbx", "%rsi", "%rdi", "%r8", "%r9",
+    "%r10", "%r11", "%r12", "%r13", "%r14", "%r15"
+};
+
+static const char *const reg32_names[REG_COUNT] = {
+    "%eax", "%ecx", "%edx", "%ebx", "%esi", "%edi", "%r8d", "%r9d",
+    "%r10d", "%r11d", "%r12d", "%r13d", "%r14d", "%r15d"
+};
+
+/* Allocation order; values that need not survive a call try caller-saved
+ * registers first so leaf code saves nothing */
+static const AsmReg caller_saved[] = { REG_RSI, REG_RDI, REG_R8, REG_R9, REG_R10 };
+static const AsmReg callee_saved[] = { REG_RBX, REG_R12, REG_R13, REG_R14, REG_R15 };
+
+#define ASM_CALLER_SAVED  (sizeof(caller_saved) / sizeof(caller_saved[0]))
+#define ASM_CALLEE_SAVED  (sizeof(callee_saved) / sizeof(callee_saved[0]))
+
+/* System V integer argument registers; later arguments go on the stack */
+static const AsmReg arg_regs[] = { REG_RDI, REG_RSI, REG_RDX, REG_RCX, REG_R8, REG_R9 };
+#define ASM_ARG_REGS  (sizeof(arg_regs) / sizeof(arg_regs[0]))
+
+typedef enum {
+    LOC_NONE,           /* Dead value */
+    LOC_REG,            /* value: AsmReg */
+    LOC_SLOT,           /* value: spill slot index */
+    LOC_ARG,            /* value: index of a stack-passed parameter */
+    LOC_IMM             /* value: immediate */
+} LocKind;
+
+typedef struct {
+    LocKind kind;
+    int32_t value;
+} Loc;
+
+static Loc loc_make(LocKind kind, int32_t value) {
+    Loc loc = { kind, value };
+    return loc;
+}
+
+static Loc loc_reg(AsmReg reg) {
+    return loc_make(LOC_REG, (int32_t)reg);
+}
+
+static bool loc_equal(Loc a, Loc b) {
+    return a.kind == b.kind && a.value == b.value;
+}
+
+static bool loc_is_mem(Loc loc) {
+    return loc.kind == LOC_SLOT || loc.kind == LOC_ARG;
+}
+
+/* ==============================================================================
+ * Generator State
+ * ==============================================================================
+ */
+
+typedef struct {
+    int from;           /* First and last position; to < 0 if never live */
+    int to;
+    bool crosses_call;
+    Loc loc;
+} Interval;
+
+typedef struct {
+    char *output;
+    size_t length;
+    size_t capacity;
+
+    CompilerConfig *config;
+    const IRModule *module;
+    int stub_count;                 /* .Ltmp<n> edge stubs, module-wide */
+    bool uses_print;
+
+    /* Current function */
+    const IRFunction *func;
+    size_t func_index;
+    const IRInstr **def_of;         /* Temporary -> defining instruction */
+    int *use_count;                 /* Temporary -> operand uses */
+    int *value_of;                  /* Temporary -> value, -1 for constants */
+    size_t value_count;             /* Parameters are values 0..n-1 */
+    Interval *intervals;
+    int *block_end;                 /* Position of each block's outgoing edge moves */
+    int *calls;                     /* Positions of calls and prints */
+    size_t call_count;
+    int slot_count;
+    AsmReg saved[ASM_CALLEE_SAVED];
+    int saved_count;
+} AsmGen;
+
+static bool asm_grow(AsmGen *g, size_t additional) {
+    size_t needed = g->length + additional + 1;
+    if (needed <= g->capacity) return true;
+
+    size_t new_capacity = g->capacity == 0 ? 4096 : g->capacity;
+    while (new_capacity < needed) {
+        new_capacity *= 2;
+    }
+
+    char *new_output = realloc(g->output, new_capacity);
+    if (!new_output) return false;
+
+    g->output = new_output;
+    g->capacity = new_capacity;
+    return true;
+}
+
+static bool asm_vappendf(AsmGen *g, const char *format, va_list args) {
+    va_list copy;
+    va_copy(copy, args);
+    int len = vsnprintf(NULL, 0, format, copy);
+    va_end(copy);
+    if (len < 0 || !asm_grow(g, (size_t)len)) return false;
+
+    vsnprintf(g->output + g->length, (size_t)len + 1, format, args);
+    g->length += (size_t)len;
+    return true;
+}
+
+static bool asm_appendf(AsmGen *g, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    bool ok = asm_vappendf(g, format, args);
+    va_end(args);
+    return ok;
+}
+
+/* One tab-indented instruction line */
+static bool emit_line(AsmGen *g, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    bool ok = asm_appendf(g, "\t") && asm_vappendf(g, format, args) && asm_appendf(g, "\n");
+    va_end(args);
+    return ok;
+}
+
+/* Stack slots sit below rbp and the saved callee-saved registers */
+static void loc_text(const AsmGen *g, Loc loc, char *text, size_t size) {
+    switch (loc.kind) {
+        case LOC_REG:
+            snprintf(text, size, "%s", reg32_names[loc.value]);
+            break;
+        case LOC_SLOT:
+            snprintf(text, size, "%d(%%rbp)", -8 * (g->saved_count + loc.value + 1));
+            break;
+        case LOC_ARG:
+            snprintf(text, size, "%d(%%rbp)", 16 + 8 * (loc.value - (int)ASM_ARG_REGS));
+            break;
+        case LOC_IMM:
+            snprintf(text, size, "$%d", (int)loc.value);
+            break;
+        case LOC_NONE:
+            snprintf(text, size, "?");
+            break;
+    }
+}
+
+static bool emit_op(AsmGen *g, const char *mnemonic, Loc src, Loc dst) {
+    char s[32], d[32];
+    loc_text(g, src, s, sizeof(s));
+    loc_text(g, dst, d, sizeof(d));
+    return emit_line(g, "%s\t%s, %s", mnemonic, s, d);
+}
+
+static bool emit_move(AsmGen *g, Loc src, Loc dst) {
+    if (dst.kind == LOC_NONE || loc_equal(src, dst)) return true;
+    if (loc_is_mem(src) && loc_is_mem(dst)) {
+        return emit_op(g, "movl", src, loc_reg(REG_R11)) &&
+               emit_op(g, "movl", loc_reg(REG_R11), dst);
+    }
+    return emit_op(g, "movl", src, dst);
+}
+
+/* ==============================================================================
+ * Values
+ * ==============================================================================
+ */
+
+static int value_id(const AsmGen *g, IRValue value) {
+    if (value.kind == IR_VALUE_PARAM) {
+        return value.index >= 0 && (size_t)value.index < g->func->param_count ? value.index : -1;
+    }
+    if (value.kind == IR_VALUE_TEMP && value.index >= 0 && value.index < g->module->temp_count) {
+        return g->value_of[value.index];
+    }
+    return -1;
+}
+
+/* Where an operand can be read: constants and undef are immediates */
+static Loc operand(const AsmGen *g, IRValue value) {
+    if (value.kind == IR_VALUE_UNDEF) return loc_make(LOC_IMM, 0);
+    if (value.kind == IR_VALUE_TEMP && value.index >= 0 && value.index < g->module->temp_count) {
+        const IRInstr *def = g->def_of[value.index];
+        if (def && def->op == IR_CONST) return loc_make(LOC_IMM, def->imm);
+    }
+    int id = value_id(g, value);
+    return id >= 0 ? g->intervals[id].loc : loc_make(LOC_IMM, 0);
+}
+
+static int temp_value(const AsmGen *g, int temp) {
+    return temp >= 0 && temp < g->module->temp_count ? g->value_of[temp] : -1;
+}
+
+static Loc dest_loc(const AsmGen *g, int temp) {
+    int id = temp_value(g, temp);
+    return id >= 0 ? g->intervals[id].loc : loc_make(LOC_NONE, 0);
+}
+
+/* Instructions up to and including the first terminator */
+static size_t block_length(const IRBlock *block) {
+    for (size_t i = 0; i < block->instr_count; i++) {
+        if (ir_opcode_is_terminator(block->instrs[i].op)) return i + 1;
+    }
+    return block->instr_count;
+}
+
+static size_t phi_count(const IRBlock *block) {
+    size_t count = 0;
+    while (count < block->instr_count && block->instrs[count].op == IR_PHI) {
+        count++;
+    }
+    return count;
+}
+
+static const IRValue *phi_source(const IRInstr *phi, int label) {
+    for (size_t j = 0; j < phi->operand_count && j < phi->label_count; j++) {
+        if (phi->labels[j] == label) return &phi->operands[j];
+    }
+    return NULL;
+}
+
+/* An icmp whose only use is the conditional branch right after it */
+static bool is_fused_compare(const AsmGen *g, const IRBlock *block, size_t i) {
+    const IRInstr *instr = &block->instrs[i];
+    if (instr->op != IR_ICMP || instr->dest < 0 || i + 1 >= block->instr_count) return false;
+
+    const IRInstr *next = &block->instrs[i + 1];
+    return next->op == IR_COND_BR && next->operand_count == 1 &&
+           next->operands[0].kind == IR_VALUE_TEMP && next->operands[0].index == instr->dest &&
+           g->use_count[instr->dest] == 1;
+}
+
+/* Number parameters, then every temporary that needs a location */
+static void number_values(AsmGen *g) {
+    const IRFunction *func = g->func;
+    int temps = g->module->temp_count;
+
+    for (size_t b = 0; b < func->block_count; b++) {
+        const IRBlock *block = func->blocks[b];
+        size_t length = block_length(block);
+        for (size_t i = 0; i < length; i++) {
+            const IRInstr *instr = &block->instrs[i];
+            if (instr->dest >= 0 && instr->dest < temps) g->def_of[instr->dest] = instr;
+            for (size_t j = 0; j < instr->operand_count; j++) {
+                IRValue v = instr->operands[j];
+                if (v.kind == IR_VALUE_TEMP && v.index >= 0 && v.index < temps) {
+                    g->use_count[v.index]++;
+                }
+            }
+        }
+    }
+
+    g->value_count = func->param_count;
+    for (size_t b = 0; b < func->block_count; b++) {
+        const IRBlock *block = func->blocks[b];
+        size_t length = block_length(block);
+        for (size_t i = 0; i < length; i++) {
+            const IRInstr *instr = &block->instrs[i];
+            if (instr->dest < 0 || instr->dest >= temps || instr->op == IR_CONST ||
+                is_fused_compare(g, block, i)) {
+                continue;
+            }
+            g->value_of[instr->dest] = (int)g->value_count++;
+        }
+    }
+}
+
+/* ==============================================================================
+ * Liveness & Live Intervals
+ * ==============================================================================
+ */
+
+static void interval_extend(Interval *iv, int pos) {
+    if (pos < iv->from) iv->from = pos;
+    if (pos > iv->to) iv->to = pos;
+}
+
+#define BIT_SET(set, i)   ((set)[(i) / 64] |= (uint64_t)1 << ((i) % 64))
+#define BIT_TEST(set, i)  (((set)[(i) / 64] >> ((i) % 64)) & 1)
+
+/*
+ * Positions count up in steps of two through the blocks in layout order:
+ * each instruction gets one, and a block's outgoing phi moves get the one
+ * after its last instruction. Phi results are also live at those move
+ * positions, so no other value holds their register when the moves land.
+ */
+static bool build_intervals(AsmGen *g) {
+    const IRFunction *func = g->func;
+    size_t blocks = func->block_count;
+    size_t n = g->value_count;
+    size_t words = (n + 63) / 64;
+    if (words == 0) words = 1;
+
+    uint64_t *sets = calloc(4 * blocks * words + words, sizeof(uint64_t));
+    if (!sets) return false;
+    uint64_t *use = sets;
+    uint64_t *def = use + blocks * words;
+    uint64_t *live_in = def + blocks * words;
+    uint64_t *live_out = live_in + blocks * words;
+    uint64_t *scratch = live_out + blocks * words;
+
+    for (size_t b = 0; b < blocks; b++) {
+        const IRBlock *block = func->blocks[b];
+        size_t length = block_length(block);
+        for (size_t i = 0; i < length; i++) {
+            const IRInstr *instr = &block->instrs[i];
+            if (instr->op != IR_PHI) {
+                for (size_t j = 0; j < instr->operand_count; j++) {
+                    int id = value_id(g, instr->operands[j]);
+                    if (id >= 0 && !BIT_TEST(def + b * words, id)) BIT_SET(use + b * words, id);
+                }
+            }
+            int id = temp_value(g, instr->dest);
+            if (id >= 0) BIT_SET(def + b * words, id);
+        }
+    }
+
+    /* live_out(b) = U live_in(s) + phi sources from b;
+     * live_in(b) = use(b) + (live_out(b) - def(b)) */
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t b = blocks; b-- > 0;) {
+            const IRBlock *block = func->blocks[b];
+            memset(scratch, 0, words * sizeof(uint64_t));
+            for (size_t s = 0; s < block->succ_count; s++) {
+                size_t succ = block->succs[s];
+                for (size_t w = 0; w < words; w++) scratch[w] |= live_in[succ * words + w];
+
+                const IRBlock *to = func->blocks[succ];
+                size_t phis = phi_count(to);
+                for (size_t p = 0; p < phis; p++) {
+                    const IRValue *v = phi_source(&to->instrs[p], block->label);
+                    int id = v ? value_id(g, *v) : -1;
+                    if (id >= 0) BIT_SET(scratch, id);
+                }
+            }
+            for (size_t w = 0; w < words; w++) {
+                uint64_t in = use[b * words + w] | (scratch[w] & ~def[b * words + w]);
+                if (scratch[w] != live_out[b * words + w] || in != live_in[b * words + w]) {
+                    live_out[b * words + w] = scratch[w];
+                    live_in[b * words + w] = in;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    for (size_t v = 0; v < n; v++) {
+        g->intervals[v].from = INT_MAX;
+        g->intervals[v].to = -1;
+        g->intervals[v].crosses_call = false;
+        g->intervals[v].loc = loc_make(LOC_NONE, 0);
+    }
+
+    int pos = 2;
+    for (size_t b = 0; b < blocks; b++) {
+        const IRBlock *block = func->blocks[b];
+        size_t length = block_length(block);
+        int start = pos;
+
+        for (size_t i = 0; i < length; i++, pos += 2) {
+            const IRInstr *instr = &block->instrs[i];
+            if (instr->op != IR_PHI) {
+                for (size_t j = 0; j < instr->operand_count; j++) {
+                    int id = value_id(g, instr->operands[j]);
+                    if (id >= 0) interval_extend(&g->intervals[id], pos);
+                }
+            }
+            if (instr->op == IR_CALL || instr->op == IR_PRINT) g->calls[g->call_count++] = pos;
+            int id = temp_value(g, instr->dest);
+            if (id >= 0) interval_extend(&g->intervals[id], pos);
+        }
+        g->block_end[b] = pos;
+
+        for (size_t v = 0; v < n; v++) {
+            if (BIT_TEST(live_in + b * words, v)) interval_extend(&g->intervals[v], start);
+            if (BIT_TEST(live_out + b * words, v)) interval_extend(&g->intervals[v], pos + 1);
+        }
+        pos += 2;
+    }
+
+    for (size_t b = 0; b < blocks; b++) {
+        const IRBlock *block = func->blocks[b];
+        size_t phis = phi_count(block);
+        for (size_t p = 0; p < phis; p++) {
+            int id = temp_value(g, block->instrs[p].dest);
+            if (id < 0) continue;
+            for (size_t k = 0; k < block->pred_count; k++) {
+                interval_extend(&g->intervals[id], g->block_end[block->preds[k]]);
+            }
+        }
+    }
+
+    for (size_t v = 0; v < n; v++) {
+        Interval *iv = &g->intervals[v];
+        if (iv->to < 0) continue;
+        if (v < func->param_count) iv->from = 0;
+        for (size_t c = 0; c < g->call_count && !iv->crosses_call; c++) {
+            iv->crosses_call = iv->from < g->calls[c] && g->calls[c] < iv->to;
+        }
+    }
+
+    free(sets);
+    return true;
+}
+
+/* ==============================================================================
+ * Linear Scan Register Allocation
+ * ==============================================================================
+ */
+
+static bool reg_in(AsmReg reg, const AsmReg *regs, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (regs[i] == reg) return true;
+    }
+    return false;
+}
+
+static bool allocate_registers(AsmGen *g) {
+    size_t n = g->value_count;
+    int *order = malloc((n + 1) * sizeof(int));
+    if (!order) return false;
+
+    /* Values are numbered roughly in definition order, so insertion sort
+     * by start position is close to linear */
+    size_t live = 0;
+    for (size_t v = 0; v < n; v++) {
+        if (g->intervals[v].to < 0) continue;
+        size_t j = live++;
+        while (j > 0 && g->intervals[order[j - 1]].from > g->intervals[v].from) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = (int)v;
+    }
+
+    int holder[REG_COUNT];
+    for (int r = 0; r < REG_COUNT; r++) holder[r] = -1;
+
+    for (size_t k = 0; k < live; k++) {
+        Interval *cur = &g->intervals[order[k]];
+
+        /* A register is free again once its value's last use is here:
+         * an instruction reads its operands before writing its result */
+        for (int r = 0; r < REG_COUNT; r++) {
+            if (holder[r] >= 0 && g->intervals[holder[r]].to <= cur->from) holder[r] = -1;
+        }
+
+        /* A parameter stays in its argument register when it can */
+        int chosen = -1;
+        size_t param = (size_t)order[k];
+        if (param < g->func->param_count && param < ASM_ARG_REGS && !cur->crosses_call &&
+            reg_in(arg_regs[param], caller_saved, ASM_CALLER_SAVED) &&
+            holder[arg_regs[param]] < 0) {
+            chosen = (int)arg_regs[param];
+        }
+        if (chosen < 0 && !cur->crosses_call) {
+            for (size_t i = 0; i < ASM_CALLER_SAVED && chosen < 0; i++) {
+                if (holder[caller_saved[i]] < 0) chosen = (int)caller_saved[i];
+            }
+        }
+        for (size_t i = 0; i < ASM_CALLEE_SAVED && chosen < 0; i++) {
+            if (holder[callee_saved[i]] < 0) chosen = (int)callee_saved[i];
+        }
+
+        if (chosen < 0) {
+            /* Spill whichever usable interval ends last */
+            int victim_reg = -1;
+            for (int r = 0; r < REG_COUNT; r++) {
+                if (holder[r] < 0) continue;
+                if (cur->crosses_call && !reg_in((AsmReg)r, callee_saved, ASM_CALLEE_SAVED)) continue;
+                if (victim_reg < 0 || g->intervals[holder[r]].to > g->intervals[holder[victim_reg]].to) {
+                    victim_reg = r;
+                }
+            }
+            if (victim_reg >= 0 && g->intervals[holder[victim_reg]].to > cur->to) {
+                g->intervals[holder[victim_reg]].loc = loc_make(LOC_SLOT, g->slot_count++);
+                chosen = victim_reg;
+            } else {
+                cur->loc = loc_make(LOC_SLOT, g->slot_count++);
+                continue;
+            }
+        }
+
+        cur->loc = loc_reg((AsmReg)chosen);
+        holder[chosen] = order[k];
+    }
+    free(order);
+
+    g->saved_count = 0;
+    for (size_t i = 0; i < ASM_CALLEE_SAVED; i++) {
+        for (size_t v = 0; v < n; v++) {
+            Loc loc = g->intervals[v].loc;
+            if (loc.kind == LOC_REG && loc.value == (int32_t)callee_saved[i]) {
+                g->saved[g->saved_count++] = callee_saved[i];
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+/* ==============================================================================
+ * Moves
+ * ==============================================================================
+ */
+
+/* Perform every dst[i] = src[i] as if at once. Moves whose destination no
+ * other move still reads go first; a pure cycle is broken by parking one
+ * destination's old value in rax */
+static bool emit_parallel_moves(AsmGen *g, Loc *src, Loc *dst, size_t count) {
+    size_t n = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (dst[i].kind == LOC_NONE || loc_equal(src[i], dst[i])) continue;
+        src[n] = src[i];
+        dst[n] = dst[i];
+        n++;
+    }
+
+    while (n > 0) {
+        bool progress = false;
+        size_t i = 0;
+        while (i < n) {
+            bool blocked = false;
+            for (size_t j = 0; j < n && !blocked; j++) {
+                blocked = j != i && loc_equal(src[j], dst[i]);
+            }
+            if (blocked) {
+                i++;
+                continue;
+            }
+            if (!emit_move(g, src[i], dst[i])) return false;
+            src[i] = src[n - 1];
+            dst[i] = dst[n - 1];
+            n--;
+            progress = true;
+        }
+
+        if (!progress) {
+            Loc parked = dst[0];
+            if (!emit_move(g, parked, loc_reg(REG_RAX))) return false;
+            for (size_t j = 0; j < n; j++) {
+                if (loc_equal(src[j], parked)) src[j] = loc_reg(REG_RAX);
+            }
+        }
+    }
+    return true;
+}
+
+/* The phi moves for the edge from block `from` into block `to` */
+static bool emit_edge_moves(AsmGen *g, size_t from, size_t to) {
+    const IRBlock *pred = g->func->blocks[from];
+    const IRBlock *succ = g->func->blocks[to];
+    size_t count = phi_count(succ);
+    if (count == 0) return true;
+
+    Loc *src = malloc(2 * count * sizeof(Loc));
+    if (!src) return false;
+    Loc *dst = src + count;
+
+    for (size_t i = 0; i < count; i++) {
+        const IRInstr *phi = &succ->instrs[i];
+        const IRValue *v = phi_source(phi, pred->label);
+        src[i] = v ? operand(g, *v) : loc_make(LOC_IMM, 0);
+        dst[i] = dest_loc(g, phi->dest);
+    }
+
+    bool ok = emit_parallel_moves(g, src, dst, count);
+    free(src);
+    return ok;
+}
+
+static bool emit_block_label(AsmGen *g, size_t block) {
+    return asm_appendf(g, ".LBB%zu_%zu:\n", g->func_index, block);
+}
+
+/* Leave block `from` for block `to`, falling through when it is next */
+static bool emit_jump(AsmGen *g, size_t from, size_t to) {
+    if (!emit_edge_moves(g, from, to)) return false;
+    if (to == from + 1) return true;
+    return emit_line(g, "jmp\t.LBB%zu_%zu", g->func_index, to);
+}
+
+/* ==============================================================================
+ * Instruction Selection
+ * ==============================================================================
+ */
+
+static const char *cond_code(IRCmp cmp) {
+    switch (cmp) {
+        case IR_CMP_EQ: return "e";
+        case IR_CMP_NE: return "ne";
+        case IR_CMP_LT: return "l";
+        case IR_CMP_LE: return "le";
+        case IR_CMP_GT: return "g";
+        default:        return "ge";
+    }
+}
+
+static IRCmp cmp_inverse(IRCmp cmp) {
+    switch (cmp) {
+        case IR_CMP_EQ: return IR_CMP_NE;
+        case IR_CMP_NE: return IR_CMP_EQ;
+        case IR_CMP_LT: return IR_CMP_GE;
+        case IR_CMP_LE: return IR_CMP_GT;
+        case IR_CMP_GT: return IR_CMP_LE;
+        default:        return IR_CMP_LT;
+    }
+}
+
+/* The comparison with its operands exchanged */
+static IRCmp cmp_swapped(IRCmp cmp) {
+    switch (cmp) {
+        case IR_CMP_LT: return IR_CMP_GT;
+        case IR_CMP_LE: return IR_CMP_GE;
+        case IR_CMP_GT: return IR_CMP_LT;
+        case IR_CMP_GE: return IR_CMP_LE;
+        default:        return cmp;
+    }
+}
+
+static bool cmp_evaluate(IRCmp cmp, int32_t a, int32_t b) {
+    switch (cmp) {
+        case IR_CMP_EQ: return a == b;
+        case IR_CMP_NE: return a != b;
+        case IR_CMP_LT: return a < b;
+        case IR_CMP_LE: return a <= b;
+        case IR_CMP_GT: return a > b;
+        default:        return a >= b;
+    }
+}
+
+/* Set the flags for `a cmp b`, where at most one side is an immediate;
+ * returns the condition to test, which changes if the sides swap */
+static bool emit_compare(AsmGen *g, Loc a, Loc b, IRCmp *cmp) {
+    if (a.kind == LOC_IMM) {
+        Loc t = a;
+        a = b;
+        b = t;
+        *cmp = cmp_swapped(*cmp);
+    }
+    if (a.kind == LOC_REG && b.kind == LOC_IMM && b.value == 0) {
+        return emit_op(g, "testl", a, a);
+    }
+    if (loc_is_mem(a) && loc_is_mem(b)) {
+        if (!emit_move(g, a, loc_reg(REG_RAX))) return false;
+        a = loc_reg(REG_RAX);
+    }
+    return emit_op(g, "cmpl", b, a);
+}
+
+/* dst = a op b for a two-address instruction */
+static bool emit_binary(AsmGen *g, const char *mnemonic, bool commutative,
+                        Loc dst, Loc a, Loc b) {
+    if (dst.kind == LOC_NONE) return true;
+
+    Loc rax = loc_reg(REG_RAX);
+    if (dst.kind == LOC_REG && loc_equal(dst, a)) return emit_op(g, mnemonic, b, dst);
+    if (dst.kind == LOC_REG && loc_equal(dst, b) && commutative) {
+        return emit_op(g, mnemonic, a, dst);
+    }
+    if (dst.kind != LOC_REG || loc_equal(dst, b)) {
+        return emit_move(g, a, rax) && emit_op(g, mnemonic, b, rax) && emit_move(g, rax, dst);
+    }
+    return emit_move(g, a, dst) && emit_op(g, mnemonic, b, dst);
+}
+
+static bool emit_add(AsmGen *g, Loc dst, Loc a, Loc b) {
+    if (a.kind == LOC_IMM && b.kind != LOC_IMM) {
+        Loc t = a;
+        a = b;
+        b = t;
+    }
+    if (dst.kind == LOC_REG && a.kind == LOC_REG && !loc_equal(dst, a)) {
+        if (b.kind == LOC_REG && !loc_equal(dst, b)) {
+            return emit_line(g, "leal\t(%s,%s), %s", reg64_names[a.value],
+                             reg64_names[b.value], reg32_names[dst.value]);
+        }
+        if (b.kind == LOC_IMM) {
+            return emit_line(g, "leal\t%d(%s), %s", (int)b.value, reg64_names[a.value],
+                             reg32_names[dst.value]);
+        }
+    }
+    return emit_binary(g, "addl", true, dst, a, b);
+}
+
+static bool emit_sub(AsmGen *g, Loc dst, Loc a, Loc b) {
+    if (dst.kind == LOC_REG && a.kind == LOC_REG && !loc_equal(dst, a) &&
+        b.kind == LOC_IMM && b.value != INT32_MIN) {
+        return emit_line(g, "leal\t%d(%s), %s", -(int)b.value, reg64_names[a.value],
+                         reg32_names[dst.value]);
+    }
+    return emit_binary(g, "subl", false, dst, a, b);
+}
+
+static bool emit_mul(AsmGen *g, Loc dst, Loc a, Loc b) {
+    if (dst.kind == LOC_NONE) return true;
+    if (a.kind == LOC_IMM && b.kind != LOC_IMM) {
+        Loc t = a;
+        a = b;
+        b = t;
+    }
+    if (b.kind != LOC_IMM) return emit_binary(g, "imull", true, dst, a, b);
+
+    Loc rax = loc_reg(REG_RAX);
+    if (a.kind == LOC_IMM) {
+        if (!emit_move(g, a, rax)) return false;
+        a = rax;
+    }
+
+    int32_t k = b.value;
+    if (dst.kind == LOC_REG && a.kind == LOC_REG) {
+        const char *x = reg64_names[a.value];
+        const char *d = reg32_names[dst.value];
+        if (k == 2) return emit_line(g, "leal\t(%s,%s), %s", x, x, d);
+        if (k == 3 || k == 5 || k == 9) {
+            return emit_line(g, "leal\t(%s,%s,%d), %s", x, x, (int)k - 1, d);
+        }
+        if ((k == 4 || k == 8) && !loc_equal(dst, a)) {
+            return emit_line(g, "leal\t0(,%s,%d), %s", x, (int)k, d);
+        }
+    }
+
+    char s[32];
+    loc_text(g, a, s, sizeof(s));
+    Loc target = dst.kind == LOC_REG ? dst : rax;
+    return emit_line(g, "imull\t$%d, %s, %s", (int)k, s, reg32_names[target.value]) &&
+           emit_move(g, target, dst);
+}
+
+static bool emit_divide(AsmGen *g, bool remainder, Loc dst, Loc a, Loc b) {
+    Loc rcx = loc_reg(REG_RCX);
+    if (!emit_move(g, a, loc_reg(REG_RAX))) return false;
+    if (b.kind == LOC_IMM) {
+        if (!emit_move(g, b, rcx)) return false;
+        b = rcx;
+    }
+
+    char s[32];
+    loc_text(g, b, s, sizeof(s));
+    return emit_line(g, "cltd") && emit_line(g, "idivl\t%s", s) &&
+           emit_move(g, loc_reg(remainder ? REG_RDX : REG_RAX), dst);
+}
+
+static bool emit_shift(AsmGen *g, const char *mnemonic, Loc dst, Loc a, Loc b) {
+    if (dst.kind == LOC_NONE) return true;
+
+    char count[32];
+    if (b.kind == LOC_IMM) {
+        int amount = (int)(b.value & 31);
+        if (strcmp(mnemonic, "sall") == 0 && amount >= 1 && amount <= 3 &&
+            dst.kind == LOC_REG && a.kind == LOC_REG && !loc_equal(dst, a)) {
+            return emit_line(g, "leal\t0(,%s,%d), %s", reg64_names[a.value], 1 << amount,
+                             reg32_names[dst.value]);
+        }
+        snprintf(count, sizeof(count), "$%d", amount);
+    } else {
+        if (!emit_move(g, b, loc_reg(REG_RCX))) return false;
+        snprintf(count, sizeof(count), "%%cl");
+    }
+
+    Loc target = dst.kind == LOC_REG ? dst : loc_reg(REG_RAX);
+    return emit_move(g, a, target) &&
+           emit_line(g, "%s\t%s, %s", mnemonic, count, reg32_names[target.value]) &&
+           emit_move(g, target, dst);
+}
+
+/* Sign-extend a 32-bit operand into a 64-bit scratch register */
+static bool emit_sign_extend(AsmGen *g, Loc src, AsmReg reg) {
+    if (src.kind == LOC_IMM) return emit_line(g, "movq\t$%d, %s", (int)src.value, reg64_names[reg]);
+
+    char s[32];
+    loc_text(g, src, s, sizeof(s));
+    return emit_line(g, "movslq\t%s, %s", s, reg64_names[reg]);
+}
+
+/* High 32 bits of the 64-bit signed product */
+static bool emit_mulhi(AsmGen *g, Loc dst, Loc a, Loc b) {
+    if (dst.kind == LOC_NONE) return true;
+    return emit_sign_extend(g, a, REG_RAX) && emit_sign_extend(g, b, REG_RCX) &&
+           emit_line(g, "imulq\t%%rcx, %%rax") && emit_line(g, "sarq\t$32, %%rax") &&
+           emit_move(g, loc_reg(REG_RAX), dst);
+}
+
+static bool emit_select(AsmGen *g, Loc dst, Loc c, Loc a, Loc b) {
+    if (dst.kind == LOC_NONE) return true;
+    if (c.kind == LOC_IMM) return emit_move(g, c.value ? a : b, dst);
+
+    Loc rax = loc_reg(REG_RAX);
+    if (b.kind == LOC_IMM) {
+        if (!emit_move(g, b, loc_reg(REG_RCX))) return false;
+        b = loc_reg(REG_RCX);
+    }
+    bool ok = emit_move(g, a, rax);
+    ok = ok && (c.kind == LOC_REG ? emit_op(g, "testl", c, c)
+                                  : emit_op(g, "cmpl", loc_make(LOC_IMM, 0), c));
+    return ok && emit_op(g, "cmovel", b, rax) && emit_move(g, rax, dst);
+}
+
+static bool emit_icmp(AsmGen *g, const IRInstr *instr, Loc dst, Loc a, Loc b) {
+    if (dst.kind == LOC_NONE) return true;
+    if (a.kind == LOC_IMM && b.kind == LOC_IMM) {
+        return emit_move(g, loc_make(LOC_IMM, cmp_evaluate(instr->cmp, a.value, b.value)), dst);
+    }
+
+    IRCmp cmp = instr->cmp;
+    return emit_compare(g, a, b, &cmp) && emit_line(g, "set%s\t%%al", cond_code(cmp)) &&
+           emit_line(g, "movzbl\t%%al, %%eax") && emit_move(g, loc_reg(REG_RAX), dst);
+}
+
+static bool emit_push(AsmGen *g, Loc src) {
+    if (src.kind == LOC_REG) return emit_line(g, "pushq\t%s", reg64_names[src.value]);
+
+    char s[32];
+    loc_text(g, src, s, sizeof(s));
+    return emit_line(g, "pushq\t%s", s);
+}
+
+/* Arguments past the sixth are pushed right to left, padded so rsp stays
+ * 16-byte aligned at the call */
+static bool emit_call(AsmGen *g, const IRInstr *instr) {
+    size_t count = instr->operand_count;
+    size_t stacked = count > ASM_ARG_REGS ? count - ASM_ARG_REGS : 0;
+    size_t pad = stacked % 2;
+
+    if (pad && !emit_line(g, "subq\t$8, %%rsp")) return false;
+    for (size_t i = count; i-- > ASM_ARG_REGS;) {
+        if (!emit_push(g, operand(g, instr->operands[i]))) return false;
+    }
+
+    Loc src[ASM_ARG_REGS], dst[ASM_ARG_REGS];
+    size_t in_regs = count < ASM_ARG_REGS ? count : ASM_ARG_REGS;
+    for (size_t i = 0; i < in_regs; i++) {
+        src[i] = operand(g, instr->operands[i]);
+        dst[i] = loc_reg(arg_regs[i]);
+    }
+    if (!emit_parallel_moves(g, src, dst, in_regs)) return false;
+
+    if (!emit_line(g, "call\t%s", instr->name ? instr->name : "?")) return false;
+    if (stacked + pad > 0 && !emit_line(g, "addq\t$%zu, %%rsp", 8 * (stacked + pad))) return false;
+    return emit_move(g, loc_reg(REG_RAX), dest_loc(g, instr->dest));
+}
+
+static bool emit_print(AsmGen *g, Loc value) {
+    g->uses_print = true;
+    return emit_move(g, value, loc_reg(REG_RSI)) &&
+           emit_line(g, "leaq\t.Lprint_format(%%rip), %%rdi") &&
+           emit_line(g, "xorl\t%%eax, %%eax") &&
+           emit_line(g, "call\tprintf@PLT");
+}
+
+static bool emit_epilogue(AsmGen *g) {
+    if (g->saved_count == 0) return emit_line(g, "leave") && emit_line(g, "ret");
+
+    if (!emit_line(g, "leaq\t%d(%%rbp), %%rsp", -8 * g->saved_count)) return false;
+    for (int i = g->saved_count; i-- > 0;) {
+        if (!emit_line(g, "popq\t%s", reg64_names[g->saved[i]])) return false;
+    }
+    return emit_line(g, "popq\t%%rbp") && emit_line(g, "ret");
+}
+
+static bool emit_cond_branch(AsmGen *g, size_t b, const IRInstr *instr, const IRInstr *compare) {
+    size_t if_true = ir_function_find_block(g->func, instr->labels[0]);
+    size_t if_false = ir_function_find_block(g->func, instr->labels[1]);
+    if (if_true == (size_t)-1 || if_false == (size_t)-1) return false;
+
+    IRCmp cmp;
+    if (compare) {
+        Loc a = operand(g, compare->operands[0]);
+        Loc c = operand(g, compare->operands[1]);
+        if (a.kind == LOC_IMM && c.kind == LOC_IMM) {
+            bool taken = cmp_evaluate(compare->cmp, a.value, c.value);
+            return emit_jump(g, b, taken ? if_true : if_false);
+        }
+        cmp = compare->cmp;
+        if (!emit_compare(g, a, c, &cmp)) return false;
+    } else {
+        Loc c = operand(g, instr->operands[0]);
+        if (c.kind == LOC_IMM) return emit_jump(g, b, c.value ? if_true : if_false);
+        cmp = IR_CMP_NE;
+        if (!emit_compare(g, c, loc_make(LOC_IMM, 0), &cmp)) return false;
+    }
+
+    bool true_moves = phi_count(g->func->blocks[if_true]) > 0;
+    bool false_moves = phi_count(g->func->blocks[if_false]) > 0;
+
+    if (!false_moves && (true_moves || if_true == b + 1)) {
+        return emit_line(g, "j%s\t.LBB%zu_%zu", cond_code(cmp_inverse(cmp)), g->func_index,
+                         if_false) &&
+               emit_jump(g, b, if_true);
+    }
+    if (!true_moves) {
+        return emit_line(g, "j%s\t.LBB%zu_%zu", cond_code(cmp), g->func_index, if_true) &&
+               emit_jump(g, b, if_false);
+    }
+
+    /* Both edges move phis: the true edge's moves go in a stub after the
+     * false edge, which therefore always jumps */
+    int stub = g->stub_count++;
+    return emit_line(g, "j%s\t.Ltmp%d", cond_code(cmp), stub) &&
+           emit_edge_moves(g, b, if_false) &&
+           emit_line(g, "jmp\t.LBB%zu_%zu", g->func_index, if_false) &&
+           asm_appendf(g, ".Ltmp%d:\n", stub) &&
+           emit_jump(g, b, if_true);
+}
+
+static bool emit_instr(AsmGen *g, size_t b, size_t i) {
+    const IRBlock *block = g->func->blocks[b];
+    const IRInstr *instr = &block->instrs[i];
+    Loc dst = dest_loc(g, instr->dest);
+    Loc ops[3];
+    for (size_t j = 0; j < 3; j++) {
+        ops[j] = j < instr->operand_count ? operand(g, instr->operands[j]) : loc_make(LOC_IMM, 0);
+    }
+
+    switch (instr->op) {
+        case IR_CONST:
+        case IR_PHI:
+            return true;
+
+        case IR_ADD:   return emit_add(g, dst, ops[0], ops[1]);
+        case IR_SUB:   return emit_sub(g, dst, ops[0], ops[1]);
+        case IR_MUL:   return emit_mul(g, dst, ops[0], ops[1]);
+        case IR_DIV:   return emit_divide(g, false, dst, ops[0], ops[1]);
+        case IR_MOD:   return emit_divide(g, true, dst, ops[0], ops[1]);
+        case IR_SHL:   return emit_shift(g, "sall", dst, ops[0], ops[1]);
+        case IR_ASHR:  return emit_shift(g, "sarl", dst, ops[0], ops[1]);
+        case IR_LSHR:  return emit_shift(g, "shrl", dst, ops[0], ops[1]);
+        case IR_MULHI: return emit_mulhi(g, dst, ops[0], ops[1]);
+        case IR_AND:   return emit_binary(g, "andl", true, dst, ops[0], ops[1]);
+        case IR_OR:    return emit_binary(g, "orl", true, dst, ops[0], ops[1]);
+        case IR_NOT:   return emit_binary(g, "xorl", true, dst, ops[0], loc_make(LOC_IMM, 1));
+        case IR_SELECT: return emit_select(g, dst, ops[0], ops[1], ops[2]);
+        case IR_CALL:  return emit_call(g, instr);
+        case IR_PRINT: return emit_print(g, ops[0]);
+
+        case IR_ICMP:
+            /* A fused compare is emitted by the branch that follows */
+            return is_fused_compare(g, block, i) || emit_icmp(g, instr, dst, ops[0], ops[1]);
+
+        case IR_BR: {
+            if (instr->label_count < 1) return false;
+            size_t target = ir_function_find_block(g->func, instr->labels[0]);
+            return target != (size_t)-1 && emit_jump(g, b, target);
+        }
+
+        case IR_COND_BR: {
+            if (instr->label_count < 2 || instr->operand_count < 1) return false;
+            bool fused = i > 0 && is_fused_compare(g, block, i - 1);
+            return emit_cond_branch(g, b, instr, fused ? &block->instrs[i - 1] : NULL);
+        }
+
+        case IR_RET:
+            if (instr->operand_count > 0 && !emit_move(g, ops[0], loc_reg(REG_RAX))) return false;
+            return emit_epilogue(g);
+
+        case IR_LOAD:
+        case IR_STORE:
+        case IR_ALLOCA:
+            break;      /* Gone once the function is in SSA form */
+    }
+    return false;
+}
+
+/* ==============================================================================
+ * Functions & Module
+ * ==============================================================================
+ */
+
+static bool emit_prologue(AsmGen *g) {
+    const IRFunction *func = g->func;
+    bool is_main = strcmp(func->name, "main") == 0;
+
+    if (!asm_appendf(g, "\n\t.p2align 4\n")) return false;
+    if (is_main && !asm_appendf(g, "\t.globl\t%s\n", func->name)) return false;
+    if (!asm_appendf(g, "\t.type\t%s, @function\n%s:\n", func->name, func->name)) return false;
+
+    if (!emit_line(g, "pushq\t%%rbp") || !emit_line(g, "movq\t%%rsp, %%rbp")) return false;
+    for (int i = 0; i < g->saved_count; i++) {
+        if (!emit_line(g, "pushq\t%s", reg64_names[g->saved[i]])) return false;
+    }
+
+    /* Keep rsp 16-byte aligned below the saved registers and slots */
+    int frame = 8 * g->slot_count;
+    if ((8 * g->saved_count + frame) % 16 != 0) frame += 8;
+    if (frame > 0 && !emit_line(g, "subq\t$%d, %%rsp", frame)) return false;
+
+    /* Parameters move from their ABI homes to their allocated locations */
+    size_t count = func->param_count;
+    if (count == 0) return true;
+
+    Loc *src = malloc(2 * count * sizeof(Loc));
+    if (!src) return false;
+    Loc *dst = src + count;
+    for (size_t i = 0; i < count; i++) {
+        src[i] = i < ASM_ARG_REGS ? loc_reg(arg_regs[i]) : loc_make(LOC_ARG, (int32_t)i);
+        dst[i] = g->intervals[i].loc;
+    }
+    bool ok = emit_parallel_moves(g, src, dst, count);
+    free(src);
+    return ok;
+}
+
+static bool emit_function(AsmGen *g, size_t index) {
+    const IRFunction *func = g->module->functions[index];
+    size_t temps = (size_t)g->module->temp_count;
+
+    g->func = func;
+    g->func_index = index;
+    g->value_count = 0;
+    g->call_count = 0;
+    g->slot_count = 0;
+    g->saved_count = 0;
+
+    size_t instrs = 0;
+    for (size_t b = 0; b < func->block_count; b++) {
+        instrs += func->blocks[b]->instr_count;
+    }
+
+    g->def_of = calloc(temps + 1, sizeof(const IRInstr *));
+    g->use_count = calloc(temps + 1, sizeof(int));
+    g->value_of = malloc((temps + 1) * sizeof(int));
+    g->intervals = malloc((temps + func->param_count + 1) * sizeof(Interval));
+    g->block_end = malloc((func->block_count + 1) * sizeof(int));
+    g->calls = malloc((instrs + 1) * sizeof(int));
+
+    bool ok = g->def_of && g->use_count && g->value_of && g->intervals && g->block_end &&
+              g->calls && ir_function_compute_cfg((IRModule *)g->module, (IRFunction *)func);
+    if (ok) {
+        for (size_t t = 0; t < temps; t++) g->value_of[t] = -1;
+        number_values(g);
+        ok = build_intervals(g) && allocate_registers(g) && emit_prologue(g);
+    }
+
+    for (size_t b = 0; ok && b < func->block_count; b++) {
+        const IRBlock *block = func->blocks[b];
+        size_t length = block_length(block);
+
+        ok = emit_block_label(g, b);
+        for (size_t i = 0; ok && i < length; i++) {
+            ok = emit_instr(g, b, i);
+        }
+
+        /* An unterminated block falls through; the last one returns */
+        if (ok && !ir_block_is_terminated(block)) {
+            ok = b + 1 < func->block_count
+                ? emit_edge_moves(g, b, b + 1)
+                : emit_line(g, "xorl\t%%eax, %%eax") && emit_epilogue(g);
+        }
+    }
+    if (ok && func->block_count == 0) {
+        ok = emit_line(g, "xorl\t%%eax, %%eax") && emit_epilogue(g);
+    }
+    ok = ok && asm_appendf(g, "\t.size\t%s, .-%s\n", func->name, func->name);
+
+    free(g->def_of);
+    free(g->use_count);
+    free(g->value_of);
+    free(g->intervals);
+    free(g->block_end);
+    free(g->calls);
+    g->def_of = NULL;
+    g->use_count = NULL;
+    g->value_of = NULL;
+    g->intervals = NULL;
+    g->block_end = NULL;
+    g->calls = NULL;
+    return ok;
+}
+
+char *generate_asm_code(ASTProgram *program, CompilerConfig *config) {
+    IRModule *module = ir_build_module(program);
+    if (!module) return NULL;
+
+    /* Registers are allocated to SSA values, so promote at every level */
+    if (!ir_module_to_ssa(module)) {
+        ir_module_destroy(module);
+        return NULL;
+    }
+
+    AsmGen g;
+    memset(&g, 0, sizeof(g));
+    g.config = config;
+    g.module = module;
+
+    bool ok = true;
+    if (config && config->emit_comments) {
+        ok = asm_appendf(&g, "# Generated by TinyLLVM Compiler\n") &&
+             asm_appendf(&g, "# Target: x86-64 assembly (GNU as, System V ABI)\n\n");
+    }
+    ok = ok && asm_appendf(&g, "\t.text\n");
+
+    for (size_t i = 0; ok && i < module->func_count; i++) {
+        ok = emit_function(&g, i);
+    }
+
+    if (ok && g.uses_print) {
+        ok = asm_appendf(&g, "\n\t.section\t.rodata\n.Lprint_format:\n\t.string\t\"%%d\\n\"\n");
+    }
+    ok = ok && asm_appendf(&g, "\n\t.section\t.note.GNU-stack,\"\",@progbits\n");
+
+    ir_module_destroy(module);
+    if (!ok) {
+        free(g.output);
+        return NULL;
+    }
+    return g.output;
+}
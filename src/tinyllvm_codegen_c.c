@@ -11,6 +11,7 @@
 #include <string.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <limits.h>
 
 /* ==============================================================================
  * Code Generation State
@@ -84,6 +85,98 @@ static bool codegen_indent(CodeGen *gen) {
 static bool generate_expression(CodeGen *gen, ASTExpr *expr);
 static bool generate_statement(CodeGen *gen, ASTStmt *stmt);
 
+/* ==============================================================================
+ * C Code Generation - Overflow Checks
+ * ==============================================================================
+ */
+
+/* Trapping arithmetic helpers, emitted when config->overflow_checks is set */
+static const char overflow_check_runtime[] =
+    "#include <stdlib.h>\n\n"
+    "static void tinyllvm_trap(const char *what) {\n"
+    "    fprintf(stderr, \"runtime error: %s\\n\", what);\n"
+    "    abort();\n"
+    "}\n\n"
+    "static inline int tinyllvm_checked_add(int a, int b) {\n"
+    "    int r;\n"
+    "    if (__builtin_add_overflow(a, b, &r)) tinyllvm_trap(\"integer overflow\");\n"
+    "    return r;\n"
+    "}\n\n"
+    "static inline int tinyllvm_checked_sub(int a, int b) {\n"
+    "    int r;\n"
+    "    if (__builtin_sub_overflow(a, b, &r)) tinyllvm_trap(\"integer overflow\");\n"
+    "    return r;\n"
+    "}\n\n"
+    "static inline int tinyllvm_checked_mul(int a, int b) {\n"
+    "    int r;\n"
+    "    if (__builtin_mul_overflow(a, b, &r)) tinyllvm_trap(\"integer overflow\");\n"
+    "    return r;\n"
+    "}\n\n"
+    "static inline int tinyllvm_checked_div(int a, int b) {\n"
+    "    if (b == 0) tinyllvm_trap(\"division by zero\");\n"
+    "    if (a == (-2147483647 - 1) && b == -1) tinyllvm_trap(\"integer overflow\");\n"
+    "    return a / b;\n"
+    "}\n\n"
+    "static inline int tinyllvm_checked_mod(int a, int b) {\n"
+    "    if (b == 0) tinyllvm_trap(\"division by zero\");\n"
+    "    if (a == (-2147483647 - 1) && b == -1) tinyllvm_trap(\"integer overflow\");\n"
+    "    return a % b;\n"
+    "}\n\n";
+
+static const char *checked_helper(ExprKind kind) {
+    switch (kind) {
+        case EXPR_ADD: return "tinyllvm_checked_add";
+        case EXPR_SUB: return "tinyllvm_checked_sub";
+        case EXPR_MUL: return "tinyllvm_checked_mul";
+        case EXPR_DIV: return "tinyllvm_checked_div";
+        case EXPR_MOD: return "tinyllvm_checked_mod";
+        default:       return NULL;
+    }
+}
+
+/* Range analysis marks the operations that cannot overflow or trap */
+static bool needs_overflow_check(const CodeGen *gen, const ASTExpr *expr) {
+    return gen->config && gen->config->overflow_checks &&
+           checked_helper(expr->kind) && !expr->overflow_safe;
+}
+
+static bool generate_checked_operation(CodeGen *gen, ASTExpr *expr) {
+    if (!codegen_append(gen, checked_helper(expr->kind))) return false;
+    if (!codegen_append(gen, "(")) return false;
+    if (!generate_expression(gen, expr->data.binary.left)) return false;
+    if (!codegen_append(gen, ", ")) return false;
+    if (!generate_expression(gen, expr->data.binary.right)) return false;
+    return codegen_append(gen, ")");
+}
+
+static bool is_wrapping_operation(const ASTExpr *expr) {
+    return expr->wraps &&
+           (expr->kind == EXPR_ADD || expr->kind == EXPR_SUB || expr->kind == EXPR_MUL);
+}
+
+/* expr as an unsigned value; nested wrapping operations stay unsigned */
+static bool generate_unsigned_operand(CodeGen *gen, ASTExpr *expr) {
+    if (!is_wrapping_operation(expr)) {
+        if (!codegen_append(gen, "(unsigned)")) return false;
+        return generate_expression(gen, expr);
+    }
+
+    const char *op = expr->kind == EXPR_ADD ? " + " : expr->kind == EXPR_SUB ? " - " : " * ";
+    if (!codegen_append(gen, "(")) return false;
+    if (!generate_unsigned_operand(gen, expr->data.binary.left)) return false;
+    if (!codegen_append(gen, op)) return false;
+    if (!generate_unsigned_operand(gen, expr->data.binary.right)) return false;
+    return codegen_append(gen, ")");
+}
+
+/* Reassociated chains are computed in unsigned so regrouped partial results
+ * wrap like the IR instead of overflowing int */
+static bool generate_wrapping_operation(CodeGen *gen, ASTExpr *expr) {
+    if (!codegen_append(gen, "((int)")) return false;
+    if (!generate_unsigned_operand(gen, expr)) return false;
+    return codegen_append(gen, ")");
+}
+
 /* ==============================================================================
  * C Code Generation - Expressions
  * ==============================================================================
@@ -92,8 +185,19 @@ static bool generate_statement(CodeGen *gen, ASTStmt *stmt);
 static bool generate_expression(CodeGen *gen, ASTExpr *expr) {
     if (!expr) return false;
     
+    if (needs_overflow_check(gen, expr)) {
+        return generate_checked_operation(gen, expr);
+    }
+    if (is_wrapping_operation(expr)) {
+        return generate_wrapping_operation(gen, expr);
+    }
+    
     switch (expr->kind) {
         case EXPR_INT_LITERAL:
+            /* Folded literals may be negative; INT_MIN has no int literal in C */
+            if (expr->data.int_lit.value == INT_MIN) {
+                return codegen_append(gen, "(-2147483647 - 1)");
+            }
             return codegen_appendf(gen, "%d", expr->data.int_lit.value);
             
         case EXPR_BOOL_LITERAL:
@@ -142,6 +246,39 @@ static bool generate_expression(CodeGen *gen, ASTExpr *expr) {
             if (!codegen_append(gen, ")")) return false;
             return true;
             
+        /* Lowered arithmetic: shifts go through unsigned to wrap like the IR */
+        case EXPR_SHL:
+            if (!codegen_append(gen, "((int)((unsigned)")) return false;
+            if (!generate_expression(gen, expr->data.binary.left)) return false;
+            if (!codegen_append(gen, " << ")) return false;
+            if (!generate_expression(gen, expr->data.binary.right)) return false;
+            if (!codegen_append(gen, "))")) return false;
+            return true;
+
+        case EXPR_SHR:
+            if (!codegen_append(gen, "(")) return false;
+            if (!generate_expression(gen, expr->data.binary.left)) return false;
+            if (!codegen_append(gen, " >> ")) return false;
+            if (!generate_expression(gen, expr->data.binary.right)) return false;
+            if (!codegen_append(gen, ")")) return false;
+            return true;
+
+        case EXPR_USHR:
+            if (!codegen_append(gen, "((int)((unsigned)")) return false;
+            if (!generate_expression(gen, expr->data.binary.left)) return false;
+            if (!codegen_append(gen, " >> ")) return false;
+            if (!generate_expression(gen, expr->data.binary.right)) return false;
+            if (!codegen_append(gen, "))")) return false;
+            return true;
+
+        case EXPR_MULHI:
+            if (!codegen_append(gen, "((int)(((long long)")) return false;
+            if (!generate_expression(gen, expr->data.binary.left)) return false;
+            if (!codegen_append(gen, " * ")) return false;
+            if (!generate_expression(gen, expr->data.binary.right)) return false;
+            if (!codegen_append(gen, ") >> 32))")) return false;
+            return true;
+
         case EXPR_EQ:
             if (!codegen_append(gen, "(")) return false;
             if (!generate_expression(gen, expr->data.binary.left)) return false;
@@ -237,6 +374,16 @@ static bool generate_expression(CodeGen *gen, ASTExpr *expr) {
             if (!codegen_append(gen, ")")) return false;
             return true;
             
+        case EXPR_SELECT:
+            if (!codegen_append(gen, "(")) return false;
+            if (!generate_expression(gen, expr->data.select.condition)) return false;
+            if (!codegen_append(gen, " ? ")) return false;
+            if (!generate_expression(gen, expr->data.select.then_expr)) return false;
+            if (!codegen_append(gen, " : ")) return false;
+            if (!generate_expression(gen, expr->data.select.else_expr)) return false;
+            if (!codegen_append(gen, ")")) return false;
+            return true;
+            
         default:
             return false;
     }
@@ -247,6 +394,45 @@ static bool generate_expression(CodeGen *gen, ASTExpr *expr) {
  * ==============================================================================
  */
 
+/* `if (c) { do { body } while (c); }` for loops marked by loop rotation */
+static bool generate_rotated_loop(CodeGen *gen, ASTStmt *stmt) {
+    ASTExpr *condition = stmt->data.while_stmt.condition;
+    ASTStmt *body = stmt->data.while_stmt.body;
+
+    if (!codegen_indent(gen)) return false;
+    if (!codegen_append(gen, "if (")) return false;
+    if (!generate_expression(gen, condition)) return false;
+    if (!codegen_append(gen, ") {\n")) return false;
+    gen->indent_level++;
+
+    if (!codegen_indent(gen)) return false;
+    if (!codegen_append(gen, "do {\n")) return false;
+    gen->indent_level++;
+
+    bool ok = true;
+    if (body->kind == STMT_BLOCK) {
+        for (size_t i = 0; i < body->data.block.stmt_count && ok; i++) {
+            ok = generate_statement(gen, body->data.block.statements[i]);
+        }
+    } else {
+        ok = generate_statement(gen, body);
+    }
+    gen->indent_level--;
+    if (!ok) {
+        gen->indent_level--;
+        return false;
+    }
+
+    if (!codegen_indent(gen)) return false;
+    if (!codegen_append(gen, "} while (")) return false;
+    if (!generate_expression(gen, condition)) return false;
+    if (!codegen_append(gen, ");\n")) return false;
+
+    gen->indent_level--;
+    if (!codegen_indent(gen)) return false;
+    return codegen_append(gen, "}\n");
+}
+
 static bool generate_statement(CodeGen *gen, ASTStmt *stmt) {
     if (!stmt) return false;
     
@@ -286,6 +472,7 @@ static bool generate_statement(CodeGen *gen, ASTStmt *stmt) {
             return true;
             
         case STMT_WHILE:
+            if (stmt->data.while_stmt.rotated) return generate_rotated_loop(gen, stmt);
             if (!codegen_indent(gen)) return false;
             if (!codegen_append(gen, "while (")) return false;
             if (!generate_expression(gen, stmt->data.while_stmt.condition)) return false;
@@ -337,6 +524,74 @@ static bool generate_statement(CodeGen *gen, ASTStmt *stmt) {
  * ==============================================================================
  */
 
+/* The implementation called by a memoized wrapper `{ return impl(params...); }` */
+static const char *memo_impl_name(const ASTFunc *func) {
+    const ASTStmt *body = func->body;
+    if (func->memo_slots == 0 || !body || body->kind != STMT_BLOCK ||
+        body->data.block.stmt_count != 1) {
+        return NULL;
+    }
+
+    const ASTStmt *ret = body->data.block.statements[0];
+    if (ret->kind != STMT_RETURN || !ret->data.return_stmt.expr ||
+        ret->data.return_stmt.expr->kind != EXPR_CALL) {
+        return NULL;
+    }
+    return ret->data.return_stmt.expr->data.call.func_name;
+}
+
+/*
+ * Direct-mapped result cache: hash the arguments into a slot, return the
+ * stored value when the slot holds the same arguments, otherwise call the
+ * implementation and overwrite the slot.
+ */
+static bool generate_memo_body(CodeGen *gen, const ASTFunc *func, const char *impl) {
+    const char *ret_type = type_to_string(func->return_type);
+
+    if (!codegen_append(gen, "{\n    static struct { bool valid;")) return false;
+    for (size_t i = 0; i < func->param_count; i++) {
+        if (!codegen_appendf(gen, " %s arg%zu;",
+                             type_to_string(func->params[i].type), i)) return false;
+    }
+    if (!codegen_appendf(gen, " %s value; } %s_cache[%zu];\n",
+                         ret_type, impl, func->memo_slots)) return false;
+
+    if (!codegen_appendf(gen, "    unsigned %s_slot = 0u;\n", impl)) return false;
+    for (size_t i = 0; i < func->param_count; i++) {
+        if (!codegen_appendf(gen, "    %s_slot = (%s_slot ^ (unsigned)%s) * 2654435761u;\n",
+                             impl, impl, func->params[i].name)) return false;
+    }
+    if (!codegen_appendf(gen, "    %s_slot &= %zuu;\n", impl, func->memo_slots - 1)) {
+        return false;
+    }
+
+    if (!codegen_appendf(gen, "    if (%s_cache[%s_slot].valid", impl, impl)) return false;
+    for (size_t i = 0; i < func->param_count; i++) {
+        if (!codegen_appendf(gen, " && %s_cache[%s_slot].arg%zu == %s",
+                             impl, impl, i, func->params[i].name)) return false;
+    }
+    if (!codegen_appendf(gen, ") {\n        return %s_cache[%s_slot].value;\n    }\n",
+                         impl, impl)) return false;
+
+    if (!codegen_appendf(gen, "    %s_cache[%s_slot].value = %s(", impl, impl, impl)) {
+        return false;
+    }
+    for (size_t i = 0; i < func->param_count; i++) {
+        if (!codegen_appendf(gen, "%s%s", i > 0 ? ", " : "", func->params[i].name)) {
+            return false;
+        }
+    }
+    if (!codegen_append(gen, ");\n")) return false;
+
+    for (size_t i = 0; i < func->param_count; i++) {
+        if (!codegen_appendf(gen, "    %s_cache[%s_slot].arg%zu = %s;\n",
+                             impl, impl, i, func->params[i].name)) return false;
+    }
+    return codegen_appendf(gen, "    %s_cache[%s_slot].valid = true;\n"
+                                "    return %s_cache[%s_slot].value;\n}\n",
+                           impl, impl, impl, impl);
+}
+
 static bool generate_function(CodeGen *gen, ASTFunc *func) {
     /* Return type */
     if (!codegen_append(gen, type_to_string(func->return_type))) return false;
@@ -364,7 +619,12 @@ static bool generate_function(CodeGen *gen, ASTFunc *func) {
     if (!codegen_append(gen, ") ")) return false;
     
     /* Body */
-    if (!generate_statement(gen, func->body)) return false;
+    const char *memo_impl = memo_impl_name(func);
+    if (memo_impl) {
+        if (!generate_memo_body(gen, func, memo_impl)) return false;
+    } else if (!generate_statement(gen, func->body)) {
+        return false;
+    }
     
     if (!codegen_append(gen, "\n")) return false;
     
@@ -385,6 +645,10 @@ static bool generate_program_c(CodeGen *gen, ASTProgram *program) {
     if (!codegen_append(gen, "#include <stdio.h>\n")) return false;
     if (!codegen_append(gen, "#include <stdbool.h>\n\n")) return false;
     
+    if (gen->config && gen->config->overflow_checks) {
+        if (!codegen_append(gen, overflow_check_runtime)) return false;
+    }
+    
     /* Forward declarations */
     for (size_t i = 0; i < program->func_count; i++) {
         ASTFunc *func = program->functions[i];
@@ -447,8 +711,10 @@ char *generate_c_code(ASTProgram *program, CompilerConfig *config) {
  * ==============================================================================
  */
 
-/* Forward declaration for IR code generator */
+/* Forward declarations for the IR, x86-64 assembly and LLVM IR generators */
 char *generate_ir_code(ASTProgram *program, CompilerConfig *config);
+char *generate_asm_code(ASTProgram *program, CompilerConfig *config);
+char *generate_llvm_code(ASTProgram *program, CompilerConfig *config);
 
 EventResult compiler_codegen_event(EventContext *context, void *user_data) {
     CompilerConfig *config = (CompilerConfig *)user_data;
@@ -472,6 +738,10 @@ EventResult compiler_codegen_event(EventContext *context, void *user_data) {
         output = generate_c_code(program, config);
     } else if (config->target == TARGET_TINYLLVM) {
         output = generate_ir_code(program, config);  // FIXED: Use IR generator!
+    } else if (config->target == TARGET_ASM_X86_64 || config->target == TARGET_ELF_X86_64) {
+        output = generate_asm_code(program, config);
+    } else if (config->target == TARGET_LLVM) {
+        output = generate_llvm_code(program, config);
     } else {
         event_result_failure(&result, "Unsupported code generation target",
                            EC_ERROR_INVALID_PARAMETER, ERROR_DETAIL_FULL);
@@ -3,97 +3,147 @@
  * TinyLLVM Compiler - IR Code Generator
  * ==============================================================================
  *
- * Generates TinyLLVM IR (human-readable intermediate representation) from AST.
+ * Lowers a typed AST to an in-memory IRModule (tinyllvm_ir.h), which
+ * ir_print_module writes as TinyLLVM IR for TARGET_TINYLLVM. Optimized
+ * builds first promote variables to SSA values (tinyllvm_ir_ssa.c).
  *
  * IR Format:
- *   - SSA-like format with explicit temporaries
+ *   - Explicit temporaries; variables in alloca'd slots, or SSA with phi
+ *     nodes once promoted
  *   - Simple instruction set: load, store, add, sub, mul, div, etc.
- *   - Labels for control flow
+ *   - Labels for control flow; && and || branch around their right operand
+ *     and join with phi
  *   - Function definitions with entry/exit blocks
  */
 
 #include "include/tinyllvm_compiler.h"
+#include "include/tinyllvm_ir.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
-#include <stdarg.h>
 
 /* ==============================================================================
- * IR Generation State
+ * IR Builder State
  * ==============================================================================
  */
 
 typedef struct {
-    char *output;
-    size_t length;
-    size_t capacity;
-    int indent_level;
-
-    /* Temporary variable counter */
-    int temp_counter;
-
-    /* Label counter */
-    int label_counter;
+    IRModule *module;
+    IRFunction *func;
+
+    /* Block receiving instructions */
+    IRBlock *block;
+
+    /* Statement nesting, recorded on each instruction for printing */
+    int depth;
+
+    /* Label of the last labeled block (IR_LABEL_ENTRY at first), for phi
+     * operands */
+    int current_block;
+
+    /* Variables in scope, innermost last, and the slot each lives in. A
+     * declaration shadowing a visible variable gets its own slot, name.N */
+    const char **scope_names;
+    const char **scope_slots;
+    size_t scope_count;
+    size_t scope_capacity;
+} IRBuilder;
+
+static const char *ir_lookup_slot(const IRBuilder *b, const char *name) {
+    for (size_t i = b->scope_count; i-- > 0;) {
+        if (strcmp(b->scope_names[i], name) == 0) return b->scope_slots[i];
+    }
+    return name;
+}
 
-    CompilerConfig *config;
-} IRCodeGen;
+static const char *ir_new_slot(IRBuilder *b, const char *name) {
+    size_t shadowed = 0;
+    for (size_t i = 0; i < b->scope_count; i++) {
+        if (strcmp(b->scope_names[i], name) == 0) shadowed++;
+    }
+    if (shadowed == 0) return name;
 
-static bool ir_codegen_grow(IRCodeGen *gen, size_t additional) {
-    size_t needed = gen->length + additional + 1;
-    if (needed <= gen->capacity) return true;
+    size_t size = strlen(name) + 24;
+    char *slot = ir_arena_alloc(&b->module->arena, size);
+    if (slot) snprintf(slot, size, "%s.%zu", name, shadowed);
+    return slot;
+}
 
-    size_t new_capacity = gen->capacity == 0 ? 1024 : gen->capacity;
-    while (new_capacity < needed) {
-        new_capacity *= 2;
+static bool ir_bind(IRBuilder *b, const char *name, const char *slot) {
+    if (b->scope_count >= b->scope_capacity) {
+        size_t new_capacity = b->scope_capacity == 0 ? 16 : b->scope_capacity * 2;
+        const char **names = realloc(b->scope_names, new_capacity * sizeof(const char *));
+        if (!names) return false;
+        b->scope_names = names;
+
+        const char **slots = realloc(b->scope_slots, new_capacity * sizeof(const char *));
+        if (!slots) return false;
+        b->scope_slots = slots;
+        b->scope_capacity = new_capacity;
     }
 
-    char *new_output = realloc(gen->output, new_capacity);
-    if (!new_output) return false;
-
-    gen->output = new_output;
-    gen->capacity = new_capacity;
+    b->scope_names[b->scope_count] = name;
+    b->scope_slots[b->scope_count] = slot;
+    b->scope_count++;
     return true;
 }
 
-static bool ir_codegen_append(IRCodeGen *gen, const char *str) {
-    size_t len = strlen(str);
-    if (!ir_codegen_grow(gen, len)) return false;
+static IRInstr *ir_emit(IRBuilder *b, IRInstr *instr) {
+    /* Code after a terminator (statements following a return) starts an
+     * unlabeled, unreachable block */
+    if (ir_block_is_terminated(b->block)) {
+        b->block = ir_function_add_block(b->module, b->func, IR_LABEL_NONE);
+        if (!b->block) return NULL;
+    }
+
+    instr->depth = b->depth;
+    return ir_block_append(b->module, b->block, instr);
+}
 
-    memcpy(gen->output + gen->length, str, len);
-    gen->length += len;
-    gen->output[gen->length] = '\0';
+static bool ir_begin_block(IRBuilder *b, int label) {
+    IRBlock *block = ir_function_add_block(b->module, b->func, label);
+    if (!block) return false;
 
+    b->block = block;
+    b->current_block = label;
     return true;
 }
 
-static bool ir_codegen_appendf(IRCodeGen *gen, const char *format, ...) {
-    char buffer[1024];
-
-    va_list args;
-    va_start(args, format);
-    int len = vsnprintf(buffer, sizeof(buffer), format, args);
-    va_end(args);
+static IRValue ir_temp(int index) {
+    return (IRValue){ .kind = IR_VALUE_TEMP, .index = index };
+}
 
-    if (len < 0 || (size_t)len >= sizeof(buffer)) {
-        return false;
-    }
+static bool ir_emit_br(IRBuilder *b, int label) {
+    IRInstr instr = { .op = IR_BR, .dest = IR_NO_TEMP, .labels = &label, .label_count = 1 };
+    return ir_emit(b, &instr) != NULL;
+}
 
-    return ir_codegen_append(gen, buffer);
+static bool ir_emit_cond_br(IRBuilder *b, int cond_temp, int true_label, int false_label) {
+    IRValue cond = ir_temp(cond_temp);
+    int labels[2] = { true_label, false_label };
+    IRInstr instr = {
+        .op = IR_COND_BR, .dest = IR_NO_TEMP,
+        .operands = &cond, .operand_count = 1,
+        .labels = labels, .label_count = 2
+    };
+    return ir_emit(b, &instr) != NULL;
 }
 
-static bool ir_codegen_indent(IRCodeGen *gen) {
-    for (int i = 0; i < gen->indent_level; i++) {
-        if (!ir_codegen_append(gen, "  ")) return false;
-    }
-    return true;
+static bool ir_emit_store(IRBuilder *b, IRValue value, const char *name) {
+    IRInstr instr = {
+        .op = IR_STORE, .type = IR_TYPE_I32, .dest = IR_NO_TEMP, .name = name,
+        .operands = &value, .operand_count = 1
+    };
+    return ir_emit(b, &instr) != NULL;
 }
 
-static int ir_get_next_temp(IRCodeGen *gen) {
-    return gen->temp_counter++;
+static bool ir_emit_alloca(IRBuilder *b, const char *name) {
+    IRInstr instr = { .op = IR_ALLOCA, .type = IR_TYPE_I32, .dest = IR_NO_TEMP, .name = name };
+    return ir_emit(b, &instr) != NULL;
 }
 
-static int ir_get_next_label(IRCodeGen *gen) {
-    return gen->label_counter++;
+static IRType ir_type_of(Type type) {
+    return type.kind == TYPE_BOOL ? IR_TYPE_I1 : IR_TYPE_I32;
 }
 
 /* ==============================================================================
@@ -101,402 +151,422 @@ static int ir_get_next_label(IRCodeGen *gen) {
  * ==============================================================================
  */
 
-static int ir_generate_expression(IRCodeGen *gen, ASTExpr *expr);
-static bool ir_generate_statement(IRCodeGen *gen, ASTStmt *stmt);
+static int ir_generate_expression(IRBuilder *b, ASTExpr *expr);
+static bool ir_generate_statement(IRBuilder *b, ASTStmt *stmt);
 
 /* ==============================================================================
- * IR Code Generation - Expressions
+ * IR Generation - Expressions
  * ==============================================================================
  */
 
-static int ir_generate_expression(IRCodeGen *gen, ASTExpr *expr) {
-    if (!expr) return -1;
-
-    int result_temp = ir_get_next_temp(gen);
-
+/* Cheap enough, and unable to trap or call, to evaluate unconditionally */
+static bool ir_expr_is_trivial(const ASTExpr *expr) {
     switch (expr->kind) {
         case EXPR_INT_LITERAL:
-            if (!ir_codegen_indent(gen)) return -1;
-            if (!ir_codegen_appendf(gen, "%%t%d = const i32 %d\n",
-                                   result_temp, expr->data.int_lit.value)) return -1;
-            return result_temp;
-
         case EXPR_BOOL_LITERAL:
-            if (!ir_codegen_indent(gen)) return -1;
-            if (!ir_codegen_appendf(gen, "%%t%d = const i1 %d\n",
-                                   result_temp, expr->data.bool_lit.value ? 1 : 0)) return -1;
-            return result_temp;
-
         case EXPR_VAR:
-            if (!ir_codegen_indent(gen)) return -1;
-            if (!ir_codegen_appendf(gen, "%%t%d = load %%%s\n",
-                                   result_temp, expr->data.var.name)) return -1;
-            return result_temp;
-
-        case EXPR_ADD: {
-            int left_temp = ir_generate_expression(gen, expr->data.binary.left);
-            if (left_temp < 0) return -1;
-            int right_temp = ir_generate_expression(gen, expr->data.binary.right);
-            if (right_temp < 0) return -1;
-
-            if (!ir_codegen_indent(gen)) return -1;
-            if (!ir_codegen_appendf(gen, "%%t%d = add i32 %%t%d, %%t%d\n",
-                                   result_temp, left_temp, right_temp)) return -1;
-            return result_temp;
-        }
-
-        case EXPR_SUB: {
-            int left_temp = ir_generate_expression(gen, expr->data.binary.left);
-            if (left_temp < 0) return -1;
-            int right_temp = ir_generate_expression(gen, expr->data.binary.right);
-            if (right_temp < 0) return -1;
-
-            if (!ir_codegen_indent(gen)) return -1;
-            if (!ir_codegen_appendf(gen, "%%t%d = sub i32 %%t%d, %%t%d\n",
-                                   result_temp, left_temp, right_temp)) return -1;
-            return result_temp;
-        }
-
-        case EXPR_MUL: {
-            int left_temp = ir_generate_expression(gen, expr->data.binary.left);
-            if (left_temp < 0) return -1;
-            int right_temp = ir_generate_expression(gen, expr->data.binary.right);
-            if (right_temp < 0) return -1;
-
-            if (!ir_codegen_indent(gen)) return -1;
-            if (!ir_codegen_appendf(gen, "%%t%d = mul i32 %%t%d, %%t%d\n",
-                                   result_temp, left_temp, right_temp)) return -1;
-            return result_temp;
-        }
-
-        case EXPR_DIV: {
-            int left_temp = ir_generate_expression(gen, expr->data.binary.left);
-            if (left_temp < 0) return -1;
-            int right_temp = ir_generate_expression(gen, expr->data.binary.right);
-            if (right_temp < 0) return -1;
-
-            if (!ir_codegen_indent(gen)) return -1;
-            if (!ir_codegen_appendf(gen, "%%t%d = div i32 %%t%d, %%t%d\n",
-                                   result_temp, left_temp, right_temp)) return -1;
-            return result_temp;
+            return true;
+        case EXPR_NOT:
+            return ir_expr_is_trivial(expr->data.unary.operand);
+        case EXPR_EQ:
+        case EXPR_NE:
+        case EXPR_LT:
+        case EXPR_LE:
+        case EXPR_GT:
+        case EXPR_GE: {
+            ExprKind left = expr->data.binary.left->kind;
+            ExprKind right = expr->data.binary.right->kind;
+            return (left == EXPR_VAR || left == EXPR_INT_LITERAL) &&
+                   (right == EXPR_VAR || right == EXPR_INT_LITERAL);
         }
+        default:
+            return false;
+    }
+}
 
-        case EXPR_MOD: {
-            int left_temp = ir_generate_expression(gen, expr->data.binary.left);
-            if (left_temp < 0) return -1;
-            int right_temp = ir_generate_expression(gen, expr->data.binary.right);
-            if (right_temp < 0) return -1;
-
-            if (!ir_codegen_indent(gen)) return -1;
-            if (!ir_codegen_appendf(gen, "%%t%d = mod i32 %%t%d, %%t%d\n",
-                                   result_temp, left_temp, right_temp)) return -1;
-            return result_temp;
-        }
+/*
+ * && and || evaluate the right operand only when the left one does not
+ * decide the result:
+ *
+ *     %l = ...                            (block B)
+ *     br i1 %l, label %Lrhs, label %Lend  (operands swapped for ||)
+ *   Lrhs:
+ *     %r = ...                            (block B')
+ *     br label %Lend
+ *   Lend:
+ *     %t = phi i1 [ %l, %B ], [ %r, %B' ]
+ *
+ * A trivial right operand is evaluated eagerly with and/or instead.
+ */
+static int ir_generate_logical(IRBuilder *b, ASTExpr *expr, int result_temp) {
+    IROpcode op = expr->kind == EXPR_AND ? IR_AND : IR_OR;
+
+    int left_temp = ir_generate_expression(b, expr->data.binary.left);
+    if (left_temp < 0) return -1;
+
+    if (ir_expr_is_trivial(expr->data.binary.right)) {
+        int right_temp = ir_generate_expression(b, expr->data.binary.right);
+        if (right_temp < 0) return -1;
+
+        IRValue ops[2] = { ir_temp(left_temp), ir_temp(right_temp) };
+        IRInstr instr = {
+            .op = op, .type = IR_TYPE_I1, .dest = result_temp,
+            .operands = ops, .operand_count = 2
+        };
+        return ir_emit(b, &instr) ? result_temp : -1;
+    }
 
-        case EXPR_EQ: {
-            int left_temp = ir_generate_expression(gen, expr->data.binary.left);
-            if (left_temp < 0) return -1;
-            int right_temp = ir_generate_expression(gen, expr->data.binary.right);
-            if (right_temp < 0) return -1;
+    int rhs_label = ir_module_new_label(b->module);
+    int end_label = ir_module_new_label(b->module);
+    int left_block = b->current_block;
+
+    bool ok = expr->kind == EXPR_AND ?
+              ir_emit_cond_br(b, left_temp, rhs_label, end_label) :
+              ir_emit_cond_br(b, left_temp, end_label, rhs_label);
+    if (!ok) return -1;
+
+    if (!ir_begin_block(b, rhs_label)) return -1;
+    int right_temp = ir_generate_expression(b, expr->data.binary.right);
+    if (right_temp < 0) return -1;
+    int right_block = b->current_block;
+    if (!ir_emit_br(b, end_label)) return -1;
+
+    if (!ir_begin_block(b, end_label)) return -1;
+    IRValue ops[2] = { ir_temp(left_temp), ir_temp(right_temp) };
+    int blocks[2] = { left_block, right_block };
+    IRInstr phi = {
+        .op = IR_PHI, .type = IR_TYPE_I1, .dest = result_temp,
+        .operands = ops, .operand_count = 2,
+        .labels = blocks, .label_count = 2
+    };
+    return ir_emit(b, &phi) ? result_temp : -1;
+}
 
-            if (!ir_codegen_indent(gen)) return -1;
-            if (!ir_codegen_appendf(gen, "%%t%d = icmp eq i32 %%t%d, %%t%d\n",
-                                   result_temp, left_temp, right_temp)) return -1;
-            return result_temp;
+static int ir_generate_call(IRBuilder *b, ASTExpr *expr, int result_temp) {
+    /* Special case for print */
+    if (strcmp(expr->data.call.func_name, "print") == 0) {
+        if (expr->data.call.arg_count > 0) {
+            int arg_temp = ir_generate_expression(b, expr->data.call.args[0]);
+            if (arg_temp < 0) return -1;
+
+            IRValue arg = ir_temp(arg_temp);
+            IRInstr instr = {
+                .op = IR_PRINT, .type = IR_TYPE_VOID, .dest = IR_NO_TEMP,
+                .operands = &arg, .operand_count = 1
+            };
+            if (!ir_emit(b, &instr)) return -1;
         }
+        return result_temp;
+    }
 
-        case EXPR_NE: {
-            int left_temp = ir_generate_expression(gen, expr->data.binary.left);
-            if (left_temp < 0) return -1;
-            int right_temp = ir_generate_expression(gen, expr->data.binary.right);
-            if (right_temp < 0) return -1;
+    /* Regular function call - first generate all arguments */
+    size_t arg_count = expr->data.call.arg_count;
+    IRValue *args = NULL;
+    if (arg_count > 0) {
+        args = malloc(arg_count * sizeof(IRValue));
+        if (!args) return -1;
+    }
 
-            if (!ir_codegen_indent(gen)) return -1;
-            if (!ir_codegen_appendf(gen, "%%t%d = icmp ne i32 %%t%d, %%t%d\n",
-                                   result_temp, left_temp, right_temp)) return -1;
-            return result_temp;
+    for (size_t i = 0; i < arg_count; i++) {
+        int arg_temp = ir_generate_expression(b, expr->data.call.args[i]);
+        if (arg_temp < 0) {
+            free(args);
+            return -1;
         }
+        args[i] = ir_temp(arg_temp);
+    }
 
-        case EXPR_LT: {
-            int left_temp = ir_generate_expression(gen, expr->data.binary.left);
-            if (left_temp < 0) return -1;
-            int right_temp = ir_generate_expression(gen, expr->data.binary.right);
-            if (right_temp < 0) return -1;
-
-            if (!ir_codegen_indent(gen)) return -1;
-            if (!ir_codegen_appendf(gen, "%%t%d = icmp lt i32 %%t%d, %%t%d\n",
-                                   result_temp, left_temp, right_temp)) return -1;
-            return result_temp;
-        }
+    IRInstr instr = {
+        .op = IR_CALL, .type = IR_TYPE_I32, .dest = result_temp,
+        .name = expr->data.call.func_name,
+        .operands = args, .operand_count = arg_count
+    };
+    bool ok = ir_emit(b, &instr) != NULL;
+    free(args);
+    return ok ? result_temp : -1;
+}
 
-        case EXPR_LE: {
-            int left_temp = ir_generate_expression(gen, expr->data.binary.left);
-            if (left_temp < 0) return -1;
-            int right_temp = ir_generate_expression(gen, expr->data.binary.right);
-            if (right_temp < 0) return -1;
+static int ir_generate_expression(IRBuilder *b, ASTExpr *expr) {
+    if (!expr) return -1;
 
-            if (!ir_codegen_indent(gen)) return -1;
-            if (!ir_codegen_appendf(gen, "%%t%d = icmp le i32 %%t%d, %%t%d\n",
-                                   result_temp, left_temp, right_temp)) return -1;
-            return result_temp;
-        }
+    int result_temp = ir_module_new_temp(b->module);
+    IRInstr instr = { .dest = result_temp, .type = IR_TYPE_I32 };
+    IRValue ops[3];
 
-        case EXPR_GT: {
-            int left_temp = ir_generate_expression(gen, expr->data.binary.left);
-            if (left_temp < 0) return -1;
-            int right_temp = ir_generate_expression(gen, expr->data.binary.right);
-            if (right_temp < 0) return -1;
+    switch (expr->kind) {
+        case EXPR_INT_LITERAL:
+            instr.op = IR_CONST;
+            instr.imm = expr->data.int_lit.value;
+            break;
 
-            if (!ir_codegen_indent(gen)) return -1;
-            if (!ir_codegen_appendf(gen, "%%t%d = icmp gt i32 %%t%d, %%t%d\n",
-                                   result_temp, left_temp, right_temp)) return -1;
-            return result_temp;
-        }
+        case EXPR_BOOL_LITERAL:
+            instr.op = IR_CONST;
+            instr.type = IR_TYPE_I1;
+            instr.imm = expr->data.bool_lit.value ? 1 : 0;
+            break;
 
+        case EXPR_VAR:
+            instr.op = IR_LOAD;
+            instr.name = ir_lookup_slot(b, expr->data.var.name);
+            break;
+
+        case EXPR_ADD:
+        case EXPR_SUB:
+        case EXPR_MUL:
+        case EXPR_DIV:
+        case EXPR_MOD:
+        case EXPR_SHL:
+        case EXPR_SHR:
+        case EXPR_USHR:
+        case EXPR_MULHI:
+        case EXPR_EQ:
+        case EXPR_NE:
+        case EXPR_LT:
+        case EXPR_LE:
+        case EXPR_GT:
         case EXPR_GE: {
-            int left_temp = ir_generate_expression(gen, expr->data.binary.left);
+            int left_temp = ir_generate_expression(b, expr->data.binary.left);
             if (left_temp < 0) return -1;
-            int right_temp = ir_generate_expression(gen, expr->data.binary.right);
+            int right_temp = ir_generate_expression(b, expr->data.binary.right);
             if (right_temp < 0) return -1;
 
-            if (!ir_codegen_indent(gen)) return -1;
-            if (!ir_codegen_appendf(gen, "%%t%d = icmp ge i32 %%t%d, %%t%d\n",
-                                   result_temp, left_temp, right_temp)) return -1;
-            return result_temp;
-        }
-
-        case EXPR_AND: {
-            int left_temp = ir_generate_expression(gen, expr->data.binary.left);
-            if (left_temp < 0) return -1;
-            int right_temp = ir_generate_expression(gen, expr->data.binary.right);
-            if (right_temp < 0) return -1;
+            switch (expr->kind) {
+                case EXPR_ADD:   instr.op = IR_ADD; break;
+                case EXPR_SUB:   instr.op = IR_SUB; break;
+                case EXPR_MUL:   instr.op = IR_MUL; break;
+                case EXPR_DIV:   instr.op = IR_DIV; break;
+                case EXPR_MOD:   instr.op = IR_MOD; break;
+                case EXPR_SHL:   instr.op = IR_SHL; break;
+                case EXPR_SHR:   instr.op = IR_ASHR; break;
+                case EXPR_USHR:  instr.op = IR_LSHR; break;
+                case EXPR_MULHI: instr.op = IR_MULHI; break;
+                case EXPR_EQ:    instr.op = IR_ICMP; instr.cmp = IR_CMP_EQ; break;
+                case EXPR_NE:    instr.op = IR_ICMP; instr.cmp = IR_CMP_NE; break;
+                case EXPR_LT:    instr.op = IR_ICMP; instr.cmp = IR_CMP_LT; break;
+                case EXPR_LE:    instr.op = IR_ICMP; instr.cmp = IR_CMP_LE; break;
+                case EXPR_GT:    instr.op = IR_ICMP; instr.cmp = IR_CMP_GT; break;
+                default:         instr.op = IR_ICMP; instr.cmp = IR_CMP_GE; break;
+            }
+            if (instr.op == IR_ICMP) instr.type = IR_TYPE_I1;
 
-            if (!ir_codegen_indent(gen)) return -1;
-            if (!ir_codegen_appendf(gen, "%%t%d = and i1 %%t%d, %%t%d\n",
-                                   result_temp, left_temp, right_temp)) return -1;
-            return result_temp;
+            ops[0] = ir_temp(left_temp);
+            ops[1] = ir_temp(right_temp);
+            instr.operands = ops;
+            instr.operand_count = 2;
+            break;
         }
 
-        case EXPR_OR: {
-            int left_temp = ir_generate_expression(gen, expr->data.binary.left);
-            if (left_temp < 0) return -1;
-            int right_temp = ir_generate_expression(gen, expr->data.binary.right);
-            if (right_temp < 0) return -1;
-
-            if (!ir_codegen_indent(gen)) return -1;
-            if (!ir_codegen_appendf(gen, "%%t%d = or i1 %%t%d, %%t%d\n",
-                                   result_temp, left_temp, right_temp)) return -1;
-            return result_temp;
-        }
+        case EXPR_AND:
+        case EXPR_OR:
+            return ir_generate_logical(b, expr, result_temp);
 
         case EXPR_NOT: {
-            int operand_temp = ir_generate_expression(gen, expr->data.unary.operand);
+            int operand_temp = ir_generate_expression(b, expr->data.unary.operand);
             if (operand_temp < 0) return -1;
 
-            if (!ir_codegen_indent(gen)) return -1;
-            if (!ir_codegen_appendf(gen, "%%t%d = xor i1 %%t%d, 1\n",
-                                   result_temp, operand_temp)) return -1;
-            return result_temp;
+            instr.op = IR_NOT;
+            instr.type = IR_TYPE_I1;
+            ops[0] = ir_temp(operand_temp);
+            instr.operands = ops;
+            instr.operand_count = 1;
+            break;
         }
 
-        case EXPR_CALL: {
-            /* Special case for print */
-            if (strcmp(expr->data.call.func_name, "print") == 0) {
-                if (expr->data.call.arg_count > 0) {
-                    int arg_temp = ir_generate_expression(gen, expr->data.call.args[0]);
-                    if (arg_temp < 0) return -1;
-
-                    if (!ir_codegen_indent(gen)) return -1;
-                    if (!ir_codegen_appendf(gen, "call void @print(i32 %%t%d)\n", arg_temp)) return -1;
-                }
-                return result_temp;
-            }
-
-            /* Regular function call - first generate all arguments */
-            int arg_temps[16];
-            for (size_t i = 0; i < expr->data.call.arg_count && i < 16; i++) {
-                arg_temps[i] = ir_generate_expression(gen, expr->data.call.args[i]);
-                if (arg_temps[i] < 0) return -1;
-            }
-
-            /* Generate call instruction */
-            if (!ir_codegen_indent(gen)) return -1;
-            if (!ir_codegen_appendf(gen, "%%t%d = call i32 @%s(",
-                                   result_temp, expr->data.call.func_name)) return -1;
-
-            for (size_t i = 0; i < expr->data.call.arg_count && i < 16; i++) {
-                if (i > 0) {
-                    if (!ir_codegen_append(gen, ", ")) return -1;
-                }
-                if (!ir_codegen_appendf(gen, "i32 %%t%d", arg_temps[i])) return -1;
-            }
-
-            if (!ir_codegen_append(gen, ")\n")) return -1;
-            return result_temp;
+        case EXPR_CALL:
+            return ir_generate_call(b, expr, result_temp);
+
+        case EXPR_SELECT: {
+            /* Both arms are evaluated; if-conversion only builds selects of
+             * arms that cannot trap or have side effects */
+            int cond_temp = ir_generate_expression(b, expr->data.select.condition);
+            if (cond_temp < 0) return -1;
+            int then_temp = ir_generate_expression(b, expr->data.select.then_expr);
+            if (then_temp < 0) return -1;
+            int else_temp = ir_generate_expression(b, expr->data.select.else_expr);
+            if (else_temp < 0) return -1;
+
+            instr.op = IR_SELECT;
+            instr.type = ir_type_of(expr->type);
+            ops[0] = ir_temp(cond_temp);
+            ops[1] = ir_temp(then_temp);
+            ops[2] = ir_temp(else_temp);
+            instr.operands = ops;
+            instr.operand_count = 3;
+            break;
         }
 
         default:
             return -1;
     }
+
+    return ir_emit(b, &instr) ? result_temp : -1;
 }
 
 /* ==============================================================================
- * IR Code Generation - Statements
+ * IR Generation - Statements
  * ==============================================================================
  */
 
-static bool ir_generate_statement(IRCodeGen *gen, ASTStmt *stmt) {
+/* Generate a nested statement one level deeper */
+static bool ir_generate_nested(IRBuilder *b, ASTStmt *stmt) {
+    b->depth++;
+    bool ok = ir_generate_statement(b, stmt);
+    b->depth--;
+    return ok;
+}
+
+/*
+ * Loops marked by loop rotation test the condition once before entering
+ * and then at the bottom of the body, one conditional branch per iteration:
+ *
+ *     br i1 %c, label %Lbody, label %Lend
+ *   Lbody:
+ *     ...body...
+ *     br i1 %c', label %Lbody, label %Lend
+ *   Lend:
+ */
+static bool ir_generate_rotated_loop(IRBuilder *b, ASTStmt *stmt) {
+    int body_label = ir_module_new_label(b->module);
+    int end_label = ir_module_new_label(b->module);
+
+    /* Guard */
+    int cond_temp = ir_generate_expression(b, stmt->data.while_stmt.condition);
+    if (cond_temp < 0) return false;
+    if (!ir_emit_cond_br(b, cond_temp, body_label, end_label)) return false;
+
+    /* Body followed by the latch test */
+    if (!ir_begin_block(b, body_label)) return false;
+    b->depth++;
+    bool ok = ir_generate_statement(b, stmt->data.while_stmt.body);
+    if (ok) {
+        cond_temp = ir_generate_expression(b, stmt->data.while_stmt.condition);
+        ok = cond_temp >= 0 && ir_emit_cond_br(b, cond_temp, body_label, end_label);
+    }
+    b->depth--;
+    if (!ok) return false;
+
+    /* End label */
+    return ir_begin_block(b, end_label);
+}
+
+static bool ir_generate_statement(IRBuilder *b, ASTStmt *stmt) {
     if (!stmt) return false;
 
     switch (stmt->kind) {
         case STMT_VAR_DECL: {
             /* Allocate space for variable */
-            if (!ir_codegen_indent(gen)) return false;
-            if (!ir_codegen_appendf(gen, "%%%s = alloca i32\n", stmt->data.var_decl.name)) return false;
+            const char *slot = ir_new_slot(b, stmt->data.var_decl.name);
+            if (!slot || !ir_emit_alloca(b, slot)) return false;
 
-            /* Generate initialization expression */
-            int init_temp = ir_generate_expression(gen, stmt->data.var_decl.init_expr);
+            /* Generate initialization expression (the variable comes into
+             * scope after it, as in the type checker) */
+            int init_temp = ir_generate_expression(b, stmt->data.var_decl.init_expr);
             if (init_temp < 0) return false;
 
             /* Store initial value */
-            if (!ir_codegen_indent(gen)) return false;
-            if (!ir_codegen_appendf(gen, "store i32 %%t%d, %%%s\n",
-                                   init_temp, stmt->data.var_decl.name)) return false;
-            return true;
+            return ir_bind(b, stmt->data.var_decl.name, slot) &&
+                   ir_emit_store(b, ir_temp(init_temp), slot);
         }
 
         case STMT_ASSIGN: {
-            /* Generate expression */
-            int expr_temp = ir_generate_expression(gen, stmt->data.assign.expr);
+            int expr_temp = ir_generate_expression(b, stmt->data.assign.expr);
             if (expr_temp < 0) return false;
-
-            /* Store to variable */
-            if (!ir_codegen_indent(gen)) return false;
-            if (!ir_codegen_appendf(gen, "store i32 %%t%d, %%%s\n",
-                                   expr_temp, stmt->data.assign.name)) return false;
-            return true;
+            return ir_emit_store(b, ir_temp(expr_temp),
+                                 ir_lookup_slot(b, stmt->data.assign.name));
         }
 
         case STMT_IF: {
             /* Generate condition */
-            int cond_temp = ir_generate_expression(gen, stmt->data.if_stmt.condition);
+            int cond_temp = ir_generate_expression(b, stmt->data.if_stmt.condition);
             if (cond_temp < 0) return false;
 
             /* Create labels */
-            int then_label = ir_get_next_label(gen);
-            int else_label = ir_get_next_label(gen);
-            int end_label = ir_get_next_label(gen);
+            int then_label = ir_module_new_label(b->module);
+            int else_label = ir_module_new_label(b->module);
+            int end_label = ir_module_new_label(b->module);
 
             /* Branch instruction */
-            if (!ir_codegen_indent(gen)) return false;
-            if (stmt->data.if_stmt.else_block) {
-                if (!ir_codegen_appendf(gen, "br i1 %%t%d, label %%L%d, label %%L%d\n",
-                                       cond_temp, then_label, else_label)) return false;
-            } else {
-                if (!ir_codegen_appendf(gen, "br i1 %%t%d, label %%L%d, label %%L%d\n",
-                                       cond_temp, then_label, end_label)) return false;
-            }
+            int false_label = stmt->data.if_stmt.else_block ? else_label : end_label;
+            if (!ir_emit_cond_br(b, cond_temp, then_label, false_label)) return false;
 
             /* Then block */
-            if (!ir_codegen_append(gen, "\n")) return false;
-            if (!ir_codegen_appendf(gen, "L%d:\n", then_label)) return false;
-            gen->indent_level++;
-            if (!ir_generate_statement(gen, stmt->data.if_stmt.then_block)) {
-                gen->indent_level--;
-                return false;
-            }
-            gen->indent_level--;
-            if (!ir_codegen_indent(gen)) return false;
-            if (!ir_codegen_appendf(gen, "br label %%L%d\n", end_label)) return false;
+            if (!ir_begin_block(b, then_label)) return false;
+            if (!ir_generate_nested(b, stmt->data.if_stmt.then_block)) return false;
+            if (!ir_emit_br(b, end_label)) return false;
 
             /* Else block (if present) */
             if (stmt->data.if_stmt.else_block) {
-                if (!ir_codegen_append(gen, "\n")) return false;
-                if (!ir_codegen_appendf(gen, "L%d:\n", else_label)) return false;
-                gen->indent_level++;
-                if (!ir_generate_statement(gen, stmt->data.if_stmt.else_block)) {
-                    gen->indent_level--;
-                    return false;
-                }
-                gen->indent_level--;
-                if (!ir_codegen_indent(gen)) return false;
-                if (!ir_codegen_appendf(gen, "br label %%L%d\n", end_label)) return false;
+                if (!ir_begin_block(b, else_label)) return false;
+                if (!ir_generate_nested(b, stmt->data.if_stmt.else_block)) return false;
+                if (!ir_emit_br(b, end_label)) return false;
             }
 
             /* End label */
-            if (!ir_codegen_append(gen, "\n")) return false;
-            if (!ir_codegen_appendf(gen, "L%d:\n", end_label)) return false;
-            return true;
+            return ir_begin_block(b, end_label);
         }
 
         case STMT_WHILE: {
+            if (stmt->data.while_stmt.rotated) return ir_generate_rotated_loop(b, stmt);
+
             /* Create labels */
-            int cond_label = ir_get_next_label(gen);
-            int body_label = ir_get_next_label(gen);
-            int end_label = ir_get_next_label(gen);
+            int cond_label = ir_module_new_label(b->module);
+            int body_label = ir_module_new_label(b->module);
+            int end_label = ir_module_new_label(b->module);
 
             /* Jump to condition */
-            if (!ir_codegen_indent(gen)) return false;
-            if (!ir_codegen_appendf(gen, "br label %%L%d\n", cond_label)) return false;
+            if (!ir_emit_br(b, cond_label)) return false;
 
             /* Condition block */
-            if (!ir_codegen_append(gen, "\n")) return false;
-            if (!ir_codegen_appendf(gen, "L%d:\n", cond_label)) return false;
-            gen->indent_level++;
-            int cond_temp = ir_generate_expression(gen, stmt->data.while_stmt.condition);
-            if (cond_temp < 0) {
-                gen->indent_level--;
-                return false;
-            }
-            if (!ir_codegen_indent(gen)) return false;
-            if (!ir_codegen_appendf(gen, "br i1 %%t%d, label %%L%d, label %%L%d\n",
-                                   cond_temp, body_label, end_label)) return false;
-            gen->indent_level--;
+            if (!ir_begin_block(b, cond_label)) return false;
+            b->depth++;
+            int cond_temp = ir_generate_expression(b, stmt->data.while_stmt.condition);
+            bool ok = cond_temp >= 0 && ir_emit_cond_br(b, cond_temp, body_label, end_label);
+            b->depth--;
+            if (!ok) return false;
 
             /* Body block */
-            if (!ir_codegen_append(gen, "\n")) return false;
-            if (!ir_codegen_appendf(gen, "L%d:\n", body_label)) return false;
-            gen->indent_level++;
-            if (!ir_generate_statement(gen, stmt->data.while_stmt.body)) {
-                gen->indent_level--;
-                return false;
-            }
-            if (!ir_codegen_indent(gen)) return false;
-            if (!ir_codegen_appendf(gen, "br label %%L%d\n", cond_label)) return false;
-            gen->indent_level--;
+            if (!ir_begin_block(b, body_label)) return false;
+            b->depth++;
+            ok = ir_generate_statement(b, stmt->data.while_stmt.body) &&
+                 ir_emit_br(b, cond_label);
+            b->depth--;
+            if (!ok) return false;
 
             /* End label */
-            if (!ir_codegen_append(gen, "\n")) return false;
-            if (!ir_codegen_appendf(gen, "L%d:\n", end_label)) return false;
-            return true;
+            return ir_begin_block(b, end_label);
         }
 
         case STMT_RETURN: {
+            IRInstr instr = { .op = IR_RET, .type = IR_TYPE_VOID, .dest = IR_NO_TEMP };
+            IRValue value;
+
             if (stmt->data.return_stmt.expr) {
-                int expr_temp = ir_generate_expression(gen, stmt->data.return_stmt.expr);
+                int expr_temp = ir_generate_expression(b, stmt->data.return_stmt.expr);
                 if (expr_temp < 0) return false;
 
-                if (!ir_codegen_indent(gen)) return false;
-                if (!ir_codegen_appendf(gen, "ret i32 %%t%d\n", expr_temp)) return false;
-            } else {
-                if (!ir_codegen_indent(gen)) return false;
-                if (!ir_codegen_append(gen, "ret void\n")) return false;
+                value = ir_temp(expr_temp);
+                instr.type = IR_TYPE_I32;
+                instr.operands = &value;
+                instr.operand_count = 1;
             }
-            return true;
+            return ir_emit(b, &instr) != NULL;
         }
 
         case STMT_EXPR: {
-            int expr_temp = ir_generate_expression(gen, stmt->data.expr_stmt.expr);
+            int expr_temp = ir_generate_expression(b, stmt->data.expr_stmt.expr);
             return expr_temp >= 0;
         }
 
-        case STMT_BLOCK:
+        case STMT_BLOCK: {
+            size_t scope_start = b->scope_count;
             for (size_t i = 0; i < stmt->data.block.stmt_count; i++) {
-                if (!ir_generate_statement(gen, stmt->data.block.statements[i])) {
+                if (!ir_generate_statement(b, stmt->data.block.statements[i])) {
                     return false;
                 }
             }
+            b->scope_count = scope_start;
             return true;
+        }
 
         default:
             return false;
@@ -504,115 +574,86 @@ static bool ir_generate_statement(IRCodeGen *gen, ASTStmt *stmt) {
 }
 
 /* ==============================================================================
- * IR Code Generation - Functions
+ * IR Generation - Functions
  * ==============================================================================
  */
 
-static bool ir_generate_function(IRCodeGen *gen, ASTFunc *func) {
-    /* Function signature */
-    const char *return_type = (func->return_type.kind == TYPE_INT) ? "i32" :
-                              (func->return_type.kind == TYPE_BOOL) ? "i1" : "void";
+static bool ir_generate_function(IRBuilder *b, const ASTFunc *func) {
+    IRType return_type = func->return_type.kind == TYPE_INT ? IR_TYPE_I32 :
+                         func->return_type.kind == TYPE_BOOL ? IR_TYPE_I1 : IR_TYPE_VOID;
 
-    if (!ir_codegen_appendf(gen, "define %s @%s(", return_type, func->name)) return false;
+    b->func = ir_module_add_function(b->module, func->name, return_type, func->param_count);
+    if (!b->func) return false;
 
-    /* Parameters */
     for (size_t i = 0; i < func->param_count; i++) {
-        if (i > 0) {
-            if (!ir_codegen_append(gen, ", ")) return false;
-        }
-
-        const char *param_type = (func->params[i].type.kind == TYPE_INT) ? "i32" :
-                                 (func->params[i].type.kind == TYPE_BOOL) ? "i1" : "i32";
-
-        if (!ir_codegen_appendf(gen, "%s %%%s.param", param_type, func->params[i].name)) return false;
+        b->func->params[i].name = ir_arena_strdup(&b->module->arena, func->params[i].name);
+        b->func->params[i].type = ir_type_of(func->params[i].type);
+        if (!b->func->params[i].name) return false;
     }
 
-    if (!ir_codegen_append(gen, ") {\n")) return false;
-
-    /* Entry label */
-    if (!ir_codegen_append(gen, "entry:\n")) return false;
-
-    gen->indent_level++;
+    if (!ir_begin_block(b, IR_LABEL_ENTRY)) return false;
+    b->depth = 1;
 
     /* Allocate space for parameters and copy values */
+    b->scope_count = 0;
     for (size_t i = 0; i < func->param_count; i++) {
-        if (!ir_codegen_indent(gen)) {
-            gen->indent_level--;
-            return false;
-        }
-        if (!ir_codegen_appendf(gen, "%%%s = alloca i32\n", func->params[i].name)) {
-            gen->indent_level--;
-            return false;
-        }
-        if (!ir_codegen_indent(gen)) {
-            gen->indent_level--;
-            return false;
-        }
-        if (!ir_codegen_appendf(gen, "store i32 %%%s.param, %%%s\n",
-                               func->params[i].name, func->params[i].name)) {
-            gen->indent_level--;
-            return false;
-        }
+        const char *name = b->func->params[i].name;
+        IRValue param = { .kind = IR_VALUE_PARAM, .index = (int)i };
+        if (!ir_emit_alloca(b, name) || !ir_emit_store(b, param, name)) return false;
+        if (!ir_bind(b, name, name)) return false;
     }
 
     /* Function body */
-    if (!ir_generate_statement(gen, func->body)) {
-        gen->indent_level--;
-        return false;
-    }
-
-    gen->indent_level--;
-
-    if (!ir_codegen_append(gen, "}\n\n")) return false;
+    if (!ir_generate_statement(b, func->body)) return false;
 
-    return true;
+    return ir_function_compute_cfg(b->module, b->func);
 }
 
 /* ==============================================================================
- * IR Code Generation - Program
+ * Public IR API
  * ==============================================================================
  */
 
-static bool ir_generate_program(IRCodeGen *gen, ASTProgram *program) {
-    /* Header */
-    if (gen->config && gen->config->emit_comments) {
-        if (!ir_codegen_append(gen, "; Generated by TinyLLVM Compiler\n")) return false;
-        if (!ir_codegen_append(gen, "; Target: TinyLLVM IR (human-readable)\n\n")) return false;
-    }
+IRModule *ir_build_module(const ASTProgram *program) {
+    if (!program) return NULL;
 
-    /* Declare print function */
-    if (!ir_codegen_append(gen, "declare void @print(i32)\n\n")) return false;
+    IRBuilder b = {
+        .module = ir_module_create(),
+        .func = NULL,
+        .block = NULL,
+        .depth = 0,
+        .current_block = IR_LABEL_ENTRY,
+        .scope_names = NULL,
+        .scope_slots = NULL,
+        .scope_count = 0,
+        .scope_capacity = 0
+    };
+    if (!b.module) return NULL;
 
-    /* Generate all functions */
     for (size_t i = 0; i < program->func_count; i++) {
-        if (!ir_generate_function(gen, program->functions[i])) return false;
+        if (!ir_generate_function(&b, program->functions[i])) {
+            ir_module_destroy(b.module);
+            b.module = NULL;
+            break;
+        }
     }
 
-    return true;
+    free(b.scope_names);
+    free(b.scope_slots);
+    return b.module;
 }
 
-/* ==============================================================================
- * Public IR Code Generator API
- * ==============================================================================
- */
-
 char *generate_ir_code(ASTProgram *program, CompilerConfig *config) {
-    if (!program) return NULL;
-
-    IRCodeGen gen = {
-        .output = NULL,
-        .length = 0,
-        .capacity = 0,
-        .indent_level = 0,
-        .temp_counter = 0,
-        .label_counter = 0,
-        .config = config
-    };
+    IRModule *module = ir_build_module(program);
+    if (!module) return NULL;
 
-    if (!ir_generate_program(&gen, program)) {
-        free(gen.output);
+    /* Optimized builds print real SSA; -O0 keeps every variable in memory */
+    if (config && config->enable_optimization && !ir_module_to_ssa(module)) {
+        ir_module_destroy(module);
         return NULL;
     }
 
-    return gen.output;
-}
\ No newline at end of file
+    char *output = ir_print_module(module, config && config->emit_comments);
+    ir_module_destroy(module);
+    return output;
+}
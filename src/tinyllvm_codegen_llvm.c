@@ -0,0 +1,574 @@
+/**
+ * ==============================================================================
+ * TinyLLVM Compiler - LLVM IR Generator
+ * ==============================================================================
+ *
+ * Emits textual LLVM IR (.ll) from the SSA form of the IR, for
+ * TARGET_LLVM, so clang, opt and llc can optimize and build the program:
+ * `clang -O2 out.ll` links a program whose main returns the CoreTiny
+ * main's value.
+ *
+ *   - Constants are folded into their uses; LLVM has no const instruction.
+ *   - TinyLLVM IR mixes i1 and i32 freely (bools are stored in i32 slots
+ *     and calls are typed i32). Every use gets the type LLVM requires: i1
+ *     values are zero-extended where an i32 is expected, and i32 values
+ *     tested against zero where an i1 is. Conversions feeding a phi are
+ *     made at the end of the incoming block.
+ *   - print calls printf through an opaque `ptr` (LLVM 15 and later;
+ *     LLVM 14 needs -opaque-pointers).
+ *   - Only main is external, so LLVM may inline, specialize and drop the
+ *     other functions freely. Arithmetic wraps (no nsw); division keeps
+ *     C's rules, as the C backend's output does.
+ *
+ * Unterminated blocks get an explicit branch to the next block, and the
+ * last one a return.
+ */
+
+#include "include/tinyllvm_compiler.h"
+#include "include/tinyllvm_ir.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+
+typedef struct {
+    char *output;
+    size_t length;
+    size_t capacity;
+
+    const IRModule *module;
+    int convert_count;              /* %c<n> conversions, module-wide */
+    bool uses_print;
+
+    /* Current function */
+    const IRFunction *func;
+    const IRInstr **def_of;         /* Temporary -> defining instruction */
+    IRType *temp_type;              /* Temporary -> LLVM type of its value */
+} LLVMGen;
+
+/* An operand as a use needs it */
+typedef struct {
+    IRValue value;
+    IRType type;
+    int converted;                  /* %c<n> holding the converted value, or -1 */
+} LLVMOperand;
+
+static bool llvm_grow(LLVMGen *g, size_t additional) {
+    size_t needed = g->length + additional + 1;
+    if (needed <= g->capacity) return true;
+
+    size_t new_capacity = g->capacity == 0 ? 4096 : g->capacity;
+    while (new_capacity < needed) {
+        new_capacity *= 2;
+    }
+
+    char *new_output = realloc(g->output, new_capacity);
+    if (!new_output) return false;
+
+    g->output = new_output;
+    g->capacity = new_capacity;
+    return true;
+}
+
+static bool llvm_appendf(LLVMGen *g, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(NULL, 0, format, args);
+    va_end(args);
+    if (len < 0 || !llvm_grow(g, (size_t)len)) return false;
+
+    va_start(args, format);
+    vsnprintf(g->output + g->length, (size_t)len + 1, format, args);
+    va_end(args);
+    g->length += (size_t)len;
+    return true;
+}
+
+static const char *type_name(IRType type) {
+    switch (type) {
+        case IR_TYPE_I1:  return "i1";
+        case IR_TYPE_I32: return "i32";
+        default:          return "void";
+    }
+}
+
+static const char *cmp_name(IRCmp cmp) {
+    switch (cmp) {
+        case IR_CMP_EQ: return "icmp eq";
+        case IR_CMP_NE: return "icmp ne";
+        case IR_CMP_LT: return "icmp slt";
+        case IR_CMP_LE: return "icmp sle";
+        case IR_CMP_GT: return "icmp sgt";
+        default:        return "icmp sge";
+    }
+}
+
+static const char *arith_name(IROpcode op) {
+    switch (op) {
+        case IR_ADD:  return "add";
+        case IR_SUB:  return "sub";
+        case IR_MUL:  return "mul";
+        case IR_DIV:  return "sdiv";
+        case IR_MOD:  return "srem";
+        case IR_SHL:  return "shl";
+        case IR_ASHR: return "ashr";
+        case IR_LSHR: return "lshr";
+        case IR_AND:  return "and";
+        default:      return "or";
+    }
+}
+
+static const IRFunction *find_function(const LLVMGen *g, const char *name) {
+    for (size_t i = 0; i < g->module->func_count; i++) {
+        if (strcmp(g->module->functions[i]->name, name) == 0) return g->module->functions[i];
+    }
+    return NULL;
+}
+
+/* main returns i32 to the C runtime whatever CoreTiny declared */
+static IRType return_type(const IRFunction *func) {
+    return strcmp(func->name, "main") == 0 ? IR_TYPE_I32 : func->return_type;
+}
+
+/* Name of a block label: entry, L<n>, or B<index> for unlabeled blocks */
+static void block_name(const IRFunction *func, size_t b, char *text, size_t size) {
+    int label = func->blocks[b]->label;
+    if (label == IR_LABEL_ENTRY) snprintf(text, size, "entry");
+    else if (label == IR_LABEL_NONE) snprintf(text, size, "B%zu", b);
+    else snprintf(text, size, "L%d", label);
+}
+
+/* ==============================================================================
+ * Operands
+ * ==============================================================================
+ */
+
+static const IRInstr *const_def(const LLVMGen *g, IRValue value) {
+    if (value.kind != IR_VALUE_TEMP || value.index < 0 ||
+        value.index >= g->module->temp_count) {
+        return NULL;
+    }
+    const IRInstr *def = g->def_of[value.index];
+    return def && def->op == IR_CONST ? def : NULL;
+}
+
+/* Whether value, used as type, must be converted first. Constants and
+ * undef are written directly in the type the use needs */
+static bool needs_conversion(const LLVMGen *g, IRValue value, IRType type) {
+    if (value.kind == IR_VALUE_PARAM) return g->func->params[value.index].type != type;
+    if (value.kind != IR_VALUE_TEMP || const_def(g, value)) return false;
+    return value.index >= 0 && value.index < g->module->temp_count &&
+           g->temp_type[value.index] != type;
+}
+
+static bool emit_value(LLVMGen *g, IRValue value, IRType type) {
+    if (value.kind == IR_VALUE_UNDEF) return llvm_appendf(g, "undef");
+    if (value.kind == IR_VALUE_PARAM) {
+        return llvm_appendf(g, "%%%s.param", g->func->params[value.index].name);
+    }
+
+    const IRInstr *def = const_def(g, value);
+    if (!def) return llvm_appendf(g, "%%t%d", value.index);
+    if (type == IR_TYPE_I1) return llvm_appendf(g, def->imm != 0 ? "true" : "false");
+    return llvm_appendf(g, "%d", (int)def->imm);
+}
+
+/* The right-hand side converting value to type */
+static bool emit_conversion(LLVMGen *g, IRValue value, IRType type) {
+    if (type == IR_TYPE_I32) {
+        return llvm_appendf(g, "zext i1 ") && emit_value(g, value, IR_TYPE_I1) &&
+               llvm_appendf(g, " to i32\n");
+    }
+    return llvm_appendf(g, "icmp ne i32 ") && emit_value(g, value, IR_TYPE_I32) &&
+           llvm_appendf(g, ", 0\n");
+}
+
+/* Prepare an operand for a use of the given type, converting it first if
+ * its value has the other one */
+static bool prepare_operand(LLVMGen *g, IRValue value, IRType type, LLVMOperand *op) {
+    op->value = value;
+    op->type = type;
+    op->converted = -1;
+    if (!needs_conversion(g, value, type)) return true;
+
+    op->converted = g->convert_count++;
+    return llvm_appendf(g, "  %%c%d = ", op->converted) && emit_conversion(g, value, type);
+}
+
+static bool emit_operand(LLVMGen *g, const LLVMOperand *op) {
+    if (op->converted >= 0) return llvm_appendf(g, "%%c%d", op->converted);
+    return emit_value(g, op->value, op->type);
+}
+
+/* ==============================================================================
+ * Instructions
+ * ==============================================================================
+ */
+
+static bool emit_binary(LLVMGen *g, const IRInstr *instr, const char *name, IRType type) {
+    LLVMOperand a, b;
+    return prepare_operand(g, instr->operands[0], type, &a) &&
+           prepare_operand(g, instr->operands[1], type, &b) &&
+           llvm_appendf(g, "  %%t%d = %s %s ", instr->dest, name, type_name(type)) &&
+           emit_operand(g, &a) && llvm_appendf(g, ", ") && emit_operand(g, &b) &&
+           llvm_appendf(g, "\n");
+}
+
+/* LLVM leaves shifts by 32 or more undefined; TinyLLVM masks the count */
+static bool emit_shift(LLVMGen *g, const IRInstr *instr) {
+    LLVMOperand a, count;
+    if (!prepare_operand(g, instr->operands[0], IR_TYPE_I32, &a) ||
+        !prepare_operand(g, instr->operands[1], IR_TYPE_I32, &count)) {
+        return false;
+    }
+
+    const IRInstr *amount = const_def(g, instr->operands[1]);
+    int masked = -1;
+    if (!amount) {
+        masked = g->convert_count++;
+        if (!llvm_appendf(g, "  %%c%d = and i32 ", masked) || !emit_operand(g, &count) ||
+            !llvm_appendf(g, ", 31\n")) {
+            return false;
+        }
+    }
+
+    if (!llvm_appendf(g, "  %%t%d = %s i32 ", instr->dest, arith_name(instr->op)) ||
+        !emit_operand(g, &a)) {
+        return false;
+    }
+    if (amount) return llvm_appendf(g, ", %d\n", (int)(amount->imm & 31));
+    return llvm_appendf(g, ", %%c%d\n", masked);
+}
+
+/* High half of the 64-bit product */
+static bool emit_mulhi(LLVMGen *g, const IRInstr *instr) {
+    LLVMOperand a, b;
+    int d = instr->dest;
+    return prepare_operand(g, instr->operands[0], IR_TYPE_I32, &a) &&
+           prepare_operand(g, instr->operands[1], IR_TYPE_I32, &b) &&
+           llvm_appendf(g, "  %%t%d.a = sext i32 ", d) && emit_operand(g, &a) &&
+           llvm_appendf(g, " to i64\n") &&
+           llvm_appendf(g, "  %%t%d.b = sext i32 ", d) && emit_operand(g, &b) &&
+           llvm_appendf(g, " to i64\n") &&
+           llvm_appendf(g, "  %%t%d.p = mul i64 %%t%d.a, %%t%d.b\n", d, d, d) &&
+           llvm_appendf(g, "  %%t%d.h = ashr i64 %%t%d.p, 32\n", d, d) &&
+           llvm_appendf(g, "  %%t%d = trunc i64 %%t%d.h to i32\n", d, d);
+}
+
+static bool emit_phi(LLVMGen *g, const IRInstr *instr) {
+    if (!llvm_appendf(g, "  %%t%d = phi %s ", instr->dest, type_name(instr->type))) return false;
+
+    for (size_t i = 0; i < instr->operand_count; i++) {
+        size_t pred = ir_function_find_block(g->func, instr->labels[i]);
+        if (pred == (size_t)-1) return false;
+
+        char name[32];
+        block_name(g->func, pred, name, sizeof(name));
+        if (!llvm_appendf(g, i > 0 ? ", [ " : "[ ")) return false;
+
+        /* Converted at the end of the incoming block (emit_edge_conversions) */
+        bool ok = needs_conversion(g, instr->operands[i], instr->type)
+            ? llvm_appendf(g, "%%t%d.%s", instr->dest, name)
+            : emit_value(g, instr->operands[i], instr->type);
+        if (!ok || !llvm_appendf(g, ", %%%s ]", name)) return false;
+    }
+    return llvm_appendf(g, "\n");
+}
+
+static bool emit_call(LLVMGen *g, const IRInstr *instr) {
+    const IRFunction *callee = find_function(g, instr->name);
+    IRType type = callee ? return_type(callee) : IR_TYPE_I32;
+
+    LLVMOperand *args = NULL;
+    if (instr->operand_count > 0) {
+        args = malloc(instr->operand_count * sizeof(LLVMOperand));
+        if (!args) return false;
+    }
+
+    bool ok = true;
+    for (size_t i = 0; ok && i < instr->operand_count; i++) {
+        IRType param = callee && i < callee->param_count ? callee->params[i].type : IR_TYPE_I32;
+        ok = prepare_operand(g, instr->operands[i], param, &args[i]);
+    }
+
+    if (ok && type != IR_TYPE_VOID && instr->dest != IR_NO_TEMP) {
+        ok = llvm_appendf(g, "  %%t%d = ", instr->dest);
+    } else if (ok) {
+        ok = llvm_appendf(g, "  ");
+    }
+    ok = ok && llvm_appendf(g, "call %s @%s(", type_name(type), instr->name);
+    for (size_t i = 0; ok && i < instr->operand_count; i++) {
+        ok = llvm_appendf(g, "%s%s ", i > 0 ? ", " : "", type_name(args[i].type)) &&
+             emit_operand(g, &args[i]);
+    }
+    ok = ok && llvm_appendf(g, ")\n");
+
+    free(args);
+    return ok;
+}
+
+static bool emit_ret(LLVMGen *g, const IRInstr *instr) {
+    IRType type = return_type(g->func);
+    if (type == IR_TYPE_VOID) return llvm_appendf(g, "  ret void\n");
+    if (!instr || instr->operand_count == 0) {
+        return llvm_appendf(g, "  ret %s %s\n", type_name(type), type == IR_TYPE_I1 ? "false" : "0");
+    }
+
+    LLVMOperand value;
+    return prepare_operand(g, instr->operands[0], type, &value) &&
+           llvm_appendf(g, "  ret %s ", type_name(type)) && emit_operand(g, &value) &&
+           llvm_appendf(g, "\n");
+}
+
+static bool emit_instr(LLVMGen *g, const IRInstr *instr) {
+    LLVMOperand a, b, c;
+
+    switch (instr->op) {
+        case IR_CONST:
+            return true;
+
+        case IR_ADD:
+        case IR_SUB:
+        case IR_MUL:
+        case IR_DIV:
+        case IR_MOD:
+            return emit_binary(g, instr, arith_name(instr->op), IR_TYPE_I32);
+
+        case IR_SHL:
+        case IR_ASHR:
+        case IR_LSHR:
+            return emit_shift(g, instr);
+
+        case IR_MULHI:
+            return emit_mulhi(g, instr);
+
+        case IR_AND:
+        case IR_OR:
+            return emit_binary(g, instr, arith_name(instr->op), IR_TYPE_I1);
+
+        case IR_ICMP:
+            return emit_binary(g, instr, cmp_name(instr->cmp), IR_TYPE_I32);
+
+        case IR_NOT:
+            return prepare_operand(g, instr->operands[0], IR_TYPE_I1, &a) &&
+                   llvm_appendf(g, "  %%t%d = xor i1 ", instr->dest) && emit_operand(g, &a) &&
+                   llvm_appendf(g, ", true\n");
+
+        case IR_SELECT:
+            return prepare_operand(g, instr->operands[0], IR_TYPE_I1, &a) &&
+                   prepare_operand(g, instr->operands[1], instr->type, &b) &&
+                   prepare_operand(g, instr->operands[2], instr->type, &c) &&
+                   llvm_appendf(g, "  %%t%d = select i1 ", instr->dest) && emit_operand(g, &a) &&
+                   llvm_appendf(g, ", %s ", type_name(instr->type)) && emit_operand(g, &b) &&
+                   llvm_appendf(g, ", %s ", type_name(instr->type)) && emit_operand(g, &c) &&
+                   llvm_appendf(g, "\n");
+
+        case IR_PHI:
+            return emit_phi(g, instr);
+
+        case IR_CALL:
+            return emit_call(g, instr);
+
+        case IR_PRINT:
+            g->uses_print = true;
+            return prepare_operand(g, instr->operands[0], IR_TYPE_I32, &a) &&
+                   llvm_appendf(g, "  call i32 (ptr, ...) @printf(ptr @.print_format, i32 ") &&
+                   emit_operand(g, &a) && llvm_appendf(g, ")\n");
+
+        default:
+            /* Loads, stores and allocas are gone after SSA construction;
+             * terminators are emitted by emit_block */
+            return false;
+    }
+}
+
+/* ==============================================================================
+ * Blocks & Functions
+ * ==============================================================================
+ */
+
+/* Phis in succ that take a value of the other type from block b get it
+ * converted here, as %t<phi>.<name of b> */
+static bool emit_edge_conversions(LLVMGen *g, size_t b, size_t succ) {
+    const IRBlock *block = g->func->blocks[b];
+    const IRBlock *target = g->func->blocks[succ];
+
+    char name[32];
+    block_name(g->func, b, name, sizeof(name));
+
+    for (size_t i = 0; i < target->instr_count && target->instrs[i].op == IR_PHI; i++) {
+        const IRInstr *phi = &target->instrs[i];
+        for (size_t k = 0; k < phi->operand_count; k++) {
+            if (phi->labels[k] != block->label ||
+                !needs_conversion(g, phi->operands[k], phi->type)) {
+                continue;
+            }
+            if (!llvm_appendf(g, "  %%t%d.%s = ", phi->dest, name) ||
+                !emit_conversion(g, phi->operands[k], phi->type)) {
+                return false;
+            }
+            break;
+        }
+    }
+    return true;
+}
+
+static bool emit_block(LLVMGen *g, size_t b) {
+    const IRFunction *func = g->func;
+    const IRBlock *block = func->blocks[b];
+
+    char name[32];
+    block_name(func, b, name, sizeof(name));
+    if (!llvm_appendf(g, b == 0 ? "%s:\n" : "\n%s:\n", name)) return false;
+
+    /* Nothing after the first terminator is reachable */
+    const IRInstr *terminator = NULL;
+    for (size_t i = 0; i < block->instr_count && !terminator; i++) {
+        const IRInstr *instr = &block->instrs[i];
+        if (ir_opcode_is_terminator(instr->op)) {
+            terminator = instr;
+        } else if (!emit_instr(g, instr)) {
+            return false;
+        }
+    }
+
+    if (terminator && terminator->op == IR_RET) return emit_ret(g, terminator);
+
+    /* An unterminated block falls through; the last one returns */
+    if (!terminator) {
+        if (b + 1 >= func->block_count) return emit_ret(g, NULL);
+
+        char next[32];
+        block_name(func, b + 1, next, sizeof(next));
+        return emit_edge_conversions(g, b, b + 1) &&
+               llvm_appendf(g, "  br label %%%s\n", next);
+    }
+
+    size_t targets[2];
+    size_t target_count = terminator->op == IR_COND_BR ? 2 : 1;
+    for (size_t i = 0; i < target_count; i++) {
+        targets[i] = ir_function_find_block(func, terminator->labels[i]);
+        if (targets[i] == (size_t)-1) return false;
+        if ((i == 0 || targets[i] != targets[0]) && !emit_edge_conversions(g, b, targets[i])) {
+            return false;
+        }
+    }
+
+    char first[32], second[32];
+    block_name(func, targets[0], first, sizeof(first));
+    if (terminator->op == IR_BR) return llvm_appendf(g, "  br label %%%s\n", first);
+
+    LLVMOperand cond;
+    block_name(func, targets[1], second, sizeof(second));
+    return prepare_operand(g, terminator->operands[0], IR_TYPE_I1, &cond) &&
+           llvm_appendf(g, "  br i1 ") && emit_operand(g, &cond) &&
+           llvm_appendf(g, ", label %%%s, label %%%s\n", first, second);
+}
+
+/* Record each temporary's defining instruction and LLVM type */
+static bool collect_temps(LLVMGen *g) {
+    size_t temps = (size_t)g->module->temp_count;
+    g->def_of = calloc(temps ? temps : 1, sizeof(IRInstr *));
+    g->temp_type = calloc(temps ? temps : 1, sizeof(IRType));
+    if (!g->def_of || !g->temp_type) return false;
+
+    for (size_t b = 0; b < g->func->block_count; b++) {
+        const IRBlock *block = g->func->blocks[b];
+        for (size_t i = 0; i < block->instr_count; i++) {
+            const IRInstr *instr = &block->instrs[i];
+            if (instr->dest < 0 || (size_t)instr->dest >= temps) continue;
+
+            IRType type = instr->type;
+            switch (instr->op) {
+                case IR_ICMP:
+                case IR_NOT:
+                case IR_AND:
+                case IR_OR:
+                    type = IR_TYPE_I1;
+                    break;
+                case IR_CALL: {
+                    const IRFunction *callee = find_function(g, instr->name);
+                    type = callee ? return_type(callee) : IR_TYPE_I32;
+                    break;
+                }
+                case IR_CONST:
+                case IR_SELECT:
+                case IR_PHI:
+                    break;
+                default:
+                    type = IR_TYPE_I32;
+                    break;
+            }
+            g->def_of[instr->dest] = instr;
+            g->temp_type[instr->dest] = type;
+        }
+    }
+    return true;
+}
+
+static bool emit_function(LLVMGen *g, const IRFunction *func) {
+    g->func = func;
+    bool ok = collect_temps(g);
+
+    bool is_main = strcmp(func->name, "main") == 0;
+    ok = ok && llvm_appendf(g, "define %s%s @%s(", is_main ? "" : "internal ",
+                            type_name(return_type(func)), func->name);
+    for (size_t i = 0; ok && i < func->param_count; i++) {
+        ok = llvm_appendf(g, "%s%s %%%s.param", i > 0 ? ", " : "",
+                          type_name(func->params[i].type), func->params[i].name);
+    }
+    ok = ok && llvm_appendf(g, ") {\n");
+
+    for (size_t b = 0; ok && b < func->block_count; b++) {
+        ok = emit_block(g, b);
+    }
+    if (ok && func->block_count == 0) {
+        ok = llvm_appendf(g, "entry:\n") && emit_ret(g, NULL);
+    }
+    ok = ok && llvm_appendf(g, "}\n\n");
+
+    free(g->def_of);
+    free(g->temp_type);
+    g->def_of = NULL;
+    g->temp_type = NULL;
+    return ok;
+}
+
+char *generate_llvm_code(ASTProgram *program, CompilerConfig *config) {
+    IRModule *module = ir_build_module(program);
+    if (!module) return NULL;
+
+    /* LLVM would promote the slots itself, but SSA drops unreachable
+     * blocks and gives every value one definition */
+    if (!ir_module_to_ssa(module)) {
+        ir_module_destroy(module);
+        return NULL;
+    }
+
+    LLVMGen g;
+    memset(&g, 0, sizeof(g));
+    g.module = module;
+
+    bool ok = true;
+    if (config && config->emit_comments) {
+        ok = llvm_appendf(&g, "; Generated by TinyLLVM Compiler\n") &&
+             llvm_appendf(&g, "; Target: LLVM IR (clang, opt, llc)\n\n");
+    }
+
+    for (size_t i = 0; ok && i < module->func_count; i++) {
+        ok = emit_function(&g, module->functions[i]);
+    }
+
+    if (ok && g.uses_print) {
+        ok = llvm_appendf(&g, "@.print_format = private unnamed_addr constant [4 x i8] "
+                              "c\"%%d\\0A\\00\"\n\n") &&
+             llvm_appendf(&g, "declare i32 @printf(ptr, ...)\n");
+    }
+
+    ir_module_destroy(module);
+    if (!ok) {
+        free(g.output);
+        return NULL;
+    }
+    return g.output;
+}
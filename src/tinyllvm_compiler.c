@@ -0,0 +1,221 @@
+/**
+ * ==============================================================================
+ * TinyLLVM Compiler - High-Level API
+ * ==============================================================================
+ *
+ * Builds the standard pipeline as an event chain and collects its outputs:
+ * Source Code → Lexer → Parser → Type Checker → Optimizer → Code Generator
+ *
+ * With config->jit the code generator is replaced by Bytecode → JIT, and
+ * the result holds native code instead of source. TARGET_ELF_X86_64 adds
+ * an Object event after the code generator, and the result holds the
+ * bytes of a relocatable object.
+ */
+
+#include "include/tinyllvm_compiler.h"
+#include "include/tinyllvm_jit.h"
+#include "include/tinyllvm_elf.h"
+#include "include/eventchains.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ==============================================================================
+ * Configuration & Chain Construction
+ * ==============================================================================
+ */
+
+CompilerConfig *compiler_config_create_default(void) {
+    CompilerConfig *config = calloc(1, sizeof(CompilerConfig));
+    if (!config) return NULL;
+
+    config->target = TARGET_C;
+    config->enable_optimization = true;
+    config->optimization_level = 1;
+    config->emit_debug_info = false;
+    config->emit_comments = false;
+    config->pretty_print = true;
+    config->track_memory = false;
+    config->max_memory_bytes = EVENTCHAINS_MAX_CONTEXT_MEMORY;
+    config->error_detail = ERROR_DETAIL_FULL;
+    config->stop_on_first_error = true;
+    return config;
+}
+
+static bool add_event(EventChain *chain, EventExecuteFunc execute, void *user_data,
+                      const char *name) {
+    ChainableEvent *event = chainable_event_create(execute, user_data, name);
+    if (!event) return false;
+
+    if (event_chain_add_event(chain, event) != EC_SUCCESS) {
+        chainable_event_destroy(event);
+        return false;
+    }
+    return true;
+}
+
+EventChain *compiler_create_chain(CompilerConfig *config) {
+    if (!config) return NULL;
+
+    FaultToleranceMode mode = config->stop_on_first_error ?
+                              FAULT_TOLERANCE_STRICT : FAULT_TOLERANCE_LENIENT;
+    EventChain *chain = event_chain_create_with_detail(mode, config->error_detail);
+    if (!chain) return NULL;
+
+    bool ok = add_event(chain, compiler_lexer_event, NULL, "Lexer") &&
+              add_event(chain, compiler_parser_event, NULL, "Parser") &&
+              add_event(chain, compiler_type_checker_event, NULL, "TypeChecker") &&
+              add_event(chain, compiler_optimizer_event, config, "Optimizer");
+    if (ok && config->jit) {
+        ok = add_event(chain, compiler_bytecode_event, config, "Bytecode") &&
+             add_event(chain, compiler_jit_event, config, "JIT");
+    } else if (ok) {
+        ok = add_event(chain, compiler_codegen_event, config, "CodeGen");
+        if (ok && config->target == TARGET_ELF_X86_64) {
+            ok = add_event(chain, compiler_object_event, config, "Object");
+        }
+    }
+
+    if (!ok) {
+        event_chain_destroy(chain);
+        return NULL;
+    }
+    return chain;
+}
+
+/* ==============================================================================
+ * Compilation
+ * ==============================================================================
+ */
+
+static size_t program_node_count(const ASTProgram *program) {
+    size_t count = 0;
+    for (size_t i = 0; i < program->func_count; i++) {
+        count += 1 + ast_stmt_node_count(program->functions[i]->body);
+    }
+    return count;
+}
+
+static bool collect_errors(CompilationResult *result, const ChainResult *chain_result) {
+    if (chain_result->failure_count == 0) return true;
+
+    result->errors = calloc(chain_result->failure_count, sizeof(char *));
+    if (!result->errors) return false;
+
+    const FailureInfo *failures = (const FailureInfo *)chain_result->failures;
+    for (size_t i = 0; i < chain_result->failure_count; i++) {
+        size_t len = strlen(failures[i].event_name) + strlen(failures[i].error_message) + 3;
+        char *message = malloc(len);
+        if (!message) return false;
+
+        snprintf(message, len, "%s: %s", failures[i].event_name, failures[i].error_message);
+        result->errors[result->error_count++] = message;
+    }
+    return true;
+}
+
+EventChainErrorCode compiler_compile(
+    const char *source_code,
+    CompilerConfig *config,
+    CompilationResult *result_out
+) {
+    if (!source_code || !config || !result_out) return EC_ERROR_NULL_POINTER;
+    memset(result_out, 0, sizeof(*result_out));
+
+    EventChain *chain = compiler_create_chain(config);
+    if (!chain) return EC_ERROR_OUT_OF_MEMORY;
+
+    EventContext *context = event_chain_get_context(chain);
+
+    size_t source_len = strlen(source_code);
+    char *source = malloc(source_len + 1);
+    if (!source) {
+        event_chain_destroy(chain);
+        return EC_ERROR_OUT_OF_MEMORY;
+    }
+    memcpy(source, source_code, source_len + 1);
+
+    EventChainErrorCode err = event_context_set_with_cleanup(context, "source_code", source, free);
+    if (err != EC_SUCCESS) {
+        free(source);
+        event_chain_destroy(chain);
+        return err;
+    }
+
+    ChainResult chain_result;
+    event_chain_execute(chain, &chain_result);
+
+    /* Statistics from whatever phases produced output */
+    TokenList *tokens = NULL;
+    ASTProgram *program = NULL;
+    OptimizationStats *stats = NULL;
+    char *output = NULL;
+
+    if (event_context_get(context, "tokens", (void **)&tokens) == EC_SUCCESS && tokens) {
+        result_out->tokens_count = tokens->count;
+    }
+    if (event_context_get(context, "ast", (void **)&program) == EC_SUCCESS && program) {
+        result_out->ast_node_count = program_node_count(program);
+    }
+    if (event_context_get(context, "opt_stats", (void **)&stats) == EC_SUCCESS && stats) {
+        result_out->functions_removed = stats->functions_removed;
+    }
+    result_out->memory_used = event_context_memory_usage(context);
+
+    err = EC_SUCCESS;
+    ElfObject *object = NULL;
+    if (chain_result.success && config->jit &&
+        event_context_get_ref(context, "jit", &result_out->jit_ref) == EC_SUCCESS) {
+        result_out->jit = ref_counted_value_get_data(result_out->jit_ref);
+        result_out->main_function = jit_module_main(result_out->jit);
+        result_out->success = true;
+    } else if (chain_result.success && config->target == TARGET_ELF_X86_64 &&
+               event_context_get(context, "object_code", (void **)&object) == EC_SUCCESS && object) {
+        result_out->output_code = malloc(object->size);
+        if (result_out->output_code) {
+            memcpy(result_out->output_code, object->data, object->size);
+            result_out->output_length = object->size;
+            result_out->success = true;
+        } else {
+            err = EC_ERROR_OUT_OF_MEMORY;
+        }
+    } else if (chain_result.success &&
+        event_context_get(context, "output_code", (void **)&output) == EC_SUCCESS && output) {
+        result_out->output_length = strlen(output);
+        result_out->output_code = malloc(result_out->output_length + 1);
+        if (result_out->output_code) {
+            memcpy(result_out->output_code, output, result_out->output_length + 1);
+            result_out->success = true;
+        } else {
+            err = EC_ERROR_OUT_OF_MEMORY;
+        }
+    } else {
+        err = chain_result.failure_count > 0 ?
+              ((const FailureInfo *)chain_result.failures)[0].error_code :
+              EC_ERROR_EVENT_EXECUTION_FAILED;
+    }
+
+    if (!collect_errors(result_out, &chain_result) && err == EC_SUCCESS) {
+        err = EC_ERROR_OUT_OF_MEMORY;
+    }
+
+    chain_result_destroy(&chain_result);
+    event_chain_destroy(chain);
+    return err;
+}
+
+void compilation_result_destroy(CompilationResult *result) {
+    if (!result) return;
+
+    free(result->output_code);
+    if (result->jit_ref) ref_counted_value_release(result->jit_ref);
+    for (size_t i = 0; i < result->error_count; i++) {
+        free(result->errors[i]);
+    }
+    free(result->errors);
+    for (size_t i = 0; i < result->warning_count; i++) {
+        free(result->warnings[i]);
+    }
+    free(result->warnings);
+    memset(result, 0, sizeof(*result));
+}
@@ -0,0 +1,1187 @@
+/**
+ * ==============================================================================
+ * TinyLLVM Compiler - ELF Object Writer
+ * ==============================================================================
+ *
+ * A small integrated assembler for the x86-64 backend's output
+ * (tinyllvm_codegen_asm.c) and an ELF64 relocatable object writer.
+ *
+ *   - Only the dialect the backend prints is understood: AT&T syntax, its
+ *     instruction forms, labels, and the .text/.section/.globl/.type/
+ *     .size/.p2align/.string directives.
+ *   - Branches to labels always use rel32 forms and are resolved in
+ *     place. Calls become R_X86_64_PLT32 relocations against the callee,
+ *     local functions included, and %rip-relative references to .rodata
+ *     become R_X86_64_PC32 against the section symbol.
+ *   - Symbols that are referenced but never defined (printf) become
+ *     undefined globals for the linker to resolve.
+ *
+ * Sections: .text, .rodata, .rela.text, .symtab, .strtab, .shstrtab and an
+ * empty .note.GNU-stack that keeps the stack non-executable.
+ */
+
+#include "include/tinyllvm_elf.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <ctype.h>
+
+/* ELF64 constants from the System V gABI and the x86-64 psABI */
+#define ELF_HEADER_SIZE     64
+#define ELF_SECTION_SIZE    64
+#define ELF_SYMBOL_SIZE     24
+#define ELF_RELA_SIZE       24
+
+#define SHT_PROGBITS        1
+#define SHT_SYMTAB          2
+#define SHT_STRTAB          3
+#define SHT_RELA            4
+
+#define SHF_ALLOC           0x2
+#define SHF_EXECINSTR       0x4
+#define SHF_INFO_LINK       0x40
+
+#define STB_LOCAL           0
+#define STB_GLOBAL          1
+#define STT_NOTYPE          0
+#define STT_FUNC            2
+#define STT_SECTION         3
+
+#define R_X86_64_PC32       2
+#define R_X86_64_PLT32      4
+
+/* Output section header indices */
+enum {
+    SHDR_NULL, SHDR_TEXT, SHDR_RODATA, SHDR_RELA_TEXT, SHDR_SYMTAB, SHDR_STRTAB,
+    SHDR_SHSTRTAB, SHDR_NOTE, SHDR_COUNT
+};
+
+/* Sections the assembler writes into */
+typedef enum {
+    SEC_TEXT,
+    SEC_RODATA,
+    SEC_NOTE,
+    SEC_COUNT
+} AsmSection;
+
+static const int section_header[SEC_COUNT] = { SHDR_TEXT, SHDR_RODATA, SHDR_NOTE };
+
+/* ==============================================================================
+ * Byte Buffers
+ * ==============================================================================
+ */
+
+typedef struct {
+    uint8_t *data;
+    size_t size;
+    size_t capacity;
+} ByteBuffer;
+
+static bool buffer_reserve(ByteBuffer *b, size_t additional) {
+    size_t needed = b->size + additional;
+    if (needed <= b->capacity) return true;
+
+    size_t new_capacity = b->capacity == 0 ? 256 : b->capacity;
+    while (new_capacity < needed) {
+        new_capacity *= 2;
+    }
+
+    uint8_t *new_data = realloc(b->data, new_capacity);
+    if (!new_data) return false;
+
+    b->data = new_data;
+    b->capacity = new_capacity;
+    return true;
+}
+
+static bool buffer_put(ByteBuffer *b, const void *data, size_t size) {
+    if (!buffer_reserve(b, size)) return false;
+    if (size > 0) memcpy(b->data + b->size, data, size);
+    b->size += size;
+    return true;
+}
+
+/* Little-endian, whatever the host */
+static bool buffer_le(ByteBuffer *b, uint64_t value, size_t bytes) {
+    uint8_t out[8];
+    for (size_t i = 0; i < bytes; i++) {
+        out[i] = (uint8_t)(value >> (8 * i));
+    }
+    return buffer_put(b, out, bytes);
+}
+
+static void buffer_patch_u32(ByteBuffer *b, size_t at, uint32_t value) {
+    for (size_t i = 0; i < 4; i++) {
+        b->data[at + i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+static bool buffer_fill(ByteBuffer *b, uint8_t byte, size_t count) {
+    if (!buffer_reserve(b, count)) return false;
+    if (count > 0) memset(b->data + b->size, byte, count);
+    b->size += count;
+    return true;
+}
+
+static bool buffer_align(ByteBuffer *b, size_t alignment, uint8_t fill) {
+    size_t padding = (alignment - b->size % alignment) % alignment;
+    return buffer_fill(b, fill, padding);
+}
+
+/* ==============================================================================
+ * Assembler State
+ * ==============================================================================
+ */
+
+typedef struct {
+    char *name;
+    int section;            /* AsmSection, or -1 while undefined */
+    uint64_t value;
+    uint64_t size;
+    bool global;
+    bool function;
+    uint32_t index;         /* Symbol table index, once laid out */
+} AsmSymbol;
+
+typedef enum {
+    FIXUP_BRANCH,           /* rel32 to a label in .text, resolved here */
+    FIXUP_CALL,             /* R_X86_64_PLT32 */
+    FIXUP_PC32              /* R_X86_64_PC32 */
+} FixupKind;
+
+typedef struct {
+    FixupKind kind;
+    size_t at;              /* Offset of the 32-bit field in .text */
+    size_t symbol;
+    int64_t addend;
+    int line;
+} Fixup;
+
+typedef struct {
+    ByteBuffer sections[SEC_COUNT];
+    AsmSection current;
+
+    AsmSymbol *symbols;
+    size_t symbol_count;
+    size_t symbol_capacity;
+    size_t *symbol_hash;    /* Open addressing; entries are index + 1 */
+    size_t hash_capacity;
+
+    Fixup *fixups;
+    size_t fixup_count;
+    size_t fixup_capacity;
+
+    int line;
+    char *error;
+    size_t error_size;
+} Assembler;
+
+static bool fail(Assembler *a, const char *format, ...) {
+    if (!a->error || a->error_size == 0) return false;
+
+    int len = snprintf(a->error, a->error_size, "line %d: ", a->line);
+    if (len >= 0 && (size_t)len < a->error_size) {
+        va_list args;
+        va_start(args, format);
+        vsnprintf(a->error + len, a->error_size - (size_t)len, format, args);
+        va_end(args);
+    }
+    return false;
+}
+
+static bool grow(void **items, size_t *capacity, size_t needed, size_t item_size) {
+    if (needed <= *capacity) return true;
+
+    size_t new_capacity = *capacity == 0 ? 64 : *capacity * 2;
+    while (new_capacity < needed) {
+        new_capacity *= 2;
+    }
+
+    void *new_items = realloc(*items, new_capacity * item_size);
+    if (!new_items) return false;
+
+    *items = new_items;
+    *capacity = new_capacity;
+    return true;
+}
+
+/* FNV-1a */
+static size_t hash_name(const char *name, size_t length) {
+    size_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ (unsigned char)name[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static bool rehash(Assembler *a) {
+    size_t capacity = a->hash_capacity == 0 ? 128 : a->hash_capacity * 2;
+    size_t *table = calloc(capacity, sizeof(size_t));
+    if (!table) return false;
+
+    for (size_t i = 0; i < a->symbol_count; i++) {
+        size_t slot = hash_name(a->symbols[i].name, strlen(a->symbols[i].name)) & (capacity - 1);
+        while (table[slot] != 0) slot = (slot + 1) & (capacity - 1);
+        table[slot] = i + 1;
+    }
+
+    free(a->symbol_hash);
+    a->symbol_hash = table;
+    a->hash_capacity = capacity;
+    return true;
+}
+
+/* The symbol with this name, created undefined on first mention; -1 if
+ * out of memory */
+static long symbol_lookup(Assembler *a, const char *name, size_t length) {
+    size_t hash = hash_name(name, length);
+    if (a->hash_capacity > 0) {
+        size_t slot = hash & (a->hash_capacity - 1);
+        while (a->symbol_hash[slot] != 0) {
+            const AsmSymbol *sym = &a->symbols[a->symbol_hash[slot] - 1];
+            if (strlen(sym->name) == length && memcmp(sym->name, name, length) == 0) {
+                return (long)(a->symbol_hash[slot] - 1);
+            }
+            slot = (slot + 1) & (a->hash_capacity - 1);
+        }
+    }
+
+    if ((a->symbol_count + 1) * 2 > a->hash_capacity && !rehash(a)) return -1;
+    if (!grow((void **)&a->symbols, &a->symbol_capacity, a->symbol_count + 1,
+              sizeof(AsmSymbol))) {
+        return -1;
+    }
+
+    AsmSymbol *sym = &a->symbols[a->symbol_count];
+    memset(sym, 0, sizeof(*sym));
+    sym->name = malloc(length + 1);
+    if (!sym->name) return -1;
+    memcpy(sym->name, name, length);
+    sym->name[length] = '\0';
+    sym->section = -1;
+
+    size_t slot = hash & (a->hash_capacity - 1);
+    while (a->symbol_hash[slot] != 0) slot = (slot + 1) & (a->hash_capacity - 1);
+    a->symbol_hash[slot] = a->symbol_count + 1;
+    return (long)a->symbol_count++;
+}
+
+/* .L names are assembler-local: never written to the symbol table */
+static bool is_local_label(const AsmSymbol *sym) {
+    return strncmp(sym->name, ".L", 2) == 0;
+}
+
+static ByteBuffer *current_section(Assembler *a) {
+    return &a->sections[a->current];
+}
+
+static bool add_fixup(Assembler *a, FixupKind kind, size_t symbol, int64_t addend) {
+    if (!grow((void **)&a->fixups, &a->fixup_capacity, a->fixup_count + 1, sizeof(Fixup))) {
+        return fail(a, "out of memory");
+    }
+    Fixup *f = &a->fixups[a->fixup_count++];
+    f->kind = kind;
+    f->at = current_section(a)->size;
+    f->symbol = symbol;
+    f->addend = addend;
+    f->line = a->line;
+    return true;
+}
+
+/* ==============================================================================
+ * Operands
+ * ==============================================================================
+ */
+
+#define REG_RIP  16
+
+typedef struct {
+    const char *name;
+    int number;
+    int width;
+} RegisterName;
+
+static const RegisterName register_names[] = {
+    { "rax", 0, 64 }, { "rcx", 1, 64 }, { "rdx", 2, 64 }, { "rbx", 3, 64 },
+    { "rsp", 4, 64 }, { "rbp", 5, 64 }, { "rsi", 6, 64 }, { "rdi", 7, 64 },
+    { "r8", 8, 64 }, { "r9", 9, 64 }, { "r10", 10, 64 }, { "r11", 11, 64 },
+    { "r12", 12, 64 }, { "r13", 13, 64 }, { "r14", 14, 64 }, { "r15", 15, 64 },
+    { "eax", 0, 32 }, { "ecx", 1, 32 }, { "edx", 2, 32 }, { "ebx", 3, 32 },
+    { "esp", 4, 32 }, { "ebp", 5, 32 }, { "esi", 6, 32 }, { "edi", 7, 32 },
+    { "r8d", 8, 32 }, { "r9d", 9, 32 }, { "r10d", 10, 32 }, { "r11d", 11, 32 },
+    { "r12d", 12, 32 }, { "r13d", 13, 32 }, { "r14d", 14, 32 }, { "r15d", 15, 32 },
+    { "al", 0, 8 }, { "cl", 1, 8 }, { "dl", 2, 8 }, { "bl", 3, 8 },
+    { "rip", REG_RIP, 64 }
+};
+
+typedef enum {
+    OPERAND_REG,            /* %reg */
+    OPERAND_IMM,            /* $imm */
+    OPERAND_MEM,            /* disp(base, index, scale) */
+    OPERAND_SYMBOL          /* Branch or call target */
+} OperandKind;
+
+typedef struct {
+    OperandKind kind;
+    int reg;
+    int width;
+    int64_t imm;
+    int base;               /* -1 if absent, REG_RIP for %rip */
+    int index;              /* -1 if absent */
+    int scale;
+    int64_t disp;
+    long symbol;            /* Displacement symbol or target, -1 if none */
+} Operand;
+
+static char *trim(char *s) {
+    while (isspace((unsigned char)*s)) s++;
+    size_t len = strlen(s);
+    while (len > 0 && isspace((unsigned char)s[len - 1])) s[--len] = '\0';
+    return s;
+}
+
+static bool parse_number(const char *text, int64_t *value) {
+    if (!*text) return false;
+    char *end;
+    long long parsed = strtoll(text, &end, 0);
+    if (*end != '\0') return false;
+    *value = (int64_t)parsed;
+    return true;
+}
+
+static bool parse_register(Assembler *a, const char *text, int *number, int *width) {
+    if (*text != '%') return fail(a, "expected a register, got '%s'", text);
+    for (size_t i = 0; i < sizeof(register_names) / sizeof(register_names[0]); i++) {
+        if (strcmp(register_names[i].name, text + 1) == 0) {
+            *number = register_names[i].number;
+            *width = register_names[i].width;
+            return true;
+        }
+    }
+    return fail(a, "unknown register '%s'", text);
+}
+
+static bool is_symbol_name(const char *text) {
+    if (!*text || isdigit((unsigned char)*text) || *text == '-') return false;
+    for (const char *p = text; *p; p++) {
+        if (!isalnum((unsigned char)*p) && *p != '_' && *p != '.' && *p != '$') return false;
+    }
+    return true;
+}
+
+static bool parse_operand(Assembler *a, char *text, Operand *op) {
+    memset(op, 0, sizeof(*op));
+    op->base = -1;
+    op->index = -1;
+    op->scale = 1;
+    op->symbol = -1;
+    text = trim(text);
+
+    if (*text == '%') {
+        op->kind = OPERAND_REG;
+        return parse_register(a, text, &op->reg, &op->width);
+    }
+    if (*text == '$') {
+        op->kind = OPERAND_IMM;
+        if (!parse_number(text + 1, &op->imm)) return fail(a, "bad immediate '%s'", text);
+        return true;
+    }
+
+    char *open = strchr(text, '(');
+    if (!open) {
+        /* Branch or call target; @PLT only says how to reach it */
+        size_t length = strlen(text);
+        if (length > 4 && strcmp(text + length - 4, "@PLT") == 0) text[length - 4] = '\0';
+        if (!is_symbol_name(text)) return fail(a, "bad operand '%s'", text);
+        op->kind = OPERAND_SYMBOL;
+        op->symbol = symbol_lookup(a, text, strlen(text));
+        return op->symbol >= 0 || fail(a, "out of memory");
+    }
+
+    op->kind = OPERAND_MEM;
+    char *close = strchr(open, ')');
+    if (!close || close[1] != '\0') return fail(a, "bad memory operand '%s'", text);
+    *open = '\0';
+    *close = '\0';
+
+    char *disp = trim(text);
+    if (*disp && !parse_number(disp, &op->disp)) {
+        if (!is_symbol_name(disp)) return fail(a, "bad displacement '%s'", disp);
+        op->symbol = symbol_lookup(a, disp, strlen(disp));
+        if (op->symbol < 0) return fail(a, "out of memory");
+    }
+
+    /* (base), (base,index), (base,index,scale) or (,index,scale) */
+    char *parts[3] = { open + 1, NULL, NULL };
+    size_t count = 1;
+    for (char *p = open + 1; *p && count < 3; p++) {
+        if (*p == ',') {
+            *p = '\0';
+            parts[count++] = p + 1;
+        }
+    }
+
+    int width;
+    char *base = trim(parts[0]);
+    if (*base && !parse_register(a, base, &op->base, &width)) return false;
+    if (count > 1 && !parse_register(a, trim(parts[1]), &op->index, &width)) return false;
+    if (count > 2) {
+        int64_t scale;
+        if (!parse_number(trim(parts[2]), &scale) ||
+            (scale != 1 && scale != 2 && scale != 4 && scale != 8)) {
+            return fail(a, "bad scale in memory operand");
+        }
+        op->scale = (int)scale;
+    }
+    if (op->index == 4 || op->index == REG_RIP) return fail(a, "bad index register");
+    if (op->symbol >= 0 && op->base != REG_RIP) return fail(a, "symbols need %%rip addressing");
+    if (op->base < 0 && op->index < 0) return fail(a, "absolute addresses are not supported");
+    return true;
+}
+
+/* ==============================================================================
+ * Encoding
+ * ==============================================================================
+ */
+
+static bool fits_int8(int64_t value) {
+    return value >= -128 && value <= 127;
+}
+
+static bool fits_int32(int64_t value) {
+    return value >= INT32_MIN && value <= INT32_MAX;
+}
+
+static bool emit_bytes(Assembler *a, const uint8_t *bytes, size_t count) {
+    return buffer_put(current_section(a), bytes, count) || fail(a, "out of memory");
+}
+
+static bool emit_byte(Assembler *a, uint8_t byte) {
+    return emit_bytes(a, &byte, 1);
+}
+
+static bool emit_le(Assembler *a, int64_t value, size_t bytes) {
+    return buffer_le(current_section(a), (uint64_t)value, bytes) || fail(a, "out of memory");
+}
+
+static bool emit_imm(Assembler *a, int64_t value, size_t bytes) {
+    if (bytes == 1 ? !fits_int8(value) : !fits_int32(value)) {
+        return fail(a, "immediate %lld out of range", (long long)value);
+    }
+    return emit_le(a, value, bytes);
+}
+
+/* REX prefix, when the operand size or a high register needs one */
+static bool emit_rex(Assembler *a, bool wide, int reg, const Operand *rm) {
+    int r = reg >= 8 && reg < REG_RIP;
+    int x = 0, b = 0;
+    if (rm->kind == OPERAND_REG) {
+        b = rm->reg >= 8;
+    } else if (rm->kind == OPERAND_MEM) {
+        b = rm->base >= 8 && rm->base != REG_RIP;
+        x = rm->index >= 8;
+    }
+    if (!wide && !r && !x && !b) return true;
+    return emit_byte(a, (uint8_t)(0x40 | (wide ? 8 : 0) | r << 2 | x << 1 | b));
+}
+
+/* ModRM, plus SIB and displacement, for reg_field and the r/m operand.
+ * trailing is the size of any immediate after it, which a %rip-relative
+ * relocation must account for */
+static bool emit_modrm(Assembler *a, int reg_field, const Operand *rm, size_t trailing) {
+    int reg = (reg_field & 7) << 3;
+
+    if (rm->kind == OPERAND_REG) return emit_byte(a, (uint8_t)(0xC0 | reg | (rm->reg & 7)));
+    if (rm->kind != OPERAND_MEM) return fail(a, "expected a register or memory operand");
+    if (!fits_int32(rm->disp)) return fail(a, "displacement out of range");
+
+    if (rm->base == REG_RIP) {
+        if (!emit_byte(a, (uint8_t)(0x05 | reg))) return false;
+        if (rm->symbol >= 0 &&
+            !add_fixup(a, FIXUP_PC32, (size_t)rm->symbol, rm->disp - 4 - (int64_t)trailing)) {
+            return false;
+        }
+        return emit_le(a, rm->symbol >= 0 ? 0 : rm->disp, 4);
+    }
+
+    static const uint8_t scale_bits[9] = { 0, 0, 1, 0, 2, 0, 0, 0, 3 };
+    uint8_t sib_scale = (uint8_t)(scale_bits[rm->scale] << 6);
+    int index = rm->index >= 0 ? rm->index & 7 : 4;
+
+    if (rm->base < 0) {
+        /* No base: SIB with base 101 and mod 00 takes a disp32 */
+        return emit_byte(a, (uint8_t)(0x04 | reg)) &&
+               emit_byte(a, (uint8_t)(sib_scale | index << 3 | 5)) &&
+               emit_le(a, rm->disp, 4);
+    }
+
+    int base = rm->base & 7;
+    int mod = rm->disp == 0 && base != 5 ? 0 : fits_int8(rm->disp) ? 1 : 2;
+    bool sib = rm->index >= 0 || base == 4;
+
+    if (!emit_byte(a, (uint8_t)(mod << 6 | reg | (sib ? 4 : base)))) return false;
+    if (sib && !emit_byte(a, (uint8_t)(sib_scale | index << 3 | base))) return false;
+    if (mod == 1) return emit_le(a, rm->disp, 1);
+    if (mod == 2) return emit_le(a, rm->disp, 4);
+    return true;
+}
+
+/* [REX] opcode ModRM..., where reg is a register or an opcode extension */
+static bool encode(Assembler *a, bool wide, const uint8_t *opcode, size_t opcode_size,
+                   int reg, const Operand *rm, size_t trailing) {
+    return emit_rex(a, wide, reg, rm) && emit_bytes(a, opcode, opcode_size) &&
+           emit_modrm(a, reg, rm, trailing);
+}
+
+static bool encode1(Assembler *a, bool wide, uint8_t opcode, int reg, const Operand *rm,
+                    size_t trailing) {
+    return encode(a, wide, &opcode, 1, reg, rm, trailing);
+}
+
+static bool encode_0f(Assembler *a, bool wide, uint8_t opcode, int reg, const Operand *rm) {
+    const uint8_t bytes[2] = { 0x0F, opcode };
+    return encode(a, wide, bytes, 2, reg, rm, 0);
+}
+
+static bool is_rm(const Operand *op) {
+    return op->kind == OPERAND_REG || op->kind == OPERAND_MEM;
+}
+
+static int condition_code(const char *name) {
+    static const struct {
+        const char *name;
+        int code;
+    } codes[] = {
+        { "o", 0 }, { "no", 1 }, { "b", 2 }, { "ae", 3 }, { "e", 4 }, { "z", 4 },
+        { "ne", 5 }, { "nz", 5 }, { "be", 6 }, { "a", 7 }, { "s", 8 }, { "ns", 9 },
+        { "p", 10 }, { "np", 11 }, { "l", 12 }, { "ge", 13 }, { "le", 14 }, { "g", 15 }
+    };
+    for (size_t i = 0; i < sizeof(codes) / sizeof(codes[0]); i++) {
+        if (strcmp(codes[i].name, name) == 0) return codes[i].code;
+    }
+    return -1;
+}
+
+/* rel32 branch or call to a symbol */
+static bool encode_branch(Assembler *a, const uint8_t *opcode, size_t size, const Operand *target,
+                          FixupKind kind) {
+    if (target->kind != OPERAND_SYMBOL) return fail(a, "expected a label");
+    return emit_bytes(a, opcode, size) &&
+           add_fixup(a, kind, (size_t)target->symbol, -4) && emit_le(a, 0, 4);
+}
+
+/* add, or, and, sub, xor and cmp share one encoding pattern */
+static bool encode_alu(Assembler *a, int group, bool wide, const Operand *src, const Operand *dst) {
+    if (!is_rm(dst)) return fail(a, "bad destination");
+
+    if (src->kind == OPERAND_IMM) {
+        if (fits_int8(src->imm)) return encode1(a, wide, 0x83, group, dst, 1) && emit_imm(a, src->imm, 1);
+        return encode1(a, wide, 0x81, group, dst, 4) && emit_imm(a, src->imm, 4);
+    }
+    if (src->kind == OPERAND_REG) return encode1(a, wide, (uint8_t)(group << 3 | 1), src->reg, dst, 0);
+    if (src->kind == OPERAND_MEM && dst->kind == OPERAND_REG) {
+        return encode1(a, wide, (uint8_t)(group << 3 | 3), dst->reg, src, 0);
+    }
+    return fail(a, "bad operands");
+}
+
+static bool encode_mov(Assembler *a, bool wide, const Operand *src, const Operand *dst) {
+    if (src->kind == OPERAND_IMM) {
+        if (dst->kind == OPERAND_REG && !wide) {
+            Operand none = { .kind = OPERAND_REG, .reg = dst->reg };
+            return emit_rex(a, false, 0, &none) && emit_byte(a, (uint8_t)(0xB8 | (dst->reg & 7))) &&
+                   emit_imm(a, src->imm, 4);
+        }
+        return is_rm(dst) && encode1(a, wide, 0xC7, 0, dst, 4) && emit_imm(a, src->imm, 4);
+    }
+    if (src->kind == OPERAND_REG && is_rm(dst)) return encode1(a, wide, 0x89, src->reg, dst, 0);
+    if (src->kind == OPERAND_MEM && dst->kind == OPERAND_REG) {
+        return encode1(a, wide, 0x8B, dst->reg, src, 0);
+    }
+    return fail(a, "bad operands");
+}
+
+/* push and pop take 64-bit registers without REX.W */
+static bool encode_stack_op(Assembler *a, uint8_t base_opcode, const Operand *op) {
+    if (op->kind != OPERAND_REG) return fail(a, "expected a register");
+    return (op->reg < 8 || emit_byte(a, 0x41)) && emit_byte(a, (uint8_t)(base_opcode | (op->reg & 7)));
+}
+
+static bool encode_push(Assembler *a, const Operand *op) {
+    if (op->kind == OPERAND_IMM) {
+        if (fits_int8(op->imm)) return emit_byte(a, 0x6A) && emit_imm(a, op->imm, 1);
+        return emit_byte(a, 0x68) && emit_imm(a, op->imm, 4);
+    }
+    if (op->kind == OPERAND_MEM) return encode1(a, false, 0xFF, 6, op, 0);
+    return encode_stack_op(a, 0x50, op);
+}
+
+static bool expect_operands(Assembler *a, size_t count, size_t expected) {
+    return count == expected || fail(a, "expected %zu operand(s)", expected);
+}
+
+static bool assemble_instruction(Assembler *a, const char *mnemonic, Operand *ops, size_t count) {
+    static const uint8_t jmp[] = { 0xE9 };
+    static const uint8_t call[] = { 0xE8 };
+
+    if (a->current != SEC_TEXT) return fail(a, "instruction outside .text");
+
+    if (strcmp(mnemonic, "ret") == 0) return expect_operands(a, count, 0) && emit_byte(a, 0xC3);
+    if (strcmp(mnemonic, "leave") == 0) return expect_operands(a, count, 0) && emit_byte(a, 0xC9);
+    if (strcmp(mnemonic, "cltd") == 0) return expect_operands(a, count, 0) && emit_byte(a, 0x99);
+    if (strcmp(mnemonic, "jmp") == 0) {
+        return expect_operands(a, count, 1) && encode_branch(a, jmp, 1, &ops[0], FIXUP_BRANCH);
+    }
+    if (strcmp(mnemonic, "call") == 0) {
+        return expect_operands(a, count, 1) && encode_branch(a, call, 1, &ops[0], FIXUP_CALL);
+    }
+    if (strcmp(mnemonic, "movslq") == 0) {
+        return expect_operands(a, count, 2) && ops[1].kind == OPERAND_REG && is_rm(&ops[0])
+            ? encode1(a, true, 0x63, ops[1].reg, &ops[0], 0) : fail(a, "bad operands");
+    }
+    if (strcmp(mnemonic, "movzbl") == 0) {
+        return expect_operands(a, count, 2) && ops[1].kind == OPERAND_REG && is_rm(&ops[0])
+            ? encode_0f(a, false, 0xB6, ops[1].reg, &ops[0]) : fail(a, "bad operands");
+    }
+
+    /* jcc, setcc and cmovcc[l] */
+    int cc;
+    if (mnemonic[0] == 'j' && (cc = condition_code(mnemonic + 1)) >= 0) {
+        const uint8_t opcode[] = { 0x0F, (uint8_t)(0x80 | cc) };
+        return expect_operands(a, count, 1) && encode_branch(a, opcode, 2, &ops[0], FIXUP_BRANCH);
+    }
+    if (strncmp(mnemonic, "set", 3) == 0 && (cc = condition_code(mnemonic + 3)) >= 0) {
+        return expect_operands(a, count, 1) && is_rm(&ops[0]) &&
+               encode_0f(a, false, (uint8_t)(0x90 | cc), 0, &ops[0]);
+    }
+    if (strncmp(mnemonic, "cmov", 4) == 0) {
+        char name[8];
+        snprintf(name, sizeof(name), "%s", mnemonic + 4);
+        cc = condition_code(name);
+        size_t length = strlen(name);
+        if (cc < 0 && length > 1 && name[length - 1] == 'l') {
+            name[length - 1] = '\0';
+            cc = condition_code(name);
+        }
+        if (cc < 0) return fail(a, "unknown instruction '%s'", mnemonic);
+        return expect_operands(a, count, 2) && ops[1].kind == OPERAND_REG && is_rm(&ops[0])
+            ? encode_0f(a, false, (uint8_t)(0x40 | cc), ops[1].reg, &ops[0]) : fail(a, "bad operands");
+    }
+
+    /* The rest carry an operand-size suffix: l (32-bit) or q (64-bit) */
+    size_t length = strlen(mnemonic);
+    char suffix = length > 1 ? mnemonic[length - 1] : '\0';
+    if (suffix != 'l' && suffix != 'q') return fail(a, "unknown instruction '%s'", mnemonic);
+    bool wide = suffix == 'q';
+
+    char stem[16];
+    if (length - 1 >= sizeof(stem)) return fail(a, "unknown instruction '%s'", mnemonic);
+    memcpy(stem, mnemonic, length - 1);
+    stem[length - 1] = '\0';
+
+    static const struct {
+        const char *name;
+        int group;
+    } alu[] = {
+        { "add", 0 }, { "or", 1 }, { "and", 4 }, { "sub", 5 }, { "xor", 6 }, { "cmp", 7 }
+    };
+    for (size_t i = 0; i < sizeof(alu) / sizeof(alu[0]); i++) {
+        if (strcmp(stem, alu[i].name) == 0) {
+            return expect_operands(a, count, 2) && encode_alu(a, alu[i].group, wide, &ops[0], &ops[1]);
+        }
+    }
+
+    static const struct {
+        const char *name;
+        int extension;
+    } shifts[] = { { "sal", 4 }, { "shl", 4 }, { "shr", 5 }, { "sar", 7 } };
+    for (size_t i = 0; i < sizeof(shifts) / sizeof(shifts[0]); i++) {
+        if (strcmp(stem, shifts[i].name) != 0) continue;
+        if (!expect_operands(a, count, 2) || !is_rm(&ops[1])) return fail(a, "bad operands");
+        if (ops[0].kind == OPERAND_IMM && ops[0].imm == 1) {
+            return encode1(a, wide, 0xD1, shifts[i].extension, &ops[1], 0);
+        }
+        if (ops[0].kind == OPERAND_IMM) {
+            return encode1(a, wide, 0xC1, shifts[i].extension, &ops[1], 1) &&
+                   emit_imm(a, ops[0].imm, 1);
+        }
+        if (ops[0].kind == OPERAND_REG && ops[0].reg == 1 && ops[0].width == 8) {
+            return encode1(a, wide, 0xD3, shifts[i].extension, &ops[1], 0);
+        }
+        return fail(a, "shift count must be an immediate or %%cl");
+    }
+
+    if (strcmp(stem, "mov") == 0) {
+        return expect_operands(a, count, 2) && encode_mov(a, wide, &ops[0], &ops[1]);
+    }
+    if (strcmp(stem, "test") == 0) {
+        return expect_operands(a, count, 2) && ops[0].kind == OPERAND_REG && is_rm(&ops[1])
+            ? encode1(a, wide, 0x85, ops[0].reg, &ops[1], 0) : fail(a, "bad operands");
+    }
+    if (strcmp(stem, "lea") == 0) {
+        return expect_operands(a, count, 2) && ops[0].kind == OPERAND_MEM &&
+               ops[1].kind == OPERAND_REG
+            ? encode1(a, wide, 0x8D, ops[1].reg, &ops[0], 0) : fail(a, "bad operands");
+    }
+    if (strcmp(stem, "idiv") == 0) {
+        return expect_operands(a, count, 1) && is_rm(&ops[0])
+            ? encode1(a, wide, 0xF7, 7, &ops[0], 0) : fail(a, "bad operands");
+    }
+    if (strcmp(stem, "imul") == 0) {
+        if (count == 2 && ops[0].kind != OPERAND_IMM) {
+            return ops[1].kind == OPERAND_REG && is_rm(&ops[0])
+                ? encode_0f(a, wide, 0xAF, ops[1].reg, &ops[0]) : fail(a, "bad operands");
+        }
+        /* imul $k, src, dst; the two-operand immediate form means src = dst */
+        const Operand *src = &ops[1];
+        const Operand *dst = count == 3 ? &ops[2] : &ops[1];
+        if ((count != 2 && count != 3) || ops[0].kind != OPERAND_IMM || !is_rm(src) ||
+            dst->kind != OPERAND_REG) {
+            return fail(a, "bad operands");
+        }
+        if (fits_int8(ops[0].imm)) {
+            return encode1(a, wide, 0x6B, dst->reg, src, 1) && emit_imm(a, ops[0].imm, 1);
+        }
+        return encode1(a, wide, 0x69, dst->reg, src, 4) && emit_imm(a, ops[0].imm, 4);
+    }
+    if (strcmp(stem, "push") == 0 && wide) {
+        return expect_operands(a, count, 1) && encode_push(a, &ops[0]);
+    }
+    if (strcmp(stem, "pop") == 0 && wide) {
+        return expect_operands(a, count, 1) && encode_stack_op(a, 0x58, &ops[0]);
+    }
+    return fail(a, "unknown instruction '%s'", mnemonic);
+}
+
+/* ==============================================================================
+ * Lines & Directives
+ * ==============================================================================
+ */
+
+static bool define_label(Assembler *a, const char *name) {
+    if (!is_symbol_name(name)) return fail(a, "bad label '%s'", name);
+
+    long index = symbol_lookup(a, name, strlen(name));
+    if (index < 0) return fail(a, "out of memory");
+
+    AsmSymbol *sym = &a->symbols[index];
+    if (sym->section >= 0) return fail(a, "label '%s' defined twice", name);
+    sym->section = (int)a->current;
+    sym->value = current_section(a)->size;
+    return true;
+}
+
+/* The symbol named by the first comma-separated argument */
+static AsmSymbol *directive_symbol(Assembler *a, char *args, char **rest) {
+    char *comma = strchr(args, ',');
+    if (comma) *comma = '\0';
+    if (rest) *rest = comma ? trim(comma + 1) : NULL;
+
+    char *name = trim(args);
+    if (!is_symbol_name(name)) {
+        fail(a, "bad symbol '%s'", name);
+        return NULL;
+    }
+    long index = symbol_lookup(a, name, strlen(name));
+    if (index < 0) {
+        fail(a, "out of memory");
+        return NULL;
+    }
+    return &a->symbols[index];
+}
+
+static bool directive_string(Assembler *a, const char *args) {
+    if (*args != '"') return fail(a, "expected a string");
+
+    ByteBuffer *section = current_section(a);
+    const char *p = args + 1;
+    while (*p && *p != '"') {
+        char c = *p++;
+        if (c == '\\') {
+            switch (*p++) {
+                case 'n':  c = '\n'; break;
+                case 't':  c = '\t'; break;
+                case '0':  c = '\0'; break;
+                case '\\': c = '\\'; break;
+                case '"':  c = '"';  break;
+                default:   return fail(a, "unsupported escape in string");
+            }
+        }
+        if (!buffer_put(section, &c, 1)) return fail(a, "out of memory");
+    }
+    if (*p != '"' || *trim((char *)p + 1) != '\0') return fail(a, "unterminated string");
+    return buffer_fill(section, 0, 1) || fail(a, "out of memory");
+}
+
+static bool assemble_directive(Assembler *a, const char *name, char *args) {
+    if (strcmp(name, ".text") == 0) {
+        a->current = SEC_TEXT;
+        return true;
+    }
+    if (strcmp(name, ".section") == 0) {
+        char *comma = strchr(args, ',');
+        if (comma) *comma = '\0';
+        args = trim(args);
+        if (strcmp(args, ".text") == 0) a->current = SEC_TEXT;
+        else if (strcmp(args, ".rodata") == 0) a->current = SEC_RODATA;
+        else if (strcmp(args, ".note.GNU-stack") == 0) a->current = SEC_NOTE;
+        else return fail(a, "unsupported section '%s'", args);
+        return true;
+    }
+    if (strcmp(name, ".globl") == 0 || strcmp(name, ".global") == 0) {
+        AsmSymbol *sym = directive_symbol(a, args, NULL);
+        if (sym) sym->global = true;
+        return sym != NULL;
+    }
+    if (strcmp(name, ".type") == 0) {
+        char *kind;
+        AsmSymbol *sym = directive_symbol(a, args, &kind);
+        if (!sym) return false;
+        if (!kind) return fail(a, "missing symbol type");
+        sym->function = strcmp(kind, "@function") == 0;
+        return true;
+    }
+    if (strcmp(name, ".size") == 0) {
+        /* Only the "name, .-name" form the backend emits */
+        char *expr;
+        AsmSymbol *sym = directive_symbol(a, args, &expr);
+        if (!sym) return false;
+        if (!expr || strncmp(expr, ".-", 2) != 0 || strcmp(expr + 2, sym->name) != 0 ||
+            sym->section != (int)a->current) {
+            return fail(a, "unsupported .size expression");
+        }
+        sym->size = current_section(a)->size - sym->value;
+        return true;
+    }
+    if (strcmp(name, ".p2align") == 0) {
+        int64_t power;
+        if (!parse_number(args, &power) || power < 0 || power > 12) {
+            return fail(a, "bad alignment");
+        }
+        uint8_t fill = a->current == SEC_TEXT ? 0x90 : 0;
+        return buffer_align(current_section(a), (size_t)1 << power, fill) || fail(a, "out of memory");
+    }
+    if (strcmp(name, ".string") == 0 || strcmp(name, ".asciz") == 0) {
+        return directive_string(a, args);
+    }
+    return fail(a, "unsupported directive '%s'", name);
+}
+
+static bool assemble_line(Assembler *a, char *line) {
+    char *text = trim(line);
+    if (*text == '\0' || *text == '#') return true;
+
+    size_t length = strlen(text);
+    if (text[length - 1] == ':') {
+        text[length - 1] = '\0';
+        return define_label(a, trim(text));
+    }
+
+    char *args = text;
+    while (*args && !isspace((unsigned char)*args)) args++;
+    if (*args) *args++ = '\0';
+    args = trim(args);
+
+    if (text[0] == '.') return assemble_directive(a, text, args);
+
+    /* Operands split at top-level commas */
+    Operand ops[3];
+    size_t count = 0;
+    char *start = args;
+    int depth = 0;
+    for (char *p = args; *start; p++) {
+        if (*p == '(') depth++;
+        if (*p == ')') depth--;
+        if ((*p == ',' && depth == 0) || *p == '\0') {
+            bool end = *p == '\0';
+            *p = '\0';
+            if (count >= 3) return fail(a, "too many operands");
+            if (!parse_operand(a, start, &ops[count++])) return false;
+            if (end) break;
+            start = p + 1;
+        }
+    }
+    return assemble_instruction(a, text, ops, count);
+}
+
+/* ==============================================================================
+ * Object File
+ * ==============================================================================
+ */
+
+static bool resolve_fixups(Assembler *a, ByteBuffer *rela) {
+    ByteBuffer *text = &a->sections[SEC_TEXT];
+
+    for (size_t i = 0; i < a->fixup_count; i++) {
+        const Fixup *f = &a->fixups[i];
+        const AsmSymbol *sym = &a->symbols[f->symbol];
+        a->line = f->line;
+
+        if (is_local_label(sym) && sym->section < 0) {
+            return fail(a, "undefined label '%s'", sym->name);
+        }
+
+        if (f->kind == FIXUP_BRANCH) {
+            if (sym->section != SEC_TEXT) return fail(a, "branch to '%s' outside .text", sym->name);
+            int64_t distance = (int64_t)sym->value - (int64_t)(f->at + 4);
+            buffer_patch_u32(text, f->at, (uint32_t)(int32_t)distance);
+            continue;
+        }
+
+        /* Local labels are reached through their section's symbol */
+        uint32_t index = sym->index;
+        int64_t addend = f->addend;
+        if (is_local_label(sym)) {
+            index = (uint32_t)(1 + sym->section);
+            addend += (int64_t)sym->value;
+        }
+
+        uint32_t type = f->kind == FIXUP_CALL ? R_X86_64_PLT32 : R_X86_64_PC32;
+        if (!buffer_le(rela, f->at, 8) ||
+            !buffer_le(rela, (uint64_t)index << 32 | type, 8) ||
+            !buffer_le(rela, (uint64_t)addend, 8)) {
+            return fail(a, "out of memory");
+        }
+    }
+    return true;
+}
+
+static bool write_symbol(ByteBuffer *symtab, uint32_t name, int bind, int type, uint16_t shndx,
+                         uint64_t value, uint64_t size) {
+    return buffer_le(symtab, name, 4) && buffer_le(symtab, (uint64_t)(bind << 4 | type), 1) &&
+           buffer_le(symtab, 0, 1) && buffer_le(symtab, shndx, 2) &&
+           buffer_le(symtab, value, 8) && buffer_le(symtab, size, 8);
+}
+
+/* Null and section symbols, then local functions, then globals; returns
+ * the index of the first global (the .symtab sh_info) */
+static bool build_symbols(Assembler *a, ByteBuffer *symtab, ByteBuffer *strtab, uint32_t *first_global) {
+    if (!buffer_fill(strtab, 0, 1)) return false;
+
+    uint32_t index = 0;
+    bool ok = write_symbol(symtab, 0, STB_LOCAL, STT_NOTYPE, 0, 0, 0);
+    for (int s = 0; ok && s < SEC_NOTE; s++) {
+        ok = write_symbol(symtab, 0, STB_LOCAL, STT_SECTION, (uint16_t)section_header[s], 0, 0);
+    }
+    index = 1 + SEC_NOTE;
+
+    for (int pass = 0; ok && pass < 2; pass++) {
+        bool globals = pass == 1;
+        if (globals) *first_global = index;
+
+        for (size_t i = 0; ok && i < a->symbol_count; i++) {
+            AsmSymbol *sym = &a->symbols[i];
+            if (is_local_label(sym)) continue;
+
+            /* Undefined symbols are imports, so global */
+            bool global = sym->global || sym->section < 0;
+            if (global != globals) continue;
+
+            sym->index = index++;
+            uint32_t name = (uint32_t)strtab->size;
+            ok = buffer_put(strtab, sym->name, strlen(sym->name) + 1) &&
+                 write_symbol(symtab, name, global ? STB_GLOBAL : STB_LOCAL,
+                              sym->function ? STT_FUNC : STT_NOTYPE,
+                              sym->section < 0 ? 0 : (uint16_t)section_header[sym->section],
+                              sym->value, sym->size);
+        }
+    }
+    return ok;
+}
+
+typedef struct {
+    uint32_t name;
+    uint32_t type;
+    uint64_t flags;
+    uint64_t offset;
+    uint64_t size;
+    uint32_t link;
+    uint32_t info;
+    uint64_t alignment;
+    uint64_t entry_size;
+} SectionHeader;
+
+static bool write_section_header(ByteBuffer *out, const SectionHeader *h) {
+    return buffer_le(out, h->name, 4) && buffer_le(out, h->type, 4) &&
+           buffer_le(out, h->flags, 8) && buffer_le(out, 0, 8) &&
+           buffer_le(out, h->offset, 8) && buffer_le(out, h->size, 8) &&
+           buffer_le(out, h->link, 4) && buffer_le(out, h->info, 4) &&
+           buffer_le(out, h->alignment, 8) && buffer_le(out, h->entry_size, 8);
+}
+
+/* Append a section's bytes at the given alignment and record where */
+static bool place_section(ByteBuffer *out, SectionHeader *h, const ByteBuffer *data, size_t alignment) {
+    if (!buffer_align(out, alignment, 0)) return false;
+    h->offset = out->size;
+    h->size = data->size;
+    h->alignment = alignment;
+    return buffer_put(out, data->data, data->size);
+}
+
+static ElfObject *write_object(Assembler *a) {
+    static const char shstrtab_text[] =
+        "\0.text\0.rodata\0.rela.text\0.symtab\0.strtab\0.shstrtab\0.note.GNU-stack";
+    static const uint32_t names[SHDR_COUNT] = { 0, 1, 7, 15, 26, 34, 42, 52 };
+
+    ByteBuffer rela = { 0 }, symtab = { 0 }, strtab = { 0 }, out = { 0 };
+    ByteBuffer shstrtab = { (uint8_t *)shstrtab_text, sizeof(shstrtab_text), 0 };
+    SectionHeader headers[SHDR_COUNT];
+    memset(headers, 0, sizeof(headers));
+
+    uint32_t first_global = 0;
+    bool ok = build_symbols(a, &symtab, &strtab, &first_global) || fail(a, "out of memory");
+    ok = ok && resolve_fixups(a, &rela);
+
+    ok = ok && buffer_fill(&out, 0, ELF_HEADER_SIZE);
+    ok = ok && place_section(&out, &headers[SHDR_TEXT], &a->sections[SEC_TEXT], 16) &&
+         place_section(&out, &headers[SHDR_RODATA], &a->sections[SEC_RODATA], 1) &&
+         place_section(&out, &headers[SHDR_RELA_TEXT], &rela, 8) &&
+         place_section(&out, &headers[SHDR_SYMTAB], &symtab, 8) &&
+         place_section(&out, &headers[SHDR_STRTAB], &strtab, 1) &&
+         place_section(&out, &headers[SHDR_SHSTRTAB], &shstrtab, 1) &&
+         place_section(&out, &headers[SHDR_NOTE], &a->sections[SEC_NOTE], 1);
+
+    headers[SHDR_TEXT].type = SHT_PROGBITS;
+    headers[SHDR_TEXT].flags = SHF_ALLOC | SHF_EXECINSTR;
+    headers[SHDR_RODATA].type = SHT_PROGBITS;
+    headers[SHDR_RODATA].flags = SHF_ALLOC;
+    headers[SHDR_RELA_TEXT].type = SHT_RELA;
+    headers[SHDR_RELA_TEXT].flags = SHF_INFO_LINK;
+    headers[SHDR_RELA_TEXT].link = SHDR_SYMTAB;
+    headers[SHDR_RELA_TEXT].info = SHDR_TEXT;
+    headers[SHDR_RELA_TEXT].entry_size = ELF_RELA_SIZE;
+    headers[SHDR_SYMTAB].type = SHT_SYMTAB;
+    headers[SHDR_SYMTAB].link = SHDR_STRTAB;
+    headers[SHDR_SYMTAB].info = first_global;
+    headers[SHDR_SYMTAB].entry_size = ELF_SYMBOL_SIZE;
+    headers[SHDR_STRTAB].type = SHT_STRTAB;
+    headers[SHDR_SHSTRTAB].type = SHT_STRTAB;
+    headers[SHDR_NOTE].type = SHT_PROGBITS;
+
+    ok = ok && buffer_align(&out, 8, 0);
+    size_t section_offset = out.size;
+    for (int i = 0; ok && i < SHDR_COUNT; i++) {
+        headers[i].name = names[i];
+        ok = write_section_header(&out, &headers[i]);
+    }
+
+    if (ok) {
+        /* ELF header: 64-bit, little-endian, relocatable, x86-64 */
+        static const uint8_t ident[16] = { 0x7F, 'E', 'L', 'F', 2, 1, 1, 0 };
+        ByteBuffer header = { 0 };
+        ok = buffer_put(&header, ident, sizeof(ident)) &&
+             buffer_le(&header, 1, 2) && buffer_le(&header, 62, 2) &&      /* ET_REL, EM_X86_64 */
+             buffer_le(&header, 1, 4) && buffer_le(&header, 0, 8) &&       /* version, entry */
+             buffer_le(&header, 0, 8) && buffer_le(&header, section_offset, 8) &&
+             buffer_le(&header, 0, 4) && buffer_le(&header, ELF_HEADER_SIZE, 2) &&
+             buffer_le(&header, 0, 2) && buffer_le(&header, 0, 2) &&       /* no program headers */
+             buffer_le(&header, ELF_SECTION_SIZE, 2) && buffer_le(&header, SHDR_COUNT, 2) &&
+             buffer_le(&header, SHDR_SHSTRTAB, 2);
+        if (ok) memcpy(out.data, header.data, ELF_HEADER_SIZE);
+        free(header.data);
+    }
+
+    free(rela.data);
+    free(symtab.data);
+    free(strtab.data);
+
+    ElfObject *object = ok ? malloc(sizeof(ElfObject)) : NULL;
+    if (!object) {
+        if (ok) fail(a, "out of memory");
+        free(out.data);
+        return NULL;
+    }
+    object->data = out.data;
+    object->size = out.size;
+    return object;
+}
+
+/* ==============================================================================
+ * Public API
+ * ==============================================================================
+ */
+
+ElfObject *elf_assemble_x86_64(const char *assembly, char *error, size_t error_size) {
+    if (error && error_size > 0) error[0] = '\0';
+
+    Assembler a;
+    memset(&a, 0, sizeof(a));
+    a.current = SEC_TEXT;
+    a.error = error;
+    a.error_size = error_size;
+
+    char *text = assembly ? strdup(assembly) : NULL;
+    bool ok = text != NULL || fail(&a, "no assembly");
+
+    for (char *line = text; ok && line;) {
+        char *next = strchr(line, '\n');
+        if (next) *next++ = '\0';
+        a.line++;
+        ok = assemble_line(&a, line);
+        line = next;
+    }
+    free(text);
+
+    ElfObject *object = ok ? write_object(&a) : NULL;
+
+    for (int s = 0; s < SEC_COUNT; s++) {
+        free(a.sections[s].data);
+    }
+    for (size_t i = 0; i < a.symbol_count; i++) {
+        free(a.symbols[i].name);
+    }
+    free(a.symbols);
+    free(a.symbol_hash);
+    free(a.fixups);
+    return object;
+}
+
+void elf_object_destroy(ElfObject *object) {
+    if (!object) return;
+    free(object->data);
+    free(object);
+}
+
+bool elf_object_write(const ElfObject *object, const char *path) {
+    if (!object || !path) return false;
+
+    FILE *file = fopen(path, "wb");
+    bool ok = file && fwrite(object->data, 1, object->size, file) == object->size;
+    if (file && fclose(file) != 0) ok = false;
+    return ok;
+}
+
+EventResult compiler_object_event(EventContext *context, void *user_data) {
+    (void)user_data;
+
+    EventResult result;
+
+    char *assembly;
+    EventChainErrorCode err = event_context_get(context, "output_code", (void **)&assembly);
+
+    if (err != EC_SUCCESS || !assembly) {
+        event_result_failure(&result, "No assembly provided to object writer",
+                             EC_ERROR_INVALID_PARAMETER, ERROR_DETAIL_FULL);
+        return result;
+    }
+
+    char error[256];
+    ElfObject *object = elf_assemble_x86_64(assembly, error, sizeof(error));
+    if (!object) {
+        event_result_failure(&result, error, EC_ERROR_EVENT_EXECUTION_FAILED, ERROR_DETAIL_FULL);
+        return result;
+    }
+
+    err = event_context_set_with_cleanup(context, "object_code", object,
+                                         (ValueCleanupFunc)elf_object_destroy);
+    if (err != EC_SUCCESS) {
+        elf_object_destroy(object);
+        event_result_failure(&result, "Failed to store object code in context",
+                             err, ERROR_DETAIL_FULL);
+        return result;
+    }
+
+    event_result_success(&result);
+    return result;
+}
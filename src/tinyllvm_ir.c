@@ -0,0 +1,248 @@
+/**
+ * ==============================================================================
+ * TinyLLVM Compiler - In-Memory IR
+ * ==============================================================================
+ *
+ * Arena allocation, module construction and control flow graph upkeep for
+ * the IR data structures in tinyllvm_ir.h.
+ */
+
+#include "include/tinyllvm_ir.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* ==============================================================================
+ * Arena
+ * ==============================================================================
+ */
+
+#define IR_ARENA_CHUNK_SIZE  (64 * 1024)
+#define IR_ARENA_ALIGN       16
+
+struct IRArenaChunk {
+    IRArenaChunk *next;
+    size_t used;
+    size_t capacity;
+};
+
+/* Chunk data starts after the header, rounded up to the alignment */
+#define IR_ARENA_HEADER \
+    ((sizeof(IRArenaChunk) + IR_ARENA_ALIGN - 1) & ~(size_t)(IR_ARENA_ALIGN - 1))
+
+void *ir_arena_alloc(IRArena *arena, size_t size) {
+    size = (size + IR_ARENA_ALIGN - 1) & ~(size_t)(IR_ARENA_ALIGN - 1);
+    if (size == 0) size = IR_ARENA_ALIGN;
+
+    IRArenaChunk *chunk = arena->chunks;
+    if (!chunk || chunk->capacity - chunk->used < size) {
+        size_t capacity = size > IR_ARENA_CHUNK_SIZE ? size : IR_ARENA_CHUNK_SIZE;
+        chunk = malloc(IR_ARENA_HEADER + capacity);
+        if (!chunk) return NULL;
+        chunk->used = 0;
+        chunk->capacity = capacity;
+        chunk->next = arena->chunks;
+        arena->chunks = chunk;
+    }
+
+    void *ptr = (unsigned char *)chunk + IR_ARENA_HEADER + chunk->used;
+    chunk->used += size;
+    memset(ptr, 0, size);
+    return ptr;
+}
+
+char *ir_arena_strdup(IRArena *arena, const char *str) {
+    size_t len = strlen(str);
+    char *copy = ir_arena_alloc(arena, len + 1);
+    if (copy) memcpy(copy, str, len + 1);
+    return copy;
+}
+
+void ir_arena_free(IRArena *arena) {
+    IRArenaChunk *chunk = arena->chunks;
+    while (chunk) {
+        IRArenaChunk *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    arena->chunks = NULL;
+}
+
+/* Grow an arena-allocated array to hold at least needed elements */
+static bool arena_grow(IRArena *arena, void **items, size_t *capacity, size_t needed,
+                       size_t elem_size) {
+    if (needed <= *capacity) return true;
+
+    size_t new_capacity = *capacity ? *capacity * 2 : 8;
+    while (new_capacity < needed) new_capacity *= 2;
+
+    void *grown = ir_arena_alloc(arena, new_capacity * elem_size);
+    if (!grown) return false;
+    if (*items) memcpy(grown, *items, *capacity * elem_size);
+
+    *items = grown;
+    *capacity = new_capacity;
+    return true;
+}
+
+/* ==============================================================================
+ * Modules, Functions & Blocks
+ * ==============================================================================
+ */
+
+IRModule *ir_module_create(void) {
+    return calloc(1, sizeof(IRModule));
+}
+
+void ir_module_destroy(IRModule *module) {
+    if (!module) return;
+    ir_arena_free(&module->arena);
+    free(module);
+}
+
+IRFunction *ir_module_add_function(IRModule *module, const char *name, IRType return_type,
+                                   size_t param_count) {
+    if (!arena_grow(&module->arena, (void **)&module->functions, &module->func_capacity,
+                    module->func_count + 1, sizeof(IRFunction *))) {
+        return NULL;
+    }
+
+    IRFunction *func = ir_arena_alloc(&module->arena, sizeof(IRFunction));
+    if (!func) return NULL;
+
+    func->name = ir_arena_strdup(&module->arena, name);
+    func->return_type = return_type;
+    func->param_count = param_count;
+    if (param_count > 0) {
+        func->params = ir_arena_alloc(&module->arena, param_count * sizeof(IRParam));
+        if (!func->params) return NULL;
+    }
+    if (!func->name) return NULL;
+
+    module->functions[module->func_count++] = func;
+    return func;
+}
+
+IRBlock *ir_function_add_block(IRModule *module, IRFunction *func, int label) {
+    if (!arena_grow(&module->arena, (void **)&func->blocks, &func->block_capacity,
+                    func->block_count + 1, sizeof(IRBlock *))) {
+        return NULL;
+    }
+
+    IRBlock *block = ir_arena_alloc(&module->arena, sizeof(IRBlock));
+    if (!block) return NULL;
+
+    block->label = label;
+    func->blocks[func->block_count++] = block;
+    return block;
+}
+
+IRInstr *ir_block_append(IRModule *module, IRBlock *block, const IRInstr *instr) {
+    if (!arena_grow(&module->arena, (void **)&block->instrs, &block->instr_capacity,
+                    block->instr_count + 1, sizeof(IRInstr))) {
+        return NULL;
+    }
+
+    IRInstr *copy = &block->instrs[block->instr_count];
+    *copy = *instr;
+    copy->operands = NULL;
+    copy->labels = NULL;
+    copy->name = NULL;
+
+    if (instr->operand_count > 0) {
+        copy->operands = ir_arena_alloc(&module->arena, instr->operand_count * sizeof(IRValue));
+        if (!copy->operands) return NULL;
+        memcpy(copy->operands, instr->operands, instr->operand_count * sizeof(IRValue));
+    }
+    if (instr->label_count > 0) {
+        copy->labels = ir_arena_alloc(&module->arena, instr->label_count * sizeof(int));
+        if (!copy->labels) return NULL;
+        memcpy(copy->labels, instr->labels, instr->label_count * sizeof(int));
+    }
+    if (instr->name) {
+        copy->name = ir_arena_strdup(&module->arena, instr->name);
+        if (!copy->name) return NULL;
+    }
+
+    block->instr_count++;
+    return copy;
+}
+
+int ir_module_new_temp(IRModule *module) {
+    return module->temp_count++;
+}
+
+int ir_module_new_label(IRModule *module) {
+    return module->label_count++;
+}
+
+/* ==============================================================================
+ * Queries & Control Flow
+ * ==============================================================================
+ */
+
+bool ir_opcode_is_terminator(IROpcode op) {
+    return op == IR_BR || op == IR_COND_BR || op == IR_RET;
+}
+
+bool ir_block_is_terminated(const IRBlock *block) {
+    return block->instr_count > 0 &&
+           ir_opcode_is_terminator(block->instrs[block->instr_count - 1].op);
+}
+
+size_t ir_function_find_block(const IRFunction *func, int label) {
+    if (label == IR_LABEL_NONE) return (size_t)-1;
+
+    for (size_t i = 0; i < func->block_count; i++) {
+        if (func->blocks[i]->label == label) return i;
+    }
+    return (size_t)-1;
+}
+
+static bool add_edge(IRModule *module, IRFunction *func, size_t from, size_t to) {
+    IRBlock *source = func->blocks[from];
+    IRBlock *target = func->blocks[to];
+
+    /* Both arms of a conditional branch may name the same block */
+    for (size_t i = 0; i < source->succ_count; i++) {
+        if (source->succs[i] == to) return true;
+    }
+
+    size_t *succs = ir_arena_alloc(&module->arena, (source->succ_count + 1) * sizeof(size_t));
+    size_t *preds = ir_arena_alloc(&module->arena, (target->pred_count + 1) * sizeof(size_t));
+    if (!succs || !preds) return false;
+
+    if (source->succ_count) memcpy(succs, source->succs, source->succ_count * sizeof(size_t));
+    if (target->pred_count) memcpy(preds, target->preds, target->pred_count * sizeof(size_t));
+    succs[source->succ_count++] = to;
+    preds[target->pred_count++] = from;
+    source->succs = succs;
+    target->preds = preds;
+    return true;
+}
+
+bool ir_function_compute_cfg(IRModule *module, IRFunction *func) {
+    for (size_t i = 0; i < func->block_count; i++) {
+        func->blocks[i]->pred_count = 0;
+        func->blocks[i]->succ_count = 0;
+    }
+
+    for (size_t i = 0; i < func->block_count; i++) {
+        IRBlock *block = func->blocks[i];
+
+        if (!ir_block_is_terminated(block)) {
+            /* Falls through into the next block in layout order */
+            if (i + 1 < func->block_count && !add_edge(module, func, i, i + 1)) return false;
+            continue;
+        }
+
+        const IRInstr *term = &block->instrs[block->instr_count - 1];
+        if (term->op == IR_RET) continue;
+
+        for (size_t j = 0; j < term->label_count; j++) {
+            size_t target = ir_function_find_block(func, term->labels[j]);
+            if (target == (size_t)-1) return false;
+            if (!add_edge(module, func, i, target)) return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,628 @@
+/**
+ * ==============================================================================
+ * TinyLLVM Compiler - IR Bytecode
+ * ==============================================================================
+ *
+ * Binary encoding of an IRModule. All multi-byte header fields are little
+ * endian; everything inside a function is an unsigned LEB128 varint, with
+ * signed values (labels, constants) zigzag-encoded first.
+ *
+ *   header    "TLIR", u8 version, u8 0, u16 0, u32 function count,
+ *             u32 string table offset, u32 temp count, u32 label count
+ *   index     per function: u32 name string, u32 offset, u32 size
+ *   strings   varint count, then per string: varint length, bytes
+ *   functions return type, params (name, type), blocks; per block its
+ *             label and instructions; per instruction opcode, type,
+ *             dest + 1, then cmp / imm / name as the opcode needs,
+ *             operands (index << 2 | kind), labels and print depth
+ *
+ * Predecessor and successor lists are not stored; they are recomputed when
+ * a function is decoded.
+ */
+
+#include "include/tinyllvm_ir.h"
+#include "include/eventchains_platform.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#if EC_PLATFORM_POSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define IR_BYTECODE_HEADER_SIZE  24
+#define IR_BYTECODE_INDEX_ENTRY  12
+
+/* ==============================================================================
+ * Writer
+ * ==============================================================================
+ */
+
+typedef struct {
+    uint8_t *data;
+    size_t length;
+    size_t capacity;
+    bool failed;
+} ByteBuffer;
+
+static void buffer_reserve(ByteBuffer *buf, size_t additional) {
+    if (buf->failed || buf->length + additional <= buf->capacity) return;
+
+    size_t capacity = buf->capacity ? buf->capacity : 1024;
+    while (capacity < buf->length + additional) capacity *= 2;
+
+    uint8_t *data = realloc(buf->data, capacity);
+    if (!data) {
+        buf->failed = true;
+        return;
+    }
+    buf->data = data;
+    buf->capacity = capacity;
+}
+
+static void buffer_bytes(ByteBuffer *buf, const void *bytes, size_t count) {
+    buffer_reserve(buf, count);
+    if (buf->failed) return;
+    memcpy(buf->data + buf->length, bytes, count);
+    buf->length += count;
+}
+
+static void buffer_u32_at(ByteBuffer *buf, size_t offset, uint32_t value) {
+    if (buf->failed) return;
+    for (int i = 0; i < 4; i++) buf->data[offset + i] = (uint8_t)(value >> (8 * i));
+}
+
+static void buffer_u32(ByteBuffer *buf, uint32_t value) {
+    buffer_reserve(buf, 4);
+    if (buf->failed) return;
+    buf->length += 4;
+    buffer_u32_at(buf, buf->length - 4, value);
+}
+
+static void buffer_varint(ByteBuffer *buf, uint64_t value) {
+    uint8_t bytes[10];
+    size_t count = 0;
+    do {
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        bytes[count++] = byte | (value ? 0x80 : 0);
+    } while (value);
+    buffer_bytes(buf, bytes, count);
+}
+
+static void buffer_signed(ByteBuffer *buf, int64_t value) {
+    buffer_varint(buf, ((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+}
+
+/* String table with open addressing on the name pointers' contents */
+typedef struct {
+    const char **strings;
+    size_t count;
+    size_t *slots;              /* string index + 1, 0 = empty */
+    size_t slot_count;
+} StringTable;
+
+static size_t hash_string(const char *str) {
+    size_t hash = 5381;
+    while (*str) hash = hash * 33 + (unsigned char)*str++;
+    return hash;
+}
+
+static bool strings_init(StringTable *table, size_t capacity) {
+    table->slot_count = 16;
+    while (table->slot_count < capacity * 2) table->slot_count *= 2;
+    table->strings = malloc(capacity * sizeof(char *));
+    table->slots = calloc(table->slot_count, sizeof(size_t));
+    table->count = 0;
+    return table->strings && table->slots;
+}
+
+static uint32_t strings_intern(StringTable *table, const char *str) {
+    size_t mask = table->slot_count - 1;
+    size_t slot = hash_string(str) & mask;
+
+    while (table->slots[slot]) {
+        size_t index = table->slots[slot] - 1;
+        if (strcmp(table->strings[index], str) == 0) return (uint32_t)index;
+        slot = (slot + 1) & mask;
+    }
+
+    table->strings[table->count] = str;
+    table->slots[slot] = ++table->count;
+    return (uint32_t)(table->count - 1);
+}
+
+/* Upper bound on distinct names, to size the table once */
+static size_t count_names(const IRModule *module) {
+    size_t count = 0;
+    for (size_t f = 0; f < module->func_count; f++) {
+        const IRFunction *func = module->functions[f];
+        count += 1 + func->param_count;
+        for (size_t b = 0; b < func->block_count; b++) {
+            count += func->blocks[b]->instr_count;
+        }
+    }
+    return count;
+}
+
+static bool op_has_name(IROpcode op) {
+    return op == IR_LOAD || op == IR_STORE || op == IR_ALLOCA || op == IR_CALL;
+}
+
+static void encode_function(ByteBuffer *buf, StringTable *strings, const IRFunction *func) {
+    buffer_varint(buf, func->return_type);
+    buffer_varint(buf, func->param_count);
+    for (size_t i = 0; i < func->param_count; i++) {
+        buffer_varint(buf, strings_intern(strings, func->params[i].name));
+        buffer_varint(buf, func->params[i].type);
+    }
+
+    buffer_varint(buf, func->block_count);
+    for (size_t b = 0; b < func->block_count; b++) {
+        const IRBlock *block = func->blocks[b];
+        buffer_signed(buf, block->label);
+        buffer_varint(buf, block->instr_count);
+
+        for (size_t i = 0; i < block->instr_count; i++) {
+            const IRInstr *instr = &block->instrs[i];
+            buffer_varint(buf, instr->op);
+            buffer_varint(buf, instr->type);
+            buffer_varint(buf, (uint64_t)(instr->dest + 1));
+
+            if (instr->op == IR_ICMP) buffer_varint(buf, instr->cmp);
+            if (instr->op == IR_CONST) buffer_signed(buf, instr->imm);
+            if (op_has_name(instr->op)) buffer_varint(buf, strings_intern(strings, instr->name));
+
+            buffer_varint(buf, instr->operand_count);
+            for (size_t j = 0; j < instr->operand_count; j++) {
+                IRValue value = instr->operands[j];
+                buffer_varint(buf, ((uint64_t)value.index << 2) | value.kind);
+            }
+            buffer_varint(buf, instr->label_count);
+            for (size_t j = 0; j < instr->label_count; j++) {
+                buffer_signed(buf, instr->labels[j]);
+            }
+            buffer_varint(buf, (uint64_t)instr->depth);
+        }
+    }
+}
+
+uint8_t *ir_bytecode_encode(const IRModule *module, size_t *size) {
+    if (!module || !size) return NULL;
+
+    StringTable strings = { 0 };
+    ByteBuffer header = { 0 }, body = { 0 };
+    size_t func_count = module->func_count;
+    uint32_t *name_index = malloc((func_count ? func_count : 1) * sizeof(uint32_t));
+    size_t *offsets = malloc((func_count + 1) * sizeof(size_t));
+    uint8_t *result = NULL;
+
+    if (!name_index || !offsets || !strings_init(&strings, count_names(module) + 1)) goto cleanup;
+
+    /* Function bodies first, so the string table is complete */
+    for (size_t f = 0; f < func_count; f++) {
+        name_index[f] = strings_intern(&strings, module->functions[f]->name);
+        offsets[f] = body.length;
+        encode_function(&body, &strings, module->functions[f]);
+    }
+    offsets[func_count] = body.length;
+
+    ByteBuffer table = { 0 };
+    buffer_varint(&table, strings.count);
+    for (size_t i = 0; i < strings.count; i++) {
+        size_t len = strlen(strings.strings[i]);
+        buffer_varint(&table, len);
+        buffer_bytes(&table, strings.strings[i], len);
+    }
+
+    size_t table_offset = IR_BYTECODE_HEADER_SIZE + func_count * IR_BYTECODE_INDEX_ENTRY;
+    size_t body_offset = table_offset + table.length;
+
+    uint8_t version[4] = { IR_BYTECODE_VERSION, 0, 0, 0 };
+    buffer_bytes(&header, IR_BYTECODE_MAGIC, 4);
+    buffer_bytes(&header, version, sizeof(version));
+    buffer_u32(&header, (uint32_t)func_count);
+    buffer_u32(&header, (uint32_t)table_offset);
+    buffer_u32(&header, (uint32_t)module->temp_count);
+    buffer_u32(&header, (uint32_t)module->label_count);
+    for (size_t f = 0; f < func_count; f++) {
+        buffer_u32(&header, name_index[f]);
+        buffer_u32(&header, (uint32_t)(body_offset + offsets[f]));
+        buffer_u32(&header, (uint32_t)(offsets[f + 1] - offsets[f]));
+    }
+    buffer_bytes(&header, table.data, table.length);
+    buffer_bytes(&header, body.data, body.length);
+    free(table.data);
+
+    if (!header.failed && !table.failed && !body.failed && header.length <= UINT32_MAX) {
+        result = header.data;
+        header.data = NULL;
+        *size = header.length;
+    }
+
+cleanup:
+    free(strings.strings);
+    free(strings.slots);
+    free(header.data);
+    free(body.data);
+    free(name_index);
+    free(offsets);
+    return result;
+}
+
+bool ir_bytecode_write(const IRModule *module, const char *path) {
+    size_t size = 0;
+    uint8_t *data = ir_bytecode_encode(module, &size);
+    if (!data) return false;
+
+    FILE *file = fopen(path, "wb");
+    bool ok = file && fwrite(data, 1, size, file) == size;
+    if (file && fclose(file) != 0) ok = false;
+    free(data);
+    return ok;
+}
+
+/* ==============================================================================
+ * Reader
+ * ==============================================================================
+ */
+
+struct IRBytecode {
+    const uint8_t *data;
+    size_t size;
+    bool mapped;                /* data is an mmap of size bytes */
+    bool owned;                 /* data was malloc'd by the reader */
+
+    size_t func_count;
+    const uint8_t *index;
+
+    size_t string_count;
+    size_t *string_offsets;     /* Offset of each string's length varint */
+    const char **strings;       /* Decoded on first use, in the module arena */
+
+    IRModule *module;
+    IRFunction **functions;     /* Decoded functions, NULL until loaded */
+};
+
+typedef struct {
+    const uint8_t *pos;
+    const uint8_t *end;
+    bool failed;
+} Cursor;
+
+static uint32_t read_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t read_varint(Cursor *c) {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (c->pos >= c->end) break;
+        uint8_t byte = *c->pos++;
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return value;
+    }
+    c->failed = true;
+    return 0;
+}
+
+static int64_t read_signed(Cursor *c) {
+    uint64_t value = read_varint(c);
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+/* A varint that must be below limit */
+static size_t read_index(Cursor *c, size_t limit) {
+    uint64_t value = read_varint(c);
+    if (value >= limit) {
+        c->failed = true;
+        return 0;
+    }
+    return (size_t)value;
+}
+
+static const char *bytecode_string(IRBytecode *bc, size_t index) {
+    if (index >= bc->string_count) return NULL;
+    if (bc->strings[index]) return bc->strings[index];
+
+    Cursor c = { bc->data + bc->string_offsets[index], bc->data + bc->size, false };
+    size_t len = read_index(&c, (size_t)(c.end - c.pos) + 1);
+    if (c.failed) return NULL;
+
+    char *str = ir_arena_alloc(&bc->module->arena, len + 1);
+    if (!str) return NULL;
+    memcpy(str, c.pos, len);
+    bc->strings[index] = str;
+    return str;
+}
+
+static bool read_string_table(IRBytecode *bc, size_t offset) {
+    if (offset > bc->size) return false;
+
+    Cursor c = { bc->data + offset, bc->data + bc->size, false };
+    bc->string_count = read_index(&c, bc->size + 1);
+    if (c.failed) return false;
+
+    bc->string_offsets = malloc((bc->string_count + 1) * sizeof(size_t));
+    bc->strings = calloc(bc->string_count + 1, sizeof(char *));
+    if (!bc->string_offsets || !bc->strings) return false;
+
+    for (size_t i = 0; i < bc->string_count; i++) {
+        bc->string_offsets[i] = (size_t)(c.pos - bc->data);
+        size_t len = read_index(&c, (size_t)(c.end - c.pos) + 1);
+        if (c.failed) return false;
+        c.pos += len;
+    }
+    return true;
+}
+
+IRBytecode *ir_bytecode_from_memory(const uint8_t *data, size_t size) {
+    if (!data || size < IR_BYTECODE_HEADER_SIZE) return NULL;
+    if (memcmp(data, IR_BYTECODE_MAGIC, 4) != 0 || data[4] != IR_BYTECODE_VERSION) return NULL;
+
+    IRBytecode *bc = calloc(1, sizeof(IRBytecode));
+    if (!bc) return NULL;
+    bc->data = data;
+    bc->size = size;
+    bc->func_count = read_u32(data + 8);
+    bc->index = data + IR_BYTECODE_HEADER_SIZE;
+
+    bc->module = ir_module_create();
+    bool ok = bc->module != NULL &&
+              bc->func_count <= (size - IR_BYTECODE_HEADER_SIZE) / IR_BYTECODE_INDEX_ENTRY;
+    if (ok) {
+        bc->module->temp_count = (int)read_u32(data + 16);
+        bc->module->label_count = (int)read_u32(data + 20);
+        bc->functions = calloc(bc->func_count + 1, sizeof(IRFunction *));
+        ok = bc->functions && read_string_table(bc, read_u32(data + 12));
+    }
+
+    /* Every index entry must name a string and point inside the data */
+    for (size_t i = 0; ok && i < bc->func_count; i++) {
+        const uint8_t *entry = bc->index + i * IR_BYTECODE_INDEX_ENTRY;
+        uint64_t offset = read_u32(entry + 4), length = read_u32(entry + 8);
+        ok = read_u32(entry) < bc->string_count && offset + length <= size;
+    }
+
+    if (!ok) {
+        ir_bytecode_close(bc);
+        return NULL;
+    }
+    return bc;
+}
+
+IRBytecode *ir_bytecode_open(const char *path) {
+#if EC_PLATFORM_POSIX
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return NULL;
+    }
+
+    size_t size = (size_t)st.st_size;
+    void *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return NULL;
+
+    IRBytecode *bc = ir_bytecode_from_memory(data, size);
+    if (!bc) {
+        munmap(data, size);
+        return NULL;
+    }
+    bc->mapped = true;
+    return bc;
+#else
+    /* No mmap: read the whole file */
+    FILE *file = fopen(path, "rb");
+    if (!file) return NULL;
+
+    uint8_t *data = NULL;
+    long size = -1;
+    if (fseek(file, 0, SEEK_END) == 0) size = ftell(file);
+    if (size > 0 && fseek(file, 0, SEEK_SET) == 0) {
+        data = malloc((size_t)size);
+        if (data && fread(data, 1, (size_t)size, file) != (size_t)size) {
+            free(data);
+            data = NULL;
+        }
+    }
+    fclose(file);
+    if (!data) return NULL;
+
+    IRBytecode *bc = ir_bytecode_from_memory(data, (size_t)size);
+    if (!bc) {
+        free(data);
+        return NULL;
+    }
+    bc->owned = true;
+    return bc;
+#endif
+}
+
+void ir_bytecode_close(IRBytecode *bc) {
+    if (!bc) return;
+
+#if EC_PLATFORM_POSIX
+    if (bc->mapped) munmap((void *)bc->data, bc->size);
+#endif
+    if (bc->owned) free((void *)bc->data);
+
+    free(bc->string_offsets);
+    free(bc->strings);
+    free(bc->functions);
+    ir_module_destroy(bc->module);
+    free(bc);
+}
+
+size_t ir_bytecode_function_count(const IRBytecode *bc) {
+    return bc ? bc->func_count : 0;
+}
+
+const char *ir_bytecode_function_name(IRBytecode *bc, size_t index) {
+    if (!bc || index >= bc->func_count) return NULL;
+    return bytecode_string(bc, read_u32(bc->index + index * IR_BYTECODE_INDEX_ENTRY));
+}
+
+size_t ir_bytecode_find_function(IRBytecode *bc, const char *name) {
+    for (size_t i = 0; i < ir_bytecode_function_count(bc); i++) {
+        const char *func_name = ir_bytecode_function_name(bc, i);
+        if (func_name && strcmp(func_name, name) == 0) return i;
+    }
+    return (size_t)-1;
+}
+
+/* Operand and label counts the printer and CFG code rely on */
+static bool valid_shape(const IRInstr *instr) {
+    size_t ops = instr->operand_count, labels = instr->label_count;
+    bool has_dest = instr->dest != IR_NO_TEMP;
+
+    switch (instr->op) {
+        case IR_CONST:
+        case IR_LOAD:
+            return has_dest && ops == 0 && labels == 0;
+        case IR_STORE:
+        case IR_PRINT:
+            return !has_dest && ops == 1 && labels == 0;
+        case IR_ALLOCA:
+            return !has_dest && ops == 0 && labels == 0;
+        case IR_NOT:
+            return has_dest && ops == 1 && labels == 0;
+        case IR_SELECT:
+            return has_dest && ops == 3 && labels == 0;
+        case IR_PHI:
+            return has_dest && ops == labels;
+        case IR_CALL:
+            return has_dest && labels == 0;
+        case IR_BR:
+            return !has_dest && ops == 0 && labels == 1;
+        case IR_COND_BR:
+            return !has_dest && ops == 1 && labels == 2;
+        case IR_RET:
+            return !has_dest && ops <= 1 && labels == 0;
+        default:
+            /* Binary arithmetic, icmp, and, or */
+            return has_dest && ops == 2 && labels == 0;
+    }
+}
+
+/* Scratch arrays for one instruction's operands and labels */
+static bool grow_scratch(IRValue **operands, int **labels, size_t *capacity, size_t needed) {
+    if (needed <= *capacity) return true;
+
+    size_t new_capacity = needed * 2;
+    IRValue *grown = realloc(*operands, new_capacity * sizeof(IRValue));
+    if (!grown) return false;
+    *operands = grown;
+
+    int *grown_labels = realloc(*labels, new_capacity * sizeof(int));
+    if (!grown_labels) return false;
+    *labels = grown_labels;
+
+    *capacity = new_capacity;
+    return true;
+}
+
+static IRFunction *decode_function(IRBytecode *bc, size_t index) {
+    const uint8_t *entry = bc->index + index * IR_BYTECODE_INDEX_ENTRY;
+    const char *name = bytecode_string(bc, read_u32(entry));
+    Cursor c = { bc->data + read_u32(entry + 4), bc->data + read_u32(entry + 4) + read_u32(entry + 8),
+                 false };
+    if (!name) return NULL;
+
+    /* No count can exceed the bytes left, which bounds every allocation */
+    size_t limit = (size_t)(c.end - c.pos) + 1;
+    IRType return_type = (IRType)read_index(&c, IR_TYPE_I32 + 1);
+    size_t param_count = read_index(&c, limit);
+    if (c.failed) return NULL;
+
+    IRModule *module = bc->module;
+    IRFunction *func = ir_module_add_function(module, name, return_type, param_count);
+    if (!func) return NULL;
+
+    for (size_t i = 0; i < param_count && !c.failed; i++) {
+        func->params[i].name = bytecode_string(bc, read_index(&c, bc->string_count));
+        func->params[i].type = (IRType)read_index(&c, IR_TYPE_I32 + 1);
+        if (!func->params[i].name) c.failed = true;
+    }
+
+    size_t block_count = read_index(&c, limit);
+    IRValue *operands = NULL;
+    int *labels = NULL;
+    size_t scratch = 0;
+
+    for (size_t b = 0; b < block_count && !c.failed; b++) {
+        IRBlock *block = ir_function_add_block(module, func, (int)read_signed(&c));
+        size_t instr_count = read_index(&c, limit);
+        if (!block) c.failed = true;
+
+        for (size_t i = 0; i < instr_count && !c.failed; i++) {
+            IRInstr instr = { 0 };
+            instr.op = (IROpcode)read_index(&c, IR_RET + 1);
+            instr.type = (IRType)read_index(&c, IR_TYPE_I32 + 1);
+            instr.dest = (int)read_index(&c, (size_t)module->temp_count + 1) - 1;
+
+            if (instr.op == IR_ICMP) instr.cmp = (IRCmp)read_index(&c, IR_CMP_GE + 1);
+            if (instr.op == IR_CONST) instr.imm = (int32_t)read_signed(&c);
+            if (op_has_name(instr.op)) {
+                instr.name = bytecode_string(bc, read_index(&c, bc->string_count));
+                if (!instr.name) c.failed = true;
+            }
+
+            instr.operand_count = read_index(&c, limit);
+            if (!grow_scratch(&operands, &labels, &scratch, instr.operand_count)) c.failed = true;
+            for (size_t j = 0; j < instr.operand_count && !c.failed; j++) {
+                uint64_t value = read_varint(&c);
+                IRValue *operand = &operands[j];
+                operand->kind = (IRValueKind)(value & 3);
+                operand->index = (int)(value >> 2);
+
+                size_t bound = operand->kind == IR_VALUE_TEMP ? (size_t)module->temp_count :
+                               operand->kind == IR_VALUE_PARAM ? param_count : 1;
+                if (operand->kind > IR_VALUE_UNDEF || (value >> 2) >= bound) c.failed = true;
+            }
+
+            instr.label_count = read_index(&c, limit);
+            if (!grow_scratch(&operands, &labels, &scratch, instr.label_count)) c.failed = true;
+            for (size_t j = 0; j < instr.label_count && !c.failed; j++) {
+                labels[j] = (int)read_signed(&c);
+            }
+            instr.depth = (int)read_index(&c, limit);
+
+            instr.operands = operands;
+            instr.labels = labels;
+            if (!c.failed && !valid_shape(&instr)) c.failed = true;
+            if (!c.failed && !ir_block_append(module, block, &instr)) c.failed = true;
+        }
+    }
+
+    free(operands);
+    free(labels);
+    if (c.failed || c.pos != c.end) return NULL;
+    return ir_function_compute_cfg(module, func) ? func : NULL;
+}
+
+const IRFunction *ir_bytecode_function(IRBytecode *bc, size_t index) {
+    if (!bc || index >= bc->func_count) return NULL;
+    if (!bc->functions[index]) bc->functions[index] = decode_function(bc, index);
+    return bc->functions[index];
+}
+
+const IRModule *ir_bytecode_module(IRBytecode *bc) {
+    if (!bc) return NULL;
+
+    for (size_t i = 0; i < bc->func_count; i++) {
+        if (!ir_bytecode_function(bc, i)) return NULL;
+    }
+
+    /* Lazily loaded functions were appended in load order */
+    for (size_t i = 0; i < bc->func_count; i++) {
+        bc->module->functions[i] = bc->functions[i];
+    }
+    return bc->module;
+}
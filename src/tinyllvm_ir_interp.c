@@ -0,0 +1,925 @@
+/**
+ * ==============================================================================
+ * TinyLLVM Compiler - IR Interpreter
+ * ==============================================================================
+ *
+ * Executes IR on a register machine. ir_program_create decodes the module
+ * once into a dense instruction array shared by all functions:
+ *
+ *   - Parameters, variables and temporaries become indices into the
+ *     function's register frame (parameters first, so a call copies its
+ *     arguments straight into registers 0..n-1).
+ *   - Loads and stores become register moves; allocas disappear since
+ *     frames start zeroed.
+ *   - Branch labels become instruction indices. Phis are lowered to moves
+ *     on each incoming edge, through shadow registers when one phi's
+ *     source is another's destination.
+ *   - A block that falls into its successor needs no jump.
+ *
+ * The run loop dispatches with computed goto under GCC and Clang and with
+ * a switch elsewhere. Calls push a frame on an explicit stack rather than
+ * recursing in C, so deep CoreTiny recursion only costs heap.
+ */
+
+#include "include/tinyllvm_ir.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define IR_INTERP_COMPUTED_GOTO 1
+#else
+#define IR_INTERP_COMPUTED_GOTO 0
+#endif
+
+#define IR_INTERP_MAX_CALL_DEPTH  1000000
+#define IR_INTERP_NO_REG          (-1)
+
+/* X-macro so the opcode enum and the computed-goto table stay in step */
+#define IR_INTERP_OPS(X) \
+    X(CONST) X(MOV) \
+    X(ADD) X(SUB) X(MUL) X(DIV) X(MOD) \
+    X(SHL) X(ASHR) X(LSHR) X(MULHI) X(AND) X(OR) X(NOT) \
+    X(EQ) X(NE) X(LT) X(LE) X(GT) X(GE) \
+    X(SELECT) X(JMP) X(JMPF) X(CALL) X(PRINT) X(RET)
+
+typedef enum {
+#define IR_INTERP_ENUM(name) OP_##name,
+    IR_INTERP_OPS(IR_INTERP_ENUM)
+#undef IR_INTERP_ENUM
+    OP_COUNT
+} InterpOp;
+
+/*
+ * Operand fields by opcode:
+ *   CONST  dest = a (immediate)           MOV    dest = r[a]
+ *   binary dest = r[a] op r[b]            SELECT dest = r[a] ? r[b] : r[c]
+ *   JMP    pc = a                         JMPF   if !r[a]: pc = b
+ *   CALL   dest = functions[a](args[b .. b+c])
+ *   PRINT  print r[a]                     RET    return r[a] (or 0 if a < 0)
+ */
+typedef struct {
+    int32_t op;
+    int32_t dest;
+    int32_t a;
+    int32_t b;
+    int32_t c;
+} InterpInstr;
+
+typedef struct {
+    char *name;
+    size_t entry;               /* Index of the first instruction */
+    size_t param_count;
+    size_t frame_size;          /* Registers per activation */
+} InterpFunction;
+
+struct IRProgram {
+    InterpInstr *code;
+    size_t code_count;
+    size_t code_capacity;
+
+    int32_t *args;              /* Call argument registers, referenced by CALL */
+    size_t arg_count;
+    size_t arg_capacity;
+
+    InterpFunction *functions;
+    size_t func_count;
+
+    IRPrintFunction print;
+    void *print_data;
+};
+
+static void set_error(char *error, size_t error_size, const char *format, ...) {
+    if (!error || error_size == 0) return;
+
+    va_list args;
+    va_start(args, format);
+    vsnprintf(error, error_size, format, args);
+    va_end(args);
+}
+
+/* ==============================================================================
+ * Decoding
+ * ==============================================================================
+ */
+
+typedef struct {
+    size_t at;                  /* Instruction whose target is patched */
+    size_t block;               /* Target block index */
+    bool field_b;               /* Patch b (JMPF) rather than a (JMP) */
+} InterpFixup;
+
+typedef struct {
+    IRProgram *program;
+    const IRModule *module;
+    const IRFunction *func;
+
+    int32_t *temp_reg;          /* Temporary number -> register */
+    size_t temp_limit;
+
+    const char **vars;          /* Variable name -> register (params + index) */
+    size_t var_count;
+    size_t var_capacity;
+
+    size_t reg_count;
+    int32_t zero_reg;           /* Never written: reads of undef */
+    int32_t shadow_base;        /* Scratch registers for conflicting phi moves */
+    size_t max_phis;
+
+    size_t *block_pc;
+    InterpFixup *fixups;
+    size_t fixup_count;
+    size_t fixup_capacity;
+
+    char *error;
+    size_t error_size;
+} InterpDecoder;
+
+static bool grow(void **items, size_t *capacity, size_t needed, size_t item_size) {
+    if (needed <= *capacity) return true;
+
+    size_t new_capacity = *capacity == 0 ? 64 : *capacity;
+    while (new_capacity < needed) {
+        new_capacity *= 2;
+    }
+
+    void *new_items = realloc(*items, new_capacity * item_size);
+    if (!new_items) return false;
+
+    *items = new_items;
+    *capacity = new_capacity;
+    return true;
+}
+
+static bool emit(InterpDecoder *d, int32_t op, int32_t dest, int32_t a, int32_t b, int32_t c) {
+    IRProgram *program = d->program;
+    if (!grow((void **)&program->code, &program->code_capacity, program->code_count + 1,
+              sizeof(InterpInstr))) {
+        set_error(d->error, d->error_size, "out of memory");
+        return false;
+    }
+
+    InterpInstr *instr = &program->code[program->code_count++];
+    instr->op = op;
+    instr->dest = dest;
+    instr->a = a;
+    instr->b = b;
+    instr->c = c;
+    return true;
+}
+
+static bool add_fixup(InterpDecoder *d, size_t block, bool field_b) {
+    if (!grow((void **)&d->fixups, &d->fixup_capacity, d->fixup_count + 1,
+              sizeof(InterpFixup))) {
+        set_error(d->error, d->error_size, "out of memory");
+        return false;
+    }
+
+    InterpFixup *fixup = &d->fixups[d->fixup_count++];
+    fixup->at = d->program->code_count - 1;
+    fixup->block = block;
+    fixup->field_b = field_b;
+    return true;
+}
+
+static int32_t new_reg(InterpDecoder *d) {
+    return (int32_t)d->reg_count++;
+}
+
+static int32_t temp_reg(InterpDecoder *d, int temp) {
+    if (temp < 0 || (size_t)temp >= d->temp_limit) return IR_INTERP_NO_REG;
+    if (d->temp_reg[temp] == IR_INTERP_NO_REG) d->temp_reg[temp] = new_reg(d);
+    return d->temp_reg[temp];
+}
+
+static int32_t var_reg(InterpDecoder *d, const char *name) {
+    if (!name) return IR_INTERP_NO_REG;
+
+    for (size_t i = 0; i < d->var_count; i++) {
+        if (strcmp(d->vars[i], name) == 0) return (int32_t)(d->func->param_count + i);
+    }
+    return IR_INTERP_NO_REG;
+}
+
+static int32_t value_reg(InterpDecoder *d, IRValue value) {
+    switch (value.kind) {
+        case IR_VALUE_PARAM:
+            if (value.index < 0 || (size_t)value.index >= d->func->param_count) {
+                return IR_INTERP_NO_REG;
+            }
+            return value.index;
+        case IR_VALUE_UNDEF:
+            return d->zero_reg;
+        default:
+            return temp_reg(d, value.index);
+    }
+}
+
+/* Registers for the instruction's operands; false if any is invalid */
+static bool operand_regs(InterpDecoder *d, const IRInstr *instr, size_t count, int32_t *regs) {
+    if (instr->operand_count < count) {
+        set_error(d->error, d->error_size, "@%s: instruction is missing operands",
+                  d->func->name);
+        return false;
+    }
+    for (size_t i = 0; i < count; i++) {
+        regs[i] = value_reg(d, instr->operands[i]);
+        if (regs[i] == IR_INTERP_NO_REG) {
+            set_error(d->error, d->error_size, "@%s: invalid operand", d->func->name);
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Frame layout: parameters, variables, temporaries, then the zero register
+ * and phi shadows. Variables must be numbered before any temporary, so
+ * they are collected in a first pass along with the temporary range;
+ * temporaries are then numbered densely in a second.
+ */
+static bool layout_frame(InterpDecoder *d) {
+    const IRFunction *func = d->func;
+    int max_temp = -1;
+    d->var_count = 0;
+    d->max_phis = 0;
+
+    for (size_t b = 0; b < func->block_count; b++) {
+        const IRBlock *block = func->blocks[b];
+        size_t phis = 0;
+
+        for (size_t i = 0; i < block->instr_count; i++) {
+            const IRInstr *instr = &block->instrs[i];
+            if (instr->dest > max_temp) max_temp = instr->dest;
+            for (size_t j = 0; j < instr->operand_count; j++) {
+                const IRValue *v = &instr->operands[j];
+                if (v->kind == IR_VALUE_TEMP && v->index > max_temp) max_temp = v->index;
+            }
+            if (instr->op == IR_PHI) phis++;
+
+            bool names_var = instr->op == IR_ALLOCA || instr->op == IR_LOAD ||
+                             instr->op == IR_STORE;
+            if (names_var && instr->name && var_reg(d, instr->name) == IR_INTERP_NO_REG) {
+                if (!grow((void **)&d->vars, &d->var_capacity, d->var_count + 1,
+                          sizeof(const char *))) {
+                    set_error(d->error, d->error_size, "out of memory");
+                    return false;
+                }
+                d->vars[d->var_count++] = instr->name;
+            }
+        }
+        if (phis > d->max_phis) d->max_phis = phis;
+    }
+
+    size_t limit = (size_t)(max_temp + 1);
+    if (limit > d->temp_limit) {
+        int32_t *map = realloc(d->temp_reg, limit * sizeof(int32_t));
+        if (!map) {
+            set_error(d->error, d->error_size, "out of memory");
+            return false;
+        }
+        d->temp_reg = map;
+        d->temp_limit = limit;
+    }
+    for (size_t i = 0; i < d->temp_limit; i++) {
+        d->temp_reg[i] = IR_INTERP_NO_REG;
+    }
+
+    d->reg_count = func->param_count + d->var_count;
+    for (size_t b = 0; b < func->block_count; b++) {
+        const IRBlock *block = func->blocks[b];
+        for (size_t i = 0; i < block->instr_count; i++) {
+            const IRInstr *instr = &block->instrs[i];
+            temp_reg(d, instr->dest);
+            for (size_t j = 0; j < instr->operand_count; j++) {
+                if (instr->operands[j].kind == IR_VALUE_TEMP) {
+                    temp_reg(d, instr->operands[j].index);
+                }
+            }
+        }
+    }
+
+    d->zero_reg = new_reg(d);
+    d->shadow_base = new_reg(d);
+    return true;
+}
+
+/* The moves for the edge from block pred into block succ's phis */
+static bool emit_phi_moves(InterpDecoder *d, size_t pred, size_t succ) {
+    const IRBlock *from = d->func->blocks[pred];
+    const IRBlock *to = d->func->blocks[succ];
+
+    size_t count = 0;
+    while (count < to->instr_count && to->instrs[count].op == IR_PHI) {
+        count++;
+    }
+    if (count == 0) return true;
+
+    /* Sources first, so the conflict check sees every destination */
+    int32_t *src = malloc(count * 2 * sizeof(int32_t));
+    if (!src) {
+        set_error(d->error, d->error_size, "out of memory");
+        return false;
+    }
+    int32_t *dst = src + count;
+
+    for (size_t i = 0; i < count; i++) {
+        const IRInstr *phi = &to->instrs[i];
+        src[i] = d->zero_reg;
+        for (size_t j = 0; j < phi->operand_count && j < phi->label_count; j++) {
+            if (phi->labels[j] == from->label) {
+                src[i] = value_reg(d, phi->operands[j]);
+                break;
+            }
+        }
+        dst[i] = temp_reg(d, phi->dest);
+        if (src[i] == IR_INTERP_NO_REG || dst[i] == IR_INTERP_NO_REG) {
+            free(src);
+            set_error(d->error, d->error_size, "@%s: invalid phi", d->func->name);
+            return false;
+        }
+    }
+
+    bool conflict = false;
+    for (size_t i = 0; i < count && !conflict; i++) {
+        for (size_t j = 0; j < count; j++) {
+            if (src[i] == dst[j] && i != j) {
+                conflict = true;
+                break;
+            }
+        }
+    }
+
+    bool ok = true;
+    for (size_t i = 0; ok && i < count; i++) {
+        if (conflict) {
+            ok = emit(d, OP_MOV, d->shadow_base + (int32_t)i, src[i], 0, 0);
+        } else if (src[i] != dst[i]) {
+            ok = emit(d, OP_MOV, dst[i], src[i], 0, 0);
+        }
+    }
+    for (size_t i = 0; ok && conflict && i < count; i++) {
+        ok = emit(d, OP_MOV, dst[i], d->shadow_base + (int32_t)i, 0, 0);
+    }
+
+    free(src);
+    return ok;
+}
+
+static bool edge_has_moves(const IRFunction *func, size_t succ) {
+    const IRBlock *to = func->blocks[succ];
+    return to->instr_count > 0 && to->instrs[0].op == IR_PHI;
+}
+
+/* Jump from block b to block target, moving phi values on the way */
+static bool emit_edge(InterpDecoder *d, size_t b, size_t target) {
+    if (!emit_phi_moves(d, b, target)) return false;
+    if (target == b + 1) return true;
+    return emit(d, OP_JMP, 0, 0, 0, 0) && add_fixup(d, target, false);
+}
+
+static size_t branch_target(InterpDecoder *d, int label) {
+    size_t target = ir_function_find_block(d->func, label);
+    if (target == (size_t)-1) {
+        set_error(d->error, d->error_size, "@%s: branch to undefined label L%d",
+                  d->func->name, label);
+    }
+    return target;
+}
+
+static size_t find_function(const IRModule *module, const char *name) {
+    for (size_t i = 0; i < module->func_count; i++) {
+        if (strcmp(module->functions[i]->name, name) == 0) return i;
+    }
+    return (size_t)-1;
+}
+
+static bool decode_call(InterpDecoder *d, const IRInstr *instr) {
+    size_t callee = instr->name ? find_function(d->module, instr->name) : (size_t)-1;
+    if (callee == (size_t)-1) {
+        set_error(d->error, d->error_size, "@%s: call to undefined function @%s",
+                  d->func->name, instr->name ? instr->name : "?");
+        return false;
+    }
+    if (d->module->functions[callee]->param_count != instr->operand_count) {
+        set_error(d->error, d->error_size, "@%s: wrong argument count for @%s",
+                  d->func->name, instr->name);
+        return false;
+    }
+
+    IRProgram *program = d->program;
+    size_t first = program->arg_count;
+    if (!grow((void **)&program->args, &program->arg_capacity,
+              first + instr->operand_count + 1, sizeof(int32_t))) {
+        set_error(d->error, d->error_size, "out of memory");
+        return false;
+    }
+    for (size_t i = 0; i < instr->operand_count; i++) {
+        int32_t reg = value_reg(d, instr->operands[i]);
+        if (reg == IR_INTERP_NO_REG) {
+            set_error(d->error, d->error_size, "@%s: invalid operand", d->func->name);
+            return false;
+        }
+        program->args[program->arg_count++] = reg;
+    }
+
+    int32_t dest = instr->dest == IR_NO_TEMP ? IR_INTERP_NO_REG : temp_reg(d, instr->dest);
+    return emit(d, OP_CALL, dest, (int32_t)callee, (int32_t)first,
+                (int32_t)instr->operand_count);
+}
+
+static bool decode_terminator(InterpDecoder *d, size_t b, const IRInstr *instr) {
+    int32_t regs[1];
+
+    switch (instr->op) {
+        case IR_BR: {
+            if (instr->label_count < 1) break;
+            size_t target = branch_target(d, instr->labels[0]);
+            return target != (size_t)-1 && emit_edge(d, b, target);
+        }
+
+        case IR_COND_BR: {
+            if (instr->label_count < 2 || !operand_regs(d, instr, 1, regs)) break;
+            size_t if_true = branch_target(d, instr->labels[0]);
+            size_t if_false = branch_target(d, instr->labels[1]);
+            if (if_true == (size_t)-1 || if_false == (size_t)-1) return false;
+
+            /* Without phi moves the false edge jumps straight to its block;
+             * otherwise to a stub after the true edge that does the moves */
+            if (!edge_has_moves(d->func, if_false)) {
+                return emit(d, OP_JMPF, 0, regs[0], 0, 0) && add_fixup(d, if_false, true) &&
+                       emit_edge(d, b, if_true);
+            }
+
+            if (!emit(d, OP_JMPF, 0, regs[0], 0, 0)) return false;
+            size_t jmpf = d->program->code_count - 1;
+            if (!emit_phi_moves(d, b, if_true) || !emit(d, OP_JMP, 0, 0, 0, 0) ||
+                !add_fixup(d, if_true, false)) {
+                return false;
+            }
+            d->program->code[jmpf].b = (int32_t)d->program->code_count;
+            return emit_edge(d, b, if_false);
+        }
+
+        case IR_RET:
+            if (instr->operand_count == 0) return emit(d, OP_RET, 0, IR_INTERP_NO_REG, 0, 0);
+            return operand_regs(d, instr, 1, regs) && emit(d, OP_RET, 0, regs[0], 0, 0);
+
+        default:
+            break;
+    }
+
+    set_error(d->error, d->error_size, "@%s: malformed terminator", d->func->name);
+    return false;
+}
+
+static int32_t arith_op(const IRInstr *instr) {
+    switch (instr->op) {
+        case IR_ADD:   return OP_ADD;
+        case IR_SUB:   return OP_SUB;
+        case IR_MUL:   return OP_MUL;
+        case IR_DIV:   return OP_DIV;
+        case IR_MOD:   return OP_MOD;
+        case IR_SHL:   return OP_SHL;
+        case IR_ASHR:  return OP_ASHR;
+        case IR_LSHR:  return OP_LSHR;
+        case IR_MULHI: return OP_MULHI;
+        case IR_AND:   return OP_AND;
+        case IR_OR:    return OP_OR;
+        default:
+            switch (instr->cmp) {
+                case IR_CMP_EQ: return OP_EQ;
+                case IR_CMP_NE: return OP_NE;
+                case IR_CMP_LT: return OP_LT;
+                case IR_CMP_LE: return OP_LE;
+                case IR_CMP_GT: return OP_GT;
+                default:        return OP_GE;
+            }
+    }
+}
+
+static bool decode_instr(InterpDecoder *d, const IRInstr *instr) {
+    int32_t regs[3];
+    int32_t dest = temp_reg(d, instr->dest);
+
+    /* Values nobody can read are only kept when they might trap or print */
+    bool has_dest = dest != IR_INTERP_NO_REG;
+
+    switch (instr->op) {
+        case IR_ALLOCA:
+        case IR_PHI:
+            return true;
+
+        case IR_CONST:
+            return !has_dest || emit(d, OP_CONST, dest, (int32_t)instr->imm, 0, 0);
+
+        case IR_LOAD: {
+            int32_t var = var_reg(d, instr->name);
+            if (var == IR_INTERP_NO_REG) break;
+            return !has_dest || emit(d, OP_MOV, dest, var, 0, 0);
+        }
+
+        case IR_STORE: {
+            int32_t var = var_reg(d, instr->name);
+            if (var == IR_INTERP_NO_REG || !operand_regs(d, instr, 1, regs)) break;
+            return emit(d, OP_MOV, var, regs[0], 0, 0);
+        }
+
+        case IR_ADD:
+        case IR_SUB:
+        case IR_MUL:
+        case IR_DIV:
+        case IR_MOD:
+        case IR_SHL:
+        case IR_ASHR:
+        case IR_LSHR:
+        case IR_MULHI:
+        case IR_AND:
+        case IR_OR:
+        case IR_ICMP:
+            if (!operand_regs(d, instr, 2, regs)) return false;
+            if (!has_dest) {
+                if (instr->op != IR_DIV && instr->op != IR_MOD) return true;
+                dest = d->shadow_base;      /* Kept for its trap */
+            }
+            return emit(d, arith_op(instr), dest, regs[0], regs[1], 0);
+
+        case IR_NOT:
+            if (!operand_regs(d, instr, 1, regs)) return false;
+            return !has_dest || emit(d, OP_NOT, dest, regs[0], 0, 0);
+
+        case IR_SELECT:
+            if (!operand_regs(d, instr, 3, regs)) return false;
+            return !has_dest || emit(d, OP_SELECT, dest, regs[0], regs[1], regs[2]);
+
+        case IR_CALL:
+            return decode_call(d, instr);
+
+        case IR_PRINT:
+            return operand_regs(d, instr, 1, regs) && emit(d, OP_PRINT, 0, regs[0], 0, 0);
+
+        case IR_BR:
+        case IR_COND_BR:
+        case IR_RET:
+            break;
+    }
+
+    set_error(d->error, d->error_size, "@%s: malformed instruction", d->func->name);
+    return false;
+}
+
+static bool decode_function(InterpDecoder *d, size_t index) {
+    const IRFunction *func = d->module->functions[index];
+    InterpFunction *out = &d->program->functions[index];
+    d->func = func;
+
+    if (!layout_frame(d)) return false;
+
+    free(d->block_pc);
+    d->block_pc = malloc((func->block_count + 1) * sizeof(size_t));
+    if (!d->block_pc) {
+        set_error(d->error, d->error_size, "out of memory");
+        return false;
+    }
+    d->fixup_count = 0;
+
+    out->name = strdup(func->name);
+    if (!out->name) {
+        set_error(d->error, d->error_size, "out of memory");
+        return false;
+    }
+    out->entry = d->program->code_count;
+    out->param_count = func->param_count;
+
+    for (size_t b = 0; b < func->block_count; b++) {
+        const IRBlock *block = func->blocks[b];
+        d->block_pc[b] = d->program->code_count;
+
+        for (size_t i = 0; i < block->instr_count; i++) {
+            const IRInstr *instr = &block->instrs[i];
+            bool ok = ir_opcode_is_terminator(instr->op) ? decode_terminator(d, b, instr)
+                                                         : decode_instr(d, instr);
+            if (!ok) return false;
+            if (ir_opcode_is_terminator(instr->op)) break;
+        }
+
+        /* An unterminated block falls through; the last one returns */
+        if (!ir_block_is_terminated(block)) {
+            bool ok = b + 1 < func->block_count
+                ? emit_phi_moves(d, b, b + 1)
+                : emit(d, OP_RET, 0, IR_INTERP_NO_REG, 0, 0);
+            if (!ok) return false;
+        }
+    }
+    if (func->block_count == 0 && !emit(d, OP_RET, 0, IR_INTERP_NO_REG, 0, 0)) return false;
+
+    for (size_t i = 0; i < d->fixup_count; i++) {
+        InterpInstr *instr = &d->program->code[d->fixups[i].at];
+        int32_t target = (int32_t)d->block_pc[d->fixups[i].block];
+        if (d->fixups[i].field_b) instr->b = target;
+        else instr->a = target;
+    }
+
+    /* The first shadow doubles as scratch, so there is always one */
+    size_t shadows = d->max_phis > 0 ? d->max_phis : 1;
+    out->frame_size = (size_t)d->shadow_base + shadows;
+    return true;
+}
+
+IRProgram *ir_program_create(const IRModule *module, char *error, size_t error_size) {
+    if (!module) {
+        set_error(error, error_size, "no module");
+        return NULL;
+    }
+
+    IRProgram *program = calloc(1, sizeof(IRProgram));
+    if (!program) {
+        set_error(error, error_size, "out of memory");
+        return NULL;
+    }
+
+    InterpDecoder d;
+    memset(&d, 0, sizeof(d));
+    d.program = program;
+    d.module = module;
+    d.error = error;
+    d.error_size = error_size;
+
+    bool ok = true;
+    if (module->func_count > 0) {
+        program->functions = calloc(module->func_count, sizeof(InterpFunction));
+        ok = program->functions != NULL;
+        if (ok) program->func_count = module->func_count;
+        else set_error(error, error_size, "out of memory");
+    }
+
+    for (size_t i = 0; ok && i < module->func_count; i++) {
+        ok = decode_function(&d, i);
+    }
+
+    free(d.temp_reg);
+    free(d.vars);
+    free(d.block_pc);
+    free(d.fixups);
+
+    if (!ok) {
+        ir_program_destroy(program);
+        return NULL;
+    }
+    return program;
+}
+
+void ir_program_destroy(IRProgram *program) {
+    if (!program) return;
+    for (size_t i = 0; i < program->func_count; i++) {
+        free(program->functions[i].name);
+    }
+    free(program->code);
+    free(program->args);
+    free(program->functions);
+    free(program);
+}
+
+void ir_program_set_print(IRProgram *program, IRPrintFunction print, void *user_data) {
+    if (!program) return;
+    program->print = print;
+    program->print_data = user_data;
+}
+
+/* ==============================================================================
+ * Execution
+ * ==============================================================================
+ */
+
+typedef struct {
+    const InterpInstr *return_pc;
+    size_t base;
+    size_t frame_size;
+    int32_t dest;
+} InterpFrame;
+
+typedef struct {
+    int32_t *regs;
+    size_t reg_capacity;
+    InterpFrame *frames;
+    size_t frame_capacity;
+} InterpStack;
+
+/* Make room for a frame of size registers at base, zeroed */
+static bool push_registers(InterpStack *stack, size_t base, size_t size) {
+    if (!grow((void **)&stack->regs, &stack->reg_capacity, base + size, sizeof(int32_t))) {
+        return false;
+    }
+    memset(stack->regs + base, 0, size * sizeof(int32_t));
+    return true;
+}
+
+static int32_t arith_shr(int32_t value, int32_t shift) {
+    uint32_t bits = (uint32_t)value;
+    shift &= 31;
+    return value < 0 ? (int32_t)~(~bits >> shift) : (int32_t)(bits >> shift);
+}
+
+static void default_print(int32_t value, void *user_data) {
+    (void)user_data;
+    printf("%d\n", value);
+}
+
+#if IR_INTERP_COMPUTED_GOTO
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#endif
+
+static bool execute(const IRProgram *program, size_t entry, InterpStack *stack,
+                    int32_t *result, char *error, size_t error_size) {
+    IRPrintFunction print = program->print ? program->print : default_print;
+    const InterpInstr *code = program->code;
+    const InterpFunction *func = &program->functions[entry];
+    const InterpInstr *pc = code + func->entry;
+
+    size_t depth = 0;
+    size_t base = 0;
+    size_t frame_size = func->frame_size;
+    int32_t *r = stack->regs;
+    int32_t value;
+
+#if IR_INTERP_COMPUTED_GOTO
+#define IR_INTERP_LABEL(name) &&do_##name,
+    static const void *const dispatch[OP_COUNT] = { IR_INTERP_OPS(IR_INTERP_LABEL) };
+#undef IR_INTERP_LABEL
+#define CASE(name)    do_##name:
+#define NEXT()        { pc++; goto *dispatch[pc->op]; }
+#define JUMP(target)  { pc = code + (target); goto *dispatch[pc->op]; }
+    goto *dispatch[pc->op];
+    {
+#else
+#define CASE(name)    case OP_##name:
+#define NEXT()        { pc++; continue; }
+#define JUMP(target)  { pc = code + (target); continue; }
+    for (;;) {
+        switch ((InterpOp)pc->op) {
+#endif
+
+        CASE(CONST)  r[pc->dest] = pc->a; NEXT();
+        CASE(MOV)    r[pc->dest] = r[pc->a]; NEXT();
+
+        CASE(ADD)    r[pc->dest] = (int32_t)((uint32_t)r[pc->a] + (uint32_t)r[pc->b]); NEXT();
+        CASE(SUB)    r[pc->dest] = (int32_t)((uint32_t)r[pc->a] - (uint32_t)r[pc->b]); NEXT();
+        CASE(MUL)    r[pc->dest] = (int32_t)((uint32_t)r[pc->a] * (uint32_t)r[pc->b]); NEXT();
+
+        CASE(DIV)
+            if (r[pc->b] == 0) goto division_by_zero;
+            if (r[pc->a] == INT32_MIN && r[pc->b] == -1) goto division_overflow;
+            r[pc->dest] = r[pc->a] / r[pc->b];
+            NEXT();
+
+        CASE(MOD)
+            if (r[pc->b] == 0) goto division_by_zero;
+            if (r[pc->a] == INT32_MIN && r[pc->b] == -1) goto division_overflow;
+            r[pc->dest] = r[pc->a] % r[pc->b];
+            NEXT();
+
+        CASE(SHL)    r[pc->dest] = (int32_t)((uint32_t)r[pc->a] << (r[pc->b] & 31)); NEXT();
+        CASE(ASHR)   r[pc->dest] = arith_shr(r[pc->a], r[pc->b]); NEXT();
+        CASE(LSHR)   r[pc->dest] = (int32_t)((uint32_t)r[pc->a] >> (r[pc->b] & 31)); NEXT();
+        CASE(MULHI)  r[pc->dest] = (int32_t)(((int64_t)r[pc->a] * r[pc->b]) >> 32); NEXT();
+        CASE(AND)    r[pc->dest] = r[pc->a] & r[pc->b]; NEXT();
+        CASE(OR)     r[pc->dest] = r[pc->a] | r[pc->b]; NEXT();
+        CASE(NOT)    r[pc->dest] = r[pc->a] ^ 1; NEXT();
+
+        CASE(EQ)     r[pc->dest] = r[pc->a] == r[pc->b]; NEXT();
+        CASE(NE)     r[pc->dest] = r[pc->a] != r[pc->b]; NEXT();
+        CASE(LT)     r[pc->dest] = r[pc->a] <  r[pc->b]; NEXT();
+        CASE(LE)     r[pc->dest] = r[pc->a] <= r[pc->b]; NEXT();
+        CASE(GT)     r[pc->dest] = r[pc->a] >  r[pc->b]; NEXT();
+        CASE(GE)     r[pc->dest] = r[pc->a] >= r[pc->b]; NEXT();
+
+        CASE(SELECT) r[pc->dest] = r[pc->a] ? r[pc->b] : r[pc->c]; NEXT();
+
+        CASE(JMP)    JUMP(pc->a);
+        CASE(JMPF)
+            if (!r[pc->a]) JUMP(pc->b);
+            NEXT();
+
+        CASE(PRINT)
+            print(r[pc->a], program->print_data);
+            NEXT();
+
+        CASE(CALL) {
+            const InterpFunction *callee = &program->functions[pc->a];
+            size_t callee_base = base + frame_size;
+
+            if (depth + 1 >= IR_INTERP_MAX_CALL_DEPTH) {
+                set_error(error, error_size, "call stack overflow in @%s", callee->name);
+                return false;
+            }
+            if (!grow((void **)&stack->frames, &stack->frame_capacity, depth + 1,
+                      sizeof(InterpFrame)) ||
+                !push_registers(stack, callee_base, callee->frame_size)) {
+                set_error(error, error_size, "out of memory");
+                return false;
+            }
+
+            int32_t *regs = stack->regs;
+            const int32_t *args = program->args + pc->b;
+            for (int32_t i = 0; i < pc->c; i++) {
+                regs[callee_base + (size_t)i] = regs[base + (size_t)args[i]];
+            }
+
+            InterpFrame *frame = &stack->frames[depth++];
+            frame->return_pc = pc + 1;
+            frame->base = base;
+            frame->frame_size = frame_size;
+            frame->dest = pc->dest;
+
+            base = callee_base;
+            frame_size = callee->frame_size;
+            r = regs + base;
+            JUMP(callee->entry);
+        }
+
+        CASE(RET)
+            value = pc->a == IR_INTERP_NO_REG ? 0 : r[pc->a];
+            if (depth == 0) {
+                if (result) *result = value;
+                return true;
+            }
+            {
+                const InterpFrame *frame = &stack->frames[--depth];
+                base = frame->base;
+                frame_size = frame->frame_size;
+                r = stack->regs + base;
+                if (frame->dest != IR_INTERP_NO_REG) r[frame->dest] = value;
+                pc = frame->return_pc;
+            }
+#if IR_INTERP_COMPUTED_GOTO
+            goto *dispatch[pc->op];
+    }
+#else
+            continue;
+
+        case OP_COUNT:
+            break;
+        }
+        break;
+    }
+    set_error(error, error_size, "invalid instruction");
+    return false;
+#endif
+
+#undef CASE
+#undef NEXT
+#undef JUMP
+
+division_by_zero:
+    set_error(error, error_size, "division by zero");
+    return false;
+
+division_overflow:
+    set_error(error, error_size, "division overflow");
+    return false;
+}
+
+#if IR_INTERP_COMPUTED_GOTO
+#pragma GCC diagnostic pop
+#endif
+
+bool ir_program_run(const IRProgram *program, const char *function,
+                    const int32_t *args, size_t arg_count, int32_t *result,
+                    char *error, size_t error_size) {
+    if (!program || !function) {
+        set_error(error, error_size, "no program");
+        return false;
+    }
+
+    size_t entry = (size_t)-1;
+    for (size_t i = 0; i < program->func_count; i++) {
+        if (strcmp(program->functions[i].name, function) == 0) {
+            entry = i;
+            break;
+        }
+    }
+    if (entry == (size_t)-1) {
+        set_error(error, error_size, "no function @%s", function);
+        return false;
+    }
+    if (program->functions[entry].param_count != arg_count) {
+        set_error(error, error_size, "@%s takes %zu argument(s), got %zu", function,
+                  program->functions[entry].param_count, arg_count);
+        return false;
+    }
+
+    InterpStack stack = { .regs = NULL, .reg_capacity = 0, .frames = NULL, .frame_capacity = 0 };
+    bool ok = push_registers(&stack, 0, program->functions[entry].frame_size);
+    if (!ok) set_error(error, error_size, "out of memory");
+
+    for (size_t i = 0; ok && i < arg_count; i++) {
+        stack.regs[i] = args[i];
+    }
+    ok = ok && execute(program, entry, &stack, result, error, error_size);
+
+    free(stack.regs);
+    free(stack.frames);
+    return ok;
+}
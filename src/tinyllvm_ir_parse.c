@@ -0,0 +1,586 @@
+/**
+ * ==============================================================================
+ * TinyLLVM Compiler - IR Parser
+ * ==============================================================================
+ *
+ * Reads textual TinyLLVM IR back into an IRModule, so IR can be cached on
+ * disk, optimized as a separate stage or handed to another backend without
+ * rerunning the front end.
+ *
+ * The parser is line-oriented and single pass: each line is a comment, a
+ * declaration, a function header or footer, a block label or one
+ * instruction. Indentation is kept as the instruction's print depth, and
+ * instructions following a terminator without a label start an unlabeled
+ * block, so ir_print_module reproduces the input exactly.
+ */
+
+#include "include/tinyllvm_ir.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <ctype.h>
+#include <limits.h>
+
+#define IR_PARSE_MAX_OPERANDS  64
+
+typedef struct {
+    const char *pos;
+    const char *line_end;
+    size_t line;
+
+    IRModule *module;
+    IRFunction *func;
+    IRBlock *block;
+
+    char *error;
+    size_t error_size;
+    bool failed;
+} IRParser;
+
+static void parse_error(IRParser *p, const char *format, ...) {
+    if (p->failed) return;
+    p->failed = true;
+    if (!p->error || p->error_size == 0) return;
+
+    int len = snprintf(p->error, p->error_size, "line %zu: ", p->line);
+    if (len < 0 || (size_t)len >= p->error_size) return;
+
+    va_list args;
+    va_start(args, format);
+    vsnprintf(p->error + len, p->error_size - (size_t)len, format, args);
+    va_end(args);
+}
+
+/* ==============================================================================
+ * Tokens
+ * ==============================================================================
+ */
+
+static void skip_spaces(IRParser *p) {
+    while (p->pos < p->line_end && *p->pos == ' ') p->pos++;
+}
+
+static bool at_end(IRParser *p) {
+    skip_spaces(p);
+    return p->pos >= p->line_end;
+}
+
+/* Consume a literal token (keyword or punctuation) */
+static bool accept(IRParser *p, const char *token) {
+    skip_spaces(p);
+    size_t len = strlen(token);
+    if ((size_t)(p->line_end - p->pos) < len || memcmp(p->pos, token, len) != 0) return false;
+
+    /* Keywords must not run into an identifier */
+    const char *after = p->pos + len;
+    if (isalnum((unsigned char)token[len - 1]) && after < p->line_end &&
+        (isalnum((unsigned char)*after) || *after == '_' || *after == '.')) {
+        return false;
+    }
+    p->pos = after;
+    return true;
+}
+
+static void expect(IRParser *p, const char *token) {
+    if (!p->failed && !accept(p, token)) parse_error(p, "expected '%s'", token);
+}
+
+static bool is_name_char(char c) {
+    return isalnum((unsigned char)c) || c == '_' || c == '.';
+}
+
+/* An identifier after a sigil ('%' or '@'); the span is not NUL-terminated */
+static bool read_name(IRParser *p, char sigil, const char **start, size_t *len) {
+    skip_spaces(p);
+    if (p->failed || p->pos >= p->line_end || *p->pos != sigil) {
+        parse_error(p, "expected '%c' name", sigil);
+        return false;
+    }
+    p->pos++;
+    *start = p->pos;
+    while (p->pos < p->line_end && is_name_char(*p->pos)) p->pos++;
+    *len = (size_t)(p->pos - *start);
+    if (*len == 0) parse_error(p, "empty name");
+    return *len > 0;
+}
+
+static const char *read_name_copy(IRParser *p, char sigil) {
+    const char *start;
+    size_t len;
+    if (!read_name(p, sigil, &start, &len)) return NULL;
+
+    char *name = ir_arena_alloc(&p->module->arena, len + 1);
+    if (!name) {
+        parse_error(p, "out of memory");
+        return NULL;
+    }
+    memcpy(name, start, len);
+    return name;
+}
+
+static int64_t read_integer(IRParser *p, int64_t min, int64_t max) {
+    skip_spaces(p);
+    const char *start = p->pos;
+    bool negative = p->pos < p->line_end && *p->pos == '-';
+    if (negative) p->pos++;
+
+    int64_t value = 0;
+    bool digits = false;
+    while (p->pos < p->line_end && isdigit((unsigned char)*p->pos)) {
+        value = value * 10 + (*p->pos++ - '0');
+        digits = true;
+        if (value > max + 1) break;
+    }
+
+    if (negative) value = -value;
+    if (!digits || value < min || value > max || (p->pos < p->line_end && isdigit((unsigned char)*p->pos))) {
+        p->pos = start;
+        parse_error(p, "expected an integer");
+        return 0;
+    }
+    return value;
+}
+
+/* Digits only (temporaries and labels), or -1 */
+static int parse_index(const char *start, size_t len) {
+    if (len == 0 || len > 9) return -1;
+    int value = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (!isdigit((unsigned char)start[i])) return -1;
+        value = value * 10 + (start[i] - '0');
+    }
+    return value;
+}
+
+static IRType read_type(IRParser *p) {
+    if (accept(p, "i32")) return IR_TYPE_I32;
+    if (accept(p, "i1")) return IR_TYPE_I1;
+    if (accept(p, "void")) return IR_TYPE_VOID;
+    parse_error(p, "expected a type");
+    return IR_TYPE_VOID;
+}
+
+static void note_temp(IRParser *p, int index) {
+    if (index >= p->module->temp_count) p->module->temp_count = index + 1;
+}
+
+static IRValue read_value(IRParser *p) {
+    IRValue value = { .kind = IR_VALUE_UNDEF, .index = 0 };
+    if (accept(p, "undef")) return value;
+
+    const char *start;
+    size_t len;
+    if (!read_name(p, '%', &start, &len)) return value;
+
+    if (len > 6 && memcmp(start + len - 6, ".param", 6) == 0) {
+        for (size_t i = 0; p->func && i < p->func->param_count; i++) {
+            const char *param = p->func->params[i].name;
+            if (strlen(param) == len - 6 && memcmp(param, start, len - 6) == 0) {
+                value.kind = IR_VALUE_PARAM;
+                value.index = (int)i;
+                return value;
+            }
+        }
+        parse_error(p, "unknown parameter '%.*s'", (int)(len - 6), start);
+        return value;
+    }
+
+    int index = start[0] == 't' ? parse_index(start + 1, len - 1) : -1;
+    if (index < 0) {
+        parse_error(p, "expected a value, got '%%%.*s'", (int)len, start);
+        return value;
+    }
+    note_temp(p, index);
+    value.kind = IR_VALUE_TEMP;
+    value.index = index;
+    return value;
+}
+
+static int read_label(IRParser *p) {
+    const char *start;
+    size_t len;
+    if (!read_name(p, '%', &start, &len)) return IR_LABEL_NONE;
+    if (len == 5 && memcmp(start, "entry", 5) == 0) return IR_LABEL_ENTRY;
+
+    int label = start[0] == 'L' ? parse_index(start + 1, len - 1) : -1;
+    if (label < 0) {
+        parse_error(p, "expected a label, got '%%%.*s'", (int)len, start);
+        return IR_LABEL_NONE;
+    }
+    return label;
+}
+
+/* ==============================================================================
+ * Instructions
+ * ==============================================================================
+ */
+
+static bool begin_block(IRParser *p, int label) {
+    if (!p->func) {
+        parse_error(p, "label outside a function");
+        return false;
+    }
+    if (label >= p->module->label_count) p->module->label_count = label + 1;
+
+    p->block = ir_function_add_block(p->module, p->func, label);
+    if (!p->block) parse_error(p, "out of memory");
+    return p->block != NULL;
+}
+
+static void emit(IRParser *p, IRInstr *instr, int depth) {
+    if (p->failed) return;
+    if (!p->func) {
+        parse_error(p, "instruction outside a function");
+        return;
+    }
+    if (!p->block || ir_block_is_terminated(p->block)) {
+        /* Entry is always labeled; anything after a terminator is dead code */
+        if (!begin_block(p, p->block ? IR_LABEL_NONE : IR_LABEL_ENTRY)) return;
+    }
+    if (!at_end(p)) {
+        parse_error(p, "unexpected '%.*s'", (int)(p->line_end - p->pos), p->pos);
+        return;
+    }
+
+    instr->depth = depth;
+    if (!ir_block_append(p->module, p->block, instr)) parse_error(p, "out of memory");
+}
+
+static bool read_binary_op(IRParser *p, IRInstr *instr) {
+    static const struct { const char *name; IROpcode op; } ops[] = {
+        { "add", IR_ADD }, { "sub", IR_SUB }, { "mulhi", IR_MULHI }, { "mul", IR_MUL },
+        { "div", IR_DIV }, { "mod", IR_MOD }, { "shl", IR_SHL }, { "ashr", IR_ASHR },
+        { "lshr", IR_LSHR }, { "and", IR_AND }, { "or", IR_OR }
+    };
+    for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+        if (accept(p, ops[i].name)) {
+            instr->op = ops[i].op;
+            return true;
+        }
+    }
+    return false;
+}
+
+static IRCmp read_cmp(IRParser *p) {
+    static const char *names[] = { "eq", "ne", "lt", "le", "gt", "ge" };
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (accept(p, names[i])) return (IRCmp)i;
+    }
+    parse_error(p, "expected a comparison");
+    return IR_CMP_EQ;
+}
+
+/* The right-hand side of `%tN = ...` */
+static void parse_definition(IRParser *p, int dest, int depth) {
+    IRValue ops[IR_PARSE_MAX_OPERANDS];
+    int labels[IR_PARSE_MAX_OPERANDS];
+    IRInstr instr = { .dest = dest, .type = IR_TYPE_I32, .operands = ops };
+
+    if (accept(p, "const")) {
+        instr.op = IR_CONST;
+        instr.type = read_type(p);
+        instr.imm = (int32_t)read_integer(p, INT32_MIN, INT32_MAX);
+    } else if (accept(p, "load")) {
+        instr.op = IR_LOAD;
+        instr.name = read_name_copy(p, '%');
+    } else if (accept(p, "icmp")) {
+        instr.op = IR_ICMP;
+        instr.type = IR_TYPE_I1;
+        instr.cmp = read_cmp(p);
+        expect(p, "i32");
+        ops[0] = read_value(p);
+        expect(p, ",");
+        ops[1] = read_value(p);
+        instr.operand_count = 2;
+    } else if (accept(p, "xor")) {
+        instr.op = IR_NOT;
+        instr.type = IR_TYPE_I1;
+        expect(p, "i1");
+        ops[0] = read_value(p);
+        expect(p, ",");
+        expect(p, "1");
+        instr.operand_count = 1;
+    } else if (accept(p, "select")) {
+        instr.op = IR_SELECT;
+        expect(p, "i1");
+        ops[0] = read_value(p);
+        expect(p, ",");
+        instr.type = read_type(p);
+        ops[1] = read_value(p);
+        expect(p, ",");
+        if (read_type(p) != instr.type) parse_error(p, "select arms differ in type");
+        ops[2] = read_value(p);
+        instr.operand_count = 3;
+    } else if (accept(p, "phi")) {
+        instr.op = IR_PHI;
+        instr.type = read_type(p);
+        instr.labels = labels;
+        do {
+            if (instr.operand_count == IR_PARSE_MAX_OPERANDS) {
+                parse_error(p, "too many phi operands");
+                break;
+            }
+            expect(p, "[");
+            ops[instr.operand_count] = read_value(p);
+            expect(p, ",");
+            labels[instr.operand_count++] = read_label(p);
+            expect(p, "]");
+        } while (!p->failed && accept(p, ","));
+        instr.label_count = instr.operand_count;
+    } else if (accept(p, "call")) {
+        instr.op = IR_CALL;
+        expect(p, "i32");
+        instr.name = read_name_copy(p, '@');
+        expect(p, "(");
+        if (!accept(p, ")")) {
+            do {
+                if (instr.operand_count == IR_PARSE_MAX_OPERANDS) {
+                    parse_error(p, "too many call arguments");
+                    break;
+                }
+                expect(p, "i32");
+                ops[instr.operand_count++] = read_value(p);
+            } while (!p->failed && accept(p, ","));
+            expect(p, ")");
+        }
+    } else if (read_binary_op(p, &instr)) {
+        instr.type = read_type(p);
+        ops[0] = read_value(p);
+        expect(p, ",");
+        ops[1] = read_value(p);
+        instr.operand_count = 2;
+    } else {
+        parse_error(p, "unknown instruction");
+    }
+
+    emit(p, &instr, depth);
+}
+
+static void parse_instruction(IRParser *p, int depth) {
+    IRValue ops[1];
+    int labels[2];
+    IRInstr instr = { .dest = IR_NO_TEMP, .operands = ops, .labels = labels };
+
+    if (accept(p, "store")) {
+        instr.op = IR_STORE;
+        instr.type = IR_TYPE_I32;
+        expect(p, "i32");
+        ops[0] = read_value(p);
+        expect(p, ",");
+        instr.name = read_name_copy(p, '%');
+        instr.operand_count = 1;
+    } else if (accept(p, "br")) {
+        if (accept(p, "label")) {
+            instr.op = IR_BR;
+            labels[0] = read_label(p);
+            instr.label_count = 1;
+        } else {
+            instr.op = IR_COND_BR;
+            expect(p, "i1");
+            ops[0] = read_value(p);
+            expect(p, ",");
+            expect(p, "label");
+            labels[0] = read_label(p);
+            expect(p, ",");
+            expect(p, "label");
+            labels[1] = read_label(p);
+            instr.operand_count = 1;
+            instr.label_count = 2;
+        }
+    } else if (accept(p, "ret")) {
+        instr.op = IR_RET;
+        if (!accept(p, "void")) {
+            expect(p, "i32");
+            instr.type = IR_TYPE_I32;
+            ops[0] = read_value(p);
+            instr.operand_count = 1;
+        }
+    } else if (accept(p, "call")) {
+        instr.op = IR_PRINT;
+        expect(p, "void");
+        expect(p, "@print");
+        expect(p, "(");
+        expect(p, "i32");
+        ops[0] = read_value(p);
+        expect(p, ")");
+        instr.operand_count = 1;
+    } else {
+        /* `%tN = ...` or `%name = alloca i32` */
+        const char *start;
+        size_t len;
+        if (!read_name(p, '%', &start, &len)) return;
+        expect(p, "=");
+
+        if (accept(p, "alloca")) {
+            expect(p, "i32");
+            char *name = ir_arena_alloc(&p->module->arena, len + 1);
+            if (!name) {
+                parse_error(p, "out of memory");
+                return;
+            }
+            memcpy(name, start, len);
+            instr.op = IR_ALLOCA;
+            instr.type = IR_TYPE_I32;
+            instr.name = name;
+        } else {
+            int dest = start[0] == 't' ? parse_index(start + 1, len - 1) : -1;
+            if (dest < 0) {
+                parse_error(p, "expected a temporary, got '%%%.*s'", (int)len, start);
+                return;
+            }
+            note_temp(p, dest);
+            parse_definition(p, dest, depth);
+            return;
+        }
+    }
+
+    emit(p, &instr, depth);
+}
+
+/* ==============================================================================
+ * Functions & Module
+ * ==============================================================================
+ */
+
+static void parse_define(IRParser *p) {
+    IRType return_type = read_type(p);
+    const char *start;
+    size_t len;
+    if (!read_name(p, '@', &start, &len)) return;
+    expect(p, "(");
+
+    /* Count parameters before creating the function */
+    const char *params = p->pos;
+    size_t param_count = 0;
+    if (!accept(p, ")")) {
+        do {
+            read_type(p);
+            const char *name;
+            size_t name_len;
+            read_name(p, '%', &name, &name_len);
+            param_count++;
+        } while (!p->failed && accept(p, ","));
+        expect(p, ")");
+    }
+    expect(p, "{");
+    if (p->failed) return;
+    if (!at_end(p)) {
+        parse_error(p, "unexpected text after '{'");
+        return;
+    }
+
+    char *name = ir_arena_alloc(&p->module->arena, len + 1);
+    if (name) memcpy(name, start, len);
+    p->func = name ? ir_module_add_function(p->module, name, return_type, param_count) : NULL;
+    p->block = NULL;
+    if (!p->func) {
+        parse_error(p, "out of memory");
+        return;
+    }
+
+    p->pos = params;
+    for (size_t i = 0; i < param_count; i++) {
+        if (i > 0) expect(p, ",");
+        p->func->params[i].type = read_type(p);
+
+        const char *param;
+        size_t param_len;
+        read_name(p, '%', &param, &param_len);
+        if (param_len <= 6 || memcmp(param + param_len - 6, ".param", 6) != 0) {
+            parse_error(p, "parameter names end in '.param'");
+            return;
+        }
+
+        char *copy = ir_arena_alloc(&p->module->arena, param_len - 5);
+        if (!copy) {
+            parse_error(p, "out of memory");
+            return;
+        }
+        memcpy(copy, param, param_len - 6);
+        p->func->params[i].name = copy;
+    }
+    p->pos = p->line_end;
+}
+
+static void end_function(IRParser *p) {
+    if (!p->func) {
+        parse_error(p, "'}' outside a function");
+        return;
+    }
+    if (p->func->block_count == 0 && !begin_block(p, IR_LABEL_ENTRY)) return;
+    if (!ir_function_compute_cfg(p->module, p->func)) {
+        parse_error(p, "branch to an undefined label in @%s", p->func->name);
+    }
+    p->func = NULL;
+    p->block = NULL;
+}
+
+static void parse_line(IRParser *p) {
+    const char *line_start = p->pos;
+    skip_spaces(p);
+    size_t indent = (size_t)(p->pos - line_start);
+
+    if (p->pos >= p->line_end || *p->pos == ';') return;
+
+    if (accept(p, "declare")) {
+        /* Only the print builtin is ever declared */
+        expect(p, "void");
+        expect(p, "@print");
+        expect(p, "(");
+        expect(p, "i32");
+        expect(p, ")");
+    } else if (accept(p, "define")) {
+        if (p->func) parse_error(p, "nested define");
+        else parse_define(p);
+    } else if (accept(p, "}")) {
+        end_function(p);
+    } else if (accept(p, "entry:")) {
+        if (p->func && p->func->block_count > 0) parse_error(p, "entry must be the first block");
+        else begin_block(p, IR_LABEL_ENTRY);
+    } else if (indent == 0 && *p->pos == 'L') {
+        p->pos++;
+        int label = (int)read_integer(p, 0, INT_MAX - 1);
+        expect(p, ":");
+        if (!p->failed && p->func && ir_function_find_block(p->func, label) != (size_t)-1) {
+            parse_error(p, "duplicate label L%d", label);
+        } else if (!p->failed) {
+            begin_block(p, label);
+        }
+    } else {
+        parse_instruction(p, (int)(indent / 2));
+        return;
+    }
+
+    if (!p->failed && !at_end(p)) parse_error(p, "unexpected text");
+}
+
+IRModule *ir_parse_module(const char *text, char *error, size_t error_size) {
+    if (error && error_size > 0) error[0] = '\0';
+    if (!text) return NULL;
+
+    IRParser p = {
+        .pos = text,
+        .line = 0,
+        .module = ir_module_create(),
+        .error = error,
+        .error_size = error_size
+    };
+    if (!p.module) return NULL;
+
+    while (*p.pos && !p.failed) {
+        const char *newline = strchr(p.pos, '\n');
+        p.line_end = newline ? newline : p.pos + strlen(p.pos);
+        p.line++;
+
+        parse_line(&p);
+        p.pos = newline ? newline + 1 : p.line_end;
+    }
+
+    if (!p.failed && p.func) parse_error(&p, "missing '}' at end of input");
+    if (p.failed) {
+        ir_module_destroy(p.module);
+        return NULL;
+    }
+    return p.module;
+}
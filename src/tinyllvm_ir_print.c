@@ -0,0 +1,257 @@
+/**
+ * ==============================================================================
+ * TinyLLVM Compiler - IR Printer
+ * ==============================================================================
+ *
+ * Writes an IRModule as textual TinyLLVM IR, the format emitted for
+ * TARGET_TINYLLVM. Each instruction is indented by its recorded statement
+ * depth; labeled blocks are preceded by a blank line.
+ */
+
+#include "include/tinyllvm_ir.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+
+typedef struct {
+    char *output;
+    size_t length;
+    size_t capacity;
+} IRPrinter;
+
+static bool printer_grow(IRPrinter *p, size_t additional) {
+    size_t needed = p->length + additional + 1;
+    if (needed <= p->capacity) return true;
+
+    size_t new_capacity = p->capacity == 0 ? 1024 : p->capacity;
+    while (new_capacity < needed) {
+        new_capacity *= 2;
+    }
+
+    char *new_output = realloc(p->output, new_capacity);
+    if (!new_output) return false;
+
+    p->output = new_output;
+    p->capacity = new_capacity;
+    return true;
+}
+
+static bool printer_append(IRPrinter *p, const char *str) {
+    size_t len = strlen(str);
+    if (!printer_grow(p, len)) return false;
+
+    memcpy(p->output + p->length, str, len);
+    p->length += len;
+    p->output[p->length] = '\0';
+    return true;
+}
+
+static bool printer_appendf(IRPrinter *p, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(NULL, 0, format, args);
+    va_end(args);
+    if (len < 0 || !printer_grow(p, (size_t)len)) return false;
+
+    va_start(args, format);
+    vsnprintf(p->output + p->length, (size_t)len + 1, format, args);
+    va_end(args);
+    p->length += (size_t)len;
+    return true;
+}
+
+static const char *type_name(IRType type) {
+    switch (type) {
+        case IR_TYPE_I1:  return "i1";
+        case IR_TYPE_I32: return "i32";
+        default:          return "void";
+    }
+}
+
+static const char *cmp_name(IRCmp cmp) {
+    switch (cmp) {
+        case IR_CMP_EQ: return "eq";
+        case IR_CMP_NE: return "ne";
+        case IR_CMP_LT: return "lt";
+        case IR_CMP_LE: return "le";
+        case IR_CMP_GT: return "gt";
+        default:        return "ge";
+    }
+}
+
+static const char *arith_name(IROpcode op) {
+    switch (op) {
+        case IR_ADD:   return "add";
+        case IR_SUB:   return "sub";
+        case IR_MUL:   return "mul";
+        case IR_DIV:   return "div";
+        case IR_MOD:   return "mod";
+        case IR_SHL:   return "shl";
+        case IR_ASHR:  return "ashr";
+        case IR_LSHR:  return "lshr";
+        case IR_MULHI: return "mulhi";
+        case IR_AND:   return "and";
+        default:       return "or";
+    }
+}
+
+static bool print_value(IRPrinter *p, const IRFunction *func, IRValue value) {
+    if (value.kind == IR_VALUE_PARAM) {
+        return printer_appendf(p, "%%%s.param", func->params[value.index].name);
+    }
+    if (value.kind == IR_VALUE_UNDEF) return printer_append(p, "undef");
+    return printer_appendf(p, "%%t%d", value.index);
+}
+
+static bool print_label(IRPrinter *p, int label) {
+    if (label == IR_LABEL_ENTRY) return printer_append(p, "%entry");
+    return printer_appendf(p, "%%L%d", label);
+}
+
+static bool print_instr(IRPrinter *p, const IRFunction *func, const IRInstr *instr) {
+    for (int i = 0; i < instr->depth; i++) {
+        if (!printer_append(p, "  ")) return false;
+    }
+
+    if (instr->dest != IR_NO_TEMP && !printer_appendf(p, "%%t%d = ", instr->dest)) return false;
+
+    const IRValue *ops = instr->operands;
+
+    switch (instr->op) {
+        case IR_CONST:
+            return printer_appendf(p, "const %s %d\n", type_name(instr->type), (int)instr->imm);
+
+        case IR_LOAD:
+            return printer_appendf(p, "load %%%s\n", instr->name);
+
+        case IR_STORE:
+            return printer_append(p, "store i32 ") && print_value(p, func, ops[0]) &&
+                   printer_appendf(p, ", %%%s\n", instr->name);
+
+        case IR_ALLOCA:
+            return printer_appendf(p, "%%%s = alloca i32\n", instr->name);
+
+        case IR_ADD:
+        case IR_SUB:
+        case IR_MUL:
+        case IR_DIV:
+        case IR_MOD:
+        case IR_SHL:
+        case IR_ASHR:
+        case IR_LSHR:
+        case IR_MULHI:
+        case IR_AND:
+        case IR_OR:
+            return printer_appendf(p, "%s %s ", arith_name(instr->op), type_name(instr->type)) &&
+                   print_value(p, func, ops[0]) && printer_append(p, ", ") &&
+                   print_value(p, func, ops[1]) && printer_append(p, "\n");
+
+        case IR_ICMP:
+            return printer_appendf(p, "icmp %s i32 ", cmp_name(instr->cmp)) &&
+                   print_value(p, func, ops[0]) && printer_append(p, ", ") &&
+                   print_value(p, func, ops[1]) && printer_append(p, "\n");
+
+        case IR_NOT:
+            return printer_append(p, "xor i1 ") && print_value(p, func, ops[0]) &&
+                   printer_append(p, ", 1\n");
+
+        case IR_SELECT: {
+            const char *type = type_name(instr->type);
+            return printer_append(p, "select i1 ") && print_value(p, func, ops[0]) &&
+                   printer_appendf(p, ", %s ", type) && print_value(p, func, ops[1]) &&
+                   printer_appendf(p, ", %s ", type) && print_value(p, func, ops[2]) &&
+                   printer_append(p, "\n");
+        }
+
+        case IR_PHI:
+            if (!printer_appendf(p, "phi %s ", type_name(instr->type))) return false;
+            for (size_t i = 0; i < instr->operand_count; i++) {
+                if (!printer_append(p, i > 0 ? ", [ " : "[ ")) return false;
+                if (!print_value(p, func, ops[i]) || !printer_append(p, ", ")) return false;
+                if (!print_label(p, instr->labels[i]) || !printer_append(p, " ]")) return false;
+            }
+            return printer_append(p, "\n");
+
+        case IR_CALL:
+            if (!printer_appendf(p, "call i32 @%s(", instr->name)) return false;
+            for (size_t i = 0; i < instr->operand_count; i++) {
+                if (i > 0 && !printer_append(p, ", ")) return false;
+                if (!printer_append(p, "i32 ") || !print_value(p, func, ops[i])) return false;
+            }
+            return printer_append(p, ")\n");
+
+        case IR_PRINT:
+            return printer_append(p, "call void @print(i32 ") && print_value(p, func, ops[0]) &&
+                   printer_append(p, ")\n");
+
+        case IR_BR:
+            return printer_append(p, "br label ") && print_label(p, instr->labels[0]) &&
+                   printer_append(p, "\n");
+
+        case IR_COND_BR:
+            return printer_append(p, "br i1 ") && print_value(p, func, ops[0]) &&
+                   printer_append(p, ", label ") && print_label(p, instr->labels[0]) &&
+                   printer_append(p, ", label ") && print_label(p, instr->labels[1]) &&
+                   printer_append(p, "\n");
+
+        case IR_RET:
+            if (instr->operand_count == 0) return printer_append(p, "ret void\n");
+            return printer_append(p, "ret i32 ") && print_value(p, func, ops[0]) &&
+                   printer_append(p, "\n");
+    }
+    return false;
+}
+
+static bool print_function(IRPrinter *p, const IRFunction *func) {
+    if (!printer_appendf(p, "define %s @%s(", type_name(func->return_type), func->name)) {
+        return false;
+    }
+    for (size_t i = 0; i < func->param_count; i++) {
+        if (i > 0 && !printer_append(p, ", ")) return false;
+        if (!printer_appendf(p, "%s %%%s.param", type_name(func->params[i].type),
+                             func->params[i].name)) {
+            return false;
+        }
+    }
+    if (!printer_append(p, ") {\n")) return false;
+
+    for (size_t b = 0; b < func->block_count; b++) {
+        const IRBlock *block = func->blocks[b];
+
+        if (block->label == IR_LABEL_ENTRY) {
+            if (!printer_append(p, "entry:\n")) return false;
+        } else if (block->label != IR_LABEL_NONE) {
+            if (!printer_appendf(p, "\nL%d:\n", block->label)) return false;
+        }
+
+        for (size_t i = 0; i < block->instr_count; i++) {
+            if (!print_instr(p, func, &block->instrs[i])) return false;
+        }
+    }
+
+    return printer_append(p, "}\n\n");
+}
+
+char *ir_print_module(const IRModule *module, bool emit_comments) {
+    if (!module) return NULL;
+
+    IRPrinter p = { .output = NULL, .length = 0, .capacity = 0 };
+    bool ok = true;
+
+    if (emit_comments) {
+        ok = printer_append(&p, "; Generated by TinyLLVM Compiler\n") &&
+             printer_append(&p, "; Target: TinyLLVM IR (human-readable)\n\n");
+    }
+    ok = ok && printer_append(&p, "declare void @print(i32)\n\n");
+
+    for (size_t i = 0; ok && i < module->func_count; i++) {
+        ok = print_function(&p, module->functions[i]);
+    }
+
+    if (!ok) {
+        free(p.output);
+        return NULL;
+    }
+    return p.output;
+}
@@ -0,0 +1,681 @@
+/**
+ * ==============================================================================
+ * TinyLLVM Compiler - SSA Construction
+ * ==============================================================================
+ *
+ * Promotes variables from stack slots to SSA values (mem2reg). CoreTiny
+ * has no address-of, so every alloca'd variable is promotable:
+ *
+ *   1. Unreachable blocks (code after a return) are dropped.
+ *   2. Dominators are computed with the Cooper-Harvey-Kennedy iteration
+ *      over reverse postorder, and dominance frontiers from them.
+ *   3. For each variable, phis are placed on the iterated dominance
+ *      frontier of its stores, but only where the variable is live on
+ *      entry (pruned SSA), so no phi is left without a use.
+ *   4. A walk of the dominator tree renames: each store pushes its value
+ *      on the variable's stack, each load is replaced by the top of the
+ *      stack, and successors' phis take the value reaching their edge.
+ *
+ * The allocas, loads and stores are then removed.
+ */
+
+#include "include/tinyllvm_ir.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    IRValue *items;
+    size_t count;
+    size_t capacity;
+} ValueStack;
+
+typedef struct {
+    IRModule *module;
+    IRFunction *func;
+    size_t block_count;
+
+    /* Variables: alloca'd names and their value types */
+    const char **vars;
+    IRType *var_types;
+    size_t var_count;
+
+    int *idom;                  /* Immediate dominator per block (entry: itself) */
+    size_t *rpo;                /* Blocks in reverse postorder */
+    size_t rpo_count;
+
+    unsigned char *defines;     /* [block * var_count + var]: block stores var */
+    unsigned char *live_in;     /* [block * var_count + var] */
+    int *phi_dest;              /* [block * var_count + var], IR_NO_TEMP if none */
+
+    /* Values replacing loaded temporaries */
+    IRValue *replacement;
+    bool *replaced;
+
+    bool *dead;                 /* Instructions to remove, flattened per block */
+    size_t *instr_base;         /* First flattened index of each block */
+
+    ValueStack *stacks;
+} SSABuilder;
+
+static size_t find_var(const SSABuilder *ssa, const char *name) {
+    for (size_t i = 0; i < ssa->var_count; i++) {
+        if (strcmp(ssa->vars[i], name) == 0) return i;
+    }
+    return (size_t)-1;
+}
+
+static IRValue resolve(const SSABuilder *ssa, IRValue value) {
+    while (value.kind == IR_VALUE_TEMP && ssa->replaced[value.index]) {
+        value = ssa->replacement[value.index];
+    }
+    return value;
+}
+
+static bool stack_push(ValueStack *stack, IRValue value) {
+    if (stack->count == stack->capacity) {
+        size_t capacity = stack->capacity ? stack->capacity * 2 : 8;
+        IRValue *items = realloc(stack->items, capacity * sizeof(IRValue));
+        if (!items) return false;
+        stack->items = items;
+        stack->capacity = capacity;
+    }
+    stack->items[stack->count++] = value;
+    return true;
+}
+
+static IRValue stack_top(const ValueStack *stack) {
+    if (stack->count == 0) return (IRValue){ .kind = IR_VALUE_UNDEF, .index = 0 };
+    return stack->items[stack->count - 1];
+}
+
+/* ==============================================================================
+ * Unreachable Blocks
+ * ==============================================================================
+ */
+
+static bool remove_unreachable(IRModule *module, IRFunction *func) {
+    size_t n = func->block_count;
+    bool *reachable = calloc(n, sizeof(bool));
+    size_t *worklist = malloc(n * sizeof(size_t));
+    if (!reachable || !worklist) {
+        free(reachable);
+        free(worklist);
+        return false;
+    }
+
+    size_t top = 0;
+    reachable[0] = true;
+    worklist[top++] = 0;
+    while (top > 0) {
+        const IRBlock *block = func->blocks[worklist[--top]];
+        for (size_t i = 0; i < block->succ_count; i++) {
+            if (!reachable[block->succs[i]]) {
+                reachable[block->succs[i]] = true;
+                worklist[top++] = block->succs[i];
+            }
+        }
+    }
+
+    size_t kept = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (reachable[i]) func->blocks[kept++] = func->blocks[i];
+    }
+    func->block_count = kept;
+    free(reachable);
+    free(worklist);
+
+    if (kept == n) return true;
+    if (!ir_function_compute_cfg(module, func)) return false;
+
+    /* Phis built for && and || lose the edges from removed blocks */
+    for (size_t b = 0; b < func->block_count; b++) {
+        IRBlock *block = func->blocks[b];
+        for (size_t i = 0; i < block->instr_count; i++) {
+            IRInstr *instr = &block->instrs[i];
+            if (instr->op != IR_PHI) continue;
+
+            size_t out = 0;
+            for (size_t j = 0; j < instr->operand_count; j++) {
+                bool from_pred = false;
+                for (size_t p = 0; p < block->pred_count; p++) {
+                    if (func->blocks[block->preds[p]]->label == instr->labels[j]) from_pred = true;
+                }
+                if (from_pred) {
+                    instr->operands[out] = instr->operands[j];
+                    instr->labels[out] = instr->labels[j];
+                    out++;
+                }
+            }
+            instr->operand_count = out;
+            instr->label_count = out;
+        }
+    }
+    return true;
+}
+
+/* ==============================================================================
+ * Dominators
+ * ==============================================================================
+ */
+
+static bool compute_rpo(SSABuilder *ssa) {
+    size_t n = ssa->block_count;
+    size_t *stack = malloc(n * sizeof(size_t));
+    size_t *next_succ = calloc(n, sizeof(size_t));
+    bool *visited = calloc(n, sizeof(bool));
+    ssa->rpo = malloc(n * sizeof(size_t));
+    if (!stack || !next_succ || !visited || !ssa->rpo) {
+        free(stack);
+        free(next_succ);
+        free(visited);
+        return false;
+    }
+
+    /* Iterative DFS; blocks are numbered in postorder into the tail of rpo */
+    size_t top = 0, post = n;
+    stack[top++] = 0;
+    visited[0] = true;
+    while (top > 0) {
+        size_t b = stack[top - 1];
+        const IRBlock *block = ssa->func->blocks[b];
+        if (next_succ[b] < block->succ_count) {
+            size_t s = block->succs[next_succ[b]++];
+            if (!visited[s]) {
+                visited[s] = true;
+                stack[top++] = s;
+            }
+        } else {
+            ssa->rpo[--post] = b;
+            top--;
+        }
+    }
+
+    /* Every block is reachable, so post has reached 0 */
+    ssa->rpo_count = n - post;
+    free(stack);
+    free(next_succ);
+    free(visited);
+    return true;
+}
+
+static bool compute_dominators(SSABuilder *ssa) {
+    size_t n = ssa->block_count;
+    size_t *order = malloc(n * sizeof(size_t));
+    ssa->idom = malloc(n * sizeof(int));
+    if (!order || !ssa->idom) {
+        free(order);
+        return false;
+    }
+
+    for (size_t i = 0; i < ssa->rpo_count; i++) order[ssa->rpo[i]] = i;
+    for (size_t i = 0; i < n; i++) ssa->idom[i] = -1;
+    ssa->idom[0] = 0;
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = 1; i < ssa->rpo_count; i++) {
+            size_t b = ssa->rpo[i];
+            const IRBlock *block = ssa->func->blocks[b];
+            int new_idom = -1;
+
+            for (size_t p = 0; p < block->pred_count; p++) {
+                int pred = (int)block->preds[p];
+                if (ssa->idom[pred] < 0) continue;
+                if (new_idom < 0) {
+                    new_idom = pred;
+                    continue;
+                }
+
+                /* Intersect: walk both fingers up to the common dominator */
+                int a = pred, c = new_idom;
+                while (a != c) {
+                    while (order[a] > order[c]) a = ssa->idom[a];
+                    while (order[c] > order[a]) c = ssa->idom[c];
+                }
+                new_idom = a;
+            }
+
+            if (ssa->idom[b] != new_idom) {
+                ssa->idom[b] = new_idom;
+                changed = true;
+            }
+        }
+    }
+
+    free(order);
+    return true;
+}
+
+/* ==============================================================================
+ * Liveness & Phi Placement
+ * ==============================================================================
+ */
+
+static bool compute_liveness(SSABuilder *ssa) {
+    size_t n = ssa->block_count, v = ssa->var_count;
+    unsigned char *upward = calloc(n * v, 1);
+    unsigned char *killed = calloc(n * v, 1);
+    ssa->live_in = calloc(n * v, 1);
+    ssa->defines = killed;
+    if (!upward || !killed || !ssa->live_in) {
+        free(upward);
+        return false;
+    }
+
+    for (size_t b = 0; b < n; b++) {
+        const IRBlock *block = ssa->func->blocks[b];
+        for (size_t i = 0; i < block->instr_count; i++) {
+            const IRInstr *instr = &block->instrs[i];
+            if (instr->op != IR_LOAD && instr->op != IR_STORE) continue;
+
+            size_t var = find_var(ssa, instr->name);
+            if (var == (size_t)-1) continue;
+            if (instr->op == IR_LOAD && !killed[b * v + var]) upward[b * v + var] = 1;
+            if (instr->op == IR_STORE) killed[b * v + var] = 1;
+        }
+    }
+
+    /* Backward dataflow, visiting blocks in postorder */
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = ssa->rpo_count; i-- > 0;) {
+            size_t b = ssa->rpo[i];
+            const IRBlock *block = ssa->func->blocks[b];
+
+            for (size_t var = 0; var < v; var++) {
+                unsigned char live_out = 0;
+                for (size_t s = 0; s < block->succ_count && !live_out; s++) {
+                    live_out = ssa->live_in[block->succs[s] * v + var];
+                }
+
+                unsigned char live = upward[b * v + var] | (live_out & !killed[b * v + var]);
+                if (live != ssa->live_in[b * v + var]) {
+                    ssa->live_in[b * v + var] = live;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    free(upward);
+    return true;
+}
+
+static bool place_phis(SSABuilder *ssa) {
+    size_t n = ssa->block_count, v = ssa->var_count;
+
+    /* Dominance frontiers, as an n x n membership table */
+    unsigned char *frontier = calloc(n * n, 1);
+    size_t *worklist = malloc(n * sizeof(size_t));
+    unsigned char *queued = malloc(n);
+    ssa->phi_dest = malloc(n * v * sizeof(int));
+    if (!frontier || !worklist || !queued || !ssa->phi_dest) {
+        free(frontier);
+        free(worklist);
+        free(queued);
+        return false;
+    }
+
+    for (size_t b = 0; b < n; b++) {
+        const IRBlock *block = ssa->func->blocks[b];
+        if (block->pred_count < 2) continue;
+        for (size_t p = 0; p < block->pred_count; p++) {
+            int runner = (int)block->preds[p];
+            while (runner != ssa->idom[b]) {
+                frontier[(size_t)runner * n + b] = 1;
+                runner = ssa->idom[runner];
+            }
+        }
+    }
+
+    for (size_t i = 0; i < n * v; i++) ssa->phi_dest[i] = IR_NO_TEMP;
+
+    for (size_t var = 0; var < v; var++) {
+        size_t top = 0;
+        for (size_t b = 0; b < n; b++) {
+            queued[b] = ssa->defines[b * v + var];
+            if (queued[b]) worklist[top++] = b;
+        }
+
+        while (top > 0) {
+            size_t b = worklist[--top];
+            for (size_t d = 0; d < n; d++) {
+                if (!frontier[b * n + d] || ssa->phi_dest[d * v + var] != IR_NO_TEMP) continue;
+                if (!ssa->live_in[d * v + var]) continue;
+
+                ssa->phi_dest[d * v + var] = ir_module_new_temp(ssa->module);
+                if (!queued[d]) {
+                    queued[d] = 1;
+                    worklist[top++] = d;
+                }
+            }
+        }
+    }
+
+    free(frontier);
+    free(worklist);
+    free(queued);
+    return true;
+}
+
+/* Prepend the placed phis to their blocks, one incoming edge per predecessor */
+static bool insert_phis(SSABuilder *ssa) {
+    size_t v = ssa->var_count;
+
+    for (size_t b = 0; b < ssa->block_count; b++) {
+        IRBlock *block = ssa->func->blocks[b];
+        size_t phi_count = 0;
+        for (size_t var = 0; var < v; var++) {
+            if (ssa->phi_dest[b * v + var] != IR_NO_TEMP) phi_count++;
+        }
+        if (phi_count == 0) continue;
+
+        size_t total = phi_count + block->instr_count;
+        IRInstr *instrs = ir_arena_alloc(&ssa->module->arena, total * sizeof(IRInstr));
+        IRValue *operands = ir_arena_alloc(&ssa->module->arena,
+                                           phi_count * block->pred_count * sizeof(IRValue));
+        int *labels = ir_arena_alloc(&ssa->module->arena, block->pred_count * sizeof(int));
+        if (!instrs || !operands || !labels) return false;
+
+        for (size_t p = 0; p < block->pred_count; p++) {
+            labels[p] = ssa->func->blocks[block->preds[p]]->label;
+        }
+
+        int depth = block->instr_count > 0 ? block->instrs[0].depth : 1;
+        size_t slot = 0;
+        for (size_t var = 0; var < v; var++) {
+            int dest = ssa->phi_dest[b * v + var];
+            if (dest == IR_NO_TEMP) continue;
+
+            IRValue *incoming = &operands[slot * block->pred_count];
+            for (size_t p = 0; p < block->pred_count; p++) {
+                incoming[p] = (IRValue){ .kind = IR_VALUE_UNDEF, .index = 0 };
+            }
+            instrs[slot++] = (IRInstr){
+                .op = IR_PHI, .type = ssa->var_types[var], .dest = dest,
+                .operands = incoming, .operand_count = block->pred_count,
+                .labels = labels, .label_count = block->pred_count,
+                .depth = depth
+            };
+        }
+
+        memcpy(instrs + phi_count, block->instrs, block->instr_count * sizeof(IRInstr));
+        block->instrs = instrs;
+        block->instr_count = total;
+        block->instr_capacity = total;
+    }
+    return true;
+}
+
+/* ==============================================================================
+ * Renaming
+ * ==============================================================================
+ */
+
+/* The phi for var at the head of block b (phis are in variable order) */
+static IRInstr *phi_for(SSABuilder *ssa, size_t b, size_t var) {
+    IRBlock *block = ssa->func->blocks[b];
+    int dest = ssa->phi_dest[b * ssa->var_count + var];
+    for (size_t i = 0; i < block->instr_count && block->instrs[i].op == IR_PHI; i++) {
+        if (block->instrs[i].dest == dest) return &block->instrs[i];
+    }
+    return NULL;
+}
+
+static bool rename_block(SSABuilder *ssa, size_t b, const size_t *children,
+                         const size_t *child_start) {
+    IRBlock *block = ssa->func->blocks[b];
+    size_t v = ssa->var_count;
+    bool ok = true;
+
+    for (size_t var = 0; var < v && ok; var++) {
+        int dest = ssa->phi_dest[b * v + var];
+        if (dest != IR_NO_TEMP) {
+            ok = stack_push(&ssa->stacks[var], (IRValue){ .kind = IR_VALUE_TEMP, .index = dest });
+        }
+    }
+
+    for (size_t i = 0; i < block->instr_count && ok; i++) {
+        IRInstr *instr = &block->instrs[i];
+        if (instr->op != IR_ALLOCA && instr->op != IR_LOAD && instr->op != IR_STORE) continue;
+
+        size_t var = find_var(ssa, instr->name);
+        if (var == (size_t)-1) continue;
+        ssa->dead[ssa->instr_base[b] + i] = true;
+
+        if (instr->op == IR_LOAD) {
+            ssa->replacement[instr->dest] = stack_top(&ssa->stacks[var]);
+            ssa->replaced[instr->dest] = true;
+        } else if (instr->op == IR_STORE) {
+            ok = stack_push(&ssa->stacks[var], resolve(ssa, instr->operands[0]));
+        }
+    }
+
+    /* Fill this block's edge into each successor's phis */
+    for (size_t s = 0; s < block->succ_count && ok; s++) {
+        size_t succ = block->succs[s];
+        const IRBlock *target = ssa->func->blocks[succ];
+        size_t edge = 0;
+        while (target->preds[edge] != b) edge++;
+
+        for (size_t var = 0; var < v; var++) {
+            if (ssa->phi_dest[succ * v + var] == IR_NO_TEMP) continue;
+            phi_for(ssa, succ, var)->operands[edge] = stack_top(&ssa->stacks[var]);
+        }
+    }
+
+    for (size_t c = child_start[b]; c < child_start[b + 1] && ok; c++) {
+        ok = rename_block(ssa, children[c], children, child_start);
+    }
+
+    /* Pop what this block pushed */
+    for (size_t var = 0; var < v; var++) {
+        if (ssa->phi_dest[b * v + var] != IR_NO_TEMP && ssa->stacks[var].count > 0) {
+            ssa->stacks[var].count--;
+        }
+    }
+    for (size_t i = 0; i < block->instr_count; i++) {
+        const IRInstr *instr = &block->instrs[i];
+        if (instr->op != IR_STORE || !ssa->dead[ssa->instr_base[b] + i]) continue;
+        size_t var = find_var(ssa, instr->name);
+        if (ssa->stacks[var].count > 0) ssa->stacks[var].count--;
+    }
+    return ok;
+}
+
+static bool rename_variables(SSABuilder *ssa) {
+    size_t n = ssa->block_count;
+
+    /* Dominator tree children, grouped by parent */
+    size_t *child_start = calloc(n + 1, sizeof(size_t));
+    size_t *children = malloc(n * sizeof(size_t));
+    size_t *fill = malloc(n * sizeof(size_t));
+    if (!child_start || !children || !fill) {
+        free(child_start);
+        free(children);
+        free(fill);
+        return false;
+    }
+
+    for (size_t b = 1; b < n; b++) child_start[ssa->idom[b] + 1]++;
+    for (size_t b = 0; b < n; b++) child_start[b + 1] += child_start[b];
+    memcpy(fill, child_start, n * sizeof(size_t));
+    for (size_t b = 1; b < n; b++) children[fill[ssa->idom[b]]++] = b;
+
+    bool ok = rename_block(ssa, 0, children, child_start);
+
+    free(child_start);
+    free(children);
+    free(fill);
+    return ok;
+}
+
+/* Drop the promoted memory operations and rewrite uses of loaded values */
+static void rewrite_function(SSABuilder *ssa) {
+    for (size_t b = 0; b < ssa->block_count; b++) {
+        IRBlock *block = ssa->func->blocks[b];
+        size_t out = 0;
+
+        for (size_t i = 0; i < block->instr_count; i++) {
+            if (ssa->dead[ssa->instr_base[b] + i]) continue;
+
+            IRInstr *instr = &block->instrs[i];
+            for (size_t j = 0; j < instr->operand_count; j++) {
+                instr->operands[j] = resolve(ssa, instr->operands[j]);
+            }
+            block->instrs[out++] = *instr;
+        }
+        block->instr_count = out;
+    }
+}
+
+/* ==============================================================================
+ * Variables
+ * ==============================================================================
+ */
+
+/* Collect the alloca'd names; a variable is i1 when every value stored to
+ * it is, counting loads of i1 variables */
+static bool collect_variables(SSABuilder *ssa) {
+    size_t total = 0;
+    for (size_t b = 0; b < ssa->block_count; b++) total += ssa->func->blocks[b]->instr_count;
+
+    size_t temps = (size_t)ssa->module->temp_count;
+    ssa->vars = malloc((total ? total : 1) * sizeof(char *));
+    ssa->var_types = malloc((total ? total : 1) * sizeof(IRType));
+    IRType *temp_types = malloc((temps ? temps : 1) * sizeof(IRType));
+    size_t *loaded_var = malloc((temps ? temps : 1) * sizeof(size_t));
+    if (!ssa->vars || !ssa->var_types || !temp_types || !loaded_var) {
+        free(temp_types);
+        free(loaded_var);
+        return false;
+    }
+
+    for (size_t b = 0; b < ssa->block_count; b++) {
+        const IRBlock *block = ssa->func->blocks[b];
+        for (size_t i = 0; i < block->instr_count; i++) {
+            const IRInstr *instr = &block->instrs[i];
+            if (instr->op == IR_ALLOCA && find_var(ssa, instr->name) == (size_t)-1) {
+                ssa->var_types[ssa->var_count] = IR_TYPE_I1;
+                ssa->vars[ssa->var_count++] = instr->name;
+            }
+        }
+    }
+
+    for (size_t b = 0; b < ssa->block_count; b++) {
+        const IRBlock *block = ssa->func->blocks[b];
+        for (size_t i = 0; i < block->instr_count; i++) {
+            const IRInstr *instr = &block->instrs[i];
+            if (instr->dest == IR_NO_TEMP) continue;
+            temp_types[instr->dest] = instr->type;
+            loaded_var[instr->dest] = instr->op == IR_LOAD ? find_var(ssa, instr->name) :
+                                                             (size_t)-1;
+        }
+    }
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t b = 0; b < ssa->block_count; b++) {
+            const IRBlock *block = ssa->func->blocks[b];
+            for (size_t i = 0; i < block->instr_count; i++) {
+                const IRInstr *instr = &block->instrs[i];
+                if (instr->op != IR_STORE) continue;
+
+                size_t var = find_var(ssa, instr->name);
+                if (var == (size_t)-1 || ssa->var_types[var] != IR_TYPE_I1) continue;
+
+                IRValue value = instr->operands[0];
+                IRType type = IR_TYPE_I32;
+                if (value.kind == IR_VALUE_PARAM) {
+                    type = ssa->func->params[value.index].type;
+                } else if (value.kind == IR_VALUE_TEMP) {
+                    size_t source = loaded_var[value.index];
+                    type = source != (size_t)-1 ? ssa->var_types[source] :
+                                                  temp_types[value.index];
+                }
+                if (type != IR_TYPE_I1) {
+                    ssa->var_types[var] = IR_TYPE_I32;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    free(temp_types);
+    free(loaded_var);
+    return true;
+}
+
+/* ==============================================================================
+ * Public API
+ * ==============================================================================
+ */
+
+static void ssa_free(SSABuilder *ssa) {
+    if (ssa->stacks) {
+        for (size_t i = 0; i < ssa->var_count; i++) free(ssa->stacks[i].items);
+    }
+    free(ssa->stacks);
+    free(ssa->vars);
+    free(ssa->var_types);
+    free(ssa->idom);
+    free(ssa->rpo);
+    free(ssa->defines);
+    free(ssa->live_in);
+    free(ssa->phi_dest);
+    free(ssa->replacement);
+    free(ssa->replaced);
+    free(ssa->dead);
+    free(ssa->instr_base);
+}
+
+bool ir_function_to_ssa(IRModule *module, IRFunction *func) {
+    if (!module || !func || func->block_count == 0) return false;
+    if (!remove_unreachable(module, func)) return false;
+
+    SSABuilder ssa = { .module = module, .func = func, .block_count = func->block_count };
+    bool ok = collect_variables(&ssa);
+    if (ok && ssa.var_count == 0) {
+        ssa_free(&ssa);
+        return true;
+    }
+
+    ok = ok && compute_rpo(&ssa) && compute_dominators(&ssa) &&
+         compute_liveness(&ssa) && place_phis(&ssa) && insert_phis(&ssa);
+
+    if (ok) {
+        /* Phis were prepended, so the flattened layout is taken only now */
+        size_t total = 0;
+        ssa.instr_base = malloc(ssa.block_count * sizeof(size_t));
+        ok = ssa.instr_base != NULL;
+        for (size_t b = 0; ok && b < ssa.block_count; b++) {
+            ssa.instr_base[b] = total;
+            total += func->blocks[b]->instr_count;
+        }
+
+        size_t temps = (size_t)module->temp_count;
+        ssa.dead = ok ? calloc(total ? total : 1, sizeof(bool)) : NULL;
+        ssa.replacement = malloc((temps ? temps : 1) * sizeof(IRValue));
+        ssa.replaced = calloc(temps ? temps : 1, sizeof(bool));
+        ssa.stacks = calloc(ssa.var_count, sizeof(ValueStack));
+        ok = ssa.dead && ssa.replacement && ssa.replaced && ssa.stacks;
+    }
+
+    ok = ok && rename_variables(&ssa);
+    if (ok) rewrite_function(&ssa);
+
+    ssa_free(&ssa);
+    return ok;
+}
+
+bool ir_module_to_ssa(IRModule *module) {
+    if (!module) return false;
+
+    for (size_t i = 0; i < module->func_count; i++) {
+        if (!ir_function_to_ssa(module, module->functions[i])) return false;
+    }
+    return true;
+}
@@ -0,0 +1,1008 @@
+/**
+ * ==============================================================================
+ * TinyLLVM Compiler - x86-64 JIT
+ * ==============================================================================
+ *
+ * Translates the stack bytecode to machine code with one template per
+ * instruction. Slots live in the native frame at [rbp - 4 * (slot + 1)].
+ * The operand stack is the machine stack with its top cached in eax, so
+ * most instructions are a single register operation; a push followed by
+ * an arithmetic or compare instruction becomes one instruction with an
+ * immediate operand. The operand depth before every instruction is found
+ * by a pass over the bytecode, and each jump target must be reached at a
+ * single depth.
+ *
+ * Calls: the caller pushes the arguments (first argument deepest) and
+ * calls the callee directly. The callee copies them into its slots and
+ * returns in eax, and the caller drops them.
+ *
+ * Generated code runs on a stack of its own, entered through a trampoline
+ * that saves the caller's registers and pins the JitRuntime in r15.
+ * Runtime errors jump to stubs that restore the caller's stack pointer,
+ * which unwinds any number of JIT frames at once. Code is assembled into
+ * a heap buffer, copied to a writable mapping and then made executable.
+ */
+
+/* MAP_ANONYMOUS is hidden in strict POSIX mode */
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+
+#include "include/tinyllvm_jit.h"
+#include "include/eventchains_platform.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+
+#if defined(__x86_64__) && EC_PLATFORM_POSIX
+#define JIT_SUPPORTED 1
+#include <sys/mman.h>
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#else
+#define JIT_SUPPORTED 0
+#endif
+
+#define JIT_STACK_SIZE    ((size_t)64 << 20)
+#define JIT_STACK_MARGIN  ((size_t)256 << 10)   /* Left free for print functions */
+#define JIT_MAX_SLOTS     (1 << 20)             /* Per function, slots and operands */
+
+typedef enum {
+    JIT_OK,
+    JIT_DIVISION_BY_ZERO,
+    JIT_DIVISION_OVERFLOW,
+    JIT_STACK_OVERFLOW,
+    JIT_ERROR_COUNT
+} JitError;
+
+static const char *const jit_error_messages[JIT_ERROR_COUNT] = {
+    NULL, "division by zero", "division overflow", "stack overflow"
+};
+
+/* Read by generated code through r15 */
+typedef struct {
+    ByteCodePrintFunction print;
+    void *print_data;
+    uintptr_t saved_sp;         /* Caller's stack pointer during a call */
+    uintptr_t stack_top;
+    uintptr_t stack_limit;
+    int32_t error;              /* JitError of the last call */
+} JitRuntime;
+
+typedef struct {
+    char *name;
+    size_t param_count;
+    size_t offset;              /* Into the code */
+} JitFunction;
+
+struct JitModule {
+    JitRuntime runtime;
+
+    uint8_t *code;
+    size_t code_size;
+    uint8_t *stack;
+
+    JitFunction *functions;
+    size_t func_count;
+    size_t main_offset;         /* main() stub, or (size_t)-1 */
+};
+
+/* Trampoline at offset 0: runs function on the JIT stack with the
+ * arguments pushed, and returns its result */
+typedef int32_t (*JitEnter)(JitRuntime *runtime, const int64_t *args, size_t arg_count,
+                            const void *function);
+
+static void set_error(char *error, size_t error_size, const char *format, ...) {
+    if (!error || error_size == 0) return;
+
+    va_list args;
+    va_start(args, format);
+    vsnprintf(error, error_size, format, args);
+    va_end(args);
+}
+
+static void default_print(int32_t value, void *user_data) {
+    (void)user_data;
+    printf("%d\n", value);
+}
+
+#if JIT_SUPPORTED
+
+/* ==============================================================================
+ * Code Buffer
+ * ==============================================================================
+ */
+
+typedef struct {
+    uint8_t *data;
+    size_t size;
+    size_t capacity;
+    bool failed;
+} JitBuffer;
+
+static void emit_bytes(JitBuffer *b, const uint8_t *bytes, size_t count) {
+    if (b->failed) return;
+
+    if (b->size + count > b->capacity) {
+        size_t capacity = b->capacity == 0 ? 4096 : b->capacity * 2;
+        while (capacity < b->size + count) {
+            capacity *= 2;
+        }
+
+        uint8_t *data = realloc(b->data, capacity);
+        if (!data) {
+            b->failed = true;
+            return;
+        }
+        b->data = data;
+        b->capacity = capacity;
+    }
+
+    memcpy(b->data + b->size, bytes, count);
+    b->size += count;
+}
+
+#define EMIT(b, ...) do { \
+        static const uint8_t bytes_[] = { __VA_ARGS__ }; \
+        emit_bytes((b), bytes_, sizeof(bytes_)); \
+    } while (0)
+
+static void encode_u32(uint8_t *out, uint32_t value) {
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+    out[2] = (uint8_t)(value >> 16);
+    out[3] = (uint8_t)(value >> 24);
+}
+
+static void emit_u32(JitBuffer *b, uint32_t value) {
+    uint8_t bytes[4];
+    encode_u32(bytes, value);
+    emit_bytes(b, bytes, sizeof(bytes));
+}
+
+static void emit_u64(JitBuffer *b, uint64_t value) {
+    emit_u32(b, (uint32_t)value);
+    emit_u32(b, (uint32_t)(value >> 32));
+}
+
+static uint32_t rel32(size_t from_end, size_t target) {
+    return (uint32_t)(int32_t)((int64_t)target - (int64_t)from_end);
+}
+
+/* rel32 operand to an offset already emitted */
+static void emit_rel32(JitBuffer *b, size_t target) {
+    emit_u32(b, rel32(b->size + 4, target));
+}
+
+/* ==============================================================================
+ * Compiler State
+ * ==============================================================================
+ */
+
+typedef struct {
+    size_t pos;                 /* Of the rel32 to patch */
+    size_t target;              /* Instruction, or function for calls */
+    bool call;
+} JitFixup;
+
+typedef struct {
+    const ByteCode *code;
+    JitBuffer out;
+
+    int *depth;                 /* Operand depth before each instruction, -1 if unreachable */
+    bool *is_target;
+    size_t *offsets;            /* Native offset of each instruction */
+    size_t *function_offsets;
+
+    JitFixup *fixups;
+    size_t fixup_count;
+    size_t fixup_capacity;
+
+    size_t exit_offset;
+    size_t stubs[JIT_ERROR_COUNT];
+
+    char *error;
+    size_t error_size;
+} JitCompiler;
+
+static bool fail(JitCompiler *c, const char *format, ...) {
+    if (c->error && c->error_size > 0) {
+        va_list args;
+        va_start(args, format);
+        vsnprintf(c->error, c->error_size, format, args);
+        va_end(args);
+    }
+    return false;
+}
+
+/* rel32 to an instruction or function, patched once all code exists */
+static void emit_fixup(JitCompiler *c, size_t target, bool call) {
+    if (c->fixup_count == c->fixup_capacity) {
+        size_t capacity = c->fixup_capacity == 0 ? 64 : c->fixup_capacity * 2;
+        JitFixup *fixups = realloc(c->fixups, capacity * sizeof(JitFixup));
+        if (!fixups) {
+            c->out.failed = true;
+            return;
+        }
+        c->fixups = fixups;
+        c->fixup_capacity = capacity;
+    }
+
+    c->fixups[c->fixup_count].pos = c->out.size;
+    c->fixups[c->fixup_count].target = target;
+    c->fixups[c->fixup_count].call = call;
+    c->fixup_count++;
+    emit_u32(&c->out, 0);
+}
+
+/* ==============================================================================
+ * Stack Depth Analysis
+ * ==============================================================================
+ */
+
+static bool is_jump(InstructionType type) {
+    return type == INSTR_JUMP || type == INSTR_JUMP_IF_FALSE || type == INSTR_JUMP_IF_TRUE ||
+           (type >= INSTR_JUMP_IF_EQ && type <= INSTR_JUMP_IF_GE);
+}
+
+static int stack_inputs(const ByteCode *code, const Instruction *instr) {
+    switch (instr->type) {
+        case INSTR_PUSH:
+        case INSTR_LOAD:
+        case INSTR_LOAD2:
+        case INSTR_LOAD2_ADD:
+        case INSTR_JUMP:
+            return 0;
+        case INSTR_NOT:
+        case INSTR_STORE:
+        case INSTR_POP:
+        case INSTR_PRINT:
+        case INSTR_JUMP_IF_FALSE:
+        case INSTR_JUMP_IF_TRUE:
+            return 1;
+        case INSTR_SELECT:
+            return 3;
+        case INSTR_CALL:
+            return (int)code->functions[instr->operand].param_count;
+        case INSTR_RETURN:
+            return instr->operand ? 1 : 0;
+        default:
+            return 2;
+    }
+}
+
+static int stack_outputs(InstructionType type) {
+    switch (type) {
+        case INSTR_LOAD2:
+            return 2;
+        case INSTR_STORE:
+        case INSTR_POP:
+        case INSTR_PRINT:
+        case INSTR_RETURN:
+            return 0;
+        default:
+            return is_jump(type) ? 0 : 1;
+    }
+}
+
+static size_t function_end(const ByteCode *code, size_t index) {
+    return index + 1 < code->func_count ? code->functions[index + 1].entry : code->count;
+}
+
+static bool check_slot(JitCompiler *c, const ByteCodeFunction *fn, size_t slot) {
+    if (slot < fn->local_count) return true;
+    return fail(c, "%s: slot %zu out of range", fn->name, slot);
+}
+
+static bool check_instruction(JitCompiler *c, const ByteCodeFunction *fn, size_t begin,
+                              size_t end, const Instruction *instr) {
+    int operand = instr->operand;
+
+    if ((int)instr->type < 0 || instr->type >= INSTR_COUNT) {
+        return fail(c, "%s: invalid instruction", fn->name);
+    }
+    if (is_jump(instr->type) && (operand < 0 || (size_t)operand < begin || (size_t)operand >= end)) {
+        return fail(c, "%s: jump out of the function", fn->name);
+    }
+
+    switch (instr->type) {
+        case INSTR_LOAD:
+        case INSTR_STORE:
+            return operand >= 0 && check_slot(c, fn, (size_t)operand);
+        case INSTR_LOAD2:
+        case INSTR_LOAD2_ADD:
+            return operand >= 0 && check_slot(c, fn, (size_t)operand & 0xFFFF) &&
+                   check_slot(c, fn, (size_t)operand >> 16);
+        case INSTR_CALL:
+            if (operand < 0 || (size_t)operand >= c->code->func_count) {
+                return fail(c, "%s: call to unknown function", fn->name);
+            }
+            return true;
+        default:
+            return true;
+    }
+}
+
+/* Give target its depth, queueing it the first time it is reached */
+static bool reach(JitCompiler *c, size_t target, int depth, size_t *work, size_t *work_count) {
+    if (c->depth[target] < 0) {
+        c->depth[target] = depth;
+        work[(*work_count)++] = target;
+        return true;
+    }
+    if (c->depth[target] != depth) {
+        return fail(c, "inconsistent stack depth at instruction %zu", target);
+    }
+    return true;
+}
+
+static bool analyze_function(JitCompiler *c, size_t index, size_t *max_depth) {
+    const ByteCode *code = c->code;
+    const ByteCodeFunction *fn = &code->functions[index];
+    size_t begin = fn->entry;
+    size_t end = function_end(code, index);
+
+    if (begin >= end || end > code->count) return fail(c, "%s: no code", fn->name);
+    if (fn->param_count > fn->local_count || fn->local_count > JIT_MAX_SLOTS) {
+        return fail(c, "%s: bad frame", fn->name);
+    }
+
+    size_t *work = malloc((end - begin) * sizeof(size_t));
+    if (!work) return fail(c, "out of memory");
+
+    size_t work_count = 0;
+    bool ok = reach(c, begin, 0, work, &work_count);
+    *max_depth = 0;
+
+    while (ok && work_count > 0) {
+        size_t i = work[--work_count];
+        const Instruction *instr = &code->instructions[i];
+        int depth = c->depth[i];
+
+        if (!check_instruction(c, fn, begin, end, instr)) {
+            ok = false;
+            break;
+        }
+
+        int inputs = stack_inputs(code, instr);
+        if (depth < inputs) {
+            ok = fail(c, "%s: stack underflow at instruction %zu", fn->name, i);
+            break;
+        }
+
+        int next = depth - inputs + stack_outputs(instr->type);
+        if (next > JIT_MAX_SLOTS) {
+            ok = fail(c, "%s: operand stack too deep", fn->name);
+            break;
+        }
+        if ((size_t)next > *max_depth) *max_depth = (size_t)next;
+
+        if (is_jump(instr->type)) {
+            c->is_target[instr->operand] = true;
+            ok = reach(c, (size_t)instr->operand, next, work, &work_count);
+        }
+        if (ok && instr->type != INSTR_JUMP && instr->type != INSTR_RETURN) {
+            ok = i + 1 < end ? reach(c, i + 1, next, work, &work_count)
+                             : fail(c, "%s: falls off the end", fn->name);
+        }
+    }
+
+    free(work);
+    return ok;
+}
+
+/* ==============================================================================
+ * Instruction Templates
+ * ==============================================================================
+ */
+
+/* setcc and jcc opcodes, in EQ, NE, LT, LE, GT, GE order */
+static const uint8_t setcc_opcodes[] = { 0x94, 0x95, 0x9C, 0x9E, 0x9F, 0x9D };
+static const uint8_t jcc_opcodes[] = { 0x84, 0x85, 0x8C, 0x8E, 0x8F, 0x8D };
+
+static uint32_t slot_disp(size_t slot) {
+    return (uint32_t)(-4 * ((int32_t)slot + 1));
+}
+
+/* op eax, [rbp + slot] */
+static void emit_slot(JitBuffer *b, uint8_t opcode, size_t slot) {
+    uint8_t bytes[2] = { opcode, 0x85 };
+    emit_bytes(b, bytes, sizeof(bytes));
+    emit_u32(b, slot_disp(slot));
+}
+
+#define SLOT_LOAD   0x8B    /* mov eax, [slot] */
+#define SLOT_STORE  0x89    /* mov [slot], eax */
+#define SLOT_ADD    0x03    /* add eax, [slot] */
+
+/* Make room for a new top of stack */
+static void emit_spill(JitBuffer *b, int depth) {
+    if (depth > 0) EMIT(b, 0x50);                           /* push rax */
+}
+
+/* Reload the top of stack after consuming it */
+static void emit_refill(JitBuffer *b, int remaining) {
+    if (remaining > 0) EMIT(b, 0x58);                       /* pop rax */
+}
+
+static void emit_setcc(JitBuffer *b, InstructionType type) {
+    uint8_t bytes[6] = { 0x0F, setcc_opcodes[type - INSTR_EQ], 0xC0,   /* setcc al */
+                         0x0F, 0xB6, 0xC0 };                           /* movzx eax, al */
+    emit_bytes(b, bytes, sizeof(bytes));
+}
+
+static void emit_jcc(JitCompiler *c, InstructionType type, size_t target) {
+    uint8_t bytes[2] = { 0x0F, jcc_opcodes[type - INSTR_JUMP_IF_EQ] };
+    emit_bytes(&c->out, bytes, sizeof(bytes));
+    emit_fixup(c, target, false);
+}
+
+/* a op b with a on the machine stack and b in eax */
+static void emit_division(JitCompiler *c, bool remainder) {
+    JitBuffer *b = &c->out;
+
+    EMIT(b, 0x59, 0x91);                                    /* pop rcx; xchg eax, ecx */
+    EMIT(b, 0x85, 0xC9, 0x0F, 0x84);                        /* test ecx, ecx; jz */
+    emit_rel32(b, c->stubs[JIT_DIVISION_BY_ZERO]);
+    EMIT(b, 0x83, 0xF9, 0xFF, 0x75, 0x0B);                  /* cmp ecx, -1; jne +11 */
+    EMIT(b, 0x3D, 0x00, 0x00, 0x00, 0x80, 0x0F, 0x84);      /* cmp eax, INT32_MIN; je */
+    emit_rel32(b, c->stubs[JIT_DIVISION_OVERFLOW]);
+    EMIT(b, 0x99, 0xF7, 0xF9);                              /* cdq; idiv ecx */
+    if (remainder) EMIT(b, 0x89, 0xD0);                     /* mov eax, edx */
+}
+
+/* "push imm; next" as one instruction on eax, if next allows it */
+static bool emit_immediate(JitCompiler *c, const Instruction *next, int32_t imm, int depth) {
+    JitBuffer *b = &c->out;
+    InstructionType type = next->type;
+
+    switch (type) {
+        case INSTR_ADD: EMIT(b, 0x05); break;                /* add eax, imm32 */
+        case INSTR_SUB: EMIT(b, 0x2D); break;                /* sub eax, imm32 */
+        case INSTR_MUL: EMIT(b, 0x69, 0xC0); break;          /* imul eax, eax, imm32 */
+        case INSTR_EQ: case INSTR_NE: case INSTR_LT:
+        case INSTR_LE: case INSTR_GT: case INSTR_GE:
+        case INSTR_JUMP_IF_EQ: case INSTR_JUMP_IF_NE: case INSTR_JUMP_IF_LT:
+        case INSTR_JUMP_IF_LE: case INSTR_JUMP_IF_GT: case INSTR_JUMP_IF_GE:
+            EMIT(b, 0x3D);                                  /* cmp eax, imm32 */
+            break;
+        default:
+            return false;
+    }
+    emit_u32(b, (uint32_t)imm);
+
+    if (type >= INSTR_EQ && type <= INSTR_GE) {
+        emit_setcc(b, type);
+    } else if (type >= INSTR_JUMP_IF_EQ) {
+        emit_refill(b, depth - 1);
+        emit_jcc(c, type, (size_t)next->operand);
+    }
+    return true;
+}
+
+/* Emit instruction i; returns how many bytecode instructions it covered */
+static size_t emit_instruction(JitCompiler *c, size_t i, size_t end) {
+    JitBuffer *b = &c->out;
+    const Instruction *instr = &c->code->instructions[i];
+    const Instruction *next = i + 1 < end && !c->is_target[i + 1] ? instr + 1 : NULL;
+    int depth = c->depth[i];
+    int operand = instr->operand;
+
+    switch (instr->type) {
+        case INSTR_PUSH:
+            if (next && depth > 0 && emit_immediate(c, next, operand, depth)) return 2;
+            emit_spill(b, depth);
+            EMIT(b, 0xB8);                                  /* mov eax, imm32 */
+            emit_u32(b, (uint32_t)operand);
+            break;
+
+        case INSTR_LOAD:
+            emit_spill(b, depth);
+            emit_slot(b, SLOT_LOAD, (size_t)operand);
+            break;
+
+        case INSTR_LOAD2:
+            emit_spill(b, depth);
+            emit_slot(b, SLOT_LOAD, (size_t)operand & 0xFFFF);
+            EMIT(b, 0x50);                                  /* push rax */
+            emit_slot(b, SLOT_LOAD, (size_t)operand >> 16);
+            break;
+
+        case INSTR_LOAD2_ADD:
+            emit_spill(b, depth);
+            emit_slot(b, SLOT_LOAD, (size_t)operand & 0xFFFF);
+            emit_slot(b, SLOT_ADD, (size_t)operand >> 16);
+            break;
+
+        case INSTR_STORE:
+            emit_slot(b, SLOT_STORE, (size_t)operand);
+            emit_refill(b, depth - 1);
+            break;
+
+        case INSTR_POP:
+            emit_refill(b, depth - 1);
+            break;
+
+        case INSTR_ADD: EMIT(b, 0x59, 0x01, 0xC8); break;               /* pop rcx; add eax, ecx */
+        case INSTR_SUB: EMIT(b, 0x59, 0x29, 0xC1, 0x89, 0xC8); break;   /* sub ecx, eax; mov eax, ecx */
+        case INSTR_MUL: EMIT(b, 0x59, 0x0F, 0xAF, 0xC1); break;         /* imul eax, ecx */
+        case INSTR_DIV: emit_division(c, false); break;
+        case INSTR_MOD: emit_division(c, true); break;
+
+        /* Shift counts are masked to five bits by the hardware */
+        case INSTR_SHL:  EMIT(b, 0x59, 0x91, 0xD3, 0xE0); break;        /* xchg; shl eax, cl */
+        case INSTR_SHR:  EMIT(b, 0x59, 0x91, 0xD3, 0xF8); break;        /* xchg; sar eax, cl */
+        case INSTR_USHR: EMIT(b, 0x59, 0x91, 0xD3, 0xE8); break;        /* xchg; shr eax, cl */
+
+        case INSTR_MULHI:
+            EMIT(b, 0x59,
+                 0x48, 0x63, 0xC0,                          /* movsxd rax, eax */
+                 0x48, 0x63, 0xC9,                          /* movsxd rcx, ecx */
+                 0x48, 0x0F, 0xAF, 0xC1,                    /* imul rax, rcx */
+                 0x48, 0xC1, 0xF8, 0x20);                   /* sar rax, 32 */
+            break;
+
+        case INSTR_EQ: case INSTR_NE: case INSTR_LT:
+        case INSTR_LE: case INSTR_GT: case INSTR_GE:
+            EMIT(b, 0x59, 0x39, 0xC1);                      /* pop rcx; cmp ecx, eax */
+            emit_setcc(b, instr->type);
+            break;
+
+        case INSTR_NOT:
+            EMIT(b, 0x85, 0xC0);                            /* test eax, eax */
+            emit_setcc(b, INSTR_EQ);
+            break;
+
+        case INSTR_SELECT:
+            EMIT(b, 0x59, 0x5A,                             /* pop rcx (then); pop rdx (cond) */
+                 0x85, 0xD2, 0x0F, 0x45, 0xC1);             /* test edx, edx; cmovne eax, ecx */
+            break;
+
+        case INSTR_JUMP:
+            EMIT(b, 0xE9);
+            emit_fixup(c, (size_t)operand, false);
+            break;
+
+        case INSTR_JUMP_IF_FALSE:
+        case INSTR_JUMP_IF_TRUE:
+            EMIT(b, 0x85, 0xC0);                            /* test eax, eax */
+            emit_refill(b, depth - 1);                      /* pop leaves flags alone; jz / jnz */
+            emit_jcc(c, instr->type == INSTR_JUMP_IF_FALSE ? INSTR_JUMP_IF_EQ : INSTR_JUMP_IF_NE,
+                     (size_t)operand);
+            break;
+
+        case INSTR_JUMP_IF_EQ: case INSTR_JUMP_IF_NE: case INSTR_JUMP_IF_LT:
+        case INSTR_JUMP_IF_LE: case INSTR_JUMP_IF_GT: case INSTR_JUMP_IF_GE:
+            EMIT(b, 0x59, 0x39, 0xC1);                      /* pop rcx; cmp ecx, eax */
+            emit_refill(b, depth - 2);
+            emit_jcc(c, instr->type, (size_t)operand);
+            break;
+
+        case INSTR_CALL: {
+            size_t params = c->code->functions[operand].param_count;
+            emit_spill(b, depth);
+            EMIT(b, 0xE8);                                  /* call rel32 */
+            emit_fixup(c, (size_t)operand, true);
+            if (params > 0) {
+                EMIT(b, 0x48, 0x81, 0xC4);                  /* add rsp, imm32 */
+                emit_u32(b, (uint32_t)(params * 8));
+            }
+            break;
+        }
+
+        case INSTR_RETURN:
+            if (!operand) EMIT(b, 0x31, 0xC0);              /* xor eax, eax */
+            EMIT(b, 0x48, 0x89, 0xEC, 0x5D, 0xC3);          /* mov rsp, rbp; pop rbp; ret */
+            break;
+
+        case INSTR_PRINT:
+            /* print(value, data) with a 16-byte aligned stack; rbx survives the call */
+            EMIT(b, 0x89, 0xC7,                             /* mov edi, eax */
+                 0x49, 0x8B, 0xB7);                         /* mov rsi, [r15 + print_data] */
+            emit_u32(b, (uint32_t)offsetof(JitRuntime, print_data));
+            EMIT(b, 0x48, 0x89, 0xE3,                       /* mov rbx, rsp */
+                 0x48, 0x83, 0xE4, 0xF0,                    /* and rsp, -16 */
+                 0x41, 0xFF, 0x97);                         /* call [r15 + print] */
+            emit_u32(b, (uint32_t)offsetof(JitRuntime, print));
+            EMIT(b, 0x48, 0x89, 0xDC);                      /* mov rsp, rbx */
+            emit_refill(b, depth - 1);
+            break;
+
+        default:
+            break;
+    }
+    return 1;
+}
+
+/* ==============================================================================
+ * Functions & Trampolines
+ * ==============================================================================
+ */
+
+static bool emit_function(JitCompiler *c, size_t index) {
+    JitBuffer *b = &c->out;
+    const ByteCodeFunction *fn = &c->code->functions[index];
+    size_t begin = fn->entry;
+    size_t end = function_end(c->code, index);
+
+    size_t max_depth = 0;
+    if (!analyze_function(c, index, &max_depth)) return false;
+
+    c->function_offsets[index] = b->size;
+    size_t frame = (fn->local_count * 4 + 15) & ~(size_t)15;
+
+    EMIT(b, 0x55, 0x48, 0x89, 0xE5);                        /* push rbp; mov rbp, rsp */
+
+    /* lea rax, [rsp - frame - operands]; cmp rax, [r15 + stack_limit]; jb */
+    EMIT(b, 0x48, 0x8D, 0x84, 0x24);
+    emit_u32(b, (uint32_t)-(int32_t)(frame + 8 * max_depth));
+    EMIT(b, 0x49, 0x3B, 0x87);
+    emit_u32(b, (uint32_t)offsetof(JitRuntime, stack_limit));
+    EMIT(b, 0x0F, 0x82);
+    emit_rel32(b, c->stubs[JIT_STACK_OVERFLOW]);
+
+    if (frame > 0) {
+        EMIT(b, 0x48, 0x81, 0xEC);                          /* sub rsp, frame */
+        emit_u32(b, (uint32_t)frame);
+    }
+
+    /* Arguments sit above the return address, the last one nearest */
+    for (size_t i = 0; i < fn->param_count; i++) {
+        EMIT(b, 0x8B, 0x85);                                /* mov eax, [rbp + arg] */
+        emit_u32(b, (uint32_t)(16 + 8 * (fn->param_count - 1 - i)));
+        emit_slot(b, SLOT_STORE, i);
+    }
+    for (size_t i = fn->param_count; i < fn->local_count; i++) {
+        EMIT(b, 0xC7, 0x85);                                /* mov dword [slot], 0 */
+        emit_u32(b, slot_disp(i));
+        emit_u32(b, 0);
+    }
+
+    for (size_t i = begin; i < end;) {
+        c->offsets[i] = b->size;
+        if (c->depth[i] < 0) {
+            i++;                                            /* Unreachable */
+            continue;
+        }
+        size_t covered = emit_instruction(c, i, end);
+        for (size_t k = 1; k < covered; k++) {
+            c->offsets[i + k] = b->size;
+        }
+        i += covered;
+    }
+    return true;
+}
+
+/* Trampoline, its exit path and the runtime error stubs */
+static void emit_runtime(JitCompiler *c) {
+    JitBuffer *b = &c->out;
+
+    EMIT(b, 0x55, 0x48, 0x89, 0xE5,                         /* push rbp; mov rbp, rsp */
+         0x53, 0x41, 0x54, 0x41, 0x57,                      /* push rbx; push r12; push r15 */
+         0x49, 0x89, 0xFF,                                  /* mov r15, rdi */
+         0x41, 0xC7, 0x87);                                 /* mov dword [r15 + error], 0 */
+    emit_u32(b, (uint32_t)offsetof(JitRuntime, error));
+    emit_u32(b, JIT_OK);
+    EMIT(b, 0x49, 0x89, 0xA7);                              /* mov [r15 + saved_sp], rsp */
+    emit_u32(b, (uint32_t)offsetof(JitRuntime, saved_sp));
+    EMIT(b, 0x49, 0x8B, 0xA7);                              /* mov rsp, [r15 + stack_top] */
+    emit_u32(b, (uint32_t)offsetof(JitRuntime, stack_top));
+    EMIT(b, 0x49, 0x89, 0xCC,                               /* mov r12, rcx */
+         0x48, 0x85, 0xD2, 0x74, 0x0B,                      /* test rdx, rdx; jz +11 */
+         0xFF, 0x36,                                        /* push qword [rsi] */
+         0x48, 0x83, 0xC6, 0x08,                            /* add rsi, 8 */
+         0x48, 0xFF, 0xCA, 0x75, 0xF5,                      /* dec rdx; jnz -11 */
+         0x41, 0xFF, 0xD4);                                 /* call r12 */
+
+    c->exit_offset = b->size;
+    EMIT(b, 0x49, 0x8B, 0xA7);                              /* mov rsp, [r15 + saved_sp] */
+    emit_u32(b, (uint32_t)offsetof(JitRuntime, saved_sp));
+    EMIT(b, 0x41, 0x5F, 0x41, 0x5C, 0x5B, 0x5D, 0xC3);      /* pop r15; pop r12; pop rbx; pop rbp; ret */
+
+    for (int error = JIT_OK + 1; error < JIT_ERROR_COUNT; error++) {
+        c->stubs[error] = b->size;
+        EMIT(b, 0x41, 0xC7, 0x87);                          /* mov dword [r15 + error], error */
+        emit_u32(b, (uint32_t)offsetof(JitRuntime, error));
+        emit_u32(b, (uint32_t)error);
+        EMIT(b, 0x31, 0xC0, 0xE9);                          /* xor eax, eax; jmp exit */
+        emit_rel32(b, c->exit_offset);
+    }
+}
+
+/* int32_t main(void) that enters through the trampoline */
+static void emit_main_stub(JitCompiler *c, JitRuntime *runtime, size_t main_offset) {
+    JitBuffer *b = &c->out;
+
+    EMIT(b, 0x48, 0xBF);                                    /* mov rdi, runtime */
+    emit_u64(b, (uint64_t)(uintptr_t)runtime);
+    EMIT(b, 0x31, 0xF6, 0x31, 0xD2,                         /* xor esi, esi; xor edx, edx */
+         0x48, 0x8D, 0x0D);                                 /* lea rcx, [rip + main] */
+    emit_rel32(b, main_offset);
+    EMIT(b, 0xE9);                                          /* jmp trampoline */
+    emit_rel32(b, 0);
+}
+
+static bool apply_fixups(JitCompiler *c) {
+    for (size_t i = 0; i < c->fixup_count; i++) {
+        const JitFixup *fixup = &c->fixups[i];
+        size_t target = fixup->call ? c->function_offsets[fixup->target] : c->offsets[fixup->target];
+        encode_u32(c->out.data + fixup->pos, rel32(fixup->pos + 4, target));
+    }
+    return true;
+}
+
+static bool compile_module(JitCompiler *c, JitModule *jit) {
+    const ByteCode *code = c->code;
+
+    emit_runtime(c);
+    for (size_t i = 0; i < code->func_count; i++) {
+        if (!emit_function(c, i)) return false;
+    }
+
+    size_t main_index = bytecode_find_function(code, "main");
+    jit->main_offset = (size_t)-1;
+    if (main_index != (size_t)-1 && code->functions[main_index].param_count == 0) {
+        jit->main_offset = c->out.size;
+        emit_main_stub(c, &jit->runtime, c->function_offsets[main_index]);
+    }
+
+    if (c->out.failed) return fail(c, "out of memory");
+    return apply_fixups(c);
+}
+
+/* ==============================================================================
+ * Module
+ * ==============================================================================
+ */
+
+static bool install_code(JitModule *jit, const JitBuffer *buffer, char *error, size_t error_size) {
+    void *code = mmap(NULL, buffer->size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (code == MAP_FAILED) {
+        set_error(error, error_size, "cannot map code memory");
+        return false;
+    }
+
+    memcpy(code, buffer->data, buffer->size);
+    if (mprotect(code, buffer->size, PROT_READ | PROT_EXEC) != 0) {
+        munmap(code, buffer->size);
+        set_error(error, error_size, "cannot make code executable");
+        return false;
+    }
+
+    jit->code = code;
+    jit->code_size = buffer->size;
+    return true;
+}
+
+static bool allocate_stack(JitModule *jit, char *error, size_t error_size) {
+    void *stack = mmap(NULL, JIT_STACK_SIZE, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (stack == MAP_FAILED) {
+        set_error(error, error_size, "cannot map JIT stack");
+        return false;
+    }
+
+    jit->stack = stack;
+    jit->runtime.stack_top = (uintptr_t)stack + JIT_STACK_SIZE;
+    jit->runtime.stack_limit = (uintptr_t)stack + JIT_STACK_MARGIN;
+    return true;
+}
+
+static bool copy_functions(JitModule *jit, const ByteCode *code, const size_t *offsets) {
+    jit->functions = calloc(code->func_count ? code->func_count : 1, sizeof(JitFunction));
+    if (!jit->functions) return false;
+
+    for (size_t i = 0; i < code->func_count; i++) {
+        jit->functions[i].name = strdup(code->functions[i].name);
+        if (!jit->functions[i].name) return false;
+
+        jit->functions[i].param_count = code->functions[i].param_count;
+        jit->functions[i].offset = offsets[i];
+        jit->func_count = i + 1;
+    }
+    return true;
+}
+
+JitModule *jit_module_create(const ByteCode *code, char *error, size_t error_size) {
+    if (!code) {
+        set_error(error, error_size, "no bytecode");
+        return NULL;
+    }
+
+    JitModule *jit = calloc(1, sizeof(JitModule));
+    if (!jit) {
+        set_error(error, error_size, "out of memory");
+        return NULL;
+    }
+    jit->runtime.print = default_print;
+
+    JitCompiler c = {
+        .code = code,
+        .depth = malloc((code->count + 1) * sizeof(int)),
+        .is_target = calloc(code->count + 1, sizeof(bool)),
+        .offsets = calloc(code->count + 1, sizeof(size_t)),
+        .function_offsets = calloc(code->func_count + 1, sizeof(size_t)),
+        .error = error,
+        .error_size = error_size
+    };
+
+    bool ok = c.depth && c.is_target && c.offsets && c.function_offsets;
+    if (!ok) {
+        set_error(error, error_size, "out of memory");
+    } else {
+        for (size_t i = 0; i <= code->count; i++) {
+            c.depth[i] = -1;
+        }
+        ok = compile_module(&c, jit) &&
+             install_code(jit, &c.out, error, error_size) &&
+             allocate_stack(jit, error, error_size);
+        if (ok && !copy_functions(jit, code, c.function_offsets)) {
+            set_error(error, error_size, "out of memory");
+            ok = false;
+        }
+    }
+
+    free(c.out.data);
+    free(c.depth);
+    free(c.is_target);
+    free(c.offsets);
+    free(c.function_offsets);
+    free(c.fixups);
+
+    if (!ok) {
+        jit_module_destroy(jit);
+        return NULL;
+    }
+    return jit;
+}
+
+void jit_module_destroy(JitModule *jit) {
+    if (!jit) return;
+
+    if (jit->code) munmap(jit->code, jit->code_size);
+    if (jit->stack) munmap(jit->stack, JIT_STACK_SIZE);
+    for (size_t i = 0; i < jit->func_count; i++) {
+        free(jit->functions[i].name);
+    }
+    free(jit->functions);
+    free(jit);
+}
+
+bool jit_module_run(JitModule *jit, const char *function,
+                    const int32_t *args, size_t arg_count, int32_t *result,
+                    char *error, size_t error_size) {
+    if (!jit || !function) {
+        set_error(error, error_size, "no JIT module");
+        return false;
+    }
+
+    const JitFunction *fn = NULL;
+    for (size_t i = 0; i < jit->func_count && !fn; i++) {
+        if (strcmp(jit->functions[i].name, function) == 0) fn = &jit->functions[i];
+    }
+    if (!fn) {
+        set_error(error, error_size, "no function %s", function);
+        return false;
+    }
+    if (fn->param_count != arg_count) {
+        set_error(error, error_size, "%s takes %zu argument(s), got %zu", function,
+                  fn->param_count, arg_count);
+        return false;
+    }
+
+    int64_t *stack_args = NULL;
+    if (arg_count > 0) {
+        stack_args = malloc(arg_count * sizeof(int64_t));
+        if (!stack_args) {
+            set_error(error, error_size, "out of memory");
+            return false;
+        }
+        for (size_t i = 0; i < arg_count; i++) {
+            stack_args[i] = args[i];
+        }
+    }
+
+    /* ISO C has no object-to-function pointer conversion */
+    JitEnter enter;
+    void *entry = jit->code;
+    memcpy(&enter, &entry, sizeof(enter));
+
+    int32_t value = enter(&jit->runtime, stack_args, arg_count, jit->code + fn->offset);
+    free(stack_args);
+
+    if (jit->runtime.error != JIT_OK) {
+        set_error(error, error_size, "%s", jit_module_error(jit));
+        return false;
+    }
+    if (result) *result = value;
+    return true;
+}
+
+JitMainFunction jit_module_main(const JitModule *jit) {
+    if (!jit || jit->main_offset == (size_t)-1) return NULL;
+
+    JitMainFunction main_function;
+    void *entry = jit->code + jit->main_offset;
+    memcpy(&main_function, &entry, sizeof(main_function));
+    return main_function;
+}
+
+#else /* !JIT_SUPPORTED */
+
+JitModule *jit_module_create(const ByteCode *code, char *error, size_t error_size) {
+    (void)code;
+    set_error(error, error_size, "the JIT needs an x86-64 POSIX host");
+    return NULL;
+}
+
+void jit_module_destroy(JitModule *jit) {
+    free(jit);
+}
+
+bool jit_module_run(JitModule *jit, const char *function,
+                    const int32_t *args, size_t arg_count, int32_t *result,
+                    char *error, size_t error_size) {
+    (void)jit; (void)function; (void)args; (void)arg_count; (void)result;
+    set_error(error, error_size, "the JIT needs an x86-64 POSIX host");
+    return false;
+}
+
+JitMainFunction jit_module_main(const JitModule *jit) {
+    (void)jit;
+    return NULL;
+}
+
+#endif /* JIT_SUPPORTED */
+
+void jit_module_set_print(JitModule *jit, ByteCodePrintFunction print, void *user_data) {
+    if (!jit) return;
+    jit->runtime.print = print ? print : default_print;
+    jit->runtime.print_data = user_data;
+}
+
+const char *jit_module_error(const JitModule *jit) {
+    if (!jit || jit->runtime.error <= JIT_OK || jit->runtime.error >= JIT_ERROR_COUNT) return NULL;
+    return jit_error_messages[jit->runtime.error];
+}
+
+/* ==============================================================================
+ * Event
+ * ==============================================================================
+ */
+
+EventResult compiler_jit_event(EventContext *context, void *user_data) {
+    (void)user_data;
+
+    EventResult result;
+
+    ByteCode *code;
+    EventChainErrorCode err = event_context_get(context, "bytecode", (void **)&code);
+
+    if (err != EC_SUCCESS || !code) {
+        event_result_failure(&result, "No bytecode provided to JIT",
+                             EC_ERROR_INVALID_PARAMETER, ERROR_DETAIL_FULL);
+        return result;
+    }
+
+    char error[256];
+    JitModule *jit = jit_module_create(code, error, sizeof(error));
+    if (!jit) {
+        event_result_failure(&result, error, EC_ERROR_EVENT_EXECUTION_FAILED, ERROR_DETAIL_FULL);
+        return result;
+    }
+
+    err = event_context_set_with_cleanup(context, "jit", jit,
+                                         (ValueCleanupFunc)jit_module_destroy);
+    if (err != EC_SUCCESS) {
+        jit_module_destroy(jit);
+        event_result_failure(&result, "Failed to store JIT module in context",
+                             err, ERROR_DETAIL_FULL);
+        return result;
+    }
+
+    event_result_success(&result);
+    return result;
+}
@@ -0,0 +1,435 @@
+/**
+ * ==============================================================================
+ * TinyLLVM Compiler - Constant & Copy Propagation
+ * ==============================================================================
+ *
+ * Forward dataflow over the structured statements of each function. Every
+ * variable binding (parameter or declaration) carries the value reaching
+ * the current point:
+ *
+ *   - a constant, after `x = 5;` or an initializer that folds to one
+ *   - a copy of another binding, after `x = y;`
+ *   - unknown otherwise
+ *
+ * Uses of constants are replaced by literals and uses of copies by the
+ * original variable, then the expression is folded so the next definition
+ * can become a constant too:
+ *
+ *   var x = 5;                     var x = 5;
+ *   var y = x * 2;          =>     var y = 10;
+ *   print(y + 1);                  print(11);
+ *
+ * Joins are conservative: after an if, a binding keeps its value only when
+ * both branches agree (a branch that always returns does not take part), and
+ * every binding assigned anywhere in a while loop is unknown at the loop
+ * head. A copy is only substituted while its source name still resolves to
+ * the same binding, so shadowing declarations cannot capture it.
+ */
+
+#include "include/tinyllvm_optimizer.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* ==============================================================================
+ * Lattice
+ * ==============================================================================
+ */
+
+typedef enum {
+    VALUE_UNKNOWN,
+    VALUE_INT,
+    VALUE_BOOL,
+    VALUE_COPY
+} ValueKind;
+
+typedef struct {
+    ValueKind kind;
+    int int_value;
+    bool bool_value;
+    size_t source;              /* VALUE_COPY: index of the copied binding */
+} Value;
+
+typedef struct {
+    const char *name;           /* Borrowed from the AST */
+    Type type;
+    Value value;
+} Binding;
+
+typedef struct {
+    Binding *bindings;          /* Innermost binding of a name is the last one */
+    size_t count;
+    size_t capacity;
+} Env;
+
+typedef struct {
+    OptimizationStats *stats;
+    size_t constants;
+    size_t copies;
+    const char *declaring;      /* Variable whose initializer is being rewritten */
+    bool checked;               /* Fold with config->overflow_checks semantics */
+    bool failed;
+} Propagator;
+
+static const Value unknown_value = { VALUE_UNKNOWN, 0, false, 0 };
+
+static bool value_equal(const Value *a, const Value *b) {
+    if (a->kind != b->kind) return false;
+
+    switch (a->kind) {
+        case VALUE_INT:  return a->int_value == b->int_value;
+        case VALUE_BOOL: return a->bool_value == b->bool_value;
+        case VALUE_COPY: return a->source == b->source;
+        default:         return true;
+    }
+}
+
+/* ==============================================================================
+ * Environment
+ * ==============================================================================
+ */
+
+static bool env_push(Env *env, const char *name, Type type, Value value) {
+    if (env->count == env->capacity) {
+        size_t capacity = env->capacity ? env->capacity * 2 : 16;
+        Binding *bindings = realloc(env->bindings, capacity * sizeof(Binding));
+        if (!bindings) return false;
+        env->bindings = bindings;
+        env->capacity = capacity;
+    }
+
+    env->bindings[env->count].name = name;
+    env->bindings[env->count].type = type;
+    env->bindings[env->count].value = value;
+    env->count++;
+    return true;
+}
+
+static size_t env_lookup(const Env *env, const char *name) {
+    for (size_t i = env->count; i > 0; i--) {
+        if (strcmp(env->bindings[i - 1].name, name) == 0) return i - 1;
+    }
+    return OPT_NOT_FOUND;
+}
+
+static bool env_copy(Env *dst, const Env *src) {
+    dst->bindings = malloc((src->capacity ? src->capacity : 1) * sizeof(Binding));
+    if (!dst->bindings) return false;
+
+    if (src->count > 0) memcpy(dst->bindings, src->bindings, src->count * sizeof(Binding));
+    dst->count = src->count;
+    dst->capacity = src->capacity ? src->capacity : 1;
+    return true;
+}
+
+/* The binding changes: it becomes unknown, as do copies of it */
+static void env_kill(Env *env, size_t index) {
+    env->bindings[index].value = unknown_value;
+    for (size_t i = 0; i < env->count; i++) {
+        if (env->bindings[i].value.kind == VALUE_COPY && env->bindings[i].value.source == index) {
+            env->bindings[i].value = unknown_value;
+        }
+    }
+}
+
+/* Leave a scope; copies of its bindings cannot outlive it */
+static void env_pop_to(Env *env, size_t count) {
+    env->count = count;
+    for (size_t i = 0; i < count; i++) {
+        if (env->bindings[i].value.kind == VALUE_COPY && env->bindings[i].value.source >= count) {
+            env->bindings[i].value = unknown_value;
+        }
+    }
+}
+
+/* Keep only the values both environments agree on (same bindings assumed) */
+static void env_meet(Env *env, const Env *other) {
+    for (size_t i = 0; i < env->count && i < other->count; i++) {
+        if (!value_equal(&env->bindings[i].value, &other->bindings[i].value)) {
+            env->bindings[i].value = unknown_value;
+        }
+    }
+}
+
+/* Kill every visible binding the statement assigns */
+static void env_kill_assigned(Env *env, const ASTStmt *stmt) {
+    if (!stmt) return;
+
+    switch (stmt->kind) {
+        case STMT_ASSIGN: {
+            size_t index = env_lookup(env, stmt->data.assign.name);
+            if (index != OPT_NOT_FOUND) env_kill(env, index);
+            break;
+        }
+        case STMT_IF:
+            env_kill_assigned(env, stmt->data.if_stmt.then_block);
+            env_kill_assigned(env, stmt->data.if_stmt.else_block);
+            break;
+        case STMT_WHILE:
+            env_kill_assigned(env, stmt->data.while_stmt.body);
+            break;
+        case STMT_BLOCK:
+            for (size_t i = 0; i < stmt->data.block.stmt_count; i++) {
+                env_kill_assigned(env, stmt->data.block.statements[i]);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/* ==============================================================================
+ * Substitution
+ * ==============================================================================
+ */
+
+static void substitute(Propagator *p, const Env *env, ASTExpr **slot) {
+    ASTExpr *expr = *slot;
+    if (!expr || p->failed) return;
+
+    if (ast_expr_is_binary(expr->kind)) {
+        substitute(p, env, &expr->data.binary.left);
+        substitute(p, env, &expr->data.binary.right);
+        return;
+    }
+    if (expr->kind == EXPR_NOT) {
+        substitute(p, env, &expr->data.unary.operand);
+        return;
+    }
+    if (expr->kind == EXPR_CALL) {
+        for (size_t i = 0; i < expr->data.call.arg_count; i++) {
+            substitute(p, env, &expr->data.call.args[i]);
+        }
+        return;
+    }
+    if (expr->kind != EXPR_VAR) return;
+
+    size_t index = env_lookup(env, expr->data.var.name);
+    if (index == OPT_NOT_FOUND) return;
+
+    const Binding *binding = &env->bindings[index];
+    ASTExpr *replacement = NULL;
+
+    switch (binding->value.kind) {
+        case VALUE_INT:
+            replacement = ast_expr_int_literal(binding->value.int_value);
+            p->constants++;
+            break;
+        case VALUE_BOOL:
+            replacement = ast_expr_bool_literal(binding->value.bool_value);
+            p->constants++;
+            break;
+        case VALUE_COPY: {
+            const Binding *source = &env->bindings[binding->value.source];
+            if (env_lookup(env, source->name) != binding->value.source) return;
+            /* In `var x = a;` with a a copy of an outer x, the new x is
+             * already in scope in its own initializer */
+            if (p->declaring && strcmp(source->name, p->declaring) == 0) return;
+            replacement = opt_make_var(source->name, source->type);
+            p->copies++;
+            break;
+        }
+        default:
+            return;
+    }
+
+    if (!replacement) {
+        p->failed = true;
+        return;
+    }
+    ast_expr_destroy(expr);
+    *slot = replacement;
+}
+
+/* Substitute and fold an expression in place */
+static void rewrite(Propagator *p, const Env *env, ASTExpr **slot) {
+    substitute(p, env, slot);
+    size_t folded = opt_fold_expr(slot, p->checked);
+    if (p->stats) p->stats->expressions_folded += folded;
+}
+
+/* The value a definition gives its binding */
+static Value value_of(const Env *env, const ASTExpr *expr, size_t target) {
+    Value value = unknown_value;
+
+    switch (expr->kind) {
+        case EXPR_INT_LITERAL:
+            value.kind = VALUE_INT;
+            value.int_value = expr->data.int_lit.value;
+            break;
+        case EXPR_BOOL_LITERAL:
+            value.kind = VALUE_BOOL;
+            value.bool_value = expr->data.bool_lit.value;
+            break;
+        case EXPR_VAR: {
+            size_t source = env_lookup(env, expr->data.var.name);
+            if (source != OPT_NOT_FOUND && source != target) {
+                value.kind = VALUE_COPY;
+                value.source = source;
+            }
+            break;
+        }
+        default:
+            break;
+    }
+    return value;
+}
+
+/* ==============================================================================
+ * Statements
+ * ==============================================================================
+ */
+
+static bool propagate_stmt(Propagator *p, Env *env, ASTStmt *stmt);
+
+/* Process a block in its own scope; returns false when it cannot fall through */
+static bool propagate_block(Propagator *p, Env *env, ASTStmt *block) {
+    size_t scope = env->count;
+    bool reachable = true;
+
+    for (size_t i = 0; i < block->data.block.stmt_count && !p->failed; i++) {
+        if (!propagate_stmt(p, env, block->data.block.statements[i])) {
+            reachable = false;      /* The rest is dead; leave it to DCE */
+            break;
+        }
+    }
+
+    env_pop_to(env, scope);
+    return reachable;
+}
+
+static bool propagate_if(Propagator *p, Env *env, ASTStmt *stmt) {
+    rewrite(p, env, &stmt->data.if_stmt.condition);
+    const ASTExpr *cond = stmt->data.if_stmt.condition;
+
+    /* A literal condition selects one branch; the other is dead */
+    if (cond->kind == EXPR_BOOL_LITERAL) {
+        ASTStmt *taken = cond->data.bool_lit.value ? stmt->data.if_stmt.then_block :
+                                                      stmt->data.if_stmt.else_block;
+        return taken ? propagate_block(p, env, taken) : true;
+    }
+
+    Env other;
+    if (!env_copy(&other, env)) {
+        p->failed = true;
+        return true;
+    }
+
+    bool then_live = propagate_block(p, env, stmt->data.if_stmt.then_block);
+    bool else_live = stmt->data.if_stmt.else_block ?
+                     propagate_block(p, &other, stmt->data.if_stmt.else_block) : true;
+
+    if (then_live && else_live) {
+        env_meet(env, &other);
+    } else if (else_live && other.count > 0) {
+        memcpy(env->bindings, other.bindings, other.count * sizeof(Binding));
+    }
+
+    free(other.bindings);
+    return then_live || else_live;
+}
+
+static bool propagate_while(Propagator *p, Env *env, ASTStmt *stmt) {
+    /* Values assigned in the loop may come from any iteration */
+    env_kill_assigned(env, stmt->data.while_stmt.body);
+
+    rewrite(p, env, &stmt->data.while_stmt.condition);
+    const ASTExpr *cond = stmt->data.while_stmt.condition;
+    if (cond->kind == EXPR_BOOL_LITERAL && !cond->data.bool_lit.value) return true;
+
+    Env body;
+    if (!env_copy(&body, env)) {
+        p->failed = true;
+        return true;
+    }
+    propagate_block(p, &body, stmt->data.while_stmt.body);
+    free(body.bindings);
+
+    /* Without break, `while (true)` is only left through a return */
+    return !(cond->kind == EXPR_BOOL_LITERAL && cond->data.bool_lit.value);
+}
+
+static bool propagate_stmt(Propagator *p, Env *env, ASTStmt *stmt) {
+    switch (stmt->kind) {
+        case STMT_VAR_DECL: {
+            p->declaring = stmt->data.var_decl.name;
+            rewrite(p, env, &stmt->data.var_decl.init_expr);
+            p->declaring = NULL;
+            Value value = value_of(env, stmt->data.var_decl.init_expr, OPT_NOT_FOUND);
+            if (!env_push(env, stmt->data.var_decl.name, stmt->data.var_decl.type, value)) {
+                p->failed = true;
+            }
+            return true;
+        }
+
+        case STMT_ASSIGN: {
+            rewrite(p, env, &stmt->data.assign.expr);
+            size_t index = env_lookup(env, stmt->data.assign.name);
+            if (index != OPT_NOT_FOUND) {
+                Value value = value_of(env, stmt->data.assign.expr, index);
+                env_kill(env, index);
+                env->bindings[index].value = value;
+            }
+            return true;
+        }
+
+        case STMT_IF:
+            return propagate_if(p, env, stmt);
+
+        case STMT_WHILE:
+            return propagate_while(p, env, stmt);
+
+        case STMT_RETURN:
+            rewrite(p, env, &stmt->data.return_stmt.expr);
+            return false;
+
+        case STMT_EXPR:
+            rewrite(p, env, &stmt->data.expr_stmt.expr);
+            return true;
+
+        case STMT_BLOCK:
+            return propagate_block(p, env, stmt);
+    }
+    return true;
+}
+
+/* ==============================================================================
+ * Pass Driver
+ * ==============================================================================
+ */
+
+void optimize_constant_propagation(ASTProgram *program, const CompilerConfig *config,
+                                   OptimizationStats *stats) {
+    if (!program) return;
+
+    bool checked = config && config->overflow_checks;
+
+    for (size_t f = 0; f < program->func_count; f++) {
+        ASTFunc *func = program->functions[f];
+        Propagator p = {
+            .stats = stats, .constants = 0, .copies = 0, .declaring = NULL,
+            .checked = checked, .failed = false
+        };
+        Env env = {0};
+
+        for (size_t i = 0; i < func->param_count && !p.failed; i++) {
+            if (!env_push(&env, func->params[i].name, func->params[i].type, unknown_value)) {
+                p.failed = true;
+            }
+        }
+        if (!p.failed) {
+            propagate_block(&p, &env, func->body);
+        }
+        free(env.bindings);
+
+        if (stats) {
+            stats->constants_propagated += p.constants;
+            stats->copies_propagated += p.copies;
+            if (p.constants + p.copies > 0) {
+                optimization_stats_remark(stats, "propagated %zu constant%s and %zu cop%s in '%s'",
+                                          p.constants, p.constants == 1 ? "" : "s",
+                                          p.copies, p.copies == 1 ? "y" : "ies", func->name);
+            }
+        }
+        if (p.failed) break;
+    }
+}
@@ -0,0 +1,63 @@
+/**
+ * ==============================================================================
+ * TinyLLVM Compiler - Dead Function Elimination
+ * ==============================================================================
+ *
+ * Removes every function that cannot be reached from main() through the
+ * call graph, so the code generators neither declare nor emit them.
+ * Programs without a main() are left untouched: all of their functions
+ * are entry points.
+ */
+
+#include "include/tinyllvm_optimizer.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define ENTRY_POINT "main"
+
+static void mark_reachable(const OptCallGraph *graph, size_t func, bool *reachable) {
+    if (reachable[func]) return;
+    reachable[func] = true;
+
+    for (size_t i = 0; i < graph->callee_counts[func]; i++) {
+        mark_reachable(graph, graph->callees[func][i], reachable);
+    }
+}
+
+void optimize_dead_functions(ASTProgram *program, OptimizationStats *stats) {
+    if (!program) return;
+
+    size_t entry = opt_find_function(program, ENTRY_POINT);
+    if (entry == OPT_NOT_FOUND) return;
+
+    OptCallGraph graph;
+    if (!opt_call_graph_build(&graph, program)) return;
+
+    bool *reachable = calloc(program->func_count, sizeof(bool));
+    if (!reachable) {
+        opt_call_graph_free(&graph);
+        return;
+    }
+    mark_reachable(&graph, entry, reachable);
+
+    /* Compact the function list in place, keeping source order */
+    size_t kept = 0;
+    for (size_t i = 0; i < program->func_count; i++) {
+        ASTFunc *func = program->functions[i];
+
+        if (reachable[i]) {
+            program->functions[kept++] = func;
+            continue;
+        }
+
+        if (stats) {
+            stats->functions_removed++;
+            optimization_stats_remark(stats, "removed unreachable function '%s'", func->name);
+        }
+        ast_func_destroy(func);
+    }
+    program->func_count = kept;
+
+    free(reachable);
+    opt_call_graph_free(&graph);
+}
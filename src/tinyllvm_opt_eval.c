@@ -0,0 +1,389 @@
+/**
+ * ==============================================================================
+ * TinyLLVM Compiler - Compile-Time Evaluation of Pure Calls
+ * ==============================================================================
+ *
+ * Calls to pure functions (no print reachable) whose arguments are all
+ * literals are run by a small AST interpreter and replaced by the result:
+ *
+ *   var fact = factorial(5);    =>    var fact = 120;
+ *
+ * The interpreter uses the backends' 32-bit wrapping semantics (shared with
+ * constant folding) and gives up, leaving the call in place, when the
+ * callee would trap (division by zero, INT_MIN / -1), falls off its end,
+ * runs longer than OPT_EVAL_FUEL steps or recurses deeper than
+ * OPT_EVAL_MAX_DEPTH calls.
+ */
+
+#include "include/tinyllvm_optimizer.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* ==============================================================================
+ * Interpreter
+ * ==============================================================================
+ */
+
+typedef enum {
+    EVAL_NEXT,      /* Statement completed normally */
+    EVAL_RETURN,    /* A return statement executed */
+    EVAL_ABORT      /* Trap, fuel exhausted or unsupported construct */
+} EvalStatus;
+
+typedef struct {
+    const char *name;
+    int32_t value;          /* Booleans are 0 or 1 */
+} EvalBinding;
+
+typedef struct {
+    const ASTProgram *program;
+    EvalBinding *bindings;  /* Variables of all active frames */
+    size_t count;
+    size_t capacity;
+    size_t frame_base;      /* First binding of the innermost call */
+    size_t fuel;
+    size_t depth;
+    bool checked;           /* Overflow traps, as under config->overflow_checks */
+    int32_t return_value;
+} Evaluator;
+
+static bool eval_tick(Evaluator *ev) {
+    if (ev->fuel == 0) return false;
+    ev->fuel--;
+    return true;
+}
+
+static bool eval_bind(Evaluator *ev, const char *name, int32_t value) {
+    if (ev->count == ev->capacity) {
+        size_t capacity = ev->capacity ? ev->capacity * 2 : 32;
+        EvalBinding *bindings = realloc(ev->bindings, capacity * sizeof(EvalBinding));
+        if (!bindings) return false;
+        ev->bindings = bindings;
+        ev->capacity = capacity;
+    }
+    ev->bindings[ev->count].name = name;
+    ev->bindings[ev->count].value = value;
+    ev->count++;
+    return true;
+}
+
+static EvalBinding *eval_lookup(Evaluator *ev, const char *name) {
+    for (size_t i = ev->count; i > ev->frame_base; i--) {
+        if (strcmp(ev->bindings[i - 1].name, name) == 0) return &ev->bindings[i - 1];
+    }
+    return NULL;
+}
+
+static bool eval_expr(Evaluator *ev, const ASTExpr *expr, int32_t *out);
+static EvalStatus eval_stmt(Evaluator *ev, const ASTStmt *stmt);
+
+static bool eval_call(Evaluator *ev, const ASTExpr *expr, int32_t *out) {
+    size_t index = opt_find_function(ev->program, expr->data.call.func_name);
+    if (index == OPT_NOT_FOUND || ev->depth >= OPT_EVAL_MAX_DEPTH) return false;
+
+    const ASTFunc *func = ev->program->functions[index];
+    if (func->param_count != expr->data.call.arg_count) return false;
+
+    /* Arguments are all evaluated in the caller's frame before any
+     * parameter is bound, so later ones cannot see earlier parameters */
+    int32_t *args = NULL;
+    if (func->param_count > 0) {
+        args = malloc(func->param_count * sizeof(int32_t));
+        if (!args) return false;
+    }
+    for (size_t i = 0; i < func->param_count; i++) {
+        if (!eval_expr(ev, expr->data.call.args[i], &args[i])) {
+            free(args);
+            return false;
+        }
+    }
+
+    size_t saved_count = ev->count;
+    for (size_t i = 0; i < func->param_count; i++) {
+        if (!eval_bind(ev, func->params[i].name, args[i])) {
+            free(args);
+            ev->count = saved_count;
+            return false;
+        }
+    }
+    free(args);
+
+    size_t saved_base = ev->frame_base;
+    ev->frame_base = saved_count;
+    ev->depth++;
+
+    EvalStatus status = eval_stmt(ev, func->body);
+
+    ev->depth--;
+    ev->frame_base = saved_base;
+    ev->count = saved_count;
+
+    if (status != EVAL_RETURN) return false;
+    *out = ev->return_value;
+    return true;
+}
+
+static bool eval_expr(Evaluator *ev, const ASTExpr *expr, int32_t *out) {
+    if (!expr || !eval_tick(ev)) return false;
+
+    switch (expr->kind) {
+        case EXPR_INT_LITERAL:
+            *out = expr->data.int_lit.value;
+            return true;
+
+        case EXPR_BOOL_LITERAL:
+            *out = expr->data.bool_lit.value ? 1 : 0;
+            return true;
+
+        case EXPR_VAR: {
+            EvalBinding *binding = eval_lookup(ev, expr->data.var.name);
+            if (!binding) return false;
+            *out = binding->value;
+            return true;
+        }
+
+        case EXPR_NOT: {
+            int32_t value;
+            if (!eval_expr(ev, expr->data.unary.operand, &value)) return false;
+            *out = !value;
+            return true;
+        }
+
+        case EXPR_AND:
+        case EXPR_OR: {
+            /* Short-circuit like the generated code, so guarded traps stay guarded */
+            int32_t left;
+            if (!eval_expr(ev, expr->data.binary.left, &left)) return false;
+            if ((expr->kind == EXPR_AND) != (left != 0)) {
+                *out = left != 0;
+                return true;
+            }
+            int32_t right;
+            if (!eval_expr(ev, expr->data.binary.right, &right)) return false;
+            *out = right != 0;
+            return true;
+        }
+
+        case EXPR_CALL:
+            return eval_call(ev, expr, out);
+
+        default:
+            break;
+    }
+
+    if (!ast_expr_is_binary(expr->kind)) return false;
+
+    int32_t left, right;
+    if (!eval_expr(ev, expr->data.binary.left, &left) ||
+        !eval_expr(ev, expr->data.binary.right, &right)) {
+        return false;
+    }
+
+    if (expr->kind >= EXPR_EQ && expr->kind <= EXPR_GE) {
+        *out = opt_evaluate_comparison(expr->kind, left, right) ? 1 : 0;
+        return true;
+    }
+    if (ev->checked) return opt_evaluate_int_checked(expr->kind, left, right, out);
+    return opt_evaluate_int(expr->kind, left, right, out);
+}
+
+static EvalStatus eval_block(Evaluator *ev, const ASTStmt *block) {
+    size_t saved_count = ev->count;
+    EvalStatus status = EVAL_NEXT;
+
+    for (size_t i = 0; i < block->data.block.stmt_count && status == EVAL_NEXT; i++) {
+        status = eval_stmt(ev, block->data.block.statements[i]);
+    }
+
+    ev->count = saved_count;
+    return status;
+}
+
+static EvalStatus eval_stmt(Evaluator *ev, const ASTStmt *stmt) {
+    if (!stmt) return EVAL_NEXT;
+    if (!eval_tick(ev)) return EVAL_ABORT;
+
+    int32_t value;
+
+    switch (stmt->kind) {
+        case STMT_VAR_DECL:
+            if (!eval_expr(ev, stmt->data.var_decl.init_expr, &value) ||
+                !eval_bind(ev, stmt->data.var_decl.name, value)) {
+                return EVAL_ABORT;
+            }
+            return EVAL_NEXT;
+
+        case STMT_ASSIGN: {
+            if (!eval_expr(ev, stmt->data.assign.expr, &value)) return EVAL_ABORT;
+            EvalBinding *binding = eval_lookup(ev, stmt->data.assign.name);
+            if (!binding) return EVAL_ABORT;
+            binding->value = value;
+            return EVAL_NEXT;
+        }
+
+        case STMT_IF:
+            if (!eval_expr(ev, stmt->data.if_stmt.condition, &value)) return EVAL_ABORT;
+            return eval_stmt(ev, value ? stmt->data.if_stmt.then_block :
+                                         stmt->data.if_stmt.else_block);
+
+        case STMT_WHILE:
+            for (;;) {
+                if (!eval_expr(ev, stmt->data.while_stmt.condition, &value)) return EVAL_ABORT;
+                if (!value) return EVAL_NEXT;
+
+                EvalStatus status = eval_stmt(ev, stmt->data.while_stmt.body);
+                if (status != EVAL_NEXT) return status;
+            }
+
+        case STMT_RETURN:
+            if (!eval_expr(ev, stmt->data.return_stmt.expr, &ev->return_value)) {
+                return EVAL_ABORT;
+            }
+            return EVAL_RETURN;
+
+        case STMT_EXPR:
+            return eval_expr(ev, stmt->data.expr_stmt.expr, &value) ? EVAL_NEXT : EVAL_ABORT;
+
+        case STMT_BLOCK:
+            return eval_block(ev, stmt);
+    }
+    return EVAL_ABORT;
+}
+
+/* ==============================================================================
+ * Call Site Rewriting
+ * ==============================================================================
+ */
+
+typedef struct {
+    ASTProgram *program;
+    const OptCallGraph *graph;
+    const ASTFunc *caller;
+    Evaluator evaluator;
+    OptimizationStats *stats;
+} EvalPass;
+
+static bool args_are_literals(const ASTExpr *call) {
+    for (size_t i = 0; i < call->data.call.arg_count; i++) {
+        ExprKind kind = call->data.call.args[i]->kind;
+        if (kind != EXPR_INT_LITERAL && kind != EXPR_BOOL_LITERAL) return false;
+    }
+    return true;
+}
+
+static void try_evaluate_call(EvalPass *pass, ASTExpr **slot) {
+    ASTExpr *call = *slot;
+    size_t index = opt_find_function(pass->program, call->data.call.func_name);
+    if (index == OPT_NOT_FOUND || !pass->graph->pure[index]) return;
+    if (!args_are_literals(call)) return;
+
+    Evaluator *ev = &pass->evaluator;
+    ev->count = 0;
+    ev->frame_base = 0;
+    ev->depth = 0;
+    ev->fuel = OPT_EVAL_FUEL;
+
+    int32_t value;
+    if (!eval_call(ev, call, &value)) return;
+
+    Type type = pass->program->functions[index]->return_type;
+    ASTExpr *literal = type.kind == TYPE_BOOL ? ast_expr_bool_literal(value != 0) :
+                                                ast_expr_int_literal(value);
+    if (!literal) return;
+
+    if (pass->stats) {
+        char text[64];
+        opt_expr_format(call, text, sizeof(text));
+        pass->stats->calls_evaluated++;
+        optimization_stats_remark(pass->stats, "evaluated '%s' at compile time in '%s'",
+                                  text, pass->caller->name);
+    }
+
+    ast_expr_destroy(call);
+    *slot = literal;
+}
+
+/* Post-order, so nested calls with constant arguments are evaluated first */
+static void eval_pass_expr(EvalPass *pass, ASTExpr **slot) {
+    ASTExpr *expr = *slot;
+    if (!expr) return;
+
+    if (ast_expr_is_binary(expr->kind)) {
+        eval_pass_expr(pass, &expr->data.binary.left);
+        eval_pass_expr(pass, &expr->data.binary.right);
+        return;
+    }
+
+    switch (expr->kind) {
+        case EXPR_NOT:
+            eval_pass_expr(pass, &expr->data.unary.operand);
+            return;
+
+        case EXPR_CALL:
+            for (size_t i = 0; i < expr->data.call.arg_count; i++) {
+                eval_pass_expr(pass, &expr->data.call.args[i]);
+            }
+            try_evaluate_call(pass, slot);
+            return;
+
+        default:
+            return;
+    }
+}
+
+static void eval_pass_stmt(EvalPass *pass, ASTStmt *stmt) {
+    if (!stmt) return;
+
+    switch (stmt->kind) {
+        case STMT_VAR_DECL:
+            eval_pass_expr(pass, &stmt->data.var_decl.init_expr);
+            return;
+        case STMT_ASSIGN:
+            eval_pass_expr(pass, &stmt->data.assign.expr);
+            return;
+        case STMT_IF:
+            eval_pass_expr(pass, &stmt->data.if_stmt.condition);
+            eval_pass_stmt(pass, stmt->data.if_stmt.then_block);
+            eval_pass_stmt(pass, stmt->data.if_stmt.else_block);
+            return;
+        case STMT_WHILE:
+            eval_pass_expr(pass, &stmt->data.while_stmt.condition);
+            eval_pass_stmt(pass, stmt->data.while_stmt.body);
+            return;
+        case STMT_RETURN:
+            eval_pass_expr(pass, &stmt->data.return_stmt.expr);
+            return;
+        case STMT_EXPR:
+            eval_pass_expr(pass, &stmt->data.expr_stmt.expr);
+            return;
+        case STMT_BLOCK:
+            for (size_t i = 0; i < stmt->data.block.stmt_count; i++) {
+                eval_pass_stmt(pass, stmt->data.block.statements[i]);
+            }
+            return;
+    }
+}
+
+void optimize_compile_time_calls(ASTProgram *program, const CompilerConfig *config,
+                                 OptimizationStats *stats) {
+    if (!program) return;
+
+    OptCallGraph graph;
+    if (!opt_call_graph_build(&graph, program)) return;
+
+    EvalPass pass = {
+        .program = program,
+        .graph = &graph,
+        .caller = NULL,
+        .evaluator = { .program = program, .checked = config && config->overflow_checks },
+        .stats = stats
+    };
+
+    for (size_t i = 0; i < program->func_count; i++) {
+        pass.caller = program->functions[i];
+        eval_pass_stmt(&pass, program->functions[i]->body);
+    }
+
+    free(pass.evaluator.bindings);
+    opt_call_graph_free(&graph);
+}
@@ -0,0 +1,615 @@
+/**
+ * ==============================================================================
+ * TinyLLVM Compiler - Constant Folding & Dead Code Elimination
+ * ==============================================================================
+ *
+ * Folding evaluates operators whose operands are literals with 32-bit
+ * wrapping arithmetic and applies algebraic identities (x + 0, x * 1,
+ * true && e, !!e, ...). Division and modulo by zero and INT_MIN / -1 are
+ * left in place so they still trap at run time.
+ *
+ * Dead code elimination removes:
+ *   - branches of `if` statements with a literal condition and loops whose
+ *     condition is literally false
+ *   - statements after a statement that always returns
+ *   - expression statements and empty `if`s without side effects
+ *   - stores to variables that are never read, when every store to the
+ *     variable is free of side effects
+ */
+
+#include "include/tinyllvm_optimizer.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+/* ==============================================================================
+ * Constant Folding
+ * ==============================================================================
+ */
+
+bool opt_expr_removable(const ASTExpr *expr, bool checked) {
+    if (!expr) return true;
+
+    switch (expr->kind) {
+        case EXPR_CALL:
+            return false;
+        case EXPR_ADD:
+        case EXPR_SUB:
+        case EXPR_MUL:
+            if (checked && !expr->overflow_safe) return false;
+            return opt_expr_removable(expr->data.binary.left, checked) &&
+                   opt_expr_removable(expr->data.binary.right, checked);
+        case EXPR_DIV:
+        case EXPR_MOD: {
+            const ASTExpr *divisor = expr->data.binary.right;
+            if (divisor->kind != EXPR_INT_LITERAL ||
+                divisor->data.int_lit.value == 0 || divisor->data.int_lit.value == -1) {
+                return false;
+            }
+            return opt_expr_removable(expr->data.binary.left, checked);
+        }
+        case EXPR_NOT:
+            return opt_expr_removable(expr->data.unary.operand, checked);
+        case EXPR_SELECT:
+            return opt_expr_removable(expr->data.select.condition, checked) &&
+                   opt_expr_removable(expr->data.select.then_expr, checked) &&
+                   opt_expr_removable(expr->data.select.else_expr, checked);
+        default:
+            if (ast_expr_is_binary(expr->kind)) {
+                return opt_expr_removable(expr->data.binary.left, checked) &&
+                       opt_expr_removable(expr->data.binary.right, checked);
+            }
+            return true;
+    }
+}
+
+bool opt_evaluate_int(ExprKind kind, int32_t l, int32_t r, int32_t *result) {
+    uint32_t ul = (uint32_t)l, ur = (uint32_t)r;
+
+    switch (kind) {
+        case EXPR_ADD: *result = (int32_t)(ul + ur); return true;
+        case EXPR_SUB: *result = (int32_t)(ul - ur); return true;
+        case EXPR_MUL: *result = (int32_t)(ul * ur); return true;
+        case EXPR_DIV:
+            if (r == 0 || (l == INT32_MIN && r == -1)) return false;
+            *result = l / r;
+            return true;
+        case EXPR_MOD:
+            if (r == 0 || (l == INT32_MIN && r == -1)) return false;
+            *result = l % r;
+            return true;
+        case EXPR_SHL:
+            if (r < 0 || r > 31) return false;
+            *result = (int32_t)(ul << r);
+            return true;
+        case EXPR_SHR:
+            if (r < 0 || r > 31) return false;
+            *result = (l < 0) ? (int32_t)~(~ul >> r) : (int32_t)(ul >> r);
+            return true;
+        case EXPR_USHR:
+            if (r < 0 || r > 31) return false;
+            *result = (int32_t)(ul >> r);
+            return true;
+        case EXPR_MULHI:
+            *result = (int32_t)(((int64_t)l * (int64_t)r) >> 32);
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool opt_evaluate_int_checked(ExprKind kind, int32_t l, int32_t r, int32_t *result) {
+    int64_t wide;
+
+    switch (kind) {
+        case EXPR_ADD: wide = (int64_t)l + r; break;
+        case EXPR_SUB: wide = (int64_t)l - r; break;
+        case EXPR_MUL: wide = (int64_t)l * r; break;
+        default:       return opt_evaluate_int(kind, l, r, result);
+    }
+    if (wide < INT32_MIN || wide > INT32_MAX) return false;
+    *result = (int32_t)wide;
+    return true;
+}
+
+bool opt_evaluate_comparison(ExprKind kind, int32_t l, int32_t r) {
+    switch (kind) {
+        case EXPR_EQ: return l == r;
+        case EXPR_NE: return l != r;
+        case EXPR_LT: return l < r;
+        case EXPR_LE: return l <= r;
+        case EXPR_GT: return l > r;
+        default:      return l >= r;
+    }
+}
+
+static bool is_int(const ASTExpr *expr, int32_t value) {
+    return expr->kind == EXPR_INT_LITERAL && expr->data.int_lit.value == value;
+}
+
+static bool is_bool(const ASTExpr *expr, bool value) {
+    return expr->kind == EXPR_BOOL_LITERAL && expr->data.bool_lit.value == value;
+}
+
+/* Replace *slot with its child *child (detached from the parent first) */
+static void replace_with_child(ASTExpr **slot, ASTExpr **child) {
+    ASTExpr *keep = *child;
+    *child = NULL;
+    ast_expr_destroy(*slot);
+    *slot = keep;
+}
+
+static bool replace_with_literal(ASTExpr **slot, ASTExpr *literal) {
+    if (!literal) return false;
+    ast_expr_destroy(*slot);
+    *slot = literal;
+    return true;
+}
+
+/* Fold the node at *slot whose operands are already folded */
+static bool fold_node(ASTExpr **slot, bool checked) {
+    ASTExpr *expr = *slot;
+
+    if (expr->kind == EXPR_NOT) {
+        ASTExpr *operand = expr->data.unary.operand;
+        if (operand->kind == EXPR_BOOL_LITERAL) {
+            return replace_with_literal(slot, ast_expr_bool_literal(!operand->data.bool_lit.value));
+        }
+        if (operand->kind == EXPR_NOT) {
+            replace_with_child(slot, &operand->data.unary.operand);
+            return true;
+        }
+        return false;
+    }
+
+    if (!ast_expr_is_binary(expr->kind)) return false;
+
+    ASTExpr **left = &expr->data.binary.left;
+    ASTExpr **right = &expr->data.binary.right;
+    ExprKind kind = expr->kind;
+
+    /* Both operands literal */
+    if ((*left)->kind == EXPR_INT_LITERAL && (*right)->kind == EXPR_INT_LITERAL) {
+        int32_t l = (*left)->data.int_lit.value;
+        int32_t r = (*right)->data.int_lit.value;
+        int32_t value;
+
+        if (kind >= EXPR_EQ && kind <= EXPR_GE) {
+            return replace_with_literal(slot,
+                                        ast_expr_bool_literal(opt_evaluate_comparison(kind, l, r)));
+        }
+        bool folds = checked ? opt_evaluate_int_checked(kind, l, r, &value) :
+                               opt_evaluate_int(kind, l, r, &value);
+        if (folds) {
+            return replace_with_literal(slot, ast_expr_int_literal(value));
+        }
+        return false;
+    }
+    if ((*left)->kind == EXPR_BOOL_LITERAL && (*right)->kind == EXPR_BOOL_LITERAL) {
+        bool l = (*left)->data.bool_lit.value;
+        bool r = (*right)->data.bool_lit.value;
+
+        switch (kind) {
+            case EXPR_EQ:  return replace_with_literal(slot, ast_expr_bool_literal(l == r));
+            case EXPR_NE:  return replace_with_literal(slot, ast_expr_bool_literal(l != r));
+            case EXPR_AND: return replace_with_literal(slot, ast_expr_bool_literal(l && r));
+            case EXPR_OR:  return replace_with_literal(slot, ast_expr_bool_literal(l || r));
+            default:       return false;
+        }
+    }
+
+    /* Algebraic identities */
+    switch (kind) {
+        case EXPR_ADD:
+            if (is_int(*right, 0)) { replace_with_child(slot, left); return true; }
+            if (is_int(*left, 0)) { replace_with_child(slot, right); return true; }
+            return false;
+        case EXPR_SUB:
+        case EXPR_SHL:
+        case EXPR_SHR:
+        case EXPR_USHR:
+            if (is_int(*right, 0)) { replace_with_child(slot, left); return true; }
+            return false;
+        case EXPR_MUL:
+            if (is_int(*right, 1)) { replace_with_child(slot, left); return true; }
+            if (is_int(*left, 1)) { replace_with_child(slot, right); return true; }
+            if ((is_int(*right, 0) && opt_expr_removable(*left, checked)) ||
+                (is_int(*left, 0) && opt_expr_removable(*right, checked))) {
+                return replace_with_literal(slot, ast_expr_int_literal(0));
+            }
+            return false;
+        case EXPR_DIV:
+            if (is_int(*right, 1)) { replace_with_child(slot, left); return true; }
+            return false;
+        case EXPR_MOD:
+            if (is_int(*right, 1) && opt_expr_removable(*left, checked)) {
+                return replace_with_literal(slot, ast_expr_int_literal(0));
+            }
+            return false;
+        case EXPR_AND:
+            if (is_bool(*left, true)) { replace_with_child(slot, right); return true; }
+            if (is_bool(*left, false)) { replace_with_child(slot, left); return true; }
+            if (is_bool(*right, true)) { replace_with_child(slot, left); return true; }
+            if (is_bool(*right, false) && opt_expr_removable(*left, checked)) {
+                replace_with_child(slot, right);
+                return true;
+            }
+            return false;
+        case EXPR_OR:
+            if (is_bool(*left, false)) { replace_with_child(slot, right); return true; }
+            if (is_bool(*left, true)) { replace_with_child(slot, left); return true; }
+            if (is_bool(*right, false)) { replace_with_child(slot, left); return true; }
+            if (is_bool(*right, true) && opt_expr_removable(*left, checked)) {
+                replace_with_child(slot, right);
+                return true;
+            }
+            return false;
+        default:
+            return false;
+    }
+}
+
+size_t opt_fold_expr(ASTExpr **slot, bool checked) {
+    ASTExpr *expr = *slot;
+    if (!expr) return 0;
+
+    size_t folded = 0;
+    if (ast_expr_is_binary(expr->kind)) {
+        folded += opt_fold_expr(&expr->data.binary.left, checked);
+        folded += opt_fold_expr(&expr->data.binary.right, checked);
+    } else if (expr->kind == EXPR_NOT) {
+        folded += opt_fold_expr(&expr->data.unary.operand, checked);
+    } else if (expr->kind == EXPR_CALL) {
+        for (size_t i = 0; i < expr->data.call.arg_count; i++) {
+            folded += opt_fold_expr(&expr->data.call.args[i], checked);
+        }
+    }
+
+    /* A fold can expose another one at the same node (e.g. !!true) */
+    while (*slot && fold_node(slot, checked)) {
+        folded++;
+    }
+    return folded;
+}
+
+static size_t fold_stmt(ASTStmt *stmt, bool checked) {
+    if (!stmt) return 0;
+
+    switch (stmt->kind) {
+        case STMT_VAR_DECL:
+            return opt_fold_expr(&stmt->data.var_decl.init_expr, checked);
+        case STMT_ASSIGN:
+            return opt_fold_expr(&stmt->data.assign.expr, checked);
+        case STMT_IF:
+            return opt_fold_expr(&stmt->data.if_stmt.condition, checked) +
+                   fold_stmt(stmt->data.if_stmt.then_block, checked) +
+                   fold_stmt(stmt->data.if_stmt.else_block, checked);
+        case STMT_WHILE:
+            return opt_fold_expr(&stmt->data.while_stmt.condition, checked) +
+                   fold_stmt(stmt->data.while_stmt.body, checked);
+        case STMT_RETURN:
+            return opt_fold_expr(&stmt->data.return_stmt.expr, checked);
+        case STMT_EXPR:
+            return opt_fold_expr(&stmt->data.expr_stmt.expr, checked);
+        case STMT_BLOCK: {
+            size_t folded = 0;
+            for (size_t i = 0; i < stmt->data.block.stmt_count; i++) {
+                folded += fold_stmt(stmt->data.block.statements[i], checked);
+            }
+            return folded;
+        }
+    }
+    return 0;
+}
+
+void optimize_constant_folding(ASTProgram *program, const CompilerConfig *config,
+                               OptimizationStats *stats) {
+    if (!program) return;
+
+    bool checked = config && config->overflow_checks;
+    for (size_t i = 0; i < program->func_count; i++) {
+        size_t folded = fold_stmt(program->functions[i]->body, checked);
+        if (stats) stats->expressions_folded += folded;
+    }
+}
+
+/* ==============================================================================
+ * Unreachable Code
+ * ==============================================================================
+ */
+
+static void remove_statement(ASTStmt *block, size_t index) {
+    ast_stmt_destroy(block->data.block.statements[index]);
+    memmove(&block->data.block.statements[index], &block->data.block.statements[index + 1],
+            (block->data.block.stmt_count - index - 1) * sizeof(ASTStmt *));
+    block->data.block.stmt_count--;
+}
+
+/* Replace block[index] with the statements of the nested block (takes it) */
+static bool splice_block(ASTStmt *block, size_t index, ASTStmt *nested) {
+    size_t count = nested->data.block.stmt_count;
+    ASTStmt **inner = nested->data.block.statements;
+
+    block->data.block.statements[index] = NULL;
+    if (count > 0 && !opt_block_insert(block, index + 1, inner, count)) {
+        block->data.block.statements[index] = nested;
+        return false;
+    }
+
+    /* The statements now belong to the outer block */
+    free(inner);
+    nested->data.block.statements = NULL;
+    nested->data.block.stmt_count = 0;
+    ast_stmt_destroy(nested);
+
+    memmove(&block->data.block.statements[index], &block->data.block.statements[index + 1],
+            (block->data.block.stmt_count - index - 1) * sizeof(ASTStmt *));
+    block->data.block.stmt_count--;
+    return true;
+}
+
+static bool declares_variables(const ASTStmt *block) {
+    for (size_t i = 0; i < block->data.block.stmt_count; i++) {
+        if (block->data.block.statements[i]->kind == STMT_VAR_DECL) return true;
+    }
+    return false;
+}
+
+static bool is_empty_block(const ASTStmt *stmt) {
+    return !stmt || (stmt->kind == STMT_BLOCK && stmt->data.block.stmt_count == 0);
+}
+
+/* Take the branch chosen by a literal condition out of an if statement */
+static ASTStmt *take_branch(ASTStmt *stmt) {
+    bool taken = stmt->data.if_stmt.condition->data.bool_lit.value;
+    ASTStmt **branch = taken ? &stmt->data.if_stmt.then_block : &stmt->data.if_stmt.else_block;
+    ASTStmt *kept = *branch;
+    *branch = NULL;
+    return kept;
+}
+
+static size_t eliminate_block(ASTStmt *block, bool checked) {
+    size_t removed = 0;
+
+    for (size_t i = 0; i < block->data.block.stmt_count; i++) {
+        ASTStmt *stmt = block->data.block.statements[i];
+
+        switch (stmt->kind) {
+            case STMT_IF:
+                if (stmt->data.if_stmt.condition->kind == EXPR_BOOL_LITERAL) {
+                    ASTStmt *kept = take_branch(stmt);
+                    ast_stmt_destroy(stmt);
+                    removed++;
+                    if (kept) {
+                        block->data.block.statements[i] = kept;
+                        i--;        /* Revisit the branch in place of the if */
+                    } else {
+                        block->data.block.statements[i] = NULL;
+                        memmove(&block->data.block.statements[i],
+                                &block->data.block.statements[i + 1],
+                                (block->data.block.stmt_count - i - 1) * sizeof(ASTStmt *));
+                        block->data.block.stmt_count--;
+                        i--;
+                    }
+                    continue;
+                }
+                removed += eliminate_block(stmt->data.if_stmt.then_block, checked);
+                if (stmt->data.if_stmt.else_block) {
+                    removed += eliminate_block(stmt->data.if_stmt.else_block, checked);
+                    if (is_empty_block(stmt->data.if_stmt.else_block)) {
+                        ast_stmt_destroy(stmt->data.if_stmt.else_block);
+                        stmt->data.if_stmt.else_block = NULL;
+                    }
+                }
+                /* if (c) {} else { s } => if (!c) { s } */
+                if (is_empty_block(stmt->data.if_stmt.then_block) && stmt->data.if_stmt.else_block) {
+                    ASTExpr *negated = ast_expr_unary(EXPR_NOT, stmt->data.if_stmt.condition);
+                    if (negated) {
+                        stmt->data.if_stmt.condition = negated;
+                        /* Only the negation is new; checked folding is safe either way */
+                        opt_fold_expr(&stmt->data.if_stmt.condition, true);
+                        ast_stmt_destroy(stmt->data.if_stmt.then_block);
+                        stmt->data.if_stmt.then_block = stmt->data.if_stmt.else_block;
+                        stmt->data.if_stmt.else_block = NULL;
+                    }
+                }
+                if (is_empty_block(stmt->data.if_stmt.then_block) &&
+                    !stmt->data.if_stmt.else_block &&
+                    opt_expr_removable(stmt->data.if_stmt.condition, checked)) {
+                    remove_statement(block, i--);
+                    removed++;
+                    continue;
+                }
+                break;
+
+            case STMT_WHILE:
+                if (is_bool(stmt->data.while_stmt.condition, false)) {
+                    remove_statement(block, i--);
+                    removed++;
+                    continue;
+                }
+                removed += eliminate_block(stmt->data.while_stmt.body, checked);
+                break;
+
+            case STMT_EXPR:
+                if (opt_expr_removable(stmt->data.expr_stmt.expr, checked)) {
+                    remove_statement(block, i--);
+                    removed++;
+                    continue;
+                }
+                break;
+
+            case STMT_BLOCK:
+                removed += eliminate_block(stmt, checked);
+                /* Blocks without declarations need no scope of their own */
+                if (!declares_variables(stmt) && splice_block(block, i, stmt)) {
+                    i--;
+                    continue;
+                }
+                break;
+
+            default:
+                break;
+        }
+
+        /* Nothing after a statement that always returns can run */
+        if (opt_stmt_always_returns(stmt)) {
+            while (block->data.block.stmt_count > i + 1) {
+                remove_statement(block, i + 1);
+                removed++;
+            }
+        }
+    }
+    return removed;
+}
+
+/* ==============================================================================
+ * Dead Stores
+ * ==============================================================================
+ */
+
+static bool collect_reads(OptNameSet *reads, const ASTExpr *expr) {
+    if (!expr) return true;
+
+    if (expr->kind == EXPR_VAR) return opt_name_set_add(reads, expr->data.var.name);
+    if (ast_expr_is_binary(expr->kind)) {
+        return collect_reads(reads, expr->data.binary.left) &&
+               collect_reads(reads, expr->data.binary.right);
+    }
+    if (expr->kind == EXPR_NOT) return collect_reads(reads, expr->data.unary.operand);
+    if (expr->kind == EXPR_SELECT) {
+        return collect_reads(reads, expr->data.select.condition) &&
+               collect_reads(reads, expr->data.select.then_expr) &&
+               collect_reads(reads, expr->data.select.else_expr);
+    }
+    if (expr->kind == EXPR_CALL) {
+        for (size_t i = 0; i < expr->data.call.arg_count; i++) {
+            if (!collect_reads(reads, expr->data.call.args[i])) return false;
+        }
+    }
+    return true;
+}
+
+/* Record read names, and names with a store that cannot be removed */
+static bool scan_stmt(OptNameSet *reads, OptNameSet *pinned, const ASTStmt *stmt,
+                      bool checked) {
+    if (!stmt) return true;
+
+    switch (stmt->kind) {
+        case STMT_VAR_DECL:
+            if (!opt_expr_removable(stmt->data.var_decl.init_expr, checked) &&
+                !opt_name_set_add(pinned, stmt->data.var_decl.name)) {
+                return false;
+            }
+            return collect_reads(reads, stmt->data.var_decl.init_expr);
+        case STMT_ASSIGN:
+            if (!opt_expr_removable(stmt->data.assign.expr, checked) &&
+                !opt_name_set_add(pinned, stmt->data.assign.name)) {
+                return false;
+            }
+            return collect_reads(reads, stmt->data.assign.expr);
+        case STMT_IF:
+            return collect_reads(reads, stmt->data.if_stmt.condition) &&
+                   scan_stmt(reads, pinned, stmt->data.if_stmt.then_block, checked) &&
+                   scan_stmt(reads, pinned, stmt->data.if_stmt.else_block, checked);
+        case STMT_WHILE:
+            return collect_reads(reads, stmt->data.while_stmt.condition) &&
+                   scan_stmt(reads, pinned, stmt->data.while_stmt.body, checked);
+        case STMT_RETURN:
+            return collect_reads(reads, stmt->data.return_stmt.expr);
+        case STMT_EXPR:
+            return collect_reads(reads, stmt->data.expr_stmt.expr);
+        case STMT_BLOCK:
+            for (size_t i = 0; i < stmt->data.block.stmt_count; i++) {
+                if (!scan_stmt(reads, pinned, stmt->data.block.statements[i], checked)) return false;
+            }
+            return true;
+    }
+    return true;
+}
+
+static bool is_dead(const OptNameSet *reads, const OptNameSet *pinned, const char *name) {
+    return !opt_name_set_contains(reads, name) && !opt_name_set_contains(pinned, name);
+}
+
+static size_t remove_dead_stores(ASTStmt *block, const OptNameSet *reads,
+                                 const OptNameSet *pinned) {
+    size_t removed = 0;
+
+    for (size_t i = 0; i < block->data.block.stmt_count; i++) {
+        ASTStmt *stmt = block->data.block.statements[i];
+
+        switch (stmt->kind) {
+            case STMT_VAR_DECL:
+                if (is_dead(reads, pinned, stmt->data.var_decl.name)) {
+                    remove_statement(block, i--);
+                    removed++;
+                }
+                break;
+            case STMT_ASSIGN:
+                if (is_dead(reads, pinned, stmt->data.assign.name)) {
+                    remove_statement(block, i--);
+                    removed++;
+                }
+                break;
+            case STMT_IF:
+                removed += remove_dead_stores(stmt->data.if_stmt.then_block, reads, pinned);
+                if (stmt->data.if_stmt.else_block) {
+                    removed += remove_dead_stores(stmt->data.if_stmt.else_block, reads, pinned);
+                }
+                break;
+            case STMT_WHILE:
+                removed += remove_dead_stores(stmt->data.while_stmt.body, reads, pinned);
+                break;
+            case STMT_BLOCK:
+                removed += remove_dead_stores(stmt, reads, pinned);
+                break;
+            default:
+                break;
+        }
+    }
+    return removed;
+}
+
+/* ==============================================================================
+ * Pass Driver
+ * ==============================================================================
+ */
+
+void optimize_dead_code_elimination(ASTProgram *program, const CompilerConfig *config,
+                                    OptimizationStats *stats) {
+    if (!program) return;
+
+    bool checked = config && config->overflow_checks;
+
+    for (size_t f = 0; f < program->func_count; f++) {
+        ASTFunc *func = program->functions[f];
+        size_t removed = 0;
+
+        /* Removing a store can leave the stores feeding it dead */
+        for (;;) {
+            size_t round = eliminate_block(func->body, checked);
+
+            OptNameSet reads, pinned;
+            if (!opt_name_set_init(&reads)) break;
+            if (!opt_name_set_init(&pinned)) {
+                opt_name_set_free(&reads);
+                break;
+            }
+            if (scan_stmt(&reads, &pinned, func->body, checked)) {
+                round += remove_dead_stores(func->body, &reads, &pinned);
+            }
+            opt_name_set_free(&reads);
+            opt_name_set_free(&pinned);
+
+            if (round == 0) break;
+            removed += round;
+        }
+
+        if (removed > 0 && stats) {
+            stats->statements_removed += removed;
+            optimization_stats_remark(stats, "removed %zu dead statement%s in '%s'",
+                                      removed, removed == 1 ? "" : "s", func->name);
+        }
+    }
+}
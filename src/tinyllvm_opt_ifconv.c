@@ -0,0 +1,162 @@
+/**
+ * ==============================================================================
+ * TinyLLVM Compiler - If-Conversion
+ * ==============================================================================
+ *
+ * Conditionals that only choose the value of one variable are rewritten as
+ * a single assignment of a select, removing the branch:
+ *
+ *   if (a > b) { m = a; } else { m = b; }    =>    m = a > b ? a : b;
+ *   if (x < 0) { x = 0 - x; }                =>    x = x < 0 ? 0 - x : x;
+ *
+ * The C backend prints selects as ternaries, which compilers lower to
+ * conditional moves; the IR backend emits a `select` instruction that
+ * evaluates both arms. Arms are therefore speculated, and only converted
+ * when they cannot trap or have side effects (no calls, no division by a
+ * possibly zero or -1 divisor, and under config->overflow_checks no
+ * arithmetic that may overflow) and are at most config->if_convert_threshold
+ * AST nodes each, so expensive work is not executed on both paths.
+ */
+
+#include "include/tinyllvm_optimizer.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    const ASTFunc *func;
+    size_t threshold;
+    bool checked;
+    OptimizationStats *stats;
+} IfConverter;
+
+/* The lone assignment in `{ x = e; }`, or NULL */
+static ASTStmt *single_assignment(ASTStmt *stmt) {
+    if (!stmt) return NULL;
+    if (stmt->kind == STMT_BLOCK) {
+        if (stmt->data.block.stmt_count != 1) return NULL;
+        stmt = stmt->data.block.statements[0];
+    }
+    return stmt->kind == STMT_ASSIGN ? stmt : NULL;
+}
+
+static bool is_empty(const ASTStmt *stmt) {
+    return !stmt || (stmt->kind == STMT_BLOCK && stmt->data.block.stmt_count == 0);
+}
+
+static bool speculatable(const IfConverter *ic, const ASTExpr *expr) {
+    return opt_expr_removable(expr, ic->checked) && ast_expr_node_count(expr) <= ic->threshold;
+}
+
+/* Detach the value assigned by an arm, or build `name` for an empty arm */
+static ASTExpr *take_arm(ASTStmt *assign, const char *name, Type type) {
+    if (!assign) return opt_make_var(name, type);
+
+    ASTExpr *expr = assign->data.assign.expr;
+    assign->data.assign.expr = NULL;
+    return expr;
+}
+
+static void restore_arm(ASTStmt *assign, ASTExpr *expr) {
+    if (assign) {
+        assign->data.assign.expr = expr;
+    } else {
+        ast_expr_destroy(expr);
+    }
+}
+
+/* Rewrite *slot when it is a convertible if statement */
+static void convert_if(IfConverter *ic, ASTStmt **slot) {
+    ASTStmt *stmt = *slot;
+    ASTStmt *then_assign = single_assignment(stmt->data.if_stmt.then_block);
+    ASTStmt *else_assign = single_assignment(stmt->data.if_stmt.else_block);
+
+    if (!then_assign && !is_empty(stmt->data.if_stmt.then_block)) return;
+    if (!else_assign && !is_empty(stmt->data.if_stmt.else_block)) return;
+    if (!then_assign && !else_assign) return;
+
+    const char *name = then_assign ? then_assign->data.assign.name :
+                                     else_assign->data.assign.name;
+    if (then_assign && else_assign &&
+        strcmp(then_assign->data.assign.name, else_assign->data.assign.name) != 0) {
+        return;
+    }
+
+    if (then_assign && !speculatable(ic, then_assign->data.assign.expr)) return;
+    if (else_assign && !speculatable(ic, else_assign->data.assign.expr)) return;
+
+    Type type = then_assign ? then_assign->data.assign.expr->type :
+                              else_assign->data.assign.expr->type;
+
+    ASTExpr *then_expr = take_arm(then_assign, name, type);
+    ASTExpr *else_expr = take_arm(else_assign, name, type);
+    ASTExpr *condition = stmt->data.if_stmt.condition;
+    ASTExpr *select = ast_expr_select(condition, then_expr, else_expr);
+    ASTStmt *assign = select ? ast_stmt_assign(name, select) : NULL;
+
+    if (!assign) {
+        /* Leave the if statement as it was */
+        if (select) {
+            select->data.select.condition = NULL;
+            select->data.select.then_expr = NULL;
+            select->data.select.else_expr = NULL;
+            ast_expr_destroy(select);
+        }
+        restore_arm(then_assign, then_expr);
+        restore_arm(else_assign, else_expr);
+        return;
+    }
+
+    if (ic->stats) {
+        char text[64];
+        opt_expr_format(condition, text, sizeof(text));
+        ic->stats->branches_converted++;
+        optimization_stats_remark(ic->stats, "converted branch on '%s' to a select of '%s' in '%s'",
+                                  text, name, ic->func->name);
+    }
+
+    stmt->data.if_stmt.condition = NULL;
+    ast_stmt_destroy(stmt);
+    *slot = assign;
+}
+
+/* Bottom-up, so converted inner conditionals can make outer ones convertible */
+static void convert_stmt(IfConverter *ic, ASTStmt **slot) {
+    ASTStmt *stmt = *slot;
+    if (!stmt) return;
+
+    switch (stmt->kind) {
+        case STMT_IF:
+            convert_stmt(ic, &stmt->data.if_stmt.then_block);
+            convert_stmt(ic, &stmt->data.if_stmt.else_block);
+            convert_if(ic, slot);
+            return;
+        case STMT_WHILE:
+            convert_stmt(ic, &stmt->data.while_stmt.body);
+            return;
+        case STMT_BLOCK:
+            for (size_t i = 0; i < stmt->data.block.stmt_count; i++) {
+                convert_stmt(ic, &stmt->data.block.statements[i]);
+            }
+            return;
+        default:
+            return;
+    }
+}
+
+void optimize_if_conversion(ASTProgram *program, const CompilerConfig *config,
+                            OptimizationStats *stats) {
+    if (!program || !config) return;
+
+    IfConverter ic = {
+        .func = NULL,
+        .threshold = config->if_convert_threshold ? config->if_convert_threshold :
+                                                    OPT_DEFAULT_IF_CONVERT_THRESHOLD,
+        .checked = config->overflow_checks,
+        .stats = stats
+    };
+
+    for (size_t i = 0; i < program->func_count; i++) {
+        ic.func = program->functions[i];
+        convert_stmt(&ic, &program->functions[i]->body);
+    }
+}
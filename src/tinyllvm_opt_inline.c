@@ -0,0 +1,503 @@
+/**
+ * ==============================================================================
+ * TinyLLVM Compiler - Function Inlining
+ * ==============================================================================
+ *
+ * Substitutes calls to small, non-recursive functions with their bodies.
+ *
+ * Callee shapes:
+ *   - Expression:  body is `return e;`, inlined in place by substituting the
+ *                  arguments for the parameters (any expression position,
+ *                  including while conditions and short-circuit operands)
+ *   - Straight:    a single trailing `return e;`, inlined as statements
+ *                  placed before the calling statement
+ *   - Flag:        multiple returns, lowered to assignments of a result
+ *                  variable plus a `done` flag guarding the remaining code
+ *
+ * Statement-level inlining only applies to calls that are evaluated
+ * unconditionally and before any other call in the statement, so moving the
+ * callee body ahead of the statement preserves the order of side effects.
+ *
+ * Cost model: callees above the size threshold are never inlined and every
+ * caller has a growth budget measured in AST nodes. Functions are processed
+ * bottom-up over the call graph so callees are already optimized.
+ */
+
+#include "include/tinyllvm_optimizer.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+/* ==============================================================================
+ * Inliner State
+ * ==============================================================================
+ */
+
+typedef enum {
+    INLINE_SHAPE_EXPR,
+    INLINE_SHAPE_STRAIGHT,
+    INLINE_SHAPE_FLAG
+} InlineShape;
+
+typedef enum {
+    SITE_NONE,      /* No call in the expression */
+    SITE_FOUND,     /* Inlinable call evaluated first */
+    SITE_BLOCKED    /* Some other call must run first */
+} SiteSearch;
+
+typedef struct {
+    ASTProgram *program;
+    OptimizationStats *stats;
+    OptCallGraph graph;
+    OptNameSet names;
+
+    size_t threshold;
+    size_t budget;
+    size_t *sizes;          /* Current body size of each function */
+
+    /* Current caller */
+    size_t caller;
+    size_t growth;
+
+    bool failed;            /* Allocation failure, stop transforming */
+} Inliner;
+
+/* ==============================================================================
+ * Callee Classification
+ * ==============================================================================
+ */
+
+static InlineShape callee_shape(const ASTFunc *callee) {
+    const BlockStmt *body = &callee->body->data.block;
+    if (body->stmt_count == 0) return INLINE_SHAPE_FLAG;
+
+    const ASTStmt *last = body->statements[body->stmt_count - 1];
+    if (last->kind != STMT_RETURN || !last->data.return_stmt.expr) {
+        return INLINE_SHAPE_FLAG;
+    }
+
+    for (size_t i = 0; i + 1 < body->stmt_count; i++) {
+        if (opt_stmt_has_return(body->statements[i])) return INLINE_SHAPE_FLAG;
+    }
+
+    return body->stmt_count == 1 ? INLINE_SHAPE_EXPR : INLINE_SHAPE_STRAIGHT;
+}
+
+/* Index of the callee if this call may be inlined into the current caller */
+static size_t inlinable_callee(Inliner *in, const ASTExpr *call) {
+    size_t index = opt_find_function(in->program, call->data.call.func_name);
+    if (index == OPT_NOT_FOUND || index == in->caller) return OPT_NOT_FOUND;
+    if (in->graph.recursive[index]) return OPT_NOT_FOUND;
+    if (in->sizes[index] > in->threshold) return OPT_NOT_FOUND;
+    if (in->growth + in->sizes[index] > in->budget) return OPT_NOT_FOUND;
+    return index;
+}
+
+static void record_inline(Inliner *in, size_t callee) {
+    in->growth += in->sizes[callee];
+    in->stats->calls_inlined++;
+    optimization_stats_remark(in->stats, "inlined '%s' into '%s'",
+                              in->program->functions[callee]->name,
+                              in->program->functions[in->caller]->name);
+}
+
+/* ==============================================================================
+ * Expression-Level Inlining
+ * ==============================================================================
+ */
+
+/* Can the argument replace every use of its parameter without a temporary? */
+static bool argument_substitutable(const ASTExpr *arg, size_t uses) {
+    if (arg->kind == EXPR_INT_LITERAL || arg->kind == EXPR_BOOL_LITERAL ||
+        arg->kind == EXPR_VAR) {
+        return true;
+    }
+    return uses <= 1 && !opt_expr_has_call(arg);
+}
+
+/* Replace parameter references in expr (a private copy) with argument copies */
+static bool substitute_params(ASTExpr **slot, const ASTFunc *callee, ASTExpr **args) {
+    ASTExpr *expr = *slot;
+
+    if (ast_expr_is_binary(expr->kind)) {
+        return substitute_params(&expr->data.binary.left, callee, args) &&
+               substitute_params(&expr->data.binary.right, callee, args);
+    }
+
+    switch (expr->kind) {
+        case EXPR_VAR:
+            for (size_t i = 0; i < callee->param_count; i++) {
+                if (strcmp(expr->data.var.name, callee->params[i].name) != 0) continue;
+
+                ASTExpr *copy = ast_expr_clone(args[i]);
+                if (!copy) return false;
+                ast_expr_destroy(expr);
+                *slot = copy;
+                return true;
+            }
+            return true;
+
+        case EXPR_NOT:
+            return substitute_params(&expr->data.unary.operand, callee, args);
+
+        case EXPR_CALL:
+            for (size_t i = 0; i < expr->data.call.arg_count; i++) {
+                if (!substitute_params(&expr->data.call.args[i], callee, args)) return false;
+            }
+            return true;
+
+        default:
+            return true;
+    }
+}
+
+static void inline_expr_tree(Inliner *in, ASTExpr **slot) {
+    ASTExpr *expr = *slot;
+    if (!expr || in->failed) return;
+
+    if (ast_expr_is_binary(expr->kind)) {
+        inline_expr_tree(in, &expr->data.binary.left);
+        inline_expr_tree(in, &expr->data.binary.right);
+        return;
+    }
+
+    if (expr->kind == EXPR_NOT) {
+        inline_expr_tree(in, &expr->data.unary.operand);
+        return;
+    }
+
+    if (expr->kind != EXPR_CALL) return;
+
+    for (size_t i = 0; i < expr->data.call.arg_count; i++) {
+        inline_expr_tree(in, &expr->data.call.args[i]);
+    }
+
+    size_t index = inlinable_callee(in, expr);
+    if (index == OPT_NOT_FOUND) return;
+
+    ASTFunc *callee = in->program->functions[index];
+    if (callee_shape(callee) != INLINE_SHAPE_EXPR) return;
+
+    const ASTExpr *result = callee->body->data.block.statements[0]->data.return_stmt.expr;
+    for (size_t i = 0; i < callee->param_count; i++) {
+        size_t uses = opt_expr_count_var(result, callee->params[i].name);
+        if (!argument_substitutable(expr->data.call.args[i], uses)) return;
+    }
+
+    ASTExpr *replacement = ast_expr_clone(result);
+    if (!replacement || !substitute_params(&replacement, callee, expr->data.call.args)) {
+        ast_expr_destroy(replacement);
+        in->failed = true;
+        return;
+    }
+
+    ast_expr_destroy(expr);
+    *slot = replacement;
+    record_inline(in, index);
+}
+
+/* ==============================================================================
+ * Statement-Level Inlining
+ * ==============================================================================
+ */
+
+/*
+ * Find the call that is evaluated first in the expression. Operands of
+ * && and || after the first are conditional, so calls there block the search.
+ */
+static SiteSearch find_site(Inliner *in, ASTExpr **slot, ASTExpr ***site_out) {
+    ASTExpr *expr = *slot;
+    if (!expr) return SITE_NONE;
+
+    if (expr->kind == EXPR_AND || expr->kind == EXPR_OR) {
+        SiteSearch left = find_site(in, &expr->data.binary.left, site_out);
+        if (left != SITE_NONE) return left;
+        return opt_expr_has_call(expr->data.binary.right) ? SITE_BLOCKED : SITE_NONE;
+    }
+
+    if (ast_expr_is_binary(expr->kind)) {
+        SiteSearch left = find_site(in, &expr->data.binary.left, site_out);
+        if (left != SITE_NONE) return left;
+        return find_site(in, &expr->data.binary.right, site_out);
+    }
+
+    if (expr->kind == EXPR_NOT) {
+        return find_site(in, &expr->data.unary.operand, site_out);
+    }
+
+    if (expr->kind != EXPR_CALL) return SITE_NONE;
+
+    /* Innermost calls first; blocked arguments still run in order as temps */
+    for (size_t i = 0; i < expr->data.call.arg_count; i++) {
+        SiteSearch arg = find_site(in, &expr->data.call.args[i], site_out);
+        if (arg == SITE_FOUND) return SITE_FOUND;
+        if (arg == SITE_BLOCKED) break;
+    }
+
+    if (inlinable_callee(in, expr) == OPT_NOT_FOUND) return SITE_BLOCKED;
+
+    *site_out = slot;
+    return SITE_FOUND;
+}
+
+/* Flag-form callees: `return e;` becomes `result = e;` */
+static bool assign_result(OptReturnLowering *rl, ASTExpr *value, OptStmtVec *out) {
+    if (!value) return true;
+
+    ASTStmt *assign = ast_stmt_assign((const char *)rl->user_data, value);
+    if (!assign) {
+        ast_expr_destroy(value);
+        return false;
+    }
+    return opt_stmt_vec_push(out, assign);
+}
+
+/*
+ * Build the statements that replace the call at *site and the expression
+ * that stands in for its value. On failure nothing is modified.
+ */
+static bool build_inline_body(Inliner *in, const ASTExpr *call, const ASTFunc *callee,
+                              OptStmtVec *prefix, ASTExpr **value_out) {
+    OptRenameMap map = {0};
+    ASTStmt *body = NULL;
+    char *result_name = NULL;
+    char *done_name = NULL;
+    bool ok = false;
+
+    /* Parameters become fresh locals initialised from the arguments */
+    for (size_t i = 0; i < callee->param_count; i++) {
+        char *fresh = opt_fresh_name(&in->names, callee->params[i].name, "i");
+        if (!fresh) goto cleanup;
+
+        ASTExpr *arg = ast_expr_clone(call->data.call.args[i]);
+        ASTStmt *decl = arg ? ast_stmt_var_decl(fresh, callee->params[i].type, arg) : NULL;
+        bool pushed = opt_rename_map_push(&map, callee->params[i].name, fresh);
+        free(fresh);
+
+        if (!decl) ast_expr_destroy(arg);
+        if (!opt_stmt_vec_push(prefix, decl) || !pushed) goto cleanup;
+    }
+
+    body = ast_stmt_clone(callee->body);
+    if (!body || !opt_freshen_locals(body, &map, &in->names, "i")) goto cleanup;
+
+    ASTStmt **stmts = body->data.block.statements;
+    size_t count = body->data.block.stmt_count;
+
+    if (callee_shape(callee) != INLINE_SHAPE_FLAG) {
+        /* Straight-line body: the trailing return expression is the value */
+        for (size_t i = 0; i + 1 < count; i++) {
+            if (!opt_stmt_vec_push(prefix, stmts[i])) {
+                for (size_t j = i + 1; j < count; j++) ast_stmt_destroy(stmts[j]);
+                body->data.block.stmt_count = 0;
+                goto cleanup;
+            }
+        }
+
+        *value_out = stmts[count - 1]->data.return_stmt.expr;
+        stmts[count - 1]->data.return_stmt.expr = NULL;
+        ast_stmt_destroy(stmts[count - 1]);
+        body->data.block.stmt_count = 0;
+        ok = true;
+        goto cleanup;
+    }
+
+    /* Multiple returns: result variable plus a done flag */
+    result_name = opt_fresh_name(&in->names, callee->name, "ret");
+    done_name = opt_fresh_name(&in->names, callee->name, "done");
+    if (!result_name || !done_name) goto cleanup;
+
+    OptReturnLowering rl = {
+        .done = done_name,
+        .lower_return = assign_result,
+        .user_data = result_name,
+        .done_used = false,
+        .failed = false
+    };
+    opt_lower_returns(&rl, body);
+    if (rl.failed) goto cleanup;
+
+    if (!rl.done_used) {
+        opt_remove_assignments(body, done_name);
+    }
+
+    if (!opt_stmt_vec_push(prefix, ast_stmt_var_decl(result_name, callee->return_type,
+                                                 opt_make_default_value(callee->return_type)))) {
+        goto cleanup;
+    }
+    if (rl.done_used &&
+        !opt_stmt_vec_push(prefix, ast_stmt_var_decl(done_name, type_bool(),
+                                                 ast_expr_bool_literal(false)))) {
+        goto cleanup;
+    }
+
+    /* Move the lowered body into the prefix */
+    stmts = body->data.block.statements;
+    count = body->data.block.stmt_count;
+    body->data.block.stmt_count = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (!opt_stmt_vec_push(prefix, stmts[i])) {
+            for (size_t j = i + 1; j < count; j++) ast_stmt_destroy(stmts[j]);
+            goto cleanup;
+        }
+    }
+
+    *value_out = opt_make_var(result_name, callee->return_type);
+    ok = *value_out != NULL;
+
+cleanup:
+    ast_stmt_destroy(body);
+    free(result_name);
+    free(done_name);
+    opt_rename_map_free(&map);
+    return ok;
+}
+
+/* Inline the call at *site, inserting the body before block[index] */
+static bool inline_call_site(Inliner *in, ASTStmt *block, size_t index,
+                             ASTExpr **site, size_t *inserted_out) {
+    ASTExpr *call = *site;
+    size_t callee_index = inlinable_callee(in, call);
+    ASTFunc *callee = in->program->functions[callee_index];
+
+    OptStmtVec prefix = {0};
+    ASTExpr *value = NULL;
+
+    if (!build_inline_body(in, call, callee, &prefix, &value) ||
+        !opt_block_insert(block, index, prefix.items, prefix.count)) {
+        opt_stmt_vec_destroy(&prefix);
+        ast_expr_destroy(value);
+        in->failed = true;
+        return false;
+    }
+
+    ast_expr_destroy(call);
+    *site = value;
+
+    *inserted_out = prefix.count;
+    free(prefix.items);
+    record_inline(in, callee_index);
+    return true;
+}
+
+/* The expression evaluated once, before anything else in the statement */
+static ASTExpr **statement_head(ASTStmt *stmt) {
+    switch (stmt->kind) {
+        case STMT_VAR_DECL: return &stmt->data.var_decl.init_expr;
+        case STMT_ASSIGN:   return &stmt->data.assign.expr;
+        case STMT_IF:       return &stmt->data.if_stmt.condition;
+        case STMT_RETURN:   return stmt->data.return_stmt.expr ? &stmt->data.return_stmt.expr : NULL;
+        case STMT_EXPR:     return &stmt->data.expr_stmt.expr;
+        default:            return NULL;
+    }
+}
+
+static void inline_block(Inliner *in, ASTStmt *block) {
+    for (size_t i = 0; i < block->data.block.stmt_count && !in->failed; i++) {
+        ASTStmt *stmt = block->data.block.statements[i];
+
+        /* Expression-shaped callees anywhere in this statement's expressions */
+        if (stmt->kind == STMT_WHILE) {
+            inline_expr_tree(in, &stmt->data.while_stmt.condition);
+        } else {
+            ASTExpr **head = statement_head(stmt);
+            if (head) inline_expr_tree(in, head);
+        }
+
+        /* Remaining calls that can be hoisted ahead of the statement */
+        ASTExpr **head = statement_head(stmt);
+        while (head && !in->failed) {
+            ASTExpr **site = NULL;
+            if (find_site(in, head, &site) != SITE_FOUND) break;
+
+            size_t inserted = 0;
+            if (!inline_call_site(in, block, i, site, &inserted)) break;
+            i += inserted;
+        }
+
+        switch (stmt->kind) {
+            case STMT_IF:
+                inline_block(in, stmt->data.if_stmt.then_block);
+                if (stmt->data.if_stmt.else_block) {
+                    inline_block(in, stmt->data.if_stmt.else_block);
+                }
+                break;
+            case STMT_WHILE:
+                inline_block(in, stmt->data.while_stmt.body);
+                break;
+            case STMT_BLOCK:
+                inline_block(in, stmt);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+/* ==============================================================================
+ * Pass Driver
+ * ==============================================================================
+ */
+
+/* Post-order walk so every callee is finished before its callers */
+static void inline_function_postorder(Inliner *in, size_t index, bool *visited) {
+    visited[index] = true;
+
+    for (size_t i = 0; i < in->graph.callee_counts[index]; i++) {
+        size_t callee = in->graph.callees[index][i];
+        if (!visited[callee]) inline_function_postorder(in, callee, visited);
+    }
+
+    if (in->failed) return;
+
+    in->caller = index;
+    in->growth = 0;
+    inline_block(in, in->program->functions[index]->body);
+    in->sizes[index] = ast_stmt_node_count(in->program->functions[index]->body);
+}
+
+void optimize_inline_functions(ASTProgram *program, const CompilerConfig *config,
+                               OptimizationStats *stats) {
+    if (!program || program->func_count == 0) return;
+
+    Inliner in = {
+        .program = program,
+        .stats = stats,
+        .threshold = (config && config->inline_threshold) ?
+                     config->inline_threshold : OPT_DEFAULT_INLINE_THRESHOLD,
+        .budget = (config && config->inline_growth_budget) ?
+                  config->inline_growth_budget : OPT_DEFAULT_INLINE_GROWTH_BUDGET,
+        .failed = false
+    };
+
+    OptimizationStats scratch = {0};
+    if (!in.stats) in.stats = &scratch;
+
+    if (!opt_call_graph_build(&in.graph, program)) return;
+
+    if (!opt_name_set_init(&in.names) || !opt_name_set_add_program(&in.names, program)) {
+        opt_name_set_free(&in.names);
+        opt_call_graph_free(&in.graph);
+        return;
+    }
+
+    in.sizes = malloc(program->func_count * sizeof(size_t));
+    bool *visited = calloc(program->func_count, sizeof(bool));
+
+    if (in.sizes && visited) {
+        for (size_t i = 0; i < program->func_count; i++) {
+            in.sizes[i] = ast_stmt_node_count(program->functions[i]->body);
+        }
+        for (size_t i = 0; i < program->func_count; i++) {
+            if (!visited[i]) inline_function_postorder(&in, i, visited);
+        }
+    }
+
+    free(visited);
+    free(in.sizes);
+    opt_name_set_free(&in.names);
+    opt_call_graph_free(&in.graph);
+
+    for (size_t i = 0; i < scratch.remark_count; i++) free(scratch.remarks[i]);
+    free(scratch.remarks);
+}
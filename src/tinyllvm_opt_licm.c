@@ -0,0 +1,610 @@
+/**
+ * ==============================================================================
+ * TinyLLVM Compiler - Loop-Invariant Code Motion
+ * ==============================================================================
+ *
+ * Hoists expressions whose operands are not assigned inside a while loop
+ * into temporaries declared just before the loop:
+ *
+ *   while (i < n * m) {              var loop_inv0 = n * m;
+ *       s = s + a / 4;         =>    var loop_inv1 = a / 4;
+ *       i = i + 1;                   while (i < loop_inv0) {
+ *   }                                    s = s + loop_inv1; ...
+ *
+ * Hoisted code runs even when the loop body never does, so only
+ * expressions that cannot trap or have side effects are moved:
+ *   - division and modulo need a constant divisor other than 0 and -1, or
+ *     a loop condition conjunct proving the divisor positive, in which case
+ *     the temporary is computed under that guard
+ *   - calls are moved only to functions that are free of side effects,
+ *     loops, recursion and possibly trapping arithmetic
+ *   - signed +, - and * (and calls, whose callees may contain them) can
+ *     overflow, which is undefined in the C output. They are only moved
+ *     from places evaluated on every iteration (not under an inner if or
+ *     loop, after a possible return, or right of && and ||), and those
+ *     from the body are computed under a copy of the loop condition, so
+ *     they only run when the loop does
+ *
+ *   var loop_inv0 = 0;
+ *   if (i < n) { loop_inv0 = a * b; }
+ *   while (i < n) { s = s + loop_inv0; ... }
+ */
+
+#include "include/tinyllvm_optimizer.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* ==============================================================================
+ * Pass State
+ * ==============================================================================
+ */
+
+typedef struct {
+    ASTProgram *program;
+    OptimizationStats *stats;
+    OptNameSet names;
+    bool *speculatable;         /* Per function: safe to call speculatively */
+    const ASTFunc *func;        /* Function being optimized */
+    bool failed;
+} Licm;
+
+typedef struct {
+    OptNameSet assigned;        /* Names assigned or declared in the loop */
+    const ASTExpr *condition;
+    ASTExpr *loop_guard;        /* Copy of the condition before hoisting, or NULL */
+    OptStmtVec hoisted;         /* Declarations placed before the loop */
+    OptStmtVec guarded;         /* Assignments run under the loop condition */
+
+    /* Hoisted expressions and their temporaries, for reuse */
+    const ASTExpr **exprs;
+    char **temps;
+    bool *conditional;          /* Temporary only assigned under a guard */
+    size_t count;
+    size_t capacity;
+} LoopInfo;
+
+/* ==============================================================================
+ * Speculation Safety
+ * ==============================================================================
+ */
+
+static bool constant_divisor_safe(const ASTExpr *divisor) {
+    return divisor->kind == EXPR_INT_LITERAL &&
+           divisor->data.int_lit.value != 0 &&
+           divisor->data.int_lit.value != -1;
+}
+
+static bool expr_speculatable(const Licm *licm, const ASTExpr *expr) {
+    if (ast_expr_is_binary(expr->kind)) {
+        if ((expr->kind == EXPR_DIV || expr->kind == EXPR_MOD) &&
+            !constant_divisor_safe(expr->data.binary.right)) {
+            return false;
+        }
+        return expr_speculatable(licm, expr->data.binary.left) &&
+               expr_speculatable(licm, expr->data.binary.right);
+    }
+
+    switch (expr->kind) {
+        case EXPR_NOT:
+            return expr_speculatable(licm, expr->data.unary.operand);
+
+        case EXPR_CALL: {
+            size_t index = opt_find_function(licm->program, expr->data.call.func_name);
+            if (index == OPT_NOT_FOUND || !licm->speculatable[index]) return false;
+            for (size_t i = 0; i < expr->data.call.arg_count; i++) {
+                if (!expr_speculatable(licm, expr->data.call.args[i])) return false;
+            }
+            return true;
+        }
+
+        default:
+            return true;
+    }
+}
+
+/* Signed arithmetic that may overflow, directly or inside a call */
+static bool may_overflow(const ASTExpr *expr) {
+    if (ast_expr_is_binary(expr->kind)) {
+        if ((expr->kind == EXPR_ADD || expr->kind == EXPR_SUB || expr->kind == EXPR_MUL) &&
+            !expr->wraps) {
+            return true;
+        }
+        return may_overflow(expr->data.binary.left) || may_overflow(expr->data.binary.right);
+    }
+
+    switch (expr->kind) {
+        case EXPR_NOT:
+            return may_overflow(expr->data.unary.operand);
+        case EXPR_CALL:
+            return true;
+        case EXPR_SELECT:
+            return may_overflow(expr->data.select.condition) ||
+                   may_overflow(expr->data.select.then_expr) ||
+                   may_overflow(expr->data.select.else_expr);
+        default:
+            return false;
+    }
+}
+
+static bool stmt_speculatable(const Licm *licm, const ASTStmt *stmt) {
+    if (!stmt) return true;
+
+    switch (stmt->kind) {
+        case STMT_VAR_DECL:
+            return expr_speculatable(licm, stmt->data.var_decl.init_expr);
+        case STMT_ASSIGN:
+            return expr_speculatable(licm, stmt->data.assign.expr);
+        case STMT_IF:
+            return expr_speculatable(licm, stmt->data.if_stmt.condition) &&
+                   stmt_speculatable(licm, stmt->data.if_stmt.then_block) &&
+                   stmt_speculatable(licm, stmt->data.if_stmt.else_block);
+        case STMT_WHILE:
+            return false;   /* Termination unknown */
+        case STMT_RETURN:
+            return !stmt->data.return_stmt.expr ||
+                   expr_speculatable(licm, stmt->data.return_stmt.expr);
+        case STMT_EXPR:
+            return expr_speculatable(licm, stmt->data.expr_stmt.expr);
+        case STMT_BLOCK:
+            for (size_t i = 0; i < stmt->data.block.stmt_count; i++) {
+                if (!stmt_speculatable(licm, stmt->data.block.statements[i])) return false;
+            }
+            return true;
+    }
+    return false;
+}
+
+/* Start from the non-recursive functions and drop any that fail the check */
+static bool compute_speculatable(Licm *licm) {
+    OptCallGraph graph;
+    if (!opt_call_graph_build(&graph, licm->program)) return false;
+
+    for (size_t i = 0; i < licm->program->func_count; i++) {
+        licm->speculatable[i] = !graph.recursive[i];
+    }
+    opt_call_graph_free(&graph);
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = 0; i < licm->program->func_count; i++) {
+            if (licm->speculatable[i] &&
+                !stmt_speculatable(licm, licm->program->functions[i]->body)) {
+                licm->speculatable[i] = false;
+                changed = true;
+            }
+        }
+    }
+    return true;
+}
+
+/* ==============================================================================
+ * Invariance
+ * ==============================================================================
+ */
+
+static bool collect_assigned(OptNameSet *set, const ASTStmt *stmt) {
+    if (!stmt) return true;
+
+    switch (stmt->kind) {
+        case STMT_VAR_DECL:
+            return opt_name_set_add(set, stmt->data.var_decl.name);
+        case STMT_ASSIGN:
+            return opt_name_set_add(set, stmt->data.assign.name);
+        case STMT_IF:
+            return collect_assigned(set, stmt->data.if_stmt.then_block) &&
+                   collect_assigned(set, stmt->data.if_stmt.else_block);
+        case STMT_WHILE:
+            return collect_assigned(set, stmt->data.while_stmt.body);
+        case STMT_BLOCK:
+            for (size_t i = 0; i < stmt->data.block.stmt_count; i++) {
+                if (!collect_assigned(set, stmt->data.block.statements[i])) return false;
+            }
+            return true;
+        default:
+            return true;
+    }
+}
+
+/* Conjunct of the loop condition proving `name > 0`, if any */
+static const ASTExpr *positive_guard(const ASTExpr *cond, const char *name) {
+    if (cond->kind == EXPR_AND) {
+        const ASTExpr *guard = positive_guard(cond->data.binary.left, name);
+        return guard ? guard : positive_guard(cond->data.binary.right, name);
+    }
+
+    if (!ast_expr_is_binary(cond->kind)) return NULL;
+
+    const ASTExpr *left = cond->data.binary.left;
+    const ASTExpr *right = cond->data.binary.right;
+    bool left_var = left->kind == EXPR_VAR && strcmp(left->data.var.name, name) == 0;
+    bool right_var = right->kind == EXPR_VAR && strcmp(right->data.var.name, name) == 0;
+
+    int bound;
+    if (left_var && right->kind == EXPR_INT_LITERAL) {
+        bound = right->data.int_lit.value;
+        if ((cond->kind == EXPR_GT && bound >= 0) || (cond->kind == EXPR_GE && bound >= 1)) {
+            return cond;
+        }
+    } else if (right_var && left->kind == EXPR_INT_LITERAL) {
+        bound = left->data.int_lit.value;
+        if ((cond->kind == EXPR_LT && bound >= 0) || (cond->kind == EXPR_LE && bound >= 1)) {
+            return cond;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Can the expression be computed once before the loop? Expressions in the
+ * body may rely on a positive-divisor conjunct of the loop condition, which
+ * is returned through guard (at most one distinct guard per expression).
+ */
+static bool expr_hoistable(const Licm *licm, const LoopInfo *loop, const ASTExpr *expr,
+                           bool in_body, const ASTExpr **guard) {
+    if (ast_expr_is_binary(expr->kind)) {
+        if (expr->kind == EXPR_DIV || expr->kind == EXPR_MOD) {
+            const ASTExpr *divisor = expr->data.binary.right;
+            if (!constant_divisor_safe(divisor)) {
+                if (!in_body || divisor->kind != EXPR_VAR) return false;
+
+                const ASTExpr *found = positive_guard(loop->condition, divisor->data.var.name);
+                if (!found) return false;
+                if (*guard && !opt_expr_equal(*guard, found)) return false;
+                *guard = found;
+            }
+        }
+        return expr_hoistable(licm, loop, expr->data.binary.left, in_body, guard) &&
+               expr_hoistable(licm, loop, expr->data.binary.right, in_body, guard);
+    }
+
+    switch (expr->kind) {
+        case EXPR_VAR:
+            return !opt_name_set_contains(&loop->assigned, expr->data.var.name);
+
+        case EXPR_NOT:
+            return expr_hoistable(licm, loop, expr->data.unary.operand, in_body, guard);
+
+        case EXPR_CALL: {
+            size_t index = opt_find_function(licm->program, expr->data.call.func_name);
+            if (index == OPT_NOT_FOUND || !licm->speculatable[index]) return false;
+            for (size_t i = 0; i < expr->data.call.arg_count; i++) {
+                if (!expr_hoistable(licm, loop, expr->data.call.args[i], in_body, guard)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        default:
+            return true;
+    }
+}
+
+/* Only expressions that do some work are worth a temporary */
+static bool worth_hoisting(const ASTExpr *expr) {
+    if (ast_expr_is_binary(expr->kind) || expr->kind == EXPR_CALL) return true;
+    if (expr->kind == EXPR_NOT) return worth_hoisting(expr->data.unary.operand);
+    return false;
+}
+
+/* ==============================================================================
+ * Hoisting
+ * ==============================================================================
+ */
+
+static bool loop_record(LoopInfo *loop, const ASTExpr *expr, char *temp, bool conditional) {
+    if (loop->count >= loop->capacity) {
+        size_t new_capacity = loop->capacity == 0 ? 8 : loop->capacity * 2;
+        const ASTExpr **new_exprs = realloc(loop->exprs, new_capacity * sizeof(ASTExpr *));
+        if (!new_exprs) return false;
+        loop->exprs = new_exprs;
+
+        char **new_temps = realloc(loop->temps, new_capacity * sizeof(char *));
+        if (!new_temps) return false;
+        loop->temps = new_temps;
+
+        bool *new_conditional = realloc(loop->conditional, new_capacity * sizeof(bool));
+        if (!new_conditional) return false;
+        loop->conditional = new_conditional;
+
+        loop->capacity = new_capacity;
+    }
+
+    loop->exprs[loop->count] = expr;
+    loop->temps[loop->count] = temp;
+    loop->conditional[loop->count] = conditional;
+    loop->count++;
+    return true;
+}
+
+/*
+ * Move *slot into a temporary declared before the loop, computed under
+ * guard if given, or under the loop condition when loop_guarded. A
+ * temporary assigned under a guard only holds its value inside the loop
+ * body, so the condition never reuses one.
+ */
+static void hoist(Licm *licm, LoopInfo *loop, ASTExpr **slot, const ASTExpr *guard,
+                  bool loop_guarded, bool in_body) {
+    ASTExpr *expr = *slot;
+
+    for (size_t i = 0; i < loop->count; i++) {
+        if (!opt_expr_equal(loop->exprs[i], expr)) continue;
+        if (loop->conditional[i] && !in_body) continue;
+
+        ASTExpr *use = opt_make_var(loop->temps[i], expr->type);
+        if (!use) {
+            licm->failed = true;
+            return;
+        }
+        ast_expr_destroy(expr);
+        *slot = use;
+        return;
+    }
+
+    char *temp = opt_fresh_name(&licm->names, "loop", "inv");
+    ASTExpr *use = temp ? opt_make_var(temp, expr->type) : NULL;
+    if (!use) {
+        free(temp);
+        licm->failed = true;
+        return;
+    }
+
+    char text[128];
+    opt_expr_format(expr, text, sizeof(text));
+
+    bool ok;
+    if (loop_guarded) {
+        /* var t = 0; and t = expr; inside the shared guard */
+        ok = opt_stmt_vec_push(&loop->hoisted,
+                               ast_stmt_var_decl(temp, expr->type,
+                                                 opt_make_default_value(expr->type)));
+        ASTStmt *assign = ast_stmt_assign(temp, expr);
+        if (!assign) ast_expr_destroy(expr);
+        ok = opt_stmt_vec_push(&loop->guarded, assign) && ok;
+    } else if (!guard) {
+        ok = opt_stmt_vec_push(&loop->hoisted, ast_stmt_var_decl(temp, expr->type, expr));
+    } else {
+        /* var t = 0; if (guard) { t = expr; } */
+        ASTStmt **then_stmts = malloc(sizeof(ASTStmt *));
+        ASTStmt *assign = ast_stmt_assign(temp, expr);
+        ASTStmt *then_block = NULL;
+
+        if (then_stmts && assign) {
+            then_stmts[0] = assign;
+            then_block = ast_stmt_block(then_stmts, 1);
+        }
+        if (!then_block) {
+            free(then_stmts);
+            if (assign) {
+                ast_stmt_destroy(assign);
+            } else {
+                ast_expr_destroy(expr);
+            }
+            ast_expr_destroy(use);
+            free(temp);
+            licm->failed = true;
+            return;
+        }
+
+        ASTExpr *cond = ast_expr_clone(guard);
+        ASTStmt *if_stmt = cond ? ast_stmt_if(cond, then_block, NULL) : NULL;
+        if (!if_stmt) {
+            ast_expr_destroy(cond);
+            ast_stmt_destroy(then_block);
+        }
+
+        ok = opt_stmt_vec_push(&loop->hoisted,
+                               ast_stmt_var_decl(temp, expr->type,
+                                                 opt_make_default_value(expr->type))) &&
+             opt_stmt_vec_push(&loop->hoisted, if_stmt);
+    }
+
+    /* The expression now lives in the hoisted statements */
+    *slot = use;
+    if (!ok || !loop_record(loop, expr, temp, loop_guarded || guard)) {
+        free(temp);
+        licm->failed = true;
+        return;
+    }
+
+    if (licm->stats) {
+        licm->stats->expressions_hoisted++;
+        optimization_stats_remark(licm->stats, "hoisted '%s' out of a loop in '%s'",
+                                  text, licm->func->name);
+    }
+}
+
+/*
+ * Hoist the invariant parts of *slot. conditional is set where the
+ * expression may be skipped on an iteration (or evaluation of the loop
+ * condition) that runs.
+ */
+static void hoist_in_expr(Licm *licm, LoopInfo *loop, ASTExpr **slot, bool in_body,
+                          bool conditional) {
+    ASTExpr *expr = *slot;
+    if (!expr || licm->failed) return;
+
+    const ASTExpr *guard = NULL;
+    if (worth_hoisting(expr) && expr_hoistable(licm, loop, expr, in_body, &guard)) {
+        bool overflows = may_overflow(expr);
+        bool loop_guarded = in_body && overflows;
+        if (!overflows || (!conditional && (!in_body || loop->loop_guard))) {
+            hoist(licm, loop, slot, loop_guarded ? NULL : guard, loop_guarded, in_body);
+            return;
+        }
+    }
+
+    if (ast_expr_is_binary(expr->kind)) {
+        bool lazy = expr->kind == EXPR_AND || expr->kind == EXPR_OR;
+        hoist_in_expr(licm, loop, &expr->data.binary.left, in_body, conditional);
+        hoist_in_expr(licm, loop, &expr->data.binary.right, in_body, conditional || lazy);
+    } else if (expr->kind == EXPR_NOT) {
+        hoist_in_expr(licm, loop, &expr->data.unary.operand, in_body, conditional);
+    } else if (expr->kind == EXPR_CALL) {
+        for (size_t i = 0; i < expr->data.call.arg_count; i++) {
+            hoist_in_expr(licm, loop, &expr->data.call.args[i], in_body, conditional);
+        }
+    }
+}
+
+static void hoist_in_stmt(Licm *licm, LoopInfo *loop, ASTStmt *stmt, bool conditional) {
+    if (!stmt || licm->failed) return;
+
+    switch (stmt->kind) {
+        case STMT_VAR_DECL:
+            hoist_in_expr(licm, loop, &stmt->data.var_decl.init_expr, true, conditional);
+            break;
+        case STMT_ASSIGN:
+            hoist_in_expr(licm, loop, &stmt->data.assign.expr, true, conditional);
+            break;
+        case STMT_IF:
+            hoist_in_expr(licm, loop, &stmt->data.if_stmt.condition, true, conditional);
+            hoist_in_stmt(licm, loop, stmt->data.if_stmt.then_block, true);
+            hoist_in_stmt(licm, loop, stmt->data.if_stmt.else_block, true);
+            break;
+        case STMT_WHILE:
+            hoist_in_expr(licm, loop, &stmt->data.while_stmt.condition, true, conditional);
+            hoist_in_stmt(licm, loop, stmt->data.while_stmt.body, true);
+            break;
+        case STMT_RETURN:
+            hoist_in_expr(licm, loop, &stmt->data.return_stmt.expr, true, conditional);
+            break;
+        case STMT_EXPR:
+            hoist_in_expr(licm, loop, &stmt->data.expr_stmt.expr, true, conditional);
+            break;
+        case STMT_BLOCK:
+            for (size_t i = 0; i < stmt->data.block.stmt_count; i++) {
+                hoist_in_stmt(licm, loop, stmt->data.block.statements[i], conditional);
+                /* Later statements are skipped when this one returns */
+                if (opt_stmt_has_return(stmt->data.block.statements[i])) conditional = true;
+            }
+            break;
+    }
+}
+
+static void licm_block(Licm *licm, ASTStmt *block);
+
+/* Optimize the loop at block[index]; returns the number of statements inserted */
+static size_t licm_loop(Licm *licm, ASTStmt *block, size_t index) {
+    ASTStmt *stmt = block->data.block.statements[index];
+
+    /* Inner loops first so their invariants can keep moving outward */
+    licm_block(licm, stmt->data.while_stmt.body);
+    if (licm->failed) return 0;
+
+    LoopInfo loop = {0};
+    if (!opt_name_set_init(&loop.assigned) ||
+        !collect_assigned(&loop.assigned, stmt->data.while_stmt.body)) {
+        opt_name_set_free(&loop.assigned);
+        licm->failed = true;
+        return 0;
+    }
+    loop.condition = stmt->data.while_stmt.condition;
+    /* The pass does not run under overflow checks */
+    if (opt_expr_removable(loop.condition, false)) {
+        loop.loop_guard = ast_expr_clone(loop.condition);
+    }
+
+    /* Body first: division guards are looked up in the original condition */
+    hoist_in_stmt(licm, &loop, stmt->data.while_stmt.body, false);
+    hoist_in_expr(licm, &loop, &stmt->data.while_stmt.condition, false, false);
+
+    /* if (condition) { guarded... } after the declarations. The copy taken
+     * before hoisting is used: the rewritten condition may read temporaries
+     * that are only initialised by the guarded assignments. */
+    if (loop.guarded.count > 0) {
+        ASTExpr *cond = loop.loop_guard;
+        ASTStmt *then_block = ast_stmt_block(loop.guarded.items, loop.guarded.count);
+        ASTStmt *if_stmt = cond && then_block ? ast_stmt_if(cond, then_block, NULL) : NULL;
+        loop.loop_guard = NULL;
+        if (!if_stmt) {
+            ast_expr_destroy(cond);
+            if (then_block) {
+                ast_stmt_destroy(then_block);
+            } else {
+                opt_stmt_vec_destroy(&loop.guarded);
+            }
+        }
+        if (!opt_stmt_vec_push(&loop.hoisted, if_stmt)) licm->failed = true;
+    } else {
+        free(loop.guarded.items);
+    }
+
+    size_t inserted = 0;
+    if (loop.hoisted.count > 0) {
+        if (opt_block_insert(block, index, loop.hoisted.items, loop.hoisted.count)) {
+            inserted = loop.hoisted.count;
+            free(loop.hoisted.items);
+        } else {
+            opt_stmt_vec_destroy(&loop.hoisted);
+            licm->failed = true;
+        }
+    } else {
+        free(loop.hoisted.items);
+    }
+
+    for (size_t i = 0; i < loop.count; i++) free(loop.temps[i]);
+    free(loop.temps);
+    free(loop.exprs);
+    free(loop.conditional);
+    ast_expr_destroy(loop.loop_guard);
+    opt_name_set_free(&loop.assigned);
+    return inserted;
+}
+
+static void licm_block(Licm *licm, ASTStmt *block) {
+    for (size_t i = 0; i < block->data.block.stmt_count && !licm->failed; i++) {
+        ASTStmt *stmt = block->data.block.statements[i];
+
+        switch (stmt->kind) {
+            case STMT_WHILE:
+                i += licm_loop(licm, block, i);
+                break;
+            case STMT_IF:
+                licm_block(licm, stmt->data.if_stmt.then_block);
+                if (stmt->data.if_stmt.else_block) {
+                    licm_block(licm, stmt->data.if_stmt.else_block);
+                }
+                break;
+            case STMT_BLOCK:
+                licm_block(licm, stmt);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+/* ==============================================================================
+ * Pass Driver
+ * ==============================================================================
+ */
+
+void optimize_loop_invariants(ASTProgram *program, OptimizationStats *stats) {
+    if (!program || program->func_count == 0) return;
+
+    Licm licm = {
+        .program = program,
+        .stats = stats,
+        .speculatable = calloc(program->func_count, sizeof(bool)),
+        .func = NULL,
+        .failed = false
+    };
+
+    if (!licm.speculatable || !compute_speculatable(&licm) ||
+        !opt_name_set_init(&licm.names)) {
+        free(licm.speculatable);
+        return;
+    }
+
+    if (opt_name_set_add_program(&licm.names, program)) {
+        for (size_t i = 0; i < program->func_count && !licm.failed; i++) {
+            licm.func = program->functions[i];
+            licm_block(&licm, program->functions[i]->body);
+        }
+    }
+
+    opt_name_set_free(&licm.names);
+    free(licm.speculatable);
+}
@@ -0,0 +1,182 @@
+/**
+ * ==============================================================================
+ * TinyLLVM Compiler - Memoization of Pure Recursive Functions
+ * ==============================================================================
+ *
+ * A function is pure when neither it nor anything it calls prints, so its
+ * result depends only on its arguments. Pure recursive functions with a
+ * few int/bool parameters are split into a cached wrapper and the original
+ * body:
+ *
+ *   func fib(n: int) : int {               func fib(n: int) : int {
+ *       if (n < 2) { return n; }     =>        return fib_memo1(n);     (cached)
+ *       return fib(n - 1) + fib(n - 2);    }
+ *   }                                      func fib_memo1(n: int) : int {
+ *                                              if (n < 2) { return n; }
+ *                                              return fib(n - 1) + fib(n - 2);
+ *                                          }
+ *
+ * The recursive calls still go through the wrapper, so every level of the
+ * recursion hits the cache. The wrapper is marked with ASTFunc.memo_slots
+ * and the C backend emits the lookup around the call as a direct-mapped
+ * table keyed by the arguments; other backends emit the plain call.
+ */
+
+#include "include/tinyllvm_optimizer.h"
+#include <stdlib.h>
+#include <string.h>
+
+static bool is_scalar(Type type) {
+    return type.kind == TYPE_INT || type.kind == TYPE_BOOL;
+}
+
+static bool is_candidate(const ASTFunc *func, const OptCallGraph *graph, size_t index) {
+    if (!graph->pure[index] || !graph->recursive[index]) return false;
+    if (strcmp(func->name, "main") == 0) return false;
+    if (!is_scalar(func->return_type)) return false;
+    if (func->param_count == 0 || func->param_count > OPT_MEMO_MAX_PARAMS) return false;
+
+    for (size_t i = 0; i < func->param_count; i++) {
+        if (!is_scalar(func->params[i].type)) return false;
+    }
+    return true;
+}
+
+/* Round the configured cache size up to a power of two */
+static size_t memo_slot_count(const CompilerConfig *config) {
+    size_t requested = config->memo_cache_size ? config->memo_cache_size :
+                                                  OPT_DEFAULT_MEMO_SLOTS;
+    size_t slots = 1;
+    while (slots < requested) slots <<= 1;
+    return slots;
+}
+
+/* The C backend declares <impl>_cache and <impl>_slot in the wrapper */
+static bool wrapper_names_free(const OptNameSet *names, const char *impl) {
+    static const char *const suffixes[] = { "_cache", "_slot" };
+    char buffer[256];
+
+    for (size_t i = 0; i < sizeof(suffixes) / sizeof(suffixes[0]); i++) {
+        if (strlen(impl) + strlen(suffixes[i]) >= sizeof(buffer)) return false;
+        strcpy(buffer, impl);
+        strcat(buffer, suffixes[i]);
+        if (opt_name_set_contains(names, buffer)) return false;
+    }
+    return true;
+}
+
+/* Body `{ return impl(params...); }` */
+static ASTStmt *build_forwarding_body(const ASTFunc *func, const char *impl) {
+    ASTExpr **args = calloc(func->param_count, sizeof(ASTExpr *));
+    if (!args) return NULL;
+
+    for (size_t i = 0; i < func->param_count; i++) {
+        args[i] = opt_make_var(func->params[i].name, func->params[i].type);
+        if (!args[i]) {
+            for (size_t j = 0; j < i; j++) ast_expr_destroy(args[j]);
+            free(args);
+            return NULL;
+        }
+    }
+
+    ASTExpr *call = ast_expr_call(impl, args, func->param_count);
+    if (!call) {
+        for (size_t i = 0; i < func->param_count; i++) ast_expr_destroy(args[i]);
+        free(args);
+        return NULL;
+    }
+    call->type = func->return_type;
+
+    ASTStmt *ret = ast_stmt_return(call);
+    if (!ret) {
+        ast_expr_destroy(call);
+        return NULL;
+    }
+
+    ASTStmt **stmts = malloc(sizeof(ASTStmt *));
+    if (!stmts) {
+        ast_stmt_destroy(ret);
+        return NULL;
+    }
+    stmts[0] = ret;
+
+    ASTStmt *block = ast_stmt_block(stmts, 1);
+    if (!block) {
+        ast_stmt_destroy(ret);
+        free(stmts);
+    }
+    return block;
+}
+
+static bool memoize_function(ASTProgram *program, size_t index, OptNameSet *names,
+                             size_t slots, OptimizationStats *stats) {
+    ASTFunc *func = program->functions[index];
+
+    char *impl_name = opt_fresh_name(names, func->name, "memo");
+    if (!impl_name) return false;
+
+    if (!wrapper_names_free(names, impl_name)) {
+        free(impl_name);
+        return true;
+    }
+
+    ASTStmt *wrapper_body = build_forwarding_body(func, impl_name);
+    ASTFunc *impl = wrapper_body ? opt_func_clone(func, impl_name) : NULL;
+    if (!impl || !opt_program_insert_function(program, index + 1, impl)) {
+        ast_func_destroy(impl);
+        ast_stmt_destroy(wrapper_body);
+        free(impl_name);
+        return false;
+    }
+
+    ast_stmt_destroy(func->body);
+    func->body = wrapper_body;
+    func->memo_slots = slots;
+
+    if (stats) {
+        stats->functions_memoized++;
+        optimization_stats_remark(stats, "memoized pure function '%s' (%zu cache entries)",
+                                  func->name, slots);
+    }
+    free(impl_name);
+    return true;
+}
+
+void optimize_memoization(ASTProgram *program, const CompilerConfig *config,
+                          OptimizationStats *stats) {
+    if (!program || !config || config->target != TARGET_C) return;
+
+    OptCallGraph graph;
+    if (!opt_call_graph_build(&graph, program)) return;
+
+    OptNameSet names;
+    if (!opt_name_set_init(&names) || !opt_name_set_add_program(&names, program)) {
+        opt_name_set_free(&names);
+        opt_call_graph_free(&graph);
+        return;
+    }
+
+    /* Decide on the original functions before clones shift the indices */
+    size_t original_count = program->func_count;
+    bool *selected = calloc(original_count ? original_count : 1, sizeof(bool));
+    if (!selected) {
+        opt_name_set_free(&names);
+        opt_call_graph_free(&graph);
+        return;
+    }
+    for (size_t i = 0; i < original_count; i++) {
+        selected[i] = is_candidate(program->functions[i], &graph, i);
+    }
+
+    size_t slots = memo_slot_count(config);
+    size_t index = 0;
+    for (size_t i = 0; i < original_count; i++, index++) {
+        if (!selected[i]) continue;
+        if (!memoize_function(program, index, &names, slots, stats)) break;
+        if (program->functions[index]->memo_slots > 0) index++;  /* Skip the clone */
+    }
+
+    free(selected);
+    opt_name_set_free(&names);
+    opt_call_graph_free(&graph);
+}
@@ -0,0 +1,654 @@
+/**
+ * ==============================================================================
+ * TinyLLVM Compiler - Interval Range Analysis
+ * ==============================================================================
+ *
+ * Abstract interpretation of each function over integer intervals, used to
+ * prove that arithmetic cannot overflow so overflow-checked builds only pay
+ * for checks that may fire. Every binding carries a range [lo, hi]
+ * (booleans are [0, 1]); parameters and call results are unknown.
+ *
+ *   - Conditions refine the ranges on each side of an if, inside a while
+ *     body and after the loop: in `while (i < n) { i = i + 1; }` the
+ *     increment sees i <= INT_MAX - 1 and is proven safe.
+ *   - && and || refine their right operand, so `b != 0 && a / b > 1`
+ *     proves the division safe.
+ *   - Loops iterate to a fixpoint; after OPT_RANGE_WIDEN_AFTER rounds any
+ *     bound that still moves is widened to the int limits.
+ *
+ * An operation whose range stays within 32 bits is marked overflow_safe.
+ * Checked operations trap on overflow, so execution continues with the
+ * in-range part of the exact result. Code proven unreachable keeps its
+ * marks: it never runs.
+ */
+
+#include "include/tinyllvm_optimizer.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define OPT_RANGE_WIDEN_AFTER 3
+#define OPT_RANGE_MAX_ROUNDS  32    /* Safety net: give up on the loop's ranges */
+
+/* ==============================================================================
+ * Intervals
+ * ==============================================================================
+ */
+
+typedef struct {
+    int64_t lo;
+    int64_t hi;
+} Range;
+
+static const Range full_range = { INT32_MIN, INT32_MAX };
+static const Range bool_range = { 0, 1 };
+
+static Range range_of_type(Type type) {
+    return type.kind == TYPE_BOOL ? bool_range : full_range;
+}
+
+static Range range_make(int64_t lo, int64_t hi) {
+    Range r = { lo, hi };
+    return r;
+}
+
+static bool range_fits(Range r) {
+    return r.lo >= INT32_MIN && r.hi <= INT32_MAX;
+}
+
+/* Checked arithmetic traps outside int, so execution continues inside it */
+static Range range_clip(Range r) {
+    if (r.lo < INT32_MIN) r.lo = INT32_MIN;
+    if (r.hi > INT32_MAX) r.hi = INT32_MAX;
+    return r;
+}
+
+static bool range_contains(Range r, int64_t value) {
+    return r.lo <= value && value <= r.hi;
+}
+
+static Range range_join(Range a, Range b) {
+    return range_make(a.lo < b.lo ? a.lo : b.lo, a.hi > b.hi ? a.hi : b.hi);
+}
+
+static int64_t min4(int64_t a, int64_t b, int64_t c, int64_t d) {
+    int64_t m = a;
+    if (b < m) m = b;
+    if (c < m) m = c;
+    if (d < m) m = d;
+    return m;
+}
+
+static int64_t max4(int64_t a, int64_t b, int64_t c, int64_t d) {
+    int64_t m = a;
+    if (b > m) m = b;
+    if (c > m) m = c;
+    if (d > m) m = d;
+    return m;
+}
+
+/* Quotients of a by the divisors in d (which excludes zero) */
+static Range range_divide(Range a, Range d) {
+    return range_make(min4(a.lo / d.lo, a.lo / d.hi, a.hi / d.lo, a.hi / d.hi),
+                      max4(a.lo / d.lo, a.lo / d.hi, a.hi / d.lo, a.hi / d.hi));
+}
+
+static Range range_div(Range a, Range d) {
+    bool has_neg = d.lo <= -1, has_pos = d.hi >= 1;
+
+    if (has_neg && has_pos) {
+        return range_join(range_divide(a, range_make(d.lo, -1)),
+                          range_divide(a, range_make(1, d.hi)));
+    }
+    if (has_neg) return range_divide(a, range_make(d.lo, d.hi < -1 ? d.hi : -1));
+    if (has_pos) return range_divide(a, range_make(d.lo > 1 ? d.lo : 1, d.hi));
+    return full_range;  /* Always divides by zero */
+}
+
+/* C remainders take the dividend's sign and are smaller than the divisor */
+static Range range_mod(Range a, Range d) {
+    int64_t magnitude = d.hi > -d.lo ? d.hi : -d.lo;
+    if (magnitude == 0) return full_range;
+
+    int64_t lo = a.lo < 0 ? (a.lo > -(magnitude - 1) ? a.lo : -(magnitude - 1)) : 0;
+    int64_t hi = a.hi > 0 ? (a.hi < magnitude - 1 ? a.hi : magnitude - 1) : 0;
+    return range_make(lo, hi);
+}
+
+/* ==============================================================================
+ * Environment
+ * ==============================================================================
+ */
+
+typedef struct {
+    const char *name;           /* Borrowed from the AST */
+    Range range;
+} Binding;
+
+typedef struct {
+    Binding *bindings;          /* Innermost binding of a name is the last one */
+    size_t count;
+    size_t capacity;
+} Env;
+
+typedef struct {
+    bool failed;
+} Analyzer;
+
+static bool env_push(Env *env, const char *name, Range range) {
+    if (env->count == env->capacity) {
+        size_t capacity = env->capacity ? env->capacity * 2 : 16;
+        Binding *bindings = realloc(env->bindings, capacity * sizeof(Binding));
+        if (!bindings) return false;
+        env->bindings = bindings;
+        env->capacity = capacity;
+    }
+
+    env->bindings[env->count].name = name;
+    env->bindings[env->count].range = range;
+    env->count++;
+    return true;
+}
+
+static Binding *env_lookup(const Env *env, const char *name) {
+    for (size_t i = env->count; i > 0; i--) {
+        if (strcmp(env->bindings[i - 1].name, name) == 0) return &env->bindings[i - 1];
+    }
+    return NULL;
+}
+
+static bool env_copy(Env *dst, const Env *src) {
+    dst->bindings = malloc((src->capacity ? src->capacity : 1) * sizeof(Binding));
+    if (!dst->bindings) return false;
+
+    if (src->count > 0) memcpy(dst->bindings, src->bindings, src->count * sizeof(Binding));
+    dst->count = src->count;
+    dst->capacity = src->capacity ? src->capacity : 1;
+    return true;
+}
+
+/* Replace dst's ranges with src's (same bindings assumed) */
+static void env_assign(Env *dst, const Env *src) {
+    if (src->count > 0) memcpy(dst->bindings, src->bindings, src->count * sizeof(Binding));
+}
+
+static void env_join(Env *env, const Env *other) {
+    for (size_t i = 0; i < env->count && i < other->count; i++) {
+        env->bindings[i].range = range_join(env->bindings[i].range, other->bindings[i].range);
+    }
+}
+
+/* Push bounds that are still moving out to the int limits */
+static void env_widen(Env *env, const Env *previous) {
+    for (size_t i = 0; i < env->count; i++) {
+        Range *r = &env->bindings[i].range;
+        if (r->lo < previous->bindings[i].range.lo) r->lo = INT32_MIN;
+        if (r->hi > previous->bindings[i].range.hi) r->hi = INT32_MAX;
+    }
+}
+
+static bool env_equal(const Env *a, const Env *b) {
+    for (size_t i = 0; i < a->count; i++) {
+        if (a->bindings[i].range.lo != b->bindings[i].range.lo ||
+            a->bindings[i].range.hi != b->bindings[i].range.hi) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* ==============================================================================
+ * Expressions
+ * ==============================================================================
+ */
+
+static bool refine(Analyzer *a, Env *env, const ASTExpr *cond, bool truth);
+
+static bool is_checked_kind(ExprKind kind) {
+    return kind == EXPR_ADD || kind == EXPR_SUB || kind == EXPR_MUL ||
+           kind == EXPR_DIV || kind == EXPR_MOD;
+}
+
+/* Range of expr under env; clears overflow_safe on operations that may overflow */
+static Range eval_range(Analyzer *a, const Env *env, ASTExpr *expr) {
+    switch (expr->kind) {
+        case EXPR_INT_LITERAL:
+            return range_make(expr->data.int_lit.value, expr->data.int_lit.value);
+
+        case EXPR_BOOL_LITERAL:
+            return range_make(expr->data.bool_lit.value, expr->data.bool_lit.value);
+
+        case EXPR_VAR: {
+            const Binding *binding = env_lookup(env, expr->data.var.name);
+            return binding ? binding->range : range_of_type(expr->type);
+        }
+
+        case EXPR_NOT:
+            eval_range(a, env, expr->data.unary.operand);
+            return bool_range;
+
+        case EXPR_CALL:
+            for (size_t i = 0; i < expr->data.call.arg_count; i++) {
+                eval_range(a, env, expr->data.call.args[i]);
+            }
+            return range_of_type(expr->type);
+
+        case EXPR_AND:
+        case EXPR_OR: {
+            /* The right operand only runs when the left one did not decide */
+            eval_range(a, env, expr->data.binary.left);
+            Env right;
+            if (!env_copy(&right, env)) {
+                a->failed = true;
+                return bool_range;
+            }
+            if (refine(a, &right, expr->data.binary.left, expr->kind == EXPR_AND)) {
+                eval_range(a, &right, expr->data.binary.right);
+            }
+            free(right.bindings);
+            return bool_range;
+        }
+
+        case EXPR_SELECT: {
+            /* Each arm sees the condition's outcome; the result is their join */
+            eval_range(a, env, expr->data.select.condition);
+            Env arm;
+            if (!env_copy(&arm, env)) {
+                a->failed = true;
+                return range_of_type(expr->type);
+            }
+            Range result = range_of_type(expr->type);
+            bool reached = false;
+            if (refine(a, &arm, expr->data.select.condition, true)) {
+                result = eval_range(a, &arm, expr->data.select.then_expr);
+                reached = true;
+            }
+            env_assign(&arm, env);
+            if (refine(a, &arm, expr->data.select.condition, false)) {
+                Range other = eval_range(a, &arm, expr->data.select.else_expr);
+                result = reached ? range_join(result, other) : other;
+                reached = true;
+            }
+            free(arm.bindings);
+            return reached ? result : range_of_type(expr->type);
+        }
+
+        default:
+            break;
+    }
+
+    if (!ast_expr_is_binary(expr->kind)) return range_of_type(expr->type);
+
+    Range l = eval_range(a, env, expr->data.binary.left);
+    Range r = eval_range(a, env, expr->data.binary.right);
+    if (!is_checked_kind(expr->kind)) return range_of_type(expr->type);
+
+    Range exact;
+    bool safe;
+    switch (expr->kind) {
+        case EXPR_ADD:
+            exact = range_make(l.lo + r.lo, l.hi + r.hi);
+            safe = range_fits(exact);
+            break;
+        case EXPR_SUB:
+            exact = range_make(l.lo - r.hi, l.hi - r.lo);
+            safe = range_fits(exact);
+            break;
+        case EXPR_MUL:
+            exact = range_make(min4(l.lo * r.lo, l.lo * r.hi, l.hi * r.lo, l.hi * r.hi),
+                               max4(l.lo * r.lo, l.lo * r.hi, l.hi * r.lo, l.hi * r.hi));
+            safe = range_fits(exact);
+            break;
+        default:
+            /* Division and remainder trap on zero and on INT_MIN / -1 */
+            exact = expr->kind == EXPR_DIV ? range_div(l, r) : range_mod(l, r);
+            safe = !range_contains(r, 0) &&
+                   !(range_contains(l, INT32_MIN) && range_contains(r, -1));
+            break;
+    }
+
+    if (!safe) expr->overflow_safe = false;
+    return range_clip(exact);
+}
+
+static ExprKind mirror_comparison(ExprKind kind) {
+    switch (kind) {
+        case EXPR_LT: return EXPR_GT;
+        case EXPR_LE: return EXPR_GE;
+        case EXPR_GT: return EXPR_LT;
+        case EXPR_GE: return EXPR_LE;
+        default:      return kind;
+    }
+}
+
+static ExprKind negate_comparison(ExprKind kind) {
+    switch (kind) {
+        case EXPR_EQ: return EXPR_NE;
+        case EXPR_NE: return EXPR_EQ;
+        case EXPR_LT: return EXPR_GE;
+        case EXPR_LE: return EXPR_GT;
+        case EXPR_GT: return EXPR_LE;
+        default:      return EXPR_LT;
+    }
+}
+
+/* Narrow binding to the values satisfying `binding op other`; false if none */
+static bool refine_binding(Binding *binding, ExprKind op, Range other) {
+    Range *r = &binding->range;
+
+    switch (op) {
+        case EXPR_LT: if (other.hi - 1 < r->hi) r->hi = other.hi - 1; break;
+        case EXPR_LE: if (other.hi < r->hi) r->hi = other.hi; break;
+        case EXPR_GT: if (other.lo + 1 > r->lo) r->lo = other.lo + 1; break;
+        case EXPR_GE: if (other.lo > r->lo) r->lo = other.lo; break;
+        case EXPR_EQ:
+            if (other.lo > r->lo) r->lo = other.lo;
+            if (other.hi < r->hi) r->hi = other.hi;
+            break;
+        case EXPR_NE:
+            if (other.lo == other.hi) {
+                if (r->lo == other.lo) r->lo++;
+                if (r->hi == other.lo) r->hi--;
+            }
+            break;
+        default:
+            break;
+    }
+    return r->lo <= r->hi;
+}
+
+/*
+ * Narrow env to the states where cond evaluates to truth. Returns false
+ * when no state does (the guarded code is unreachable).
+ */
+static bool refine(Analyzer *a, Env *env, const ASTExpr *cond, bool truth) {
+    switch (cond->kind) {
+        case EXPR_BOOL_LITERAL:
+            return cond->data.bool_lit.value == truth;
+
+        case EXPR_VAR: {
+            Binding *binding = env_lookup(env, cond->data.var.name);
+            if (!binding) return true;
+            return refine_binding(binding, EXPR_EQ, range_make(truth, truth));
+        }
+
+        case EXPR_NOT:
+            return refine(a, env, cond->data.unary.operand, !truth);
+
+        case EXPR_AND:
+        case EXPR_OR:
+            /* Both operands are known when && holds or || fails */
+            if (truth == (cond->kind == EXPR_AND)) {
+                return refine(a, env, cond->data.binary.left, truth) &&
+                       refine(a, env, cond->data.binary.right, truth);
+            }
+            return true;
+
+        case EXPR_EQ: case EXPR_NE: case EXPR_LT:
+        case EXPR_LE: case EXPR_GT: case EXPR_GE: {
+            ExprKind op = truth ? cond->kind : negate_comparison(cond->kind);
+            const ASTExpr *left = cond->data.binary.left;
+            const ASTExpr *right = cond->data.binary.right;
+
+            /* Ranges are taken before either side is narrowed */
+            Range left_range = eval_range(a, env, (ASTExpr *)left);
+            Range right_range = eval_range(a, env, (ASTExpr *)right);
+
+            if (left->kind == EXPR_VAR) {
+                Binding *binding = env_lookup(env, left->data.var.name);
+                if (binding && !refine_binding(binding, op, right_range)) return false;
+            }
+            if (right->kind == EXPR_VAR) {
+                Binding *binding = env_lookup(env, right->data.var.name);
+                if (binding && !refine_binding(binding, mirror_comparison(op), left_range)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        default:
+            return true;
+    }
+}
+
+/* ==============================================================================
+ * Statements
+ * ==============================================================================
+ */
+
+static bool analyze_stmt(Analyzer *a, Env *env, ASTStmt *stmt);
+
+/* Analyze a block in its own scope; returns false when it cannot fall through */
+static bool analyze_block(Analyzer *a, Env *env, ASTStmt *block) {
+    size_t scope = env->count;
+    bool reachable = true;
+
+    for (size_t i = 0; i < block->data.block.stmt_count && !a->failed; i++) {
+        if (!analyze_stmt(a, env, block->data.block.statements[i])) {
+            reachable = false;
+            break;
+        }
+    }
+
+    env->count = scope;
+    return reachable;
+}
+
+static bool analyze_if(Analyzer *a, Env *env, ASTStmt *stmt) {
+    ASTExpr *cond = stmt->data.if_stmt.condition;
+    eval_range(a, env, cond);
+
+    Env other;
+    if (!env_copy(&other, env)) {
+        a->failed = true;
+        return true;
+    }
+
+    bool then_live = refine(a, env, cond, true) &&
+                     analyze_block(a, env, stmt->data.if_stmt.then_block);
+    bool else_live = refine(a, &other, cond, false) &&
+                     (!stmt->data.if_stmt.else_block ||
+                      analyze_block(a, &other, stmt->data.if_stmt.else_block));
+
+    if (then_live && else_live) {
+        env_join(env, &other);
+    } else if (else_live) {
+        env_assign(env, &other);
+    }
+
+    free(other.bindings);
+    return then_live || else_live;
+}
+
+static bool analyze_while(Analyzer *a, Env *env, ASTStmt *stmt) {
+    ASTExpr *cond = stmt->data.while_stmt.condition;
+
+    Env head, body, next;
+    if (!env_copy(&head, env) || !env_copy(&body, env) || !env_copy(&next, env)) {
+        a->failed = true;
+        return true;
+    }
+
+    /* Loop head = entry joined with the end of the body, to a fixpoint */
+    for (size_t round = 0; !a->failed; round++) {
+        env_assign(&body, &head);
+        eval_range(a, &body, cond);
+
+        env_assign(&next, env);
+        if (refine(a, &body, cond, true) &&
+            analyze_block(a, &body, stmt->data.while_stmt.body)) {
+            env_join(&next, &body);
+        }
+
+        if (round >= OPT_RANGE_WIDEN_AFTER) env_widen(&next, &head);
+        if (round >= OPT_RANGE_MAX_ROUNDS) {
+            for (size_t i = 0; i < next.count; i++) next.bindings[i].range = full_range;
+        }
+        if (env_equal(&next, &head)) break;
+        env_assign(&head, &next);
+    }
+
+    /* Without break, the loop is only left when the condition fails */
+    env_assign(env, &head);
+    bool exits = refine(a, env, cond, false);
+
+    free(head.bindings);
+    free(body.bindings);
+    free(next.bindings);
+    return exits;
+}
+
+static bool analyze_stmt(Analyzer *a, Env *env, ASTStmt *stmt) {
+    switch (stmt->kind) {
+        case STMT_VAR_DECL: {
+            Range range = eval_range(a, env, stmt->data.var_decl.init_expr);
+            if (!env_push(env, stmt->data.var_decl.name, range)) a->failed = true;
+            return true;
+        }
+
+        case STMT_ASSIGN: {
+            Range range = eval_range(a, env, stmt->data.assign.expr);
+            Binding *binding = env_lookup(env, stmt->data.assign.name);
+            if (binding) binding->range = range;
+            return true;
+        }
+
+        case STMT_IF:
+            return analyze_if(a, env, stmt);
+
+        case STMT_WHILE:
+            return analyze_while(a, env, stmt);
+
+        case STMT_RETURN:
+            if (stmt->data.return_stmt.expr) eval_range(a, env, stmt->data.return_stmt.expr);
+            return false;
+
+        case STMT_EXPR:
+            eval_range(a, env, stmt->data.expr_stmt.expr);
+            return true;
+
+        case STMT_BLOCK:
+            return analyze_block(a, env, stmt);
+    }
+    return true;
+}
+
+/* ==============================================================================
+ * Marking
+ * ==============================================================================
+ */
+
+typedef struct {
+    bool value;             /* Mark to set */
+    size_t checked;         /* Operations that overflow checks apply to */
+    size_t safe;            /* ...of which proven safe */
+} MarkWalk;
+
+static void mark_expr(MarkWalk *m, ASTExpr *expr, bool set) {
+    if (!expr) return;
+
+    if (ast_expr_is_binary(expr->kind)) {
+        mark_expr(m, expr->data.binary.left, set);
+        mark_expr(m, expr->data.binary.right, set);
+        if (is_checked_kind(expr->kind)) {
+            if (set) expr->overflow_safe = m->value;
+            m->checked++;
+            if (expr->overflow_safe) m->safe++;
+        }
+        return;
+    }
+
+    switch (expr->kind) {
+        case EXPR_NOT:
+            mark_expr(m, expr->data.unary.operand, set);
+            return;
+        case EXPR_CALL:
+            for (size_t i = 0; i < expr->data.call.arg_count; i++) {
+                mark_expr(m, expr->data.call.args[i], set);
+            }
+            return;
+        case EXPR_SELECT:
+            mark_expr(m, expr->data.select.condition, set);
+            mark_expr(m, expr->data.select.then_expr, set);
+            mark_expr(m, expr->data.select.else_expr, set);
+            return;
+        default:
+            return;
+    }
+}
+
+/* Set every checked operation to m->value (set) or count the marks */
+static void mark_stmt(MarkWalk *m, ASTStmt *stmt, bool set) {
+    if (!stmt) return;
+
+    switch (stmt->kind) {
+        case STMT_VAR_DECL:
+            mark_expr(m, stmt->data.var_decl.init_expr, set);
+            return;
+        case STMT_ASSIGN:
+            mark_expr(m, stmt->data.assign.expr, set);
+            return;
+        case STMT_IF:
+            mark_expr(m, stmt->data.if_stmt.condition, set);
+            mark_stmt(m, stmt->data.if_stmt.then_block, set);
+            mark_stmt(m, stmt->data.if_stmt.else_block, set);
+            return;
+        case STMT_WHILE:
+            mark_expr(m, stmt->data.while_stmt.condition, set);
+            mark_stmt(m, stmt->data.while_stmt.body, set);
+            return;
+        case STMT_RETURN:
+            mark_expr(m, stmt->data.return_stmt.expr, set);
+            return;
+        case STMT_EXPR:
+            mark_expr(m, stmt->data.expr_stmt.expr, set);
+            return;
+        case STMT_BLOCK:
+            for (size_t i = 0; i < stmt->data.block.stmt_count; i++) {
+                mark_stmt(m, stmt->data.block.statements[i], set);
+            }
+            return;
+    }
+}
+
+/* ==============================================================================
+ * Pass Driver
+ * ==============================================================================
+ */
+
+void optimize_range_analysis(ASTProgram *program, OptimizationStats *stats) {
+    if (!program) return;
+
+    for (size_t f = 0; f < program->func_count; f++) {
+        ASTFunc *func = program->functions[f];
+        Analyzer a = { .failed = false };
+        Env env = {0};
+
+        /* Start optimistic; the analysis clears operations that may overflow */
+        MarkWalk marks = { .value = true };
+        mark_stmt(&marks, func->body, true);
+
+        for (size_t i = 0; i < func->param_count && !a.failed; i++) {
+            if (!env_push(&env, func->params[i].name, range_of_type(func->params[i].type))) {
+                a.failed = true;
+            }
+        }
+        if (!a.failed) analyze_block(&a, &env, func->body);
+        free(env.bindings);
+
+        if (a.failed) {
+            marks.value = false;
+            mark_stmt(&marks, func->body, true);
+            break;
+        }
+
+        MarkWalk counts = { .value = false };
+        mark_stmt(&counts, func->body, false);
+        if (stats && counts.safe > 0) {
+            stats->overflow_checks_elided += counts.safe;
+            optimization_stats_remark(stats, "proved %zu of %zu arithmetic operation%s in '%s' "
+                                      "cannot overflow", counts.safe, counts.checked,
+                                      counts.checked == 1 ? "" : "s", func->name);
+        }
+    }
+}
@@ -0,0 +1,416 @@
+/**
+ * ==============================================================================
+ * TinyLLVM Compiler - Reassociation
+ * ==============================================================================
+ *
+ * Chains of + and - (and chains of *) are flattened into their operands,
+ * which are regrouped by rank before the tree is rebuilt:
+ *
+ *   (a + 3) + (b + 4) - 2    =>    (a + b) + 5
+ *   x * 4 * y * 2            =>    (x * y) * 8
+ *
+ * An operand's rank is the depth of the innermost enclosing loop that
+ * assigns one of its variables, so loop-invariant operands are grouped
+ * first (where LICM can hoist them) and constants last, folded into one.
+ * Both backends use 32-bit wrapping arithmetic, under which + and * are
+ * associative and commutative, so regrouping preserves results. A
+ * regrouped partial sum can overflow where no source operation did, so
+ * the rebuilt nodes are marked `wraps` and the C backend evaluates them
+ * in unsigned arithmetic rather than relying on signed overflow. With
+ * config->overflow_checks such a sum could trap instead, so the pass is
+ * disabled. Chains containing calls are left
+ * alone to keep their side effects in order.
+ */
+
+#include "include/tinyllvm_optimizer.h"
+#include <stdlib.h>
+
+/* ==============================================================================
+ * Operand Chains
+ * ==============================================================================
+ */
+
+typedef struct {
+    ASTExpr **slot;         /* Operand in the original tree */
+    bool negate;            /* Subtracted (sums only) */
+    size_t rank;
+} Operand;
+
+typedef struct {
+    ExprKind kind;          /* EXPR_ADD for +/- chains, EXPR_MUL for * chains */
+    Operand *operands;
+    size_t count;
+    size_t capacity;
+    int32_t constant;       /* Folded literal operands */
+    size_t constant_count;
+    bool failed;
+} Chain;
+
+static void chain_push(Chain *chain, ASTExpr **slot, bool negate) {
+    if (chain->count == chain->capacity) {
+        size_t capacity = chain->capacity ? chain->capacity * 2 : 8;
+        Operand *operands = realloc(chain->operands, capacity * sizeof(Operand));
+        if (!operands) {
+            chain->failed = true;
+            return;
+        }
+        chain->operands = operands;
+        chain->capacity = capacity;
+    }
+    chain->operands[chain->count].slot = slot;
+    chain->operands[chain->count].negate = negate;
+    chain->operands[chain->count].rank = 0;
+    chain->count++;
+}
+
+static bool in_chain(const Chain *chain, ExprKind kind) {
+    if (chain->kind == EXPR_ADD) return kind == EXPR_ADD || kind == EXPR_SUB;
+    return kind == EXPR_MUL;
+}
+
+static void chain_collect(Chain *chain, ASTExpr **slot, bool negate) {
+    ASTExpr *expr = *slot;
+
+    if (in_chain(chain, expr->kind)) {
+        chain_collect(chain, &expr->data.binary.left, negate);
+        chain_collect(chain, &expr->data.binary.right,
+                      expr->kind == EXPR_SUB ? !negate : negate);
+        return;
+    }
+
+    if (expr->kind == EXPR_INT_LITERAL) {
+        int32_t value = expr->data.int_lit.value;
+        if (chain->kind == EXPR_MUL) {
+            opt_evaluate_int(EXPR_MUL, chain->constant, value, &chain->constant);
+        } else {
+            opt_evaluate_int(negate ? EXPR_SUB : EXPR_ADD, chain->constant, value,
+                             &chain->constant);
+        }
+        chain->constant_count++;
+        return;
+    }
+
+    chain_push(chain, slot, negate);
+}
+
+/* ==============================================================================
+ * Ranking
+ * ==============================================================================
+ */
+
+typedef struct {
+    const ASTFunc *func;
+    const ASTStmt **loops;  /* Enclosing while loops, outermost first */
+    size_t loop_count;
+    size_t loop_capacity;
+    OptimizationStats *stats;
+    bool failed;
+} Reassociator;
+
+static size_t var_rank(const Reassociator *re, const char *name) {
+    for (size_t depth = re->loop_count; depth > 0; depth--) {
+        if (opt_stmt_writes_var(re->loops[depth - 1]->data.while_stmt.body, name)) {
+            return depth;
+        }
+    }
+    return 0;
+}
+
+static size_t expr_rank(const Reassociator *re, const ASTExpr *expr) {
+    size_t rank = 0, sub;
+
+    if (ast_expr_is_binary(expr->kind)) {
+        rank = expr_rank(re, expr->data.binary.left);
+        sub = expr_rank(re, expr->data.binary.right);
+        return sub > rank ? sub : rank;
+    }
+
+    switch (expr->kind) {
+        case EXPR_VAR:
+            return var_rank(re, expr->data.var.name);
+        case EXPR_NOT:
+            return expr_rank(re, expr->data.unary.operand);
+        case EXPR_CALL:
+            for (size_t i = 0; i < expr->data.call.arg_count; i++) {
+                sub = expr_rank(re, expr->data.call.args[i]);
+                if (sub > rank) rank = sub;
+            }
+            return rank;
+        case EXPR_SELECT:
+            rank = expr_rank(re, expr->data.select.condition);
+            sub = expr_rank(re, expr->data.select.then_expr);
+            if (sub > rank) rank = sub;
+            sub = expr_rank(re, expr->data.select.else_expr);
+            return sub > rank ? sub : rank;
+        default:
+            return 0;
+    }
+}
+
+/* ==============================================================================
+ * Rebuilding
+ * ==============================================================================
+ */
+
+static ASTExpr *wrapping_binary(ExprKind kind, ASTExpr *left, ASTExpr *right) {
+    ASTExpr *expr = ast_expr_binary(kind, left, right);
+    if (expr) expr->wraps = true;
+    return expr;
+}
+
+/* Combine acc (negated when *acc_negate) with operand into acc */
+static ASTExpr *combine(ExprKind kind, ASTExpr *acc, bool *acc_negate,
+                        ASTExpr *operand, bool negate) {
+    if (!acc) {
+        *acc_negate = negate;
+        return operand;
+    }
+    if (kind == EXPR_MUL) return wrapping_binary(EXPR_MUL, acc, operand);
+
+    if (*acc_negate == negate) return wrapping_binary(EXPR_ADD, acc, operand);
+    if (!*acc_negate) return wrapping_binary(EXPR_SUB, acc, operand);
+
+    *acc_negate = false;
+    return wrapping_binary(EXPR_SUB, operand, acc);
+}
+
+/* The regrouped chain, operands cloned; NULL on allocation failure */
+static ASTExpr *chain_build(const Chain *chain) {
+    ASTExpr *result = NULL;
+    bool result_negate = false;
+
+    /* Operands are sorted by rank; each rank forms a group */
+    size_t start = 0;
+    while (start < chain->count) {
+        size_t end = start;
+        while (end < chain->count && chain->operands[end].rank == chain->operands[start].rank) {
+            end++;
+        }
+
+        ASTExpr *group = NULL;
+        bool group_negate = false;
+        for (size_t i = start; i < end; i++) {
+            ASTExpr *operand = ast_expr_clone(*chain->operands[i].slot);
+            ASTExpr *next = operand ? combine(chain->kind, group, &group_negate, operand,
+                                              chain->operands[i].negate) : NULL;
+            if (!next) {
+                ast_expr_destroy(operand);
+                ast_expr_destroy(group);
+                ast_expr_destroy(result);
+                return NULL;
+            }
+            group = next;
+        }
+
+        ASTExpr *next = combine(chain->kind, result, &result_negate, group, group_negate);
+        if (!next) {
+            ast_expr_destroy(group);
+            ast_expr_destroy(result);
+            return NULL;
+        }
+        result = next;
+        start = end;
+    }
+
+    /* Constants last */
+    ASTExpr *next = result;
+    if (chain->kind == EXPR_MUL) {
+        if (chain->constant != 1) {
+            ASTExpr *literal = ast_expr_int_literal(chain->constant);
+            next = literal ? wrapping_binary(EXPR_MUL, result, literal) : NULL;
+            if (!next) ast_expr_destroy(literal);
+        }
+    } else if (result_negate) {
+        ASTExpr *literal = ast_expr_int_literal(chain->constant);
+        next = literal ? wrapping_binary(EXPR_SUB, literal, result) : NULL;
+        if (!next) ast_expr_destroy(literal);
+    } else if (chain->constant != 0) {
+        bool subtract = chain->constant < 0;
+        ASTExpr *literal = ast_expr_int_literal(subtract ? -chain->constant : chain->constant);
+        next = literal ? wrapping_binary(subtract ? EXPR_SUB : EXPR_ADD, result, literal) : NULL;
+        if (!next) ast_expr_destroy(literal);
+    }
+
+    if (!next) ast_expr_destroy(result);
+    return next;
+}
+
+/* Worth rebuilding: constants to fold, or invariant operands to group */
+static bool chain_profitable(const Chain *chain) {
+    if (chain->count == 0 || chain->constant == INT32_MIN) return false;
+    if (chain->constant_count >= 2) return true;
+
+    size_t max_rank = 0, below_max = 0;
+    bool sorted = true;
+    for (size_t i = 0; i < chain->count; i++) {
+        if (chain->operands[i].rank > max_rank) max_rank = chain->operands[i].rank;
+        if (i > 0 && chain->operands[i].rank < chain->operands[i - 1].rank) sorted = false;
+    }
+    for (size_t i = 0; i < chain->count; i++) {
+        if (chain->operands[i].rank < max_rank) below_max++;
+    }
+    return !sorted && below_max >= 2;
+}
+
+static void sort_by_rank(Chain *chain) {
+    for (size_t i = 1; i < chain->count; i++) {
+        Operand operand = chain->operands[i];
+        size_t j = i;
+        while (j > 0 && chain->operands[j - 1].rank > operand.rank) {
+            chain->operands[j] = chain->operands[j - 1];
+            j--;
+        }
+        chain->operands[j] = operand;
+    }
+}
+
+/* ==============================================================================
+ * Traversal
+ * ==============================================================================
+ */
+
+static void reassociate_expr(Reassociator *re, ASTExpr **slot);
+
+static void reassociate_chain(Reassociator *re, ASTExpr **slot, ExprKind kind) {
+    Chain chain = { .kind = kind, .constant = kind == EXPR_MUL ? 1 : 0 };
+    chain_collect(&chain, slot, false);
+    if (chain.failed) {
+        re->failed = true;
+        free(chain.operands);
+        return;
+    }
+
+    /* Operands first, so nested chains are already regrouped */
+    bool has_call = false;
+    for (size_t i = 0; i < chain.count; i++) {
+        reassociate_expr(re, chain.operands[i].slot);
+        if (opt_expr_has_call(*chain.operands[i].slot)) has_call = true;
+        chain.operands[i].rank = expr_rank(re, *chain.operands[i].slot);
+    }
+
+    if (has_call || !chain_profitable(&chain)) {
+        free(chain.operands);
+        return;
+    }
+
+    char before[64];
+    opt_expr_format(*slot, before, sizeof(before));
+
+    sort_by_rank(&chain);
+    ASTExpr *rebuilt = chain_build(&chain);
+    free(chain.operands);
+    if (!rebuilt) {
+        re->failed = true;
+        return;
+    }
+
+    ast_expr_destroy(*slot);
+    *slot = rebuilt;
+
+    if (re->stats) {
+        char after[64];
+        opt_expr_format(rebuilt, after, sizeof(after));
+        re->stats->expressions_reassociated++;
+        optimization_stats_remark(re->stats, "reassociated '%s' as '%s' in '%s'",
+                                  before, after, re->func->name);
+    }
+}
+
+static void reassociate_expr(Reassociator *re, ASTExpr **slot) {
+    ASTExpr *expr = *slot;
+    if (!expr || re->failed) return;
+
+    switch (expr->kind) {
+        case EXPR_ADD:
+        case EXPR_SUB:
+            reassociate_chain(re, slot, EXPR_ADD);
+            return;
+        case EXPR_MUL:
+            reassociate_chain(re, slot, EXPR_MUL);
+            return;
+        case EXPR_NOT:
+            reassociate_expr(re, &expr->data.unary.operand);
+            return;
+        case EXPR_CALL:
+            for (size_t i = 0; i < expr->data.call.arg_count; i++) {
+                reassociate_expr(re, &expr->data.call.args[i]);
+            }
+            return;
+        case EXPR_SELECT:
+            reassociate_expr(re, &expr->data.select.condition);
+            reassociate_expr(re, &expr->data.select.then_expr);
+            reassociate_expr(re, &expr->data.select.else_expr);
+            return;
+        default:
+            if (ast_expr_is_binary(expr->kind)) {
+                reassociate_expr(re, &expr->data.binary.left);
+                reassociate_expr(re, &expr->data.binary.right);
+            }
+            return;
+    }
+}
+
+static bool push_loop(Reassociator *re, const ASTStmt *loop) {
+    if (re->loop_count == re->loop_capacity) {
+        size_t capacity = re->loop_capacity ? re->loop_capacity * 2 : 8;
+        const ASTStmt **loops = realloc(re->loops, capacity * sizeof(ASTStmt *));
+        if (!loops) return false;
+        re->loops = loops;
+        re->loop_capacity = capacity;
+    }
+    re->loops[re->loop_count++] = loop;
+    return true;
+}
+
+static void reassociate_stmt(Reassociator *re, ASTStmt *stmt) {
+    if (!stmt || re->failed) return;
+
+    switch (stmt->kind) {
+        case STMT_VAR_DECL:
+            reassociate_expr(re, &stmt->data.var_decl.init_expr);
+            return;
+        case STMT_ASSIGN:
+            reassociate_expr(re, &stmt->data.assign.expr);
+            return;
+        case STMT_IF:
+            reassociate_expr(re, &stmt->data.if_stmt.condition);
+            reassociate_stmt(re, stmt->data.if_stmt.then_block);
+            reassociate_stmt(re, stmt->data.if_stmt.else_block);
+            return;
+        case STMT_WHILE:
+            if (!push_loop(re, stmt)) {
+                re->failed = true;
+                return;
+            }
+            reassociate_expr(re, &stmt->data.while_stmt.condition);
+            reassociate_stmt(re, stmt->data.while_stmt.body);
+            re->loop_count--;
+            return;
+        case STMT_RETURN:
+            reassociate_expr(re, &stmt->data.return_stmt.expr);
+            return;
+        case STMT_EXPR:
+            reassociate_expr(re, &stmt->data.expr_stmt.expr);
+            return;
+        case STMT_BLOCK:
+            for (size_t i = 0; i < stmt->data.block.stmt_count; i++) {
+                reassociate_stmt(re, stmt->data.block.statements[i]);
+            }
+            return;
+    }
+}
+
+void optimize_reassociation(ASTProgram *program, const CompilerConfig *config,
+                            OptimizationStats *stats) {
+    if (!program || !config || config->overflow_checks) return;
+
+    Reassociator re = { .stats = stats };
+
+    for (size_t i = 0; i < program->func_count && !re.failed; i++) {
+        re.func = program->functions[i];
+        re.loop_count = 0;
+        reassociate_stmt(&re, program->functions[i]->body);
+    }
+
+    free(re.loops);
+}
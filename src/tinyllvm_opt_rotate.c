@@ -0,0 +1,77 @@
+/**
+ * ==============================================================================
+ * TinyLLVM Compiler - Loop Rotation
+ * ==============================================================================
+ *
+ * A while loop tests its condition at the top and jumps back from the end
+ * of the body, two branches per iteration. Rotation turns it into a guarded
+ * do-while with the test at the bottom:
+ *
+ *   while (i < n) {            if (i < n) {
+ *       body           =>          do { body } while (i < n);
+ *   }                          }
+ *
+ * so each iteration takes one conditional branch. The condition is
+ * evaluated at the same points as before, so conditions with calls are
+ * fine, but it is emitted twice, which limits rotation to conditions of at
+ * most OPT_ROTATE_MAX_COND_NODES AST nodes. Loops are only marked here
+ * (WhileStmt.rotated); the C and IR backends emit the rotated shape.
+ */
+
+#include "include/tinyllvm_optimizer.h"
+
+typedef struct {
+    const ASTFunc *func;
+    OptimizationStats *stats;
+} Rotator;
+
+static void rotate_loop(Rotator *rot, ASTStmt *loop) {
+    const ASTExpr *condition = loop->data.while_stmt.condition;
+
+    /* A literal condition leaves nothing to guard */
+    if (condition->kind == EXPR_BOOL_LITERAL) return;
+    if (ast_expr_node_count(condition) > OPT_ROTATE_MAX_COND_NODES) return;
+
+    loop->data.while_stmt.rotated = true;
+
+    if (rot->stats) {
+        char text[64];
+        opt_expr_format(condition, text, sizeof(text));
+        rot->stats->loops_rotated++;
+        optimization_stats_remark(rot->stats, "rotated loop on '%s' in '%s'",
+                                  text, rot->func->name);
+    }
+}
+
+static void rotate_stmt(Rotator *rot, ASTStmt *stmt) {
+    if (!stmt) return;
+
+    switch (stmt->kind) {
+        case STMT_IF:
+            rotate_stmt(rot, stmt->data.if_stmt.then_block);
+            rotate_stmt(rot, stmt->data.if_stmt.else_block);
+            return;
+        case STMT_WHILE:
+            rotate_stmt(rot, stmt->data.while_stmt.body);
+            if (!stmt->data.while_stmt.rotated) rotate_loop(rot, stmt);
+            return;
+        case STMT_BLOCK:
+            for (size_t i = 0; i < stmt->data.block.stmt_count; i++) {
+                rotate_stmt(rot, stmt->data.block.statements[i]);
+            }
+            return;
+        default:
+            return;
+    }
+}
+
+void optimize_loop_rotation(ASTProgram *program, OptimizationStats *stats) {
+    if (!program) return;
+
+    Rotator rot = { .func = NULL, .stats = stats };
+
+    for (size_t i = 0; i < program->func_count; i++) {
+        rot.func = program->functions[i];
+        rotate_stmt(&rot, program->functions[i]->body);
+    }
+}
@@ -0,0 +1,394 @@
+/**
+ * ==============================================================================
+ * TinyLLVM Compiler - Function Specialization
+ * ==============================================================================
+ *
+ * Clones functions for call sites that pass literal arguments, binding the
+ * constant parameters at the top of the clone and dropping them from its
+ * parameter list:
+ *
+ *   power(2, n)    =>    power_spec0(n)
+ *
+ *   func power_spec0(e: int) : int {
+ *       var b = 2;
+ *       ...original body of power...
+ *   }
+ *
+ * Constant propagation and folding then simplify the clone. Call sites
+ * with the same constants share a clone, so recursive calls that keep
+ * passing the constant (`power(b, e - 1)` becomes `power(2, e - 1)` after
+ * propagation) are redirected to the clone in the next round. The number
+ * of clones is limited by config->specialize_budget and large functions
+ * are never cloned.
+ */
+
+#include "include/tinyllvm_optimizer.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    const char *callee;     /* Borrowed: functions outlive the pass */
+    char *clone;
+    size_t param_count;
+    bool *constant;         /* Per parameter: bound in the clone */
+    int32_t *values;        /* Booleans are 0 or 1 */
+} Specialization;
+
+typedef struct {
+    ASTProgram *program;
+    const OptCallGraph *graph;
+    OptNameSet names;
+    Specialization *specs;
+    size_t spec_count;
+    size_t budget;          /* Clones that may still be created */
+    size_t rewritten;       /* Call sites redirected in this round */
+    const ASTFunc *caller;
+    OptimizationStats *stats;
+    bool failed;
+} Specializer;
+
+static bool is_literal(const ASTExpr *expr) {
+    return expr->kind == EXPR_INT_LITERAL || expr->kind == EXPR_BOOL_LITERAL;
+}
+
+static int32_t literal_value(const ASTExpr *expr) {
+    if (expr->kind == EXPR_BOOL_LITERAL) return expr->data.bool_lit.value ? 1 : 0;
+    return expr->data.int_lit.value;
+}
+
+static void spec_free(Specialization *spec) {
+    free(spec->clone);
+    free(spec->constant);
+    free(spec->values);
+}
+
+static bool spec_matches(const Specialization *spec, const ASTExpr *call) {
+    if (strcmp(spec->callee, call->data.call.func_name) != 0 ||
+        spec->param_count != call->data.call.arg_count) {
+        return false;
+    }
+
+    for (size_t i = 0; i < spec->param_count; i++) {
+        const ASTExpr *arg = call->data.call.args[i];
+        if (spec->constant[i] != is_literal(arg)) return false;
+        if (spec->constant[i] && spec->values[i] != literal_value(arg)) return false;
+    }
+    return true;
+}
+
+/* ==============================================================================
+ * Cloning
+ * ==============================================================================
+ */
+
+static bool body_redeclares_bound(const ASTStmt *body, const ASTExpr *call,
+                                  const ASTFunc *func) {
+    for (size_t i = 0; i < body->data.block.stmt_count; i++) {
+        const ASTStmt *stmt = body->data.block.statements[i];
+        if (stmt->kind != STMT_VAR_DECL) continue;
+
+        for (size_t j = 0; j < func->param_count; j++) {
+            if (is_literal(call->data.call.args[j]) &&
+                strcmp(stmt->data.var_decl.name, func->params[j].name) == 0) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/* Clone callee with the literal arguments of call bound as local variables */
+static ASTFunc *build_clone(const ASTFunc *callee, const ASTExpr *call, const char *name) {
+    ASTFunc *clone = opt_func_clone(callee, name);
+    if (!clone) return NULL;
+
+    OptStmtVec bindings = {0};
+    for (size_t i = 0; i < clone->param_count; i++) {
+        const ASTExpr *arg = call->data.call.args[i];
+        if (!is_literal(arg)) continue;
+
+        ASTExpr *value = ast_expr_clone(arg);
+        ASTStmt *decl = value ? ast_stmt_var_decl(clone->params[i].name,
+                                                  clone->params[i].type, value) : NULL;
+        if (!decl) ast_expr_destroy(value);
+        if (!opt_stmt_vec_push(&bindings, decl)) {
+            opt_stmt_vec_destroy(&bindings);
+            ast_func_destroy(clone);
+            return NULL;
+        }
+    }
+
+    /* The body's top-level declarations may shadow parameters; bind the
+     * constants in an enclosing block then, { bindings; { body } } */
+    bool ok;
+    if (body_redeclares_bound(clone->body, call, clone)) {
+        ASTStmt *inner = clone->body;
+        ASTStmt *body = NULL;
+        clone->body = NULL;
+        if (opt_stmt_vec_push(&bindings, inner)) {
+            body = ast_stmt_block(bindings.items, bindings.count);
+        }
+        clone->body = body;
+        ok = body != NULL;
+    } else {
+        ok = opt_block_insert(clone->body, 0, bindings.items, bindings.count);
+        if (ok) free(bindings.items);
+    }
+
+    if (!ok) {
+        opt_stmt_vec_destroy(&bindings);
+        ast_func_destroy(clone);
+        return NULL;
+    }
+
+    /* Drop the bound parameters, keeping the rest in order */
+    size_t kept = 0;
+    for (size_t i = 0; i < clone->param_count; i++) {
+        if (is_literal(call->data.call.args[i])) {
+            free(clone->params[i].name);
+        } else {
+            clone->params[kept++] = clone->params[i];
+        }
+    }
+    clone->param_count = kept;
+    return clone;
+}
+
+static Specialization *create_specialization(Specializer *sp, const ASTExpr *call,
+                                             const ASTFunc *callee) {
+    size_t count = call->data.call.arg_count;
+
+    Specialization *specs = realloc(sp->specs, (sp->spec_count + 1) * sizeof(Specialization));
+    if (!specs) return NULL;
+    sp->specs = specs;
+
+    Specialization *spec = &specs[sp->spec_count];
+    spec->callee = callee->name;
+    spec->param_count = count;
+    spec->clone = opt_fresh_name(&sp->names, callee->name, "spec");
+    spec->constant = calloc(count, sizeof(bool));
+    spec->values = calloc(count, sizeof(int32_t));
+
+    ASTFunc *clone = NULL;
+    if (spec->clone && spec->constant && spec->values) {
+        clone = build_clone(callee, call, spec->clone);
+    }
+
+    /* Appended, so the indices of the current call graph stay valid */
+    if (!clone || !opt_program_insert_function(sp->program, sp->program->func_count, clone)) {
+        ast_func_destroy(clone);
+        spec_free(spec);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        spec->constant[i] = is_literal(call->data.call.args[i]);
+        if (spec->constant[i]) spec->values[i] = literal_value(call->data.call.args[i]);
+    }
+
+    sp->spec_count++;
+    sp->budget--;
+
+    if (sp->stats) {
+        char text[64];
+        opt_expr_format(call, text, sizeof(text));
+        sp->stats->functions_specialized++;
+        optimization_stats_remark(sp->stats, "specialized '%s' as '%s' for '%s' in '%s'",
+                                  callee->name, spec->clone, text, sp->caller->name);
+    }
+    return spec;
+}
+
+/* ==============================================================================
+ * Call Site Rewriting
+ * ==============================================================================
+ */
+
+static bool worth_specializing(const Specializer *sp, const ASTExpr *call, size_t index) {
+    const ASTFunc *callee = sp->program->functions[index];
+
+    if (strcmp(callee->name, "main") == 0) return false;
+    if (callee->param_count != call->data.call.arg_count) return false;
+    if (ast_stmt_node_count(callee->body) > OPT_SPECIALIZE_MAX_NODES) return false;
+
+    size_t constants = 0;
+    for (size_t i = 0; i < call->data.call.arg_count; i++) {
+        if (is_literal(call->data.call.args[i])) constants++;
+    }
+    if (constants == 0) return false;
+
+    /* Pure calls with only constants are compile-time evaluation's job;
+     * reaching here means evaluation gave up, and a clone would not help */
+    if (constants == call->data.call.arg_count && sp->graph->pure[index]) {
+        return false;
+    }
+    return true;
+}
+
+/* Redirect call to the clone, dropping its literal arguments */
+static bool redirect_call(ASTExpr **slot, const Specialization *spec) {
+    ASTExpr *call = *slot;
+    size_t kept = 0;
+    for (size_t i = 0; i < spec->param_count; i++) {
+        if (!spec->constant[i]) kept++;
+    }
+
+    ASTExpr **args = NULL;
+    if (kept > 0) {
+        args = malloc(kept * sizeof(ASTExpr *));
+        if (!args) return false;
+    }
+
+    ASTExpr *redirected = ast_expr_call(spec->clone, args, kept);
+    if (!redirected) {
+        free(args);
+        return false;
+    }
+    redirected->type = call->type;
+
+    size_t next = 0;
+    for (size_t i = 0; i < spec->param_count; i++) {
+        if (spec->constant[i]) continue;
+        args[next++] = call->data.call.args[i];
+        call->data.call.args[i] = NULL;
+    }
+
+    ast_expr_destroy(call);
+    *slot = redirected;
+    return true;
+}
+
+static void specialize_call(Specializer *sp, ASTExpr **slot) {
+    ASTExpr *call = *slot;
+
+    for (size_t i = 0; i < sp->spec_count; i++) {
+        if (spec_matches(&sp->specs[i], call)) {
+            if (redirect_call(slot, &sp->specs[i])) sp->rewritten++;
+            else sp->failed = true;
+            return;
+        }
+    }
+
+    if (sp->budget == 0) return;
+
+    /* Clones appended in this round are not in the call graph yet */
+    size_t index = opt_find_function(sp->program, call->data.call.func_name);
+    if (index == OPT_NOT_FOUND || index >= sp->graph->func_count) return;
+    if (!worth_specializing(sp, call, index)) return;
+
+    Specialization *spec = create_specialization(sp, call, sp->program->functions[index]);
+    if (!spec) {
+        sp->failed = true;
+        return;
+    }
+    if (redirect_call(slot, spec)) sp->rewritten++;
+    else sp->failed = true;
+}
+
+static void specialize_expr(Specializer *sp, ASTExpr **slot) {
+    ASTExpr *expr = *slot;
+    if (!expr || sp->failed) return;
+
+    if (ast_expr_is_binary(expr->kind)) {
+        specialize_expr(sp, &expr->data.binary.left);
+        specialize_expr(sp, &expr->data.binary.right);
+        return;
+    }
+
+    switch (expr->kind) {
+        case EXPR_NOT:
+            specialize_expr(sp, &expr->data.unary.operand);
+            return;
+
+        case EXPR_CALL:
+            for (size_t i = 0; i < expr->data.call.arg_count; i++) {
+                specialize_expr(sp, &expr->data.call.args[i]);
+            }
+            specialize_call(sp, slot);
+            return;
+
+        default:
+            return;
+    }
+}
+
+static void specialize_stmt(Specializer *sp, ASTStmt *stmt) {
+    if (!stmt || sp->failed) return;
+
+    switch (stmt->kind) {
+        case STMT_VAR_DECL:
+            specialize_expr(sp, &stmt->data.var_decl.init_expr);
+            return;
+        case STMT_ASSIGN:
+            specialize_expr(sp, &stmt->data.assign.expr);
+            return;
+        case STMT_IF:
+            specialize_expr(sp, &stmt->data.if_stmt.condition);
+            specialize_stmt(sp, stmt->data.if_stmt.then_block);
+            specialize_stmt(sp, stmt->data.if_stmt.else_block);
+            return;
+        case STMT_WHILE:
+            specialize_expr(sp, &stmt->data.while_stmt.condition);
+            specialize_stmt(sp, stmt->data.while_stmt.body);
+            return;
+        case STMT_RETURN:
+            specialize_expr(sp, &stmt->data.return_stmt.expr);
+            return;
+        case STMT_EXPR:
+            specialize_expr(sp, &stmt->data.expr_stmt.expr);
+            return;
+        case STMT_BLOCK:
+            for (size_t i = 0; i < stmt->data.block.stmt_count; i++) {
+                specialize_stmt(sp, stmt->data.block.statements[i]);
+            }
+            return;
+    }
+}
+
+/* One sweep over every function; returns whether any call was redirected */
+static bool specialize_round(Specializer *sp) {
+    OptCallGraph graph;
+    if (!opt_call_graph_build(&graph, sp->program)) return false;
+    sp->graph = &graph;
+    sp->rewritten = 0;
+
+    /* Functions are inserted while iterating; each is visited exactly once */
+    for (size_t i = 0; i < sp->program->func_count && !sp->failed; i++) {
+        sp->caller = sp->program->functions[i];
+        specialize_stmt(sp, sp->program->functions[i]->body);
+    }
+
+    sp->graph = NULL;
+    opt_call_graph_free(&graph);
+    return sp->rewritten > 0 && !sp->failed;
+}
+
+void optimize_function_specialization(ASTProgram *program, const CompilerConfig *config,
+                                      OptimizationStats *stats) {
+    if (!program || !config) return;
+
+    Specializer sp = {
+        .program = program,
+        .budget = config->specialize_budget ? config->specialize_budget :
+                                              OPT_DEFAULT_SPECIALIZE_BUDGET,
+        .stats = stats
+    };
+
+    if (!opt_name_set_init(&sp.names) || !opt_name_set_add_program(&sp.names, program)) {
+        opt_name_set_free(&sp.names);
+        return;
+    }
+
+    /* Propagate the bound constants so the next round sees the literal
+     * arguments of recursive calls; every round redirects at least one call
+     * and the number of clones is bounded, so this terminates */
+    size_t rounds = 0;
+    while (specialize_round(&sp) && rounds++ < OPT_SPECIALIZE_MAX_ROUNDS) {
+        optimize_constant_propagation(program, config, stats);
+        optimize_constant_folding(program, config, stats);
+    }
+
+    for (size_t i = 0; i < sp.spec_count; i++) spec_free(&sp.specs[i]);
+    free(sp.specs);
+    opt_name_set_free(&sp.names);
+}
@@ -0,0 +1,572 @@
+/**
+ * ==============================================================================
+ * TinyLLVM Compiler - Strength Reduction
+ * ==============================================================================
+ *
+ * Replaces expensive integer arithmetic with cheaper operations:
+ *
+ *   - induction variables: when the only write to i in a while loop is a
+ *     top-level `i = i + S;`, every `i * C` in the loop reads a variable
+ *     initialized to `i * C` before the loop and advanced by S * C right
+ *     after the update
+ *   - multiplication by a constant becomes a shift (x * 8 => x << 3) or two
+ *     shifts and an add or subtract (x * 10 => (x << 3) + (x << 1))
+ *   - signed division and modulo by a constant become a multiply-high and
+ *     shifts, corrected to round toward zero like the division they replace
+ *
+ * The arithmetic rewrites produce the lowered operators (EXPR_SHL, EXPR_SHR,
+ * EXPR_USHR, EXPR_MULHI), which wrap like the 32-bit IR instructions. They
+ * are only applied for the IR and native targets (including the JIT); C
+ * compilers perform the same lowering themselves.
+ */
+
+#include "include/tinyllvm_optimizer.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define MAX_INDUCTION_FACTORS 8     /* Distinct `i * C` products per counter */
+
+/* ==============================================================================
+ * Pass State
+ * ==============================================================================
+ */
+
+typedef struct {
+    OptimizationStats *stats;
+    OptNameSet names;
+    const ASTFunc *func;
+    bool lower_arithmetic;      /* Emit shifts and multiply-high */
+    bool failed;
+} Reducer;
+
+typedef bool (*SlotVisitor)(Reducer *r, ASTExpr **slot, void *data);
+
+static bool visit_expr(Reducer *r, ASTExpr **slot, SlotVisitor visit, void *data) {
+    ASTExpr *expr = *slot;
+    if (!expr) return true;
+
+    /* Children first so rewritten operands are seen by their parent */
+    if (ast_expr_is_binary(expr->kind)) {
+        if (!visit_expr(r, &expr->data.binary.left, visit, data)) return false;
+        if (!visit_expr(r, &expr->data.binary.right, visit, data)) return false;
+    } else if (expr->kind == EXPR_NOT) {
+        if (!visit_expr(r, &expr->data.unary.operand, visit, data)) return false;
+    } else if (expr->kind == EXPR_CALL) {
+        for (size_t i = 0; i < expr->data.call.arg_count; i++) {
+            if (!visit_expr(r, &expr->data.call.args[i], visit, data)) return false;
+        }
+    }
+    return visit(r, slot, data);
+}
+
+static bool visit_stmt(Reducer *r, ASTStmt *stmt, SlotVisitor visit, void *data) {
+    if (!stmt) return true;
+
+    switch (stmt->kind) {
+        case STMT_VAR_DECL:
+            return visit_expr(r, &stmt->data.var_decl.init_expr, visit, data);
+        case STMT_ASSIGN:
+            return visit_expr(r, &stmt->data.assign.expr, visit, data);
+        case STMT_IF:
+            return visit_expr(r, &stmt->data.if_stmt.condition, visit, data) &&
+                   visit_stmt(r, stmt->data.if_stmt.then_block, visit, data) &&
+                   visit_stmt(r, stmt->data.if_stmt.else_block, visit, data);
+        case STMT_WHILE:
+            return visit_expr(r, &stmt->data.while_stmt.condition, visit, data) &&
+                   visit_stmt(r, stmt->data.while_stmt.body, visit, data);
+        case STMT_RETURN:
+            return visit_expr(r, &stmt->data.return_stmt.expr, visit, data);
+        case STMT_EXPR:
+            return visit_expr(r, &stmt->data.expr_stmt.expr, visit, data);
+        case STMT_BLOCK:
+            for (size_t i = 0; i < stmt->data.block.stmt_count; i++) {
+                if (!visit_stmt(r, stmt->data.block.statements[i], visit, data)) return false;
+            }
+            return true;
+    }
+    return true;
+}
+
+static void record(Reducer *r, const char *text) {
+    if (!r->stats) return;
+    r->stats->strength_reductions++;
+    optimization_stats_remark(r->stats, "strength-reduced '%s' in '%s'",
+                              text, r->func->name);
+}
+
+/* ==============================================================================
+ * Induction Variables
+ * ==============================================================================
+ */
+
+/* `var * C` or `C * var` with C >= 2; stores C */
+static bool match_product(const ASTExpr *expr, const char *var, long long *factor) {
+    if (expr->kind != EXPR_MUL) return false;
+
+    const ASTExpr *left = expr->data.binary.left;
+    const ASTExpr *right = expr->data.binary.right;
+
+    if (left->kind == EXPR_INT_LITERAL) {
+        const ASTExpr *tmp = left;
+        left = right;
+        right = tmp;
+    }
+    if (left->kind != EXPR_VAR || strcmp(left->data.var.name, var) != 0) return false;
+    if (right->kind != EXPR_INT_LITERAL || right->data.int_lit.value < 2) return false;
+
+    *factor = right->data.int_lit.value;
+    return true;
+}
+
+/* `i = i + S` or `i = i - S` with a literal S; stores the signed step */
+static bool match_increment(const ASTStmt *stmt, const char **var, long long *step) {
+    if (stmt->kind != STMT_ASSIGN) return false;
+
+    const char *name = stmt->data.assign.name;
+    const ASTExpr *expr = stmt->data.assign.expr;
+    if (expr->kind != EXPR_ADD && expr->kind != EXPR_SUB) return false;
+
+    const ASTExpr *left = expr->data.binary.left;
+    const ASTExpr *right = expr->data.binary.right;
+
+    if (expr->kind == EXPR_ADD && left->kind == EXPR_INT_LITERAL) {
+        const ASTExpr *tmp = left;
+        left = right;
+        right = tmp;
+    }
+    if (left->kind != EXPR_VAR || strcmp(left->data.var.name, name) != 0) return false;
+    if (right->kind != EXPR_INT_LITERAL) return false;
+
+    *var = name;
+    *step = right->data.int_lit.value;
+    if (expr->kind == EXPR_SUB) *step = -*step;
+    return true;
+}
+
+typedef struct {
+    const char *var;
+    long long factors[MAX_INDUCTION_FACTORS];
+    size_t count;
+} FactorSet;
+
+static bool collect_factor(Reducer *r, ASTExpr **slot, void *data) {
+    (void)r;
+    FactorSet *set = data;
+
+    long long factor;
+    if (!match_product(*slot, set->var, &factor)) return true;
+
+    for (size_t i = 0; i < set->count; i++) {
+        if (set->factors[i] == factor) return true;
+    }
+    if (set->count < MAX_INDUCTION_FACTORS) {
+        set->factors[set->count++] = factor;
+    }
+    return true;
+}
+
+typedef struct {
+    const char *var;
+    long long factor;
+    const char *temp;
+} ProductUse;
+
+static bool replace_product(Reducer *r, ASTExpr **slot, void *data) {
+    ProductUse *use = data;
+
+    long long factor;
+    if (!match_product(*slot, use->var, &factor) || factor != use->factor) return true;
+
+    ASTExpr *var = opt_make_var(use->temp, type_int());
+    if (!var) {
+        r->failed = true;
+        return false;
+    }
+    ast_expr_destroy(*slot);
+    *slot = var;
+    return true;
+}
+
+/* `temp = temp + |delta|` or `temp = temp - |delta|` */
+static ASTStmt *make_advance(const char *temp, long long delta) {
+    ExprKind kind = delta < 0 ? EXPR_SUB : EXPR_ADD;
+    ASTExpr *left = opt_make_var(temp, type_int());
+    ASTExpr *right = ast_expr_int_literal((int)(delta < 0 ? -delta : delta));
+    ASTExpr *sum = (left && right) ? ast_expr_binary(kind, left, right) : NULL;
+
+    if (!sum) {
+        ast_expr_destroy(left);
+        ast_expr_destroy(right);
+        return NULL;
+    }
+
+    ASTStmt *stmt = ast_stmt_assign(temp, sum);
+    if (!stmt) ast_expr_destroy(sum);
+    return stmt;
+}
+
+/* `var temp = var * factor;` */
+static ASTStmt *make_initializer(const char *temp, const char *var, long long factor) {
+    ASTExpr *left = opt_make_var(var, type_int());
+    ASTExpr *right = ast_expr_int_literal((int)factor);
+    ASTExpr *product = (left && right) ? ast_expr_binary(EXPR_MUL, left, right) : NULL;
+
+    if (!product) {
+        ast_expr_destroy(left);
+        ast_expr_destroy(right);
+        return NULL;
+    }
+
+    ASTStmt *stmt = ast_stmt_var_decl(temp, type_int(), product);
+    if (!stmt) ast_expr_destroy(product);
+    return stmt;
+}
+
+/* The counter is written by body[update] and nowhere else in the loop */
+static bool sole_update(const ASTStmt *body, size_t update, const char *var) {
+    for (size_t j = 0; j < body->data.block.stmt_count; j++) {
+        if (j != update && opt_stmt_writes_var(body->data.block.statements[j], var)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Reduce products of one counter; returns the number of statements inserted before the loop */
+static size_t reduce_counter(Reducer *r, ASTStmt *block, size_t index, size_t update,
+                             const char *var, long long step) {
+    ASTStmt *loop = block->data.block.statements[index];
+    ASTStmt *body = loop->data.while_stmt.body;
+
+    FactorSet set = { .var = var, .count = 0 };
+    if (!visit_expr(r, &loop->data.while_stmt.condition, collect_factor, &set) ||
+        !visit_stmt(r, body, collect_factor, &set)) {
+        return 0;
+    }
+
+    size_t inserted = 0;
+    for (size_t f = 0; f < set.count && !r->failed; f++) {
+        long long factor = set.factors[f];
+        long long delta = step * factor;
+        if (delta == 0 || delta > INT32_MAX || delta < -INT32_MAX) continue;
+
+        char *temp = opt_fresh_name(&r->names, var, "iv");
+        if (!temp) {
+            r->failed = true;
+            break;
+        }
+
+        ASTStmt *init = make_initializer(temp, var, factor);
+        ASTStmt *advance = make_advance(temp, delta);
+        if (!init || !advance ||
+            !opt_block_insert(body, update + 1 + inserted, &advance, 1)) {
+            if (init) ast_stmt_destroy(init);
+            if (advance) ast_stmt_destroy(advance);
+            free(temp);
+            r->failed = true;
+            break;
+        }
+
+        /* The advance statement only reads the new variable, so no product is lost */
+        ProductUse use = { .var = var, .factor = factor, .temp = temp };
+        visit_expr(r, &loop->data.while_stmt.condition, replace_product, &use);
+        visit_stmt(r, body, replace_product, &use);
+
+        if (!opt_block_insert(block, index, &init, 1)) {
+            ast_stmt_destroy(init);
+            free(temp);
+            r->failed = true;
+            break;
+        }
+        index++;
+        inserted++;
+
+        if (r->stats) {
+            r->stats->strength_reductions++;
+            optimization_stats_remark(r->stats,
+                                      "replaced '%s * %lld' with induction variable '%s' in '%s'",
+                                      var, factor, temp, r->func->name);
+        }
+        free(temp);
+    }
+    return inserted;
+}
+
+static void reduce_block(Reducer *r, ASTStmt *block);
+
+/* Reduce the loop at block[index]; returns the number of statements inserted */
+static size_t reduce_loop(Reducer *r, ASTStmt *block, size_t index) {
+    ASTStmt *loop = block->data.block.statements[index];
+    ASTStmt *body = loop->data.while_stmt.body;
+
+    reduce_block(r, body);
+    if (r->failed || body->kind != STMT_BLOCK) return 0;
+
+    size_t inserted = 0;
+    for (size_t j = 0; j < body->data.block.stmt_count && !r->failed; j++) {
+        const char *var;
+        long long step;
+        if (!match_increment(body->data.block.statements[j], &var, &step)) continue;
+        if (!sole_update(body, j, var)) continue;
+
+        size_t added = reduce_counter(r, block, index + inserted, j, var, step);
+        inserted += added;
+        j += added;     /* Advance statements follow the update */
+    }
+    return inserted;
+}
+
+static void reduce_block(Reducer *r, ASTStmt *block) {
+    for (size_t i = 0; i < block->data.block.stmt_count && !r->failed; i++) {
+        ASTStmt *stmt = block->data.block.statements[i];
+
+        switch (stmt->kind) {
+            case STMT_WHILE:
+                i += reduce_loop(r, block, i);
+                break;
+            case STMT_IF:
+                reduce_block(r, stmt->data.if_stmt.then_block);
+                if (stmt->data.if_stmt.else_block) {
+                    reduce_block(r, stmt->data.if_stmt.else_block);
+                }
+                break;
+            case STMT_BLOCK:
+                reduce_block(r, stmt);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+/* ==============================================================================
+ * Arithmetic Lowering
+ * ==============================================================================
+ */
+
+static bool is_power_of_two(uint32_t value) {
+    return value != 0 && (value & (value - 1)) == 0;
+}
+
+static int log2_exact(uint32_t value) {
+    int shift = 0;
+    while (value > 1) {
+        value >>= 1;
+        shift++;
+    }
+    return shift;
+}
+
+/* Build kind(left, right), destroying both operands on failure */
+static ASTExpr *make_binary(ExprKind kind, ASTExpr *left, ASTExpr *right) {
+    ASTExpr *expr = (left && right) ? ast_expr_binary(kind, left, right) : NULL;
+    if (!expr) {
+        ast_expr_destroy(left);
+        ast_expr_destroy(right);
+    }
+    return expr;
+}
+
+static ASTExpr *make_shift(ExprKind kind, ASTExpr *value, int amount) {
+    if (amount == 0) return value;
+    return make_binary(kind, value, ast_expr_int_literal(amount));
+}
+
+/* Operands that may be evaluated more than once */
+static bool duplicable(const ASTExpr *expr) {
+    return expr->kind == EXPR_VAR || expr->kind == EXPR_INT_LITERAL;
+}
+
+/**
+ * x * C for C = 2^a, 2^a + 2^b or 2^a - 2^b; NULL when C has no cheap
+ * form or on allocation failure (*failed tells them apart).
+ */
+static ASTExpr *lower_multiply(const ASTExpr *x, uint32_t c, bool *failed) {
+    if (is_power_of_two(c)) {
+        ASTExpr *copy = ast_expr_clone(x);
+        ASTExpr *result = copy ? make_shift(EXPR_SHL, copy, log2_exact(c)) : NULL;
+        if (!result) *failed = true;
+        return result;
+    }
+    if (!duplicable(x)) return NULL;
+
+    uint32_t low = c & -c;
+    ExprKind combine;
+    int high_shift;
+
+    if (is_power_of_two(c - low)) {
+        combine = EXPR_ADD;             /* 2^a + 2^b */
+        high_shift = log2_exact(c - low);
+    } else if (is_power_of_two(c + low)) {
+        combine = EXPR_SUB;             /* 2^a - 2^b */
+        high_shift = log2_exact(c + low);
+    } else {
+        return NULL;
+    }
+
+    ASTExpr *high = make_shift(EXPR_SHL, ast_expr_clone(x), high_shift);
+    ASTExpr *rest = make_shift(EXPR_SHL, ast_expr_clone(x), log2_exact(low));
+    ASTExpr *result = make_binary(combine, high, rest);
+    if (!result) *failed = true;
+    return result;
+}
+
+/**
+ * Magic multiplier and shift for signed division by d >= 2
+ * (Hacker's Delight, section 10-4).
+ */
+static void division_magic(uint32_t d, int32_t *multiplier, int *shift) {
+    const uint32_t two31 = 0x80000000u;
+    uint32_t anc = two31 - 1 - two31 % d;
+    uint32_t q1 = two31 / anc, r1 = two31 - q1 * anc;
+    uint32_t q2 = two31 / d, r2 = two31 - q2 * d;
+    uint32_t delta;
+    int p = 31;
+
+    do {
+        p++;
+        q1 *= 2;
+        r1 *= 2;
+        if (r1 >= anc) {
+            q1++;
+            r1 -= anc;
+        }
+        q2 *= 2;
+        r2 *= 2;
+        if (r2 >= d) {
+            q2++;
+            r2 -= d;
+        }
+        delta = d - r2;
+    } while (q1 < delta || (q1 == delta && r1 == 0));
+
+    *multiplier = (int32_t)(q2 + 1);
+    *shift = p - 32;
+}
+
+/* x / d for a duplicable x and d >= 2, rounding toward zero */
+static ASTExpr *lower_divide(const ASTExpr *x, uint32_t d) {
+    if (is_power_of_two(d)) {
+        /* (x + (negative ? d - 1 : 0)) >> k */
+        int k = log2_exact(d);
+        ASTExpr *bias = (k == 1) ?
+            make_shift(EXPR_USHR, ast_expr_clone(x), 31) :
+            make_shift(EXPR_USHR, make_shift(EXPR_SHR, ast_expr_clone(x), 31), 32 - k);
+        return make_shift(EXPR_SHR, make_binary(EXPR_ADD, ast_expr_clone(x), bias), k);
+    }
+
+    int32_t multiplier;
+    int shift;
+    division_magic(d, &multiplier, &shift);
+
+    /* q = mulhi(x, M) [+ x]; q = q >> s; q = q + (x >>> 31) */
+    ASTExpr *q = make_binary(EXPR_MULHI, ast_expr_clone(x), ast_expr_int_literal(multiplier));
+    if (multiplier < 0) {
+        q = make_binary(EXPR_ADD, q, ast_expr_clone(x));
+    }
+    q = make_shift(EXPR_SHR, q, shift);
+    return make_binary(EXPR_ADD, q, make_shift(EXPR_USHR, ast_expr_clone(x), 31));
+}
+
+/* x % d = x - (x / d) * d */
+static ASTExpr *lower_modulo(const ASTExpr *x, uint32_t d) {
+    ASTExpr *quotient = lower_divide(x, d);
+    ASTExpr *product = is_power_of_two(d) ?
+        make_shift(EXPR_SHL, quotient, log2_exact(d)) :
+        make_binary(EXPR_MUL, quotient, ast_expr_int_literal((int)d));
+    return make_binary(EXPR_SUB, ast_expr_clone(x), product);
+}
+
+static bool lower_arithmetic(Reducer *r, ASTExpr **slot, void *data) {
+    (void)data;
+    ASTExpr *expr = *slot;
+    ASTExpr *left, *right;
+    ASTExpr *result = NULL;
+    bool failed = false;
+
+    switch (expr->kind) {
+        case EXPR_MUL:
+            left = expr->data.binary.left;
+            right = expr->data.binary.right;
+            if (left->kind == EXPR_INT_LITERAL) {
+                ASTExpr *tmp = left;
+                left = right;
+                right = tmp;
+            }
+            if (right->kind != EXPR_INT_LITERAL || left->kind == EXPR_INT_LITERAL ||
+                right->data.int_lit.value < 2) {
+                return true;
+            }
+            result = lower_multiply(left, (uint32_t)right->data.int_lit.value, &failed);
+            break;
+
+        case EXPR_DIV:
+        case EXPR_MOD:
+            left = expr->data.binary.left;
+            right = expr->data.binary.right;
+            if (left->kind != EXPR_VAR || right->kind != EXPR_INT_LITERAL ||
+                right->data.int_lit.value < 2) {
+                return true;
+            }
+            result = (expr->kind == EXPR_DIV) ?
+                lower_divide(left, (uint32_t)right->data.int_lit.value) :
+                lower_modulo(left, (uint32_t)right->data.int_lit.value);
+            failed = (result == NULL);
+            break;
+
+        default:
+            return true;
+    }
+
+    if (failed) {
+        r->failed = true;
+        return false;
+    }
+    if (!result) return true;
+
+    char text[128];
+    opt_expr_format(expr, text, sizeof(text));
+    record(r, text);
+
+    ast_expr_destroy(expr);
+    *slot = result;
+    return true;
+}
+
+/* ==============================================================================
+ * Pass Driver
+ * ==============================================================================
+ */
+
+void optimize_strength_reduction(ASTProgram *program, const CompilerConfig *config,
+                                 OptimizationStats *stats) {
+    if (!program) return;
+
+    Reducer r = {
+        .stats = stats,
+        .func = NULL,
+        .lower_arithmetic = config && (config->target == TARGET_TINYLLVM ||
+                                       config->target == TARGET_ASM_X86_64 ||
+                                       config->target == TARGET_ELF_X86_64 || config->jit),
+        .failed = false
+    };
+
+    /* Induction variables run one step ahead of the loop, which a checked
+     * build could trap on */
+    bool reduce_inductions = !(config && config->overflow_checks);
+
+    if (!opt_name_set_init(&r.names)) return;
+
+    if (opt_name_set_add_program(&r.names, program)) {
+        for (size_t i = 0; i < program->func_count && !r.failed; i++) {
+            r.func = program->functions[i];
+            if (reduce_inductions) reduce_block(&r, r.func->body);
+            if (r.lower_arithmetic && !r.failed) {
+                visit_stmt(&r, r.func->body, lower_arithmetic, NULL);
+            }
+        }
+    }
+
+    opt_name_set_free(&r.names);
+}
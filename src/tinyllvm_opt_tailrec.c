@@ -0,0 +1,456 @@
+/**
+ * ==============================================================================
+ * TinyLLVM Compiler - Tail Recursion Elimination
+ * ==============================================================================
+ *
+ * Turns self-recursive functions whose recursive calls are all in tail
+ * position into loops:
+ *
+ *   func gcd(a: int, b: int) : int {        int ret = 0; bool again = true;
+ *       if (b == 0) { return a; }     =>    while (again) {
+ *       return gcd(b, a % b);                   again = false;
+ *   }                                           ... a = b; b = next; again = true;
+ *                                           }
+ *                                           return ret;
+ *
+ * Accumulator introduction: when recursive returns have the form
+ * `e * f(...)` (or `e + f(...)`), the pending operations are folded into an
+ * accumulator so the call becomes a tail call, and base-case returns yield
+ * `acc * value`. Integer + and * are associative and commutative under
+ * wrapping arithmetic, so the result is unchanged. With overflow checks the
+ * regrouped partial results could trap where the original ones did not, so
+ * only plain tail calls are converted.
+ */
+
+#include "include/tinyllvm_optimizer.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* ==============================================================================
+ * Analysis
+ * ==============================================================================
+ */
+
+typedef struct {
+    const ASTFunc *func;
+    size_t self_calls;      /* Every call to the function in its body */
+    size_t tail_calls;      /* Calls in a recognised tail position */
+    ExprKind acc_op;        /* EXPR_ADD or EXPR_MUL when accumulating */
+    bool allow_accumulator;
+    bool accumulates;
+    bool valid;
+} TailAnalysis;
+
+static bool is_self_call(const TailAnalysis *ta, const ASTExpr *expr) {
+    return expr->kind == EXPR_CALL &&
+           strcmp(expr->data.call.func_name, ta->func->name) == 0;
+}
+
+static size_t count_self_calls(const TailAnalysis *ta, const ASTExpr *expr) {
+    if (!expr) return 0;
+
+    if (ast_expr_is_binary(expr->kind)) {
+        return count_self_calls(ta, expr->data.binary.left) +
+               count_self_calls(ta, expr->data.binary.right);
+    }
+
+    switch (expr->kind) {
+        case EXPR_NOT:
+            return count_self_calls(ta, expr->data.unary.operand);
+        case EXPR_CALL: {
+            size_t count = is_self_call(ta, expr) ? 1 : 0;
+            for (size_t i = 0; i < expr->data.call.arg_count; i++) {
+                count += count_self_calls(ta, expr->data.call.args[i]);
+            }
+            return count;
+        }
+        default:
+            return 0;
+    }
+}
+
+/*
+ * For `e op f(...)` or `f(...) op e`, return the recursive call and store
+ * the other operand; NULL if the expression does not have that shape.
+ */
+static ASTExpr *accumulator_call(const TailAnalysis *ta, ASTExpr *expr, ASTExpr **operand) {
+    if (!ta->allow_accumulator) return NULL;
+    if (expr->kind != EXPR_ADD && expr->kind != EXPR_MUL) return NULL;
+
+    ASTExpr *left = expr->data.binary.left;
+    ASTExpr *right = expr->data.binary.right;
+
+    /* The operand is evaluated before the call after the rewrite */
+    if (is_self_call(ta, right) && !opt_expr_has_call(left)) {
+        *operand = left;
+        return right;
+    }
+    if (is_self_call(ta, left) && !opt_expr_has_call(right)) {
+        *operand = right;
+        return left;
+    }
+    return NULL;
+}
+
+static void analyze_returns(TailAnalysis *ta, const ASTStmt *stmt) {
+    if (!stmt) return;
+
+    switch (stmt->kind) {
+        case STMT_VAR_DECL:
+            ta->self_calls += count_self_calls(ta, stmt->data.var_decl.init_expr);
+            break;
+        case STMT_ASSIGN:
+            ta->self_calls += count_self_calls(ta, stmt->data.assign.expr);
+            break;
+        case STMT_EXPR:
+            ta->self_calls += count_self_calls(ta, stmt->data.expr_stmt.expr);
+            break;
+        case STMT_IF:
+            ta->self_calls += count_self_calls(ta, stmt->data.if_stmt.condition);
+            analyze_returns(ta, stmt->data.if_stmt.then_block);
+            analyze_returns(ta, stmt->data.if_stmt.else_block);
+            break;
+        case STMT_WHILE:
+            ta->self_calls += count_self_calls(ta, stmt->data.while_stmt.condition);
+            analyze_returns(ta, stmt->data.while_stmt.body);
+            break;
+        case STMT_BLOCK:
+            for (size_t i = 0; i < stmt->data.block.stmt_count; i++) {
+                analyze_returns(ta, stmt->data.block.statements[i]);
+            }
+            break;
+        case STMT_RETURN: {
+            ASTExpr *expr = stmt->data.return_stmt.expr;
+            if (!expr) break;
+
+            ta->self_calls += count_self_calls(ta, expr);
+
+            ASTExpr *operand = NULL;
+            if (is_self_call(ta, expr)) {
+                ta->tail_calls++;
+            } else if (accumulator_call(ta, expr, &operand)) {
+                if (ta->accumulates && ta->acc_op != expr->kind) ta->valid = false;
+                ta->accumulates = true;
+                ta->acc_op = expr->kind;
+                ta->tail_calls++;
+            }
+            break;
+        }
+    }
+}
+
+static bool declares_name(const ASTStmt *stmt, const char *name) {
+    if (!stmt) return false;
+
+    switch (stmt->kind) {
+        case STMT_VAR_DECL:
+            return strcmp(stmt->data.var_decl.name, name) == 0;
+        case STMT_IF:
+            return declares_name(stmt->data.if_stmt.then_block, name) ||
+                   declares_name(stmt->data.if_stmt.else_block, name);
+        case STMT_WHILE:
+            return declares_name(stmt->data.while_stmt.body, name);
+        case STMT_BLOCK:
+            for (size_t i = 0; i < stmt->data.block.stmt_count; i++) {
+                if (declares_name(stmt->data.block.statements[i], name)) return true;
+            }
+            return false;
+        default:
+            return false;
+    }
+}
+
+/* ==============================================================================
+ * Rewriting
+ * ==============================================================================
+ */
+
+typedef struct {
+    const TailAnalysis *analysis;
+    OptNameSet *names;
+    const char *result;
+    const char *again;
+    const char *acc;
+} TailRewrite;
+
+static ASTExpr *make_acc_op(const TailRewrite *tr, ASTExpr *value) {
+    ASTExpr *acc = opt_make_var(tr->acc, type_int());
+    ASTExpr *expr = acc ? ast_expr_binary(tr->analysis->acc_op, acc, value) : NULL;
+    if (!expr) {
+        ast_expr_destroy(acc);
+        ast_expr_destroy(value);
+    }
+    return expr;
+}
+
+/* Reassign the parameters from the call's arguments (consumes call) */
+static bool rebind_params(TailRewrite *tr, ASTExpr *call, OptStmtVec *out) {
+    const ASTFunc *func = tr->analysis->func;
+    size_t count = func->param_count;
+    bool ok = true;
+
+    bool any_call = false;
+    for (size_t i = 0; i < count; i++) {
+        if (opt_expr_has_call(call->data.call.args[i])) any_call = true;
+    }
+
+    bool *identity = calloc(count ? count : 1, sizeof(bool));
+    char **temps = calloc(count ? count : 1, sizeof(char *));
+    if (!identity || !temps) ok = false;
+
+    for (size_t i = 0; ok && i < count; i++) {
+        const ASTExpr *arg = call->data.call.args[i];
+        identity[i] = arg->kind == EXPR_VAR &&
+                      strcmp(arg->data.var.name, func->params[i].name) == 0;
+    }
+
+    /* Arguments that read an earlier-assigned parameter are computed first */
+    for (size_t i = 0; ok && i < count; i++) {
+        if (identity[i]) continue;
+
+        bool needs_temp = any_call;
+        for (size_t j = 0; !needs_temp && j < i; j++) {
+            if (!identity[j] &&
+                opt_expr_count_var(call->data.call.args[i], func->params[j].name) > 0) {
+                needs_temp = true;
+            }
+        }
+        if (!needs_temp) continue;
+
+        temps[i] = opt_fresh_name(tr->names, func->params[i].name, "next");
+        if (!temps[i] ||
+            !opt_stmt_vec_push(out, ast_stmt_var_decl(temps[i], func->params[i].type,
+                                                      call->data.call.args[i]))) {
+            ok = false;
+            break;
+        }
+        call->data.call.args[i] = NULL;
+    }
+
+    for (size_t i = 0; ok && i < count; i++) {
+        if (identity[i]) continue;
+
+        ASTExpr *value = temps[i] ? opt_make_var(temps[i], func->params[i].type)
+                                  : call->data.call.args[i];
+        if (!temps[i]) call->data.call.args[i] = NULL;
+
+        ASTStmt *assign = value ? ast_stmt_assign(func->params[i].name, value) : NULL;
+        if (!assign) ast_expr_destroy(value);
+        ok = opt_stmt_vec_push(out, assign);
+    }
+
+    ok = ok && opt_stmt_vec_push(out, ast_stmt_assign(tr->again, ast_expr_bool_literal(true)));
+
+    for (size_t i = 0; temps && i < count; i++) free(temps[i]);
+    free(temps);
+    free(identity);
+    ast_expr_destroy(call);
+    return ok;
+}
+
+static bool lower_tail_return(OptReturnLowering *rl, ASTExpr *value, OptStmtVec *out) {
+    TailRewrite *tr = (TailRewrite *)rl->user_data;
+    if (!value) return true;
+
+    if (is_self_call(tr->analysis, value)) {
+        return rebind_params(tr, value, out);
+    }
+
+    ASTExpr *operand = NULL;
+    ASTExpr *call = accumulator_call(tr->analysis, value, &operand);
+    if (call) {
+        /* acc = acc op e; then continue with the call's arguments */
+        value->data.binary.left = NULL;
+        value->data.binary.right = NULL;
+        ast_expr_destroy(value);
+
+        ASTExpr *update = make_acc_op(tr, operand);
+        ASTStmt *assign = update ? ast_stmt_assign(tr->acc, update) : NULL;
+        if (!assign) {
+            ast_expr_destroy(update);
+            ast_expr_destroy(call);
+            return false;
+        }
+        if (!opt_stmt_vec_push(out, assign)) {
+            ast_expr_destroy(call);
+            return false;
+        }
+        return rebind_params(tr, call, out);
+    }
+
+    /* Base case */
+    if (tr->acc) {
+        value = make_acc_op(tr, value);
+        if (!value) return false;
+    }
+
+    ASTStmt *assign = ast_stmt_assign(tr->result, value);
+    if (!assign) {
+        ast_expr_destroy(value);
+        return false;
+    }
+    return opt_stmt_vec_push(out, assign);
+}
+
+static ASTStmt *make_flag_reset(const char *name, bool value) {
+    ASTExpr *literal = ast_expr_bool_literal(value);
+    ASTStmt *stmt = literal ? ast_stmt_assign(name, literal) : NULL;
+    if (!stmt) ast_expr_destroy(literal);
+    return stmt;
+}
+
+static bool eliminate_tail_recursion(ASTFunc *func, const TailAnalysis *ta, OptNameSet *names) {
+    char *result = opt_fresh_name(names, func->name, "ret");
+    char *again = opt_fresh_name(names, func->name, "again");
+    char *done = opt_fresh_name(names, func->name, "done");
+    char *acc = ta->accumulates ? opt_fresh_name(names, func->name, "acc") : NULL;
+
+    OptStmtVec prologue = {0};
+    OptStmtVec loop = {0};
+    ASTStmt *body = NULL;
+    bool ok = false;
+
+    if (!result || !again || !done || (ta->accumulates && !acc)) goto cleanup;
+
+    body = ast_stmt_clone(func->body);
+    if (!body) goto cleanup;
+
+    /* Locals shadowing a parameter would capture the reassignments */
+    for (size_t i = 0; i < func->param_count; i++) {
+        if (!declares_name(body, func->params[i].name)) continue;
+
+        OptRenameMap map = {0};
+        bool renamed = opt_freshen_locals(body, &map, names, "tr");
+        opt_rename_map_free(&map);
+        if (!renamed) goto cleanup;
+        break;
+    }
+
+    TailRewrite tr = {
+        .analysis = ta,
+        .names = names,
+        .result = result,
+        .again = again,
+        .acc = acc
+    };
+    OptReturnLowering rl = {
+        .done = done,
+        .lower_return = lower_tail_return,
+        .user_data = &tr,
+        .done_used = false,
+        .failed = false
+    };
+    opt_lower_returns(&rl, body);
+    if (rl.failed) goto cleanup;
+
+    if (!rl.done_used) {
+        opt_remove_assignments(body, done);
+    }
+
+    /* var ret = 0; [var acc = identity;] var again = true; [var done = false;] */
+    if (!opt_stmt_vec_push(&prologue, ast_stmt_var_decl(result, func->return_type,
+                                                        opt_make_default_value(func->return_type)))) {
+        goto cleanup;
+    }
+    if (acc && !opt_stmt_vec_push(&prologue, ast_stmt_var_decl(acc, type_int(),
+                                  ast_expr_int_literal(ta->acc_op == EXPR_MUL ? 1 : 0)))) {
+        goto cleanup;
+    }
+    if (!opt_stmt_vec_push(&prologue, ast_stmt_var_decl(again, type_bool(),
+                                                        ast_expr_bool_literal(true)))) {
+        goto cleanup;
+    }
+    if (rl.done_used &&
+        !opt_stmt_vec_push(&prologue, ast_stmt_var_decl(done, type_bool(),
+                                                        ast_expr_bool_literal(false)))) {
+        goto cleanup;
+    }
+
+    /* while (again) { again = false; [done = false;] body } */
+    if (!opt_stmt_vec_push(&loop, make_flag_reset(again, false))) goto cleanup;
+    if (rl.done_used && !opt_stmt_vec_push(&loop, make_flag_reset(done, false))) goto cleanup;
+    if (!opt_block_insert(body, 0, loop.items, loop.count)) goto cleanup;
+    free(loop.items);
+    loop.items = NULL;
+    loop.count = 0;
+
+    ASTExpr *cond = opt_make_var(again, type_bool());
+    ASTStmt *while_stmt = cond ? ast_stmt_while(cond, body) : NULL;
+    if (!while_stmt) {
+        ast_expr_destroy(cond);
+        goto cleanup;
+    }
+    body = NULL;
+
+    if (!opt_stmt_vec_push(&prologue, while_stmt)) goto cleanup;
+    if (!opt_stmt_vec_push(&prologue, ast_stmt_return(opt_make_var(result, func->return_type)))) {
+        goto cleanup;
+    }
+
+    ASTStmt *new_body = ast_stmt_block(prologue.items, prologue.count);
+    if (!new_body) goto cleanup;
+    prologue.items = NULL;
+    prologue.count = 0;
+
+    ast_stmt_destroy(func->body);
+    func->body = new_body;
+    ok = true;
+
+cleanup:
+    opt_stmt_vec_destroy(&prologue);
+    opt_stmt_vec_destroy(&loop);
+    ast_stmt_destroy(body);
+    free(result);
+    free(again);
+    free(done);
+    free(acc);
+    return ok;
+}
+
+/* ==============================================================================
+ * Pass Driver
+ * ==============================================================================
+ */
+
+void optimize_tail_recursion(ASTProgram *program, const CompilerConfig *config,
+                             OptimizationStats *stats) {
+    if (!program) return;
+
+    OptNameSet names;
+    if (!opt_name_set_init(&names)) return;
+    if (!opt_name_set_add_program(&names, program)) {
+        opt_name_set_free(&names);
+        return;
+    }
+
+    for (size_t i = 0; i < program->func_count; i++) {
+        ASTFunc *func = program->functions[i];
+
+        TailAnalysis ta = {
+            .func = func,
+            .self_calls = 0,
+            .tail_calls = 0,
+            .acc_op = EXPR_ADD,
+            .allow_accumulator = !(config && config->overflow_checks),
+            .accumulates = false,
+            .valid = true
+        };
+        analyze_returns(&ta, func->body);
+
+        /* Every self call must be rewritable and the body must not fall off the end */
+        if (!ta.valid || ta.tail_calls == 0 || ta.tail_calls != ta.self_calls) continue;
+        if (!opt_stmt_always_returns(func->body)) continue;
+
+        if (!eliminate_tail_recursion(func, &ta, &names)) continue;
+
+        if (stats) {
+            stats->tail_calls_eliminated += ta.tail_calls;
+            optimization_stats_remark(stats, ta.accumulates ?
+                                      "converted recursion in '%s' into a loop with an accumulator" :
+                                      "converted tail recursion in '%s' into a loop",
+                                      func->name);
+        }
+    }
+
+    opt_name_set_free(&names);
+}
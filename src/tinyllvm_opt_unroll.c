@@ -0,0 +1,424 @@
+/**
+ * ==============================================================================
+ * TinyLLVM Compiler - Loop Unrolling
+ * ==============================================================================
+ *
+ * Recognizes counted loops with constant bounds:
+ *
+ *   var i = C1;                     (or i = C1; nothing in between writes i)
+ *   while (i < C2) {                (<, <=, > or >=, either operand order)
+ *       ...                         (no other writes to i)
+ *       i = i + C3;                 (or i = i - C3)
+ *   }
+ *
+ * Loops of at most unroll_threshold iterations are fully unrolled: each
+ * copy of the body sees i as a constant, exposing folding, and i receives
+ * its final value afterwards. Longer loops are unrolled by unroll_factor:
+ * copy k reads i + k*C3, a single update advances i by factor*C3, and the
+ * original loop runs the remaining iterations.
+ *
+ * Each copy gets fresh names for its locals so copies can share a scope.
+ */
+
+#include "include/tinyllvm_optimizer.h"
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+typedef struct {
+    const char *var;
+    ExprKind cmp;           /* Comparison with the variable on the left */
+    long long start;
+    long long bound;
+    long long step;
+    long long trip;         /* Iterations executed */
+} CountedLoop;
+
+typedef struct {
+    OptimizationStats *stats;
+    OptNameSet names;
+    const ASTFunc *func;
+    size_t threshold;
+    size_t factor;
+    bool failed;
+} Unroller;
+
+/* ==============================================================================
+ * Recognition
+ * ==============================================================================
+ */
+
+static bool is_var(const ASTExpr *expr, const char *name) {
+    return expr->kind == EXPR_VAR && (!name || strcmp(expr->data.var.name, name) == 0);
+}
+
+static ExprKind mirror_comparison(ExprKind kind) {
+    switch (kind) {
+        case EXPR_LT: return EXPR_GT;
+        case EXPR_LE: return EXPR_GE;
+        case EXPR_GT: return EXPR_LT;
+        case EXPR_GE: return EXPR_LE;
+        default:      return kind;
+    }
+}
+
+/* `i = i + C`, `i = C + i` or `i = i - C`; returns false otherwise */
+static bool match_increment(const ASTStmt *stmt, const char *var, long long *step) {
+    if (stmt->kind != STMT_ASSIGN || strcmp(stmt->data.assign.name, var) != 0) return false;
+
+    const ASTExpr *expr = stmt->data.assign.expr;
+    if (expr->kind != EXPR_ADD && expr->kind != EXPR_SUB) return false;
+
+    const ASTExpr *left = expr->data.binary.left;
+    const ASTExpr *right = expr->data.binary.right;
+
+    if (is_var(left, var) && right->kind == EXPR_INT_LITERAL) {
+        *step = right->data.int_lit.value;
+        if (expr->kind == EXPR_SUB) *step = -*step;
+        return true;
+    }
+    if (expr->kind == EXPR_ADD && is_var(right, var) && left->kind == EXPR_INT_LITERAL) {
+        *step = left->data.int_lit.value;
+        return true;
+    }
+    return false;
+}
+
+/* Constant initial value assigned to var before block[index] */
+static bool find_start(const ASTStmt *block, size_t index, const char *var, long long *start) {
+    for (size_t j = index; j > 0; j--) {
+        const ASTStmt *stmt = block->data.block.statements[j - 1];
+        const ASTExpr *value = NULL;
+
+        if (stmt->kind == STMT_VAR_DECL && strcmp(stmt->data.var_decl.name, var) == 0) {
+            value = stmt->data.var_decl.init_expr;
+        } else if (stmt->kind == STMT_ASSIGN && strcmp(stmt->data.assign.name, var) == 0) {
+            value = stmt->data.assign.expr;
+        } else if (opt_stmt_writes_var(stmt, var)) {
+            return false;
+        } else {
+            continue;
+        }
+
+        if (value->kind != EXPR_INT_LITERAL) return false;
+        *start = value->data.int_lit.value;
+        return true;
+    }
+    return false;
+}
+
+static long long trip_count(const CountedLoop *loop) {
+    long long distance;
+
+    switch (loop->cmp) {
+        case EXPR_LT:
+            if (loop->start >= loop->bound) return 0;
+            distance = loop->bound - loop->start;
+            return (distance + loop->step - 1) / loop->step;
+        case EXPR_LE:
+            if (loop->start > loop->bound) return 0;
+            return (loop->bound - loop->start) / loop->step + 1;
+        case EXPR_GT:
+            if (loop->start <= loop->bound) return 0;
+            distance = loop->start - loop->bound;
+            return (distance - loop->step - 1) / -loop->step;
+        case EXPR_GE:
+            if (loop->start < loop->bound) return 0;
+            return (loop->start - loop->bound) / -loop->step + 1;
+        default:
+            return -1;
+    }
+}
+
+static bool recognize_loop(const ASTStmt *block, size_t index, CountedLoop *loop) {
+    const ASTStmt *stmt = block->data.block.statements[index];
+    const ASTExpr *cond = stmt->data.while_stmt.condition;
+    const ASTStmt *body = stmt->data.while_stmt.body;
+
+    if (cond->kind < EXPR_LT || cond->kind > EXPR_GE) return false;
+
+    const ASTExpr *left = cond->data.binary.left;
+    const ASTExpr *right = cond->data.binary.right;
+
+    if (is_var(left, NULL) && right->kind == EXPR_INT_LITERAL) {
+        loop->var = left->data.var.name;
+        loop->cmp = cond->kind;
+        loop->bound = right->data.int_lit.value;
+    } else if (is_var(right, NULL) && left->kind == EXPR_INT_LITERAL) {
+        loop->var = right->data.var.name;
+        loop->cmp = mirror_comparison(cond->kind);
+        loop->bound = left->data.int_lit.value;
+    } else {
+        return false;
+    }
+
+    size_t count = body->data.block.stmt_count;
+    if (count == 0 || !match_increment(body->data.block.statements[count - 1],
+                                       loop->var, &loop->step)) {
+        return false;
+    }
+
+    /* The increment must be the only write, and every iteration must reach it */
+    for (size_t i = 0; i + 1 < count; i++) {
+        const ASTStmt *child = body->data.block.statements[i];
+        if (opt_stmt_writes_var(child, loop->var) || opt_stmt_always_returns(child)) {
+            return false;
+        }
+    }
+
+    bool ascending = loop->cmp == EXPR_LT || loop->cmp == EXPR_LE;
+    if (loop->step == 0 || (ascending != (loop->step > 0))) return false;
+
+    if (!find_start(block, index, loop->var, &loop->start)) return false;
+
+    loop->trip = trip_count(loop);
+    if (loop->trip < 0) return false;
+
+    /* The original loop must not overflow i */
+    long long last = loop->start + loop->trip * loop->step;
+    return last >= INT_MIN && last <= INT_MAX;
+}
+
+/* ==============================================================================
+ * Rewriting
+ * ==============================================================================
+ */
+
+/* var + offset, written with a positive literal */
+static ASTExpr *make_offset(const char *var, long long offset) {
+    ASTExpr *base = opt_make_var(var, type_int());
+    if (!base || offset == 0) return base;
+
+    ASTExpr *amount = ast_expr_int_literal((int)(offset < 0 ? -offset : offset));
+    ASTExpr *expr = amount ? ast_expr_binary(offset < 0 ? EXPR_SUB : EXPR_ADD, base, amount)
+                           : NULL;
+    if (!expr) {
+        ast_expr_destroy(base);
+        ast_expr_destroy(amount);
+    }
+    return expr;
+}
+
+/* Append a copy of the body (without its increment) reading i as value */
+static bool append_copy(Unroller *un, const ASTStmt *body, const CountedLoop *loop,
+                        const ASTExpr *value, OptStmtVec *out) {
+    ASTStmt *copy = ast_stmt_clone(body);
+    if (!copy) return false;
+
+    /* Drop the increment */
+    copy->data.block.stmt_count--;
+    ast_stmt_destroy(copy->data.block.statements[copy->data.block.stmt_count]);
+
+    OptRenameMap map = {0};
+    bool ok = opt_freshen_locals(copy, &map, &un->names, "u") &&
+              opt_stmt_substitute_var(copy, loop->var, value);
+    opt_rename_map_free(&map);
+
+    size_t count = copy->data.block.stmt_count;
+    size_t moved = 0;
+    for (; ok && moved < count; moved++) {
+        ok = opt_stmt_vec_push(out, copy->data.block.statements[moved]);
+    }
+
+    /* Statements not moved (on failure) are destroyed with the copy */
+    if (moved > 0) {
+        memmove(copy->data.block.statements, copy->data.block.statements + moved,
+                (count - moved) * sizeof(ASTStmt *));
+        copy->data.block.stmt_count = ok ? 0 : count - moved;
+    }
+    ast_stmt_destroy(copy);
+    return ok;
+}
+
+static bool build_full_unroll(Unroller *un, const ASTStmt *body, const CountedLoop *loop,
+                              OptStmtVec *out) {
+    for (long long k = 0; k < loop->trip; k++) {
+        ASTExpr *value = ast_expr_int_literal((int)(loop->start + k * loop->step));
+        bool ok = value && append_copy(un, body, loop, value, out);
+        ast_expr_destroy(value);
+        if (!ok) return false;
+    }
+
+    if (loop->trip == 0) return true;
+
+    /* i holds its exit value afterwards */
+    ASTExpr *final = ast_expr_int_literal((int)(loop->start + loop->trip * loop->step));
+    ASTStmt *assign = final ? ast_stmt_assign(loop->var, final) : NULL;
+    if (!assign) ast_expr_destroy(final);
+    return opt_stmt_vec_push(out, assign);
+}
+
+static bool build_partial_unroll(Unroller *un, const ASTStmt *loop_stmt,
+                                 const CountedLoop *loop, OptStmtVec *out) {
+    const ASTStmt *body = loop_stmt->data.while_stmt.body;
+    long long factor = (long long)un->factor;
+    long long main_trips = loop->trip / factor;
+    long long main_end = loop->start + main_trips * factor * loop->step;
+
+    OptStmtVec main_body = {0};
+    bool ok = true;
+
+    for (long long k = 0; ok && k < factor; k++) {
+        ASTExpr *value = make_offset(loop->var, k * loop->step);
+        ok = value && append_copy(un, body, loop, value, &main_body);
+        ast_expr_destroy(value);
+    }
+
+    if (ok) {
+        ASTExpr *advance = make_offset(loop->var, factor * loop->step);
+        ASTStmt *assign = advance ? ast_stmt_assign(loop->var, advance) : NULL;
+        if (!assign) ast_expr_destroy(advance);
+        ok = opt_stmt_vec_push(&main_body, assign);
+    }
+
+    /* while (i < main_end) or while (i > main_end) */
+    ASTStmt *main_block = ok ? ast_stmt_block(main_body.items, main_body.count) : NULL;
+    if (!main_block) {
+        opt_stmt_vec_destroy(&main_body);
+        return false;
+    }
+
+    ASTExpr *var = opt_make_var(loop->var, type_int());
+    ASTExpr *end = ast_expr_int_literal((int)main_end);
+    ASTExpr *cond = (var && end) ? ast_expr_binary(loop->step > 0 ? EXPR_LT : EXPR_GT, var, end)
+                                 : NULL;
+    ASTStmt *main_loop = cond ? ast_stmt_while(cond, main_block) : NULL;
+    if (!main_loop) {
+        if (cond) {
+            ast_expr_destroy(cond);
+        } else {
+            ast_expr_destroy(var);
+            ast_expr_destroy(end);
+        }
+        ast_stmt_destroy(main_block);
+        return false;
+    }
+
+    if (!opt_stmt_vec_push(out, main_loop)) return false;
+
+    /* Remainder loop: the original loop runs the leftover iterations */
+    if (loop->trip % factor != 0) {
+        return opt_stmt_vec_push(out, ast_stmt_clone(loop_stmt));
+    }
+    return true;
+}
+
+/* Replace block[index] with the statements in vec (takes ownership) */
+static bool replace_statement(ASTStmt *block, size_t index, OptStmtVec *vec) {
+    if (!opt_block_insert(block, index, vec->items, vec->count)) return false;
+
+    size_t at = index + vec->count;
+    ast_stmt_destroy(block->data.block.statements[at]);
+    memmove(&block->data.block.statements[at], &block->data.block.statements[at + 1],
+            (block->data.block.stmt_count - at - 1) * sizeof(ASTStmt *));
+    block->data.block.stmt_count--;
+
+    free(vec->items);
+    vec->items = NULL;
+    vec->count = 0;
+    return true;
+}
+
+/* Try to unroll block[index]; returns the number of statements now in its place */
+static size_t unroll_loop(Unroller *un, ASTStmt *block, size_t index) {
+    ASTStmt *stmt = block->data.block.statements[index];
+
+    CountedLoop loop;
+    if (!recognize_loop(block, index, &loop)) return 1;
+
+    size_t body_size = ast_stmt_node_count(stmt->data.while_stmt.body);
+    OptStmtVec out = {0};
+    bool full;
+
+    if ((size_t)loop.trip <= un->threshold && body_size * (size_t)loop.trip <= OPT_UNROLL_MAX_NODES) {
+        full = true;
+        if (!build_full_unroll(un, stmt->data.while_stmt.body, &loop, &out)) goto fail;
+    } else if (un->factor >= 2 && loop.trip >= (long long)un->factor &&
+               body_size * un->factor <= OPT_UNROLL_MAX_NODES) {
+        full = false;
+        if (!build_partial_unroll(un, stmt, &loop, &out)) goto fail;
+    } else {
+        return 1;
+    }
+
+    /* Report before the loop (which owns the variable name) is replaced */
+    if (un->stats) {
+        un->stats->loops_unrolled++;
+        if (full) {
+            optimization_stats_remark(un->stats, "fully unrolled loop over '%s' (%lld iterations) in '%s'",
+                                      loop.var, loop.trip, un->func->name);
+        } else {
+            optimization_stats_remark(un->stats, "unrolled loop over '%s' by %zu in '%s'",
+                                      loop.var, un->factor, un->func->name);
+        }
+    }
+
+    size_t count = out.count;
+    if (!replace_statement(block, index, &out)) goto fail;
+
+    return count;
+
+fail:
+    opt_stmt_vec_destroy(&out);
+    un->failed = true;
+    return 1;
+}
+
+static void unroll_block(Unroller *un, ASTStmt *block) {
+    size_t i = 0;
+
+    while (i < block->data.block.stmt_count && !un->failed) {
+        ASTStmt *stmt = block->data.block.statements[i];
+
+        switch (stmt->kind) {
+            case STMT_WHILE:
+                /* Inner loops first */
+                unroll_block(un, stmt->data.while_stmt.body);
+                i += unroll_loop(un, block, i);
+                continue;
+            case STMT_IF:
+                unroll_block(un, stmt->data.if_stmt.then_block);
+                if (stmt->data.if_stmt.else_block) {
+                    unroll_block(un, stmt->data.if_stmt.else_block);
+                }
+                break;
+            case STMT_BLOCK:
+                unroll_block(un, stmt);
+                break;
+            default:
+                break;
+        }
+        i++;
+    }
+}
+
+/* ==============================================================================
+ * Pass Driver
+ * ==============================================================================
+ */
+
+void optimize_loop_unrolling(ASTProgram *program, const CompilerConfig *config,
+                             OptimizationStats *stats) {
+    if (!program) return;
+
+    Unroller un = {
+        .stats = stats,
+        .func = NULL,
+        .threshold = (config && config->unroll_threshold) ?
+                     config->unroll_threshold : OPT_DEFAULT_UNROLL_THRESHOLD,
+        .factor = (config && config->unroll_factor) ?
+                  config->unroll_factor : OPT_DEFAULT_UNROLL_FACTOR,
+        .failed = false
+    };
+
+    if (!opt_name_set_init(&un.names)) return;
+
+    if (opt_name_set_add_program(&un.names, program)) {
+        for (size_t i = 0; i < program->func_count && !un.failed; i++) {
+            un.func = program->functions[i];
+            unroll_block(&un, program->functions[i]->body);
+        }
+    }
+
+    opt_name_set_free(&un.names);
+}
@@ -0,0 +1,1264 @@
+/**
+ * ==============================================================================
+ * TinyLLVM Compiler - Optimizer
+ * ==============================================================================
+ *
+ * Drives the AST optimization passes and provides the helpers they share.
+ *
+ * Pipeline (by optimization_level):
+ *   - 0: no passes
+ *   - 1+: dead function elimination, so unreachable helpers are never
+ *         optimized, and again at the end for functions left uncalled
+ *   - 1+: tail recursion elimination, then scalar cleanup (constant and
+ *         copy propagation, constant folding, dead code elimination)
+ *   - 2+: function inlining, compile-time evaluation of calls with constant
+ *         arguments, each followed by a scalar cleanup; reassociation, then
+ *         loop-invariant code motion (skipped under overflow checks)
+ *   - 3:  function specialization and a scalar cleanup, loop unrolling
+ *   - 2+: strength reduction, if-conversion and loop rotation, after
+ *         unrolling so they see the unrolled loops
+ *   - 3:  memoization, after the final dead function elimination so no
+ *         pass rewrites the cached wrappers
+ *   - 1+: range analysis under overflow checks, last so it marks the
+ *         arithmetic code generation actually sees
+ */
+
+#include "include/tinyllvm_optimizer.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+
+static char *opt_strdup(const char *str) {
+    size_t len = strlen(str);
+    char *dup = malloc(len + 1);
+    if (dup) {
+        memcpy(dup, str, len + 1);
+    }
+    return dup;
+}
+
+/* ==============================================================================
+ * Optimization Statistics
+ * ==============================================================================
+ */
+
+OptimizationStats *optimization_stats_create(void) {
+    return calloc(1, sizeof(OptimizationStats));
+}
+
+void optimization_stats_destroy(OptimizationStats *stats) {
+    if (!stats) return;
+
+    for (size_t i = 0; i < stats->remark_count; i++) {
+        free(stats->remarks[i]);
+    }
+    free(stats->remarks);
+    free(stats);
+}
+
+void optimization_stats_remark(OptimizationStats *stats, const char *format, ...) {
+    if (!stats) return;
+
+    char buffer[512];
+
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+
+    if (len < 0) return;
+
+    if (stats->remark_count >= stats->remark_capacity) {
+        size_t new_capacity = stats->remark_capacity == 0 ? 16 : stats->remark_capacity * 2;
+        char **new_remarks = realloc(stats->remarks, new_capacity * sizeof(char *));
+        if (!new_remarks) return;
+
+        stats->remarks = new_remarks;
+        stats->remark_capacity = new_capacity;
+    }
+
+    char *remark = opt_strdup(buffer);
+    if (remark) {
+        stats->remarks[stats->remark_count++] = remark;
+    }
+}
+
+/* ==============================================================================
+ * Identifier Sets
+ * ==============================================================================
+ */
+
+static size_t name_hash(const char *name) {
+    size_t hash = 14695981039346656037ULL & (size_t)-1;
+    for (const unsigned char *p = (const unsigned char *)name; *p; p++) {
+        hash ^= *p;
+        hash *= (size_t)1099511628211ULL;
+    }
+    return hash;
+}
+
+bool opt_name_set_init(OptNameSet *set) {
+    set->capacity = 64;
+    set->count = 0;
+    set->next_suffix = 0;
+    set->slots = calloc(set->capacity, sizeof(char *));
+    return set->slots != NULL;
+}
+
+void opt_name_set_free(OptNameSet *set) {
+    if (!set->slots) return;
+
+    for (size_t i = 0; i < set->capacity; i++) {
+        free(set->slots[i]);
+    }
+    free(set->slots);
+    set->slots = NULL;
+    set->capacity = 0;
+    set->count = 0;
+}
+
+bool opt_name_set_contains(const OptNameSet *set, const char *name) {
+    size_t mask = set->capacity - 1;
+    for (size_t i = name_hash(name) & mask; set->slots[i]; i = (i + 1) & mask) {
+        if (strcmp(set->slots[i], name) == 0) return true;
+    }
+    return false;
+}
+
+static bool name_set_grow(OptNameSet *set) {
+    size_t new_capacity = set->capacity * 2;
+    char **new_slots = calloc(new_capacity, sizeof(char *));
+    if (!new_slots) return false;
+
+    size_t mask = new_capacity - 1;
+    for (size_t i = 0; i < set->capacity; i++) {
+        char *name = set->slots[i];
+        if (!name) continue;
+
+        size_t j = name_hash(name) & mask;
+        while (new_slots[j]) j = (j + 1) & mask;
+        new_slots[j] = name;
+    }
+
+    free(set->slots);
+    set->slots = new_slots;
+    set->capacity = new_capacity;
+    return true;
+}
+
+bool opt_name_set_add(OptNameSet *set, const char *name) {
+    if (opt_name_set_contains(set, name)) return true;
+
+    /* Keep the load factor below 1/2 */
+    if ((set->count + 1) * 2 > set->capacity) {
+        if (!name_set_grow(set)) return false;
+    }
+
+    char *copy = opt_strdup(name);
+    if (!copy) return false;
+
+    size_t mask = set->capacity - 1;
+    size_t i = name_hash(name) & mask;
+    while (set->slots[i]) i = (i + 1) & mask;
+
+    set->slots[i] = copy;
+    set->count++;
+    return true;
+}
+
+static bool name_set_add_expr(OptNameSet *set, const ASTExpr *expr) {
+    if (!expr) return true;
+
+    if (ast_expr_is_binary(expr->kind)) {
+        return name_set_add_expr(set, expr->data.binary.left) &&
+               name_set_add_expr(set, expr->data.binary.right);
+    }
+
+    switch (expr->kind) {
+        case EXPR_VAR:
+            return opt_name_set_add(set, expr->data.var.name);
+        case EXPR_NOT:
+            return name_set_add_expr(set, expr->data.unary.operand);
+        case EXPR_SELECT:
+            return name_set_add_expr(set, expr->data.select.condition) &&
+                   name_set_add_expr(set, expr->data.select.then_expr) &&
+                   name_set_add_expr(set, expr->data.select.else_expr);
+        case EXPR_CALL:
+            for (size_t i = 0; i < expr->data.call.arg_count; i++) {
+                if (!name_set_add_expr(set, expr->data.call.args[i])) return false;
+            }
+            return true;
+        default:
+            return true;
+    }
+}
+
+static bool name_set_add_stmt(OptNameSet *set, const ASTStmt *stmt) {
+    if (!stmt) return true;
+
+    switch (stmt->kind) {
+        case STMT_VAR_DECL:
+            return opt_name_set_add(set, stmt->data.var_decl.name) &&
+                   name_set_add_expr(set, stmt->data.var_decl.init_expr);
+        case STMT_ASSIGN:
+            return opt_name_set_add(set, stmt->data.assign.name) &&
+                   name_set_add_expr(set, stmt->data.assign.expr);
+        case STMT_IF:
+            return name_set_add_expr(set, stmt->data.if_stmt.condition) &&
+                   name_set_add_stmt(set, stmt->data.if_stmt.then_block) &&
+                   name_set_add_stmt(set, stmt->data.if_stmt.else_block);
+        case STMT_WHILE:
+            return name_set_add_expr(set, stmt->data.while_stmt.condition) &&
+                   name_set_add_stmt(set, stmt->data.while_stmt.body);
+        case STMT_RETURN:
+            return name_set_add_expr(set, stmt->data.return_stmt.expr);
+        case STMT_EXPR:
+            return name_set_add_expr(set, stmt->data.expr_stmt.expr);
+        case STMT_BLOCK:
+            for (size_t i = 0; i < stmt->data.block.stmt_count; i++) {
+                if (!name_set_add_stmt(set, stmt->data.block.statements[i])) return false;
+            }
+            return true;
+    }
+    return true;
+}
+
+bool opt_name_set_add_program(OptNameSet *set, const ASTProgram *program) {
+    if (!opt_name_set_add(set, "print")) return false;
+
+    for (size_t i = 0; i < program->func_count; i++) {
+        const ASTFunc *func = program->functions[i];
+        if (!opt_name_set_add(set, func->name)) return false;
+        for (size_t j = 0; j < func->param_count; j++) {
+            if (!opt_name_set_add(set, func->params[j].name)) return false;
+        }
+        if (!name_set_add_stmt(set, func->body)) return false;
+    }
+    return true;
+}
+
+char *opt_fresh_name(OptNameSet *set, const char *base, const char *tag) {
+    char buffer[256];
+
+    for (;;) {
+        snprintf(buffer, sizeof(buffer), "%.200s_%s%u", base, tag, set->next_suffix++);
+        if (!opt_name_set_contains(set, buffer)) break;
+    }
+
+    if (!opt_name_set_add(set, buffer)) return NULL;
+    return opt_strdup(buffer);
+}
+
+/* ==============================================================================
+ * Scoped Renaming
+ * ==============================================================================
+ */
+
+bool opt_rename_map_push(OptRenameMap *map, const char *from, const char *to) {
+    if (map->count >= map->capacity) {
+        size_t new_capacity = map->capacity == 0 ? 8 : map->capacity * 2;
+        char **new_from = realloc(map->from, new_capacity * sizeof(char *));
+        if (!new_from) return false;
+        map->from = new_from;
+
+        char **new_to = realloc(map->to, new_capacity * sizeof(char *));
+        if (!new_to) return false;
+        map->to = new_to;
+
+        map->capacity = new_capacity;
+    }
+
+    char *from_copy = opt_strdup(from);
+    char *to_copy = opt_strdup(to);
+    if (!from_copy || !to_copy) {
+        free(from_copy);
+        free(to_copy);
+        return false;
+    }
+
+    map->from[map->count] = from_copy;
+    map->to[map->count] = to_copy;
+    map->count++;
+    return true;
+}
+
+void opt_rename_map_pop_to(OptRenameMap *map, size_t count) {
+    while (map->count > count) {
+        map->count--;
+        free(map->from[map->count]);
+        free(map->to[map->count]);
+    }
+}
+
+void opt_rename_map_free(OptRenameMap *map) {
+    opt_rename_map_pop_to(map, 0);
+    free(map->from);
+    free(map->to);
+    map->from = NULL;
+    map->to = NULL;
+    map->capacity = 0;
+}
+
+const char *opt_rename_map_lookup(const OptRenameMap *map, const char *name) {
+    for (size_t i = map->count; i > 0; i--) {
+        if (strcmp(map->from[i - 1], name) == 0) return map->to[i - 1];
+    }
+    return NULL;
+}
+
+static bool replace_name(char **slot, const char *name) {
+    char *copy = opt_strdup(name);
+    if (!copy) return false;
+    free(*slot);
+    *slot = copy;
+    return true;
+}
+
+bool opt_rename_expr(ASTExpr *expr, const OptRenameMap *map) {
+    if (!expr) return true;
+
+    if (ast_expr_is_binary(expr->kind)) {
+        return opt_rename_expr(expr->data.binary.left, map) &&
+               opt_rename_expr(expr->data.binary.right, map);
+    }
+
+    switch (expr->kind) {
+        case EXPR_VAR: {
+            const char *to = opt_rename_map_lookup(map, expr->data.var.name);
+            return to ? replace_name(&expr->data.var.name, to) : true;
+        }
+        case EXPR_NOT:
+            return opt_rename_expr(expr->data.unary.operand, map);
+        case EXPR_SELECT:
+            return opt_rename_expr(expr->data.select.condition, map) &&
+                   opt_rename_expr(expr->data.select.then_expr, map) &&
+                   opt_rename_expr(expr->data.select.else_expr, map);
+        case EXPR_CALL:
+            for (size_t i = 0; i < expr->data.call.arg_count; i++) {
+                if (!opt_rename_expr(expr->data.call.args[i], map)) return false;
+            }
+            return true;
+        default:
+            return true;
+    }
+}
+
+bool opt_freshen_locals(ASTStmt *stmt, OptRenameMap *map, OptNameSet *names,
+                        const char *tag) {
+    if (!stmt) return true;
+
+    switch (stmt->kind) {
+        case STMT_VAR_DECL: {
+            /* The initializer sees the enclosing binding */
+            if (!opt_rename_expr(stmt->data.var_decl.init_expr, map)) return false;
+
+            char *fresh = opt_fresh_name(names, stmt->data.var_decl.name, tag);
+            if (!fresh) return false;
+
+            bool ok = opt_rename_map_push(map, stmt->data.var_decl.name, fresh);
+            free(stmt->data.var_decl.name);
+            stmt->data.var_decl.name = fresh;
+            return ok;
+        }
+
+        case STMT_ASSIGN: {
+            const char *to = opt_rename_map_lookup(map, stmt->data.assign.name);
+            if (to && !replace_name(&stmt->data.assign.name, to)) return false;
+            return opt_rename_expr(stmt->data.assign.expr, map);
+        }
+
+        case STMT_IF:
+            return opt_rename_expr(stmt->data.if_stmt.condition, map) &&
+                   opt_freshen_locals(stmt->data.if_stmt.then_block, map, names, tag) &&
+                   opt_freshen_locals(stmt->data.if_stmt.else_block, map, names, tag);
+
+        case STMT_WHILE:
+            return opt_rename_expr(stmt->data.while_stmt.condition, map) &&
+                   opt_freshen_locals(stmt->data.while_stmt.body, map, names, tag);
+
+        case STMT_RETURN:
+            return opt_rename_expr(stmt->data.return_stmt.expr, map);
+
+        case STMT_EXPR:
+            return opt_rename_expr(stmt->data.expr_stmt.expr, map);
+
+        case STMT_BLOCK: {
+            size_t mark = map->count;
+            bool ok = true;
+            for (size_t i = 0; ok && i < stmt->data.block.stmt_count; i++) {
+                ok = opt_freshen_locals(stmt->data.block.statements[i], map, names, tag);
+            }
+            opt_rename_map_pop_to(map, mark);
+            return ok;
+        }
+    }
+    return true;
+}
+
+/* ==============================================================================
+ * Call Graph
+ * ==============================================================================
+ */
+
+size_t opt_find_function(const ASTProgram *program, const char *name) {
+    for (size_t i = 0; i < program->func_count; i++) {
+        if (strcmp(program->functions[i]->name, name) == 0) return i;
+    }
+    return OPT_NOT_FOUND;
+}
+
+static bool call_graph_add_edge(OptCallGraph *graph, size_t from, size_t to) {
+    for (size_t i = 0; i < graph->callee_counts[from]; i++) {
+        if (graph->callees[from][i] == to) return true;
+    }
+
+    size_t count = graph->callee_counts[from];
+    size_t *new_callees = realloc(graph->callees[from], (count + 1) * sizeof(size_t));
+    if (!new_callees) return false;
+
+    new_callees[count] = to;
+    graph->callees[from] = new_callees;
+    graph->callee_counts[from] = count + 1;
+    return true;
+}
+
+static bool call_graph_scan_expr(OptCallGraph *graph, const ASTProgram *program,
+                                 size_t from, const ASTExpr *expr) {
+    if (!expr) return true;
+
+    if (ast_expr_is_binary(expr->kind)) {
+        return call_graph_scan_expr(graph, program, from, expr->data.binary.left) &&
+               call_graph_scan_expr(graph, program, from, expr->data.binary.right);
+    }
+
+    switch (expr->kind) {
+        case EXPR_NOT:
+            return call_graph_scan_expr(graph, program, from, expr->data.unary.operand);
+
+        case EXPR_SELECT:
+            return call_graph_scan_expr(graph, program, from, expr->data.select.condition) &&
+                   call_graph_scan_expr(graph, program, from, expr->data.select.then_expr) &&
+                   call_graph_scan_expr(graph, program, from, expr->data.select.else_expr);
+
+        case EXPR_CALL: {
+            for (size_t i = 0; i < expr->data.call.arg_count; i++) {
+                if (!call_graph_scan_expr(graph, program, from, expr->data.call.args[i])) {
+                    return false;
+                }
+            }
+            size_t to = opt_find_function(program, expr->data.call.func_name);
+            if (to == OPT_NOT_FOUND) {
+                /* print, the only builtin, is the only source of side effects */
+                graph->pure[from] = false;
+                return true;
+            }
+            return call_graph_add_edge(graph, from, to);
+        }
+
+        default:
+            return true;
+    }
+}
+
+static bool call_graph_scan_stmt(OptCallGraph *graph, const ASTProgram *program,
+                                 size_t from, const ASTStmt *stmt) {
+    if (!stmt) return true;
+
+    switch (stmt->kind) {
+        case STMT_VAR_DECL:
+            return call_graph_scan_expr(graph, program, from, stmt->data.var_decl.init_expr);
+        case STMT_ASSIGN:
+            return call_graph_scan_expr(graph, program, from, stmt->data.assign.expr);
+        case STMT_IF:
+            return call_graph_scan_expr(graph, program, from, stmt->data.if_stmt.condition) &&
+                   call_graph_scan_stmt(graph, program, from, stmt->data.if_stmt.then_block) &&
+                   call_graph_scan_stmt(graph, program, from, stmt->data.if_stmt.else_block);
+        case STMT_WHILE:
+            return call_graph_scan_expr(graph, program, from, stmt->data.while_stmt.condition) &&
+                   call_graph_scan_stmt(graph, program, from, stmt->data.while_stmt.body);
+        case STMT_RETURN:
+            return call_graph_scan_expr(graph, program, from, stmt->data.return_stmt.expr);
+        case STMT_EXPR:
+            return call_graph_scan_expr(graph, program, from, stmt->data.expr_stmt.expr);
+        case STMT_BLOCK:
+            for (size_t i = 0; i < stmt->data.block.stmt_count; i++) {
+                if (!call_graph_scan_stmt(graph, program, from,
+                                          stmt->data.block.statements[i])) {
+                    return false;
+                }
+            }
+            return true;
+    }
+    return true;
+}
+
+/* Depth-first search: can target be reached from node? */
+static bool call_graph_reaches(const OptCallGraph *graph, size_t node, size_t target,
+                               bool *visited) {
+    for (size_t i = 0; i < graph->callee_counts[node]; i++) {
+        size_t next = graph->callees[node][i];
+        if (next == target) return true;
+        if (visited[next]) continue;
+        visited[next] = true;
+        if (call_graph_reaches(graph, next, target, visited)) return true;
+    }
+    return false;
+}
+
+bool opt_call_graph_build(OptCallGraph *graph, const ASTProgram *program) {
+    size_t n = program->func_count;
+
+    graph->func_count = n;
+    graph->callees = calloc(n ? n : 1, sizeof(size_t *));
+    graph->callee_counts = calloc(n ? n : 1, sizeof(size_t));
+    graph->recursive = calloc(n ? n : 1, sizeof(bool));
+    graph->pure = calloc(n ? n : 1, sizeof(bool));
+    bool *visited = calloc(n ? n : 1, sizeof(bool));
+
+    if (!graph->callees || !graph->callee_counts || !graph->recursive || !graph->pure ||
+        !visited) {
+        free(visited);
+        opt_call_graph_free(graph);
+        return false;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        graph->pure[i] = true;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        if (!call_graph_scan_stmt(graph, program, i, program->functions[i]->body)) {
+            free(visited);
+            opt_call_graph_free(graph);
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        memset(visited, 0, n * sizeof(bool));
+        graph->recursive[i] = call_graph_reaches(graph, i, i, visited);
+    }
+
+    /* Impurity flows from callees to callers */
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = 0; i < n; i++) {
+            if (!graph->pure[i]) continue;
+            for (size_t j = 0; j < graph->callee_counts[i]; j++) {
+                if (!graph->pure[graph->callees[i][j]]) {
+                    graph->pure[i] = false;
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    free(visited);
+    return true;
+}
+
+void opt_call_graph_free(OptCallGraph *graph) {
+    if (graph->callees) {
+        for (size_t i = 0; i < graph->func_count; i++) {
+            free(graph->callees[i]);
+        }
+    }
+    free(graph->callees);
+    free(graph->callee_counts);
+    free(graph->recursive);
+    free(graph->pure);
+    graph->callees = NULL;
+    graph->callee_counts = NULL;
+    graph->recursive = NULL;
+    graph->pure = NULL;
+    graph->func_count = 0;
+}
+
+/* ==============================================================================
+ * AST Queries & Builders
+ * ==============================================================================
+ */
+
+bool opt_expr_has_call(const ASTExpr *expr) {
+    if (!expr) return false;
+
+    if (ast_expr_is_binary(expr->kind)) {
+        return opt_expr_has_call(expr->data.binary.left) ||
+               opt_expr_has_call(expr->data.binary.right);
+    }
+
+    switch (expr->kind) {
+        case EXPR_NOT:
+            return opt_expr_has_call(expr->data.unary.operand);
+        case EXPR_SELECT:
+            return opt_expr_has_call(expr->data.select.condition) ||
+                   opt_expr_has_call(expr->data.select.then_expr) ||
+                   opt_expr_has_call(expr->data.select.else_expr);
+        case EXPR_CALL:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool opt_stmt_has_return(const ASTStmt *stmt) {
+    if (!stmt) return false;
+
+    switch (stmt->kind) {
+        case STMT_RETURN:
+            return true;
+        case STMT_IF:
+            return opt_stmt_has_return(stmt->data.if_stmt.then_block) ||
+                   opt_stmt_has_return(stmt->data.if_stmt.else_block);
+        case STMT_WHILE:
+            return opt_stmt_has_return(stmt->data.while_stmt.body);
+        case STMT_BLOCK:
+            for (size_t i = 0; i < stmt->data.block.stmt_count; i++) {
+                if (opt_stmt_has_return(stmt->data.block.statements[i])) return true;
+            }
+            return false;
+        default:
+            return false;
+    }
+}
+
+bool opt_expr_equal(const ASTExpr *a, const ASTExpr *b) {
+    if (!a || !b) return a == b;
+    if (a->kind != b->kind) return false;
+
+    if (ast_expr_is_binary(a->kind)) {
+        return opt_expr_equal(a->data.binary.left, b->data.binary.left) &&
+               opt_expr_equal(a->data.binary.right, b->data.binary.right);
+    }
+
+    switch (a->kind) {
+        case EXPR_INT_LITERAL:
+            return a->data.int_lit.value == b->data.int_lit.value;
+        case EXPR_BOOL_LITERAL:
+            return a->data.bool_lit.value == b->data.bool_lit.value;
+        case EXPR_VAR:
+            return strcmp(a->data.var.name, b->data.var.name) == 0;
+        case EXPR_NOT:
+            return opt_expr_equal(a->data.unary.operand, b->data.unary.operand);
+        case EXPR_SELECT:
+            return opt_expr_equal(a->data.select.condition, b->data.select.condition) &&
+                   opt_expr_equal(a->data.select.then_expr, b->data.select.then_expr) &&
+                   opt_expr_equal(a->data.select.else_expr, b->data.select.else_expr);
+        case EXPR_CALL:
+            if (strcmp(a->data.call.func_name, b->data.call.func_name) != 0 ||
+                a->data.call.arg_count != b->data.call.arg_count) {
+                return false;
+            }
+            for (size_t i = 0; i < a->data.call.arg_count; i++) {
+                if (!opt_expr_equal(a->data.call.args[i], b->data.call.args[i])) return false;
+            }
+            return true;
+        default:
+            return false;
+    }
+}
+
+static const char *binary_operator_symbol(ExprKind kind) {
+    switch (kind) {
+        case EXPR_ADD: return "+";
+        case EXPR_SUB: return "-";
+        case EXPR_MUL: return "*";
+        case EXPR_DIV: return "/";
+        case EXPR_MOD: return "%";
+        case EXPR_SHL: return "<<";
+        case EXPR_SHR: return ">>";
+        case EXPR_USHR: return ">>>";
+        case EXPR_MULHI: return "*hi";
+        case EXPR_EQ:  return "==";
+        case EXPR_NE:  return "!=";
+        case EXPR_LT:  return "<";
+        case EXPR_LE:  return "<=";
+        case EXPR_GT:  return ">";
+        case EXPR_GE:  return ">=";
+        case EXPR_AND: return "&&";
+        case EXPR_OR:  return "||";
+        default:       return "?";
+    }
+}
+
+static void format_append(char *buffer, size_t size, size_t *len, const char *text) {
+    while (*text && *len + 1 < size) {
+        buffer[(*len)++] = *text++;
+    }
+    buffer[*len] = '\0';
+}
+
+static void format_expr(const ASTExpr *expr, char *buffer, size_t size, size_t *len,
+                        bool nested) {
+    char number[32];
+
+    if (ast_expr_is_binary(expr->kind)) {
+        if (nested) format_append(buffer, size, len, "(");
+        format_expr(expr->data.binary.left, buffer, size, len, true);
+        format_append(buffer, size, len, " ");
+        format_append(buffer, size, len, binary_operator_symbol(expr->kind));
+        format_append(buffer, size, len, " ");
+        format_expr(expr->data.binary.right, buffer, size, len, true);
+        if (nested) format_append(buffer, size, len, ")");
+        return;
+    }
+
+    switch (expr->kind) {
+        case EXPR_INT_LITERAL:
+            snprintf(number, sizeof(number), "%d", expr->data.int_lit.value);
+            format_append(buffer, size, len, number);
+            break;
+        case EXPR_BOOL_LITERAL:
+            format_append(buffer, size, len, expr->data.bool_lit.value ? "true" : "false");
+            break;
+        case EXPR_VAR:
+            format_append(buffer, size, len, expr->data.var.name);
+            break;
+        case EXPR_NOT:
+            format_append(buffer, size, len, "!");
+            format_expr(expr->data.unary.operand, buffer, size, len, true);
+            break;
+        case EXPR_CALL:
+            format_append(buffer, size, len, expr->data.call.func_name);
+            format_append(buffer, size, len, "(");
+            for (size_t i = 0; i < expr->data.call.arg_count; i++) {
+                if (i > 0) format_append(buffer, size, len, ", ");
+                format_expr(expr->data.call.args[i], buffer, size, len, false);
+            }
+            format_append(buffer, size, len, ")");
+            break;
+        case EXPR_SELECT:
+            if (nested) format_append(buffer, size, len, "(");
+            format_expr(expr->data.select.condition, buffer, size, len, true);
+            format_append(buffer, size, len, " ? ");
+            format_expr(expr->data.select.then_expr, buffer, size, len, true);
+            format_append(buffer, size, len, " : ");
+            format_expr(expr->data.select.else_expr, buffer, size, len, true);
+            if (nested) format_append(buffer, size, len, ")");
+            break;
+        default:
+            break;
+    }
+}
+
+void opt_expr_format(const ASTExpr *expr, char *buffer, size_t size) {
+    if (size == 0) return;
+
+    size_t len = 0;
+    buffer[0] = '\0';
+    if (expr) format_expr(expr, buffer, size, &len, false);
+}
+
+size_t opt_expr_count_var(const ASTExpr *expr, const char *name) {
+    if (!expr) return 0;
+
+    if (ast_expr_is_binary(expr->kind)) {
+        return opt_expr_count_var(expr->data.binary.left, name) +
+               opt_expr_count_var(expr->data.binary.right, name);
+    }
+
+    switch (expr->kind) {
+        case EXPR_VAR:
+            return strcmp(expr->data.var.name, name) == 0 ? 1 : 0;
+        case EXPR_NOT:
+            return opt_expr_count_var(expr->data.unary.operand, name);
+        case EXPR_SELECT:
+            return opt_expr_count_var(expr->data.select.condition, name) +
+                   opt_expr_count_var(expr->data.select.then_expr, name) +
+                   opt_expr_count_var(expr->data.select.else_expr, name);
+        case EXPR_CALL: {
+            size_t count = 0;
+            for (size_t i = 0; i < expr->data.call.arg_count; i++) {
+                count += opt_expr_count_var(expr->data.call.args[i], name);
+            }
+            return count;
+        }
+        default:
+            return 0;
+    }
+}
+
+bool opt_stmt_writes_var(const ASTStmt *stmt, const char *name) {
+    if (!stmt) return false;
+
+    switch (stmt->kind) {
+        case STMT_VAR_DECL:
+            return strcmp(stmt->data.var_decl.name, name) == 0;
+        case STMT_ASSIGN:
+            return strcmp(stmt->data.assign.name, name) == 0;
+        case STMT_IF:
+            return opt_stmt_writes_var(stmt->data.if_stmt.then_block, name) ||
+                   opt_stmt_writes_var(stmt->data.if_stmt.else_block, name);
+        case STMT_WHILE:
+            return opt_stmt_writes_var(stmt->data.while_stmt.body, name);
+        case STMT_BLOCK:
+            for (size_t i = 0; i < stmt->data.block.stmt_count; i++) {
+                if (opt_stmt_writes_var(stmt->data.block.statements[i], name)) return true;
+            }
+            return false;
+        default:
+            return false;
+    }
+}
+
+bool opt_expr_substitute_var(ASTExpr **slot, const char *name, const ASTExpr *replacement) {
+    ASTExpr *expr = *slot;
+    if (!expr) return true;
+
+    if (ast_expr_is_binary(expr->kind)) {
+        return opt_expr_substitute_var(&expr->data.binary.left, name, replacement) &&
+               opt_expr_substitute_var(&expr->data.binary.right, name, replacement);
+    }
+
+    switch (expr->kind) {
+        case EXPR_VAR: {
+            if (strcmp(expr->data.var.name, name) != 0) return true;
+
+            ASTExpr *copy = ast_expr_clone(replacement);
+            if (!copy) return false;
+            ast_expr_destroy(expr);
+            *slot = copy;
+            return true;
+        }
+        case EXPR_NOT:
+            return opt_expr_substitute_var(&expr->data.unary.operand, name, replacement);
+        case EXPR_SELECT:
+            return opt_expr_substitute_var(&expr->data.select.condition, name, replacement) &&
+                   opt_expr_substitute_var(&expr->data.select.then_expr, name, replacement) &&
+                   opt_expr_substitute_var(&expr->data.select.else_expr, name, replacement);
+        case EXPR_CALL:
+            for (size_t i = 0; i < expr->data.call.arg_count; i++) {
+                if (!opt_expr_substitute_var(&expr->data.call.args[i], name, replacement)) {
+                    return false;
+                }
+            }
+            return true;
+        default:
+            return true;
+    }
+}
+
+bool opt_stmt_substitute_var(ASTStmt *stmt, const char *name, const ASTExpr *replacement) {
+    if (!stmt) return true;
+
+    switch (stmt->kind) {
+        case STMT_VAR_DECL:
+            return opt_expr_substitute_var(&stmt->data.var_decl.init_expr, name, replacement);
+        case STMT_ASSIGN:
+            return opt_expr_substitute_var(&stmt->data.assign.expr, name, replacement);
+        case STMT_IF:
+            return opt_expr_substitute_var(&stmt->data.if_stmt.condition, name, replacement) &&
+                   opt_stmt_substitute_var(stmt->data.if_stmt.then_block, name, replacement) &&
+                   opt_stmt_substitute_var(stmt->data.if_stmt.else_block, name, replacement);
+        case STMT_WHILE:
+            return opt_expr_substitute_var(&stmt->data.while_stmt.condition, name, replacement) &&
+                   opt_stmt_substitute_var(stmt->data.while_stmt.body, name, replacement);
+        case STMT_RETURN:
+            return opt_expr_substitute_var(&stmt->data.return_stmt.expr, name, replacement);
+        case STMT_EXPR:
+            return opt_expr_substitute_var(&stmt->data.expr_stmt.expr, name, replacement);
+        case STMT_BLOCK:
+            for (size_t i = 0; i < stmt->data.block.stmt_count; i++) {
+                if (!opt_stmt_substitute_var(stmt->data.block.statements[i], name, replacement)) {
+                    return false;
+                }
+            }
+            return true;
+    }
+    return true;
+}
+
+ASTExpr *opt_make_var(const char *name, Type type) {
+    ASTExpr *expr = ast_expr_var(name);
+    if (expr) expr->type = type;
+    return expr;
+}
+
+ASTExpr *opt_make_default_value(Type type) {
+    if (type.kind == TYPE_BOOL) return ast_expr_bool_literal(false);
+    return ast_expr_int_literal(0);
+}
+
+bool opt_block_insert(ASTStmt *block, size_t index, ASTStmt **stmts, size_t count) {
+    if (count == 0) return true;
+
+    size_t old_count = block->data.block.stmt_count;
+    ASTStmt **new_stmts = realloc(block->data.block.statements,
+                                  (old_count + count) * sizeof(ASTStmt *));
+    if (!new_stmts) return false;
+
+    memmove(&new_stmts[index + count], &new_stmts[index],
+            (old_count - index) * sizeof(ASTStmt *));
+    memcpy(&new_stmts[index], stmts, count * sizeof(ASTStmt *));
+
+    block->data.block.statements = new_stmts;
+    block->data.block.stmt_count = old_count + count;
+    return true;
+}
+
+bool opt_stmt_always_returns(const ASTStmt *stmt) {
+    if (!stmt) return false;
+
+    switch (stmt->kind) {
+        case STMT_RETURN:
+            return true;
+        case STMT_IF:
+            return opt_stmt_always_returns(stmt->data.if_stmt.then_block) &&
+                   opt_stmt_always_returns(stmt->data.if_stmt.else_block);
+        case STMT_BLOCK:
+            for (size_t i = 0; i < stmt->data.block.stmt_count; i++) {
+                if (opt_stmt_always_returns(stmt->data.block.statements[i])) return true;
+            }
+            return false;
+        default:
+            return false;
+    }
+}
+
+void opt_remove_assignments(ASTStmt *stmt, const char *name) {
+    if (!stmt) return;
+
+    switch (stmt->kind) {
+        case STMT_IF:
+            opt_remove_assignments(stmt->data.if_stmt.then_block, name);
+            opt_remove_assignments(stmt->data.if_stmt.else_block, name);
+            break;
+
+        case STMT_WHILE:
+            opt_remove_assignments(stmt->data.while_stmt.body, name);
+            break;
+
+        case STMT_BLOCK: {
+            size_t kept = 0;
+            for (size_t i = 0; i < stmt->data.block.stmt_count; i++) {
+                ASTStmt *child = stmt->data.block.statements[i];
+                if (child->kind == STMT_ASSIGN && strcmp(child->data.assign.name, name) == 0) {
+                    ast_stmt_destroy(child);
+                    continue;
+                }
+                opt_remove_assignments(child, name);
+                stmt->data.block.statements[kept++] = child;
+            }
+            stmt->data.block.stmt_count = kept;
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+/* ==============================================================================
+ * Function Cloning
+ * ==============================================================================
+ */
+
+ASTFunc *opt_func_clone(const ASTFunc *func, const char *name) {
+    Param *params = NULL;
+    if (func->param_count > 0) {
+        params = calloc(func->param_count, sizeof(Param));
+        if (!params) return NULL;
+    }
+
+    bool ok = true;
+    for (size_t i = 0; i < func->param_count && ok; i++) {
+        params[i].name = opt_strdup(func->params[i].name);
+        params[i].type = func->params[i].type;
+        ok = params[i].name != NULL;
+    }
+
+    ASTStmt *body = ok ? ast_stmt_clone(func->body) : NULL;
+    ASTFunc *clone = body ? ast_func_create(name, params, func->param_count,
+                                            func->return_type, body) : NULL;
+    if (!clone) {
+        ast_stmt_destroy(body);
+        for (size_t i = 0; i < func->param_count && params; i++) {
+            free(params[i].name);
+        }
+        free(params);
+    }
+    return clone;
+}
+
+bool opt_program_insert_function(ASTProgram *program, size_t index, ASTFunc *func) {
+    ASTFunc **functions = realloc(program->functions,
+                                  (program->func_count + 1) * sizeof(ASTFunc *));
+    if (!functions) return false;
+
+    memmove(&functions[index + 1], &functions[index],
+            (program->func_count - index) * sizeof(ASTFunc *));
+    functions[index] = func;
+
+    program->functions = functions;
+    program->func_count++;
+    return true;
+}
+
+/* ==============================================================================
+ * Statement Lists
+ * ==============================================================================
+ */
+
+bool opt_stmt_vec_push(OptStmtVec *vec, ASTStmt *stmt) {
+    if (!stmt) return false;
+
+    if (vec->count >= vec->capacity) {
+        size_t new_capacity = vec->capacity == 0 ? 8 : vec->capacity * 2;
+        ASTStmt **new_items = realloc(vec->items, new_capacity * sizeof(ASTStmt *));
+        if (!new_items) {
+            ast_stmt_destroy(stmt);
+            return false;
+        }
+        vec->items = new_items;
+        vec->capacity = new_capacity;
+    }
+
+    vec->items[vec->count++] = stmt;
+    return true;
+}
+
+void opt_stmt_vec_destroy(OptStmtVec *vec) {
+    for (size_t i = 0; i < vec->count; i++) {
+        ast_stmt_destroy(vec->items[i]);
+    }
+    free(vec->items);
+    vec->items = NULL;
+    vec->count = 0;
+    vec->capacity = 0;
+}
+
+/* ==============================================================================
+ * Return Lowering
+ * ==============================================================================
+ */
+
+static ASTExpr *make_not_done(const OptReturnLowering *rl) {
+    ASTExpr *flag = opt_make_var(rl->done, type_bool());
+    ASTExpr *not_done = flag ? ast_expr_unary(EXPR_NOT, flag) : NULL;
+    if (!not_done) ast_expr_destroy(flag);
+    return not_done;
+}
+
+/*
+ * Lower returns in a statement list. Every entry of stmts is either moved
+ * into out or destroyed.
+ */
+static void lower_return_list(OptReturnLowering *rl, ASTStmt **stmts, size_t count,
+                              OptStmtVec *out) {
+    size_t i = 0;
+
+    for (; i < count && !rl->failed; i++) {
+        ASTStmt *stmt = stmts[i];
+
+        if (stmt->kind == STMT_RETURN) {
+            ASTExpr *value = stmt->data.return_stmt.expr;
+            stmt->data.return_stmt.expr = NULL;
+            ast_stmt_destroy(stmt);
+
+            if (!rl->lower_return(rl, value, out) ||
+                !opt_stmt_vec_push(out, ast_stmt_assign(rl->done, ast_expr_bool_literal(true)))) {
+                rl->failed = true;
+            }
+            i++;
+            break;
+        }
+
+        bool returns = opt_stmt_has_return(stmt);
+        bool terminates = returns && opt_stmt_always_returns(stmt);
+
+        switch (stmt->kind) {
+            case STMT_IF:
+                opt_lower_returns(rl, stmt->data.if_stmt.then_block);
+                if (stmt->data.if_stmt.else_block) {
+                    opt_lower_returns(rl, stmt->data.if_stmt.else_block);
+                }
+                break;
+
+            case STMT_WHILE:
+                if (returns) {
+                    /* Leave the loop once a return has executed */
+                    opt_lower_returns(rl, stmt->data.while_stmt.body);
+                    ASTExpr *not_done = make_not_done(rl);
+                    ASTExpr *cond = not_done ? ast_expr_binary(EXPR_AND, not_done,
+                                                               stmt->data.while_stmt.condition)
+                                             : NULL;
+                    if (!cond) {
+                        ast_expr_destroy(not_done);
+                        rl->failed = true;
+                        break;
+                    }
+                    stmt->data.while_stmt.condition = cond;
+                    rl->done_used = true;
+                }
+                break;
+
+            case STMT_BLOCK:
+                opt_lower_returns(rl, stmt);
+                break;
+
+            default:
+                break;
+        }
+
+        if (!opt_stmt_vec_push(out, stmt)) {
+            rl->failed = true;
+            i++;
+            break;
+        }
+
+        if (!returns) continue;
+
+        i++;
+        if (!terminates && i < count) {
+            /* Guard the rest of the list behind the done flag */
+            OptStmtVec rest = {0};
+            lower_return_list(rl, &stmts[i], count - i, &rest);
+            i = count;
+
+            ASTStmt *rest_block = ast_stmt_block(rest.items, rest.count);
+            ASTExpr *not_done = make_not_done(rl);
+            ASTStmt *guard = (rest_block && not_done) ? ast_stmt_if(not_done, rest_block, NULL)
+                                                      : NULL;
+            if (!guard) {
+                if (rest_block) {
+                    ast_stmt_destroy(rest_block);
+                } else {
+                    opt_stmt_vec_destroy(&rest);
+                }
+                ast_expr_destroy(not_done);
+                rl->failed = true;
+            } else if (!opt_stmt_vec_push(out, guard)) {
+                rl->failed = true;
+            }
+            rl->done_used = true;
+        }
+        break;
+    }
+
+    /* Anything after a return (or left over on failure) is dropped */
+    for (; i < count; i++) {
+        ast_stmt_destroy(stmts[i]);
+    }
+}
+
+void opt_lower_returns(OptReturnLowering *rl, ASTStmt *block) {
+    ASTStmt **stmts = block->data.block.statements;
+    size_t count = block->data.block.stmt_count;
+
+    OptStmtVec out = {0};
+    lower_return_list(rl, stmts, count, &out);
+    free(stmts);
+
+    block->data.block.statements = out.items;
+    block->data.block.stmt_count = out.count;
+}
+
+/* ==============================================================================
+ * Optimizer Event (EventChains Integration)
+ * ==============================================================================
+ */
+
+/* Propagation exposes constants to folding, which exposes dead branches */
+static void run_scalar_cleanup(ASTProgram *program, const CompilerConfig *config,
+                               OptimizationStats *stats) {
+    optimize_constant_propagation(program, config, stats);
+    optimize_constant_folding(program, config, stats);
+    optimize_dead_code_elimination(program, config, stats);
+}
+
+static void run_pipeline(ASTProgram *program, const CompilerConfig *config,
+                         OptimizationStats *stats) {
+    int level = config->optimization_level;
+
+    if (level >= 1) {
+        optimize_dead_functions(program, stats);
+        optimize_tail_recursion(program, config, stats);
+        run_scalar_cleanup(program, config, stats);
+    }
+
+    if (level >= 2) {
+        optimize_inline_functions(program, config, stats);
+        run_scalar_cleanup(program, config, stats);
+        optimize_compile_time_calls(program, config, stats);
+        run_scalar_cleanup(program, config, stats);
+        /* Groups invariant operands so LICM can hoist them */
+        optimize_reassociation(program, config, stats);
+        /* Hoisted arithmetic may run when the loop does not: a checked
+         * build would trap where the program did not */
+        if (!config->overflow_checks) {
+            optimize_loop_invariants(program, stats);
+        }
+    }
+
+    if (level >= 3) {
+        /* Bound constants give unrolling constant trip counts in the clones */
+        optimize_function_specialization(program, config, stats);
+        run_scalar_cleanup(program, config, stats);
+        optimize_loop_unrolling(program, config, stats);
+    }
+
+    if (level >= 2) {
+        optimize_strength_reduction(program, config, stats);
+        optimize_if_conversion(program, config, stats);
+        optimize_loop_rotation(program, stats);
+    }
+
+    if (level >= 1) {
+        optimize_dead_functions(program, stats);
+    }
+
+    /* Last, so no later pass inlines or rewrites the cached wrappers */
+    if (level >= 3) {
+        optimize_memoization(program, config, stats);
+    }
+
+    /* Marks the arithmetic that checked code generation can leave unchecked */
+    if (level >= 1 && config->overflow_checks) {
+        optimize_range_analysis(program, stats);
+    }
+}
+
+EventResult compiler_optimizer_event(EventContext *context, void *user_data) {
+    CompilerConfig *config = (CompilerConfig *)user_data;
+
+    EventResult result;
+
+    /* Get AST from context */
+    ASTProgram *program;
+    EventChainErrorCode err = event_context_get(context, "ast", (void**)&program);
+
+    if (err != EC_SUCCESS || !program) {
+        event_result_failure(&result, "No AST provided to optimizer",
+                           EC_ERROR_INVALID_PARAMETER, ERROR_DETAIL_FULL);
+        return result;
+    }
+
+    OptimizationStats *stats = optimization_stats_create();
+    if (!stats) {
+        event_result_failure(&result, "Failed to allocate optimization statistics",
+                           EC_ERROR_OUT_OF_MEMORY, ERROR_DETAIL_FULL);
+        return result;
+    }
+
+    if (config && config->enable_optimization) {
+        run_pipeline(program, config, stats);
+    }
+
+    /* Store statistics in context */
+    err = event_context_set_with_cleanup(context, "opt_stats", stats,
+                                         (ValueCleanupFunc)optimization_stats_destroy);
+
+    if (err != EC_SUCCESS) {
+        optimization_stats_destroy(stats);
+        event_result_failure(&result, "Failed to store optimization statistics in context",
+                           err, ERROR_DETAIL_FULL);
+        return result;
+    }
+
+    /* Success */
+    event_result_success(&result);
+    return result;
+}
@@ -0,0 +1,352 @@
+/**
+ * ==============================================================================
+ * TinyLLVM Bytecode VM Benchmark
+ * ==============================================================================
+ *
+ * Times a few CoreTiny workloads on the stack bytecode VM, the in-process
+ * JIT and, where a C compiler is available ($CC, default "cc"), the C
+ * backend's output built at -O0 and -O2. Times for the C builds include
+ * process start-up; the JIT is n/a on hosts it does not support.
+ *
+ * Usage: bench_bytecode [repetitions]
+ */
+
+#include "include/tinyllvm_compiler.h"
+#include "include/tinyllvm_bytecode.h"
+#include "include/tinyllvm_jit.h"
+#include "include/eventchains_platform.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+    const char *name;
+    const char *source;
+} Workload;
+
+static const Workload workloads[] = {
+    {
+        "fib",
+        "func fib(n: int) : int {\n"
+        "    if (n < 2) { return n; }\n"
+        "    return fib(n - 1) + fib(n - 2);\n"
+        "}\n"
+        "func main() : int { print(fib(30)); return 0; }\n"
+    },
+    {
+        "loops",
+        "func main() : int {\n"
+        "    var total = 0;\n"
+        "    var i = 0;\n"
+        "    while (i < 3000) {\n"
+        "        var j = 0;\n"
+        "        while (j < 3000) {\n"
+        "            total = total + i * j + (i - j);\n"
+        "            j = j + 1;\n"
+        "        }\n"
+        "        i = i + 1;\n"
+        "    }\n"
+        "    print(total);\n"
+        "    return 0;\n"
+        "}\n"
+    },
+    {
+        "primes",
+        "func is_prime(n: int) : bool {\n"
+        "    if (n < 2) { return false; }\n"
+        "    var d = 2;\n"
+        "    while (d * d <= n) {\n"
+        "        if (n % d == 0) { return false; }\n"
+        "        d = d + 1;\n"
+        "    }\n"
+        "    return true;\n"
+        "}\n"
+        "func main() : int {\n"
+        "    var count = 0;\n"
+        "    var n = 0;\n"
+        "    while (n < 300000) {\n"
+        "        if (is_prime(n)) { count = count + 1; }\n"
+        "        n = n + 1;\n"
+        "    }\n"
+        "    print(count);\n"
+        "    return 0;\n"
+        "}\n"
+    },
+    {
+        "gcd",
+        "func gcd(a: int, b: int) : int {\n"
+        "    while (b != 0) { var t = b; b = a % b; a = t; }\n"
+        "    return a;\n"
+        "}\n"
+        "func main() : int {\n"
+        "    var sum = 0;\n"
+        "    var a = 1;\n"
+        "    while (a < 1500) {\n"
+        "        var b = 1;\n"
+        "        while (b < 1500) { sum = sum + gcd(a, b); b = b + 1; }\n"
+        "        a = a + 1;\n"
+        "    }\n"
+        "    print(sum);\n"
+        "    return 0;\n"
+        "}\n"
+    }
+};
+
+static double now_seconds(void) {
+#if EC_PLATFORM_POSIX
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+#else
+    return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+static EventChain *compile(const char *source, CompilerConfig *config,
+                           EventExecuteFunc last, const char *last_name) {
+    EventChain *chain = event_chain_create(FAULT_TOLERANCE_STRICT);
+    event_chain_add_event(chain, chainable_event_create(compiler_lexer_event, NULL, "Lexer"));
+    event_chain_add_event(chain, chainable_event_create(compiler_parser_event, NULL, "Parser"));
+    event_chain_add_event(chain, chainable_event_create(compiler_type_checker_event, NULL, "TypeChecker"));
+    event_chain_add_event(chain, chainable_event_create(compiler_optimizer_event, config, "Optimizer"));
+    event_chain_add_event(chain, chainable_event_create(last, config, last_name));
+
+    EventContext *ctx = event_chain_get_context(chain);
+    event_context_set_with_cleanup(ctx, "source_code", strdup(source), free);
+
+    ChainResult result;
+    event_chain_execute(chain, &result);
+    bool success = result.success;
+    if (!success && result.failure_count > 0) {
+        FailureInfo *info = (FailureInfo *)result.failures;
+        fprintf(stderr, "  Error in %s: %s\n", info[0].event_name, info[0].error_message);
+    }
+    chain_result_destroy(&result);
+
+    if (!success) {
+        event_chain_destroy(chain);
+        return NULL;
+    }
+    return chain;
+}
+
+typedef struct {
+    char text[256];
+    size_t length;
+} Output;
+
+static void capture_print(int32_t value, void *user_data) {
+    Output *output = user_data;
+    int written = snprintf(output->text + output->length, sizeof(output->text) - output->length,
+                           "%d\n", value);
+    if (written > 0 && output->length + (size_t)written < sizeof(output->text)) {
+        output->length += (size_t)written;
+    }
+}
+
+/* Best wall time of reps VM runs of main, or a negative value on error */
+static double time_vm(const ByteCode *code, int reps, Output *output) {
+    ByteCodeVM *vm = bytecode_vm_create(code);
+    if (!vm) return -1.0;
+    bytecode_vm_set_print(vm, capture_print, output);
+
+    double best = -1.0;
+    for (int i = 0; i < reps; i++) {
+        output->length = 0;
+        output->text[0] = '\0';
+
+        char error[256];
+        int32_t result;
+        double start = now_seconds();
+        bool ok = bytecode_vm_run(vm, "main", NULL, 0, &result, error, sizeof(error));
+        double elapsed = now_seconds() - start;
+        if (!ok) {
+            fprintf(stderr, "  VM error: %s\n", error);
+            best = -1.0;
+            break;
+        }
+        if (best < 0 || elapsed < best) best = elapsed;
+    }
+
+    bytecode_vm_destroy(vm);
+    return best;
+}
+
+/* Best wall time of reps calls of the JIT-compiled main, or a negative
+ * value if the JIT is unavailable or fails */
+static double time_jit(const char *source, const CompilerConfig *base, int reps, Output *output) {
+    CompilerConfig config = *base;
+    config.jit = true;
+
+    CompilationResult compiled;
+    if (compiler_compile(source, &config, &compiled) != EC_SUCCESS || !compiled.main_function) {
+        compilation_result_destroy(&compiled);
+        return -1.0;
+    }
+    jit_module_set_print(compiled.jit, capture_print, output);
+
+    double best = -1.0;
+    for (int i = 0; i < reps; i++) {
+        output->length = 0;
+        output->text[0] = '\0';
+
+        double start = now_seconds();
+        compiled.main_function();
+        double elapsed = now_seconds() - start;
+        if (jit_module_error(compiled.jit)) {
+            fprintf(stderr, "  JIT error: %s\n", jit_module_error(compiled.jit));
+            best = -1.0;
+            break;
+        }
+        if (best < 0 || elapsed < best) best = elapsed;
+    }
+
+    compilation_result_destroy(&compiled);
+    return best;
+}
+
+#if EC_PLATFORM_POSIX
+static bool write_file(const char *path, const char *content) {
+    FILE *f = fopen(path, "w");
+    if (!f) return false;
+    bool ok = fputs(content, f) >= 0;
+    return fclose(f) == 0 && ok;
+}
+
+static bool read_output(const char *path, Output *output) {
+    FILE *f = fopen(path, "r");
+    if (!f) return false;
+    output->length = fread(output->text, 1, sizeof(output->text) - 1, f);
+    output->text[output->length] = '\0';
+    fclose(f);
+    return true;
+}
+
+/* Build the generated C at the given -O level and return the best wall
+ * time of reps runs, or a negative value if it could not be built */
+static double time_native(const char *name, const char *c_code, const char *cc, int level,
+                          int reps, Output *output) {
+    char source_path[128], exe_path[128], out_path[128], command[512];
+    snprintf(source_path, sizeof(source_path), "bench_%s.c", name);
+    snprintf(exe_path, sizeof(exe_path), "./bench_%s_O%d", name, level);
+    snprintf(out_path, sizeof(out_path), "bench_%s_O%d.txt", name, level);
+
+    if (!write_file(source_path, c_code)) return -1.0;
+
+    snprintf(command, sizeof(command), "%s -O%d -o %s %s 2>/dev/null",
+             cc, level, exe_path, source_path);
+    if (system(command) != 0) return -1.0;
+
+    snprintf(command, sizeof(command), "%s > %s", exe_path, out_path);
+    double best = -1.0;
+    for (int i = 0; i < reps; i++) {
+        double start = now_seconds();
+        int status = system(command);
+        double elapsed = now_seconds() - start;
+        if (status != 0) return -1.0;
+        if (best < 0 || elapsed < best) best = elapsed;
+    }
+
+    bool ok = read_output(out_path, output);
+    remove(out_path);
+    remove(exe_path);
+    remove(source_path);
+    return ok ? best : -1.0;
+}
+#endif
+
+static void print_time(double seconds) {
+    if (seconds < 0) {
+        printf("  %10s", "n/a");
+    } else {
+        printf("  %9.1fms", seconds * 1000.0);
+    }
+}
+
+int main(int argc, char **argv) {
+    int reps = argc > 1 ? atoi(argv[1]) : 3;
+    if (reps < 1) reps = 1;
+
+    const char *cc = getenv("CC");
+    if (!cc || !*cc) cc = "cc";
+
+    event_chain_initialize();
+
+    printf("=== TinyLLVM Bytecode VM Benchmark (best of %d) ===\n\n", reps);
+    printf("%-8s  %11s  %11s  %11s  %11s\n", "workload", "vm", "jit", "cc -O0", "cc -O2");
+
+    bool all_match = true;
+    size_t count = sizeof(workloads) / sizeof(workloads[0]);
+    for (size_t w = 0; w < count; w++) {
+        const Workload *workload = &workloads[w];
+        CompilerConfig config = {
+            .target = TARGET_C,
+            .enable_optimization = true,
+            .optimization_level = 2,
+            .pretty_print = true,
+            .max_memory_bytes = EVENTCHAINS_MAX_CONTEXT_MEMORY,
+            .error_detail = ERROR_DETAIL_FULL,
+            .stop_on_first_error = true
+        };
+
+        EventChain *chain = compile(workload->source, &config, compiler_bytecode_event, "Bytecode");
+        if (!chain) {
+            all_match = false;
+            continue;
+        }
+
+        ByteCode *code = NULL;
+        event_context_get(event_chain_get_context(chain), "bytecode", (void **)&code);
+        Output vm_output = { .text = "", .length = 0 };
+        double vm_time = code ? time_vm(code, reps, &vm_output) : -1.0;
+        event_chain_destroy(chain);
+
+        Output jit_output = { .text = "", .length = 0 };
+        double jit_time = time_jit(workload->source, &config, reps, &jit_output);
+
+        printf("%-8s", workload->name);
+        print_time(vm_time);
+        print_time(jit_time);
+        if (vm_time < 0) all_match = false;
+
+        const char *verdict = "";
+        if (jit_time >= 0 && strcmp(jit_output.text, vm_output.text) != 0) {
+            verdict = "  OUTPUT MISMATCH";
+            all_match = false;
+        }
+#if EC_PLATFORM_POSIX
+        chain = compile(workload->source, &config, compiler_codegen_event, "CodeGen");
+        char *c_code = NULL;
+        if (chain) event_context_get(event_chain_get_context(chain), "output_code", (void **)&c_code);
+
+        const int levels[] = { 0, 2 };
+        for (size_t i = 0; i < sizeof(levels) / sizeof(levels[0]); i++) {
+            Output native_output = { .text = "", .length = 0 };
+            double native_time = c_code
+                ? time_native(workload->name, c_code, cc, levels[i], reps, &native_output)
+                : -1.0;
+            print_time(native_time);
+
+            if (native_time >= 0 && strcmp(native_output.text, vm_output.text) != 0) {
+                verdict = "  OUTPUT MISMATCH";
+                all_match = false;
+            } else if (native_time >= 0 && vm_time >= 0 && jit_time >= 0 && levels[i] == 0 &&
+                       all_match) {
+                static char ratio[64];
+                snprintf(ratio, sizeof(ratio), "  vm/O0 = %.1fx, jit/O0 = %.2fx",
+                         vm_time / native_time, jit_time / native_time);
+                verdict = ratio;
+            }
+        }
+        event_chain_destroy(chain);
+#else
+        print_time(-1.0);
+        print_time(-1.0);
+#endif
+        printf("%s\n", verdict);
+    }
+
+    event_chain_cleanup();
+    return all_match ? 0 : 1;
+}
@@ -0,0 +1,969 @@
+/**
+ * ==============================================================================
+ * TinyLLVM - IR Example Tests
+ * ==============================================================================
+ *
+ * Runs every CoreTiny program in tests/examples_coretiny.c (path given as
+ * the first argument) through the TinyLLVM IR tooling: the printed IR must
+ * parse back into a module that prints identically, and interpreting it
+ * must print the program's expected output. The stack bytecode VM and,
+ * on x86-64 POSIX hosts, the JIT must print the same, as must the x86-64
+ * assembly backend's output and the ELF object writer's once linked by cc
+ * (skipped without one). So must the LLVM IR backend's output on POSIX
+ * hosts where clang, or llc and cc, can build it.
+ */
+
+#include "include/tinyllvm_compiler.h"
+#include "include/tinyllvm_ir.h"
+#include "include/tinyllvm_bytecode.h"
+#include "include/tinyllvm_jit.h"
+#include "include/eventchains.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+#define MAX_EXAMPLES 32
+
+#if EC_PLATFORM_POSIX
+#define TEST_NATIVE 1
+#include <sys/wait.h>
+#else
+#define TEST_NATIVE 0
+#endif
+
+#if defined(__x86_64__) && EC_PLATFORM_POSIX
+#define TEST_JIT 1
+#define TEST_ASM 1
+#else
+#define TEST_JIT 0
+#define TEST_ASM 0
+#endif
+
+typedef struct {
+    char *title;
+    char *source;
+} Example;
+
+/* What each example prints when run */
+static const struct {
+    const char *title;
+    const char *output;
+} expected_outputs[] = {
+    { "Factorial",                               "120\n" },
+    { "Greatest Common Divisor (GCD)",           "6\n" },
+    { "Is Prime",                                "1\n" },
+    { "Fibonacci",                               "55\n" },
+    { "Sum of Array Elements (using recursion)", "5050\n" },
+    { "Logical Operations",                      "1\n" },
+    { "Multiple Conditions",                     "-1\n0\n1\n" },
+    { "Power Function",                          "1024\n" }
+};
+
+static int failures = 0;
+
+#if TEST_NATIVE
+/* Whether cc can assemble and link the x86-64 backend's output */
+static bool have_cc = false;
+
+/* Command building test_ir_examples_native.ll into a program, NULL if no
+ * LLVM tool here can */
+static const char *llvm_build = NULL;
+#endif
+
+static void check(bool condition, const char *test, const char *what) {
+    if (condition) {
+        printf("  ✓ %s\n", what);
+    } else {
+        printf("  ❌ %s: %s\n", test, what);
+        failures++;
+    }
+}
+
+/* ==============================================================================
+ * Example Extraction
+ * ==============================================================================
+ */
+
+static char *read_file(const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (!file) return NULL;
+
+    char *data = NULL;
+    long size = -1;
+    if (fseek(file, 0, SEEK_END) == 0) size = ftell(file);
+    if (size >= 0 && fseek(file, 0, SEEK_SET) == 0) {
+        data = malloc((size_t)size + 1);
+        if (data && fread(data, 1, (size_t)size, file) != (size_t)size) {
+            free(data);
+            data = NULL;
+        }
+        if (data) data[size] = '\0';
+    }
+    fclose(file);
+    return data;
+}
+
+static char *copy_span(const char *start, size_t len) {
+    char *copy = malloc(len + 1);
+    if (copy) {
+        memcpy(copy, start, len);
+        copy[len] = '\0';
+    }
+    return copy;
+}
+
+/*
+ * Each example is a comment block with an "Example N: Title" line and a
+ * "CoreTiny:" section whose lines are prefixed by " * ", ending at the
+ * close of the comment or the "C Equivalent:" section.
+ */
+static size_t extract_examples(const char *text, Example *examples, size_t max) {
+    size_t count = 0;
+    const char *pos = text;
+
+    while (count < max && (pos = strstr(pos, " * Example ")) != NULL) {
+        const char *title = strchr(pos, ':');
+        const char *title_end = title ? strchr(title, '\n') : NULL;
+        const char *code = strstr(pos, " * CoreTiny:\n * ---------\n");
+        if (!title || !title_end || !code) break;
+
+        code += strlen(" * CoreTiny:\n * ---------\n");
+        const char *close = strstr(code, " */");
+        const char *other = strstr(code, " * C Equivalent:");
+        const char *end = other && other < close ? other : close;
+        if (!end) break;
+
+        /* Strip the comment prefix from each line */
+        char *source = malloc((size_t)(end - code) + 1);
+        if (!source) break;
+        size_t len = 0;
+        for (const char *line = code; line < end;) {
+            const char *next = strchr(line, '\n');
+            if (!next || next > end) next = end;
+            if (strncmp(line, " * ", 3) == 0) line += 3;
+            else if (strncmp(line, " *", 2) == 0) line += 2;
+            memcpy(source + len, line, (size_t)(next - line));
+            len += (size_t)(next - line);
+            source[len++] = '\n';
+            line = next + 1;
+        }
+        source[len] = '\0';
+
+        examples[count].title = copy_span(title + 2, (size_t)(title_end - title - 2));
+        examples[count].source = source;
+        count++;
+        pos = end;
+    }
+    return count;
+}
+
+/* ==============================================================================
+ * Compilation
+ * ==============================================================================
+ */
+
+static CompilerConfig example_config(int level) {
+    CompilerConfig config = {
+        .target = TARGET_TINYLLVM,
+        .enable_optimization = level > 0,
+        .optimization_level = level,
+        .emit_comments = true,
+        .pretty_print = true,
+        .max_memory_bytes = EVENTCHAINS_MAX_CONTEXT_MEMORY,
+        .error_detail = ERROR_DETAIL_FULL,
+        .stop_on_first_error = true
+    };
+    return config;
+}
+
+/* Run the front end, the optimizer and then `last` over source. The chain
+ * is returned so results can be read from its context; NULL on failure */
+static EventChain *run_pipeline(const char *source, CompilerConfig *config,
+                                EventExecuteFunc last, const char *last_name) {
+    EventChain *chain = event_chain_create(FAULT_TOLERANCE_STRICT);
+    event_chain_add_event(chain, chainable_event_create(compiler_lexer_event, NULL, "Lexer"));
+    event_chain_add_event(chain, chainable_event_create(compiler_parser_event, NULL, "Parser"));
+    event_chain_add_event(chain, chainable_event_create(compiler_type_checker_event, NULL, "TypeChecker"));
+    event_chain_add_event(chain, chainable_event_create(compiler_optimizer_event, config, "Optimizer"));
+    event_chain_add_event(chain, chainable_event_create(last, config, last_name));
+
+    EventContext *ctx = event_chain_get_context(chain);
+    event_context_set_with_cleanup(ctx, "source_code", strdup(source), free);
+
+    ChainResult result;
+    event_chain_execute(chain, &result);
+
+    bool success = result.success;
+    if (!success && result.failure_count > 0) {
+        FailureInfo *info = (FailureInfo *)result.failures;
+        printf("  Error in %s: %s\n", info[0].event_name, info[0].error_message);
+    }
+
+    chain_result_destroy(&result);
+    if (!success) {
+        event_chain_destroy(chain);
+        return NULL;
+    }
+    return chain;
+}
+
+static char *compile_to_target(const char *source, int level, CodeGenTarget target) {
+    CompilerConfig config = example_config(level);
+    config.target = target;
+    EventChain *chain = run_pipeline(source, &config, compiler_codegen_event, "CodeGen");
+    if (!chain) return NULL;
+
+    char *ir = NULL;
+    char *code = NULL;
+    event_context_get(event_chain_get_context(chain), "output_code", (void **)&code);
+    if (code) ir = strdup(code);
+
+    event_chain_destroy(chain);
+    return ir;
+}
+
+static char *compile_to_ir(const char *source, int level) {
+    return compile_to_target(source, level, TARGET_TINYLLVM);
+}
+
+/* ==============================================================================
+ * Interpretation
+ * ==============================================================================
+ */
+
+typedef struct {
+    char text[1024];
+    size_t length;
+} PrintBuffer;
+
+static void capture_print(int32_t value, void *user_data) {
+    PrintBuffer *buffer = user_data;
+    if (buffer->length >= sizeof(buffer->text)) return;
+
+    int len = snprintf(buffer->text + buffer->length, sizeof(buffer->text) - buffer->length,
+                       "%d\n", (int)value);
+    if (len > 0) buffer->length += (size_t)len;
+}
+
+/* Run main, capturing what it prints; false (error set) if it fails */
+static bool run_main(const IRModule *module, PrintBuffer *printed, int32_t *result,
+                     char *error, size_t error_size) {
+    printed->text[0] = '\0';
+    printed->length = 0;
+
+    IRProgram *program = ir_program_create(module, error, error_size);
+    if (!program) return false;
+
+    ir_program_set_print(program, capture_print, printed);
+    bool ok = ir_program_run(program, "main", NULL, 0, result, error, error_size);
+    ir_program_destroy(program);
+    return ok;
+}
+
+/* Compile to stack bytecode and run main on the VM */
+static bool run_bytecode(const char *source, int level, PrintBuffer *printed, int32_t *result,
+                         char *error, size_t error_size) {
+    printed->text[0] = '\0';
+    printed->length = 0;
+
+    CompilerConfig config = example_config(level);
+    EventChain *chain = run_pipeline(source, &config, compiler_bytecode_event, "Bytecode");
+    if (!chain) {
+        snprintf(error, error_size, "compilation failed");
+        return false;
+    }
+
+    ByteCode *code = NULL;
+    event_context_get(event_chain_get_context(chain), "bytecode", (void **)&code);
+    ByteCodeVM *vm = bytecode_vm_create(code);
+    bool ok = vm != NULL;
+    if (ok) {
+        bytecode_vm_set_print(vm, capture_print, printed);
+        ok = bytecode_vm_run(vm, "main", NULL, 0, result, error, error_size);
+    } else {
+        snprintf(error, error_size, "no bytecode");
+    }
+
+    bytecode_vm_destroy(vm);
+    event_chain_destroy(chain);
+    return ok;
+}
+
+/* Compile with config.jit through compiler_compile and call main natively */
+static bool run_jit(const char *source, int level, PrintBuffer *printed, int32_t *result,
+                    char *error, size_t error_size) {
+    printed->text[0] = '\0';
+    printed->length = 0;
+
+    CompilerConfig config = example_config(level);
+    config.jit = true;
+
+    CompilationResult compiled;
+    if (compiler_compile(source, &config, &compiled) != EC_SUCCESS || !compiled.main_function) {
+        snprintf(error, error_size, "%s", compiled.error_count > 0 ? compiled.errors[0] : "no main");
+        compilation_result_destroy(&compiled);
+        return false;
+    }
+
+    jit_module_set_print(compiled.jit, capture_print, printed);
+    *result = compiled.main_function();
+
+    const char *runtime_error = jit_module_error(compiled.jit);
+    if (runtime_error) snprintf(error, error_size, "%s", runtime_error);
+
+    compilation_result_destroy(&compiled);
+    return runtime_error == NULL;
+}
+
+#if TEST_NATIVE
+/* Write the program for TARGET_ASM_X86_64 (assembly), TARGET_LLVM or
+ * TARGET_ELF_X86_64 (object, through compiler_compile) to path */
+static bool write_native(const char *source, int level, CodeGenTarget target, const char *path) {
+    char *code = NULL;
+    size_t length = 0;
+
+    if (target == TARGET_ELF_X86_64) {
+        CompilerConfig config = example_config(level);
+        config.target = target;
+        CompilationResult compiled;
+        if (compiler_compile(source, &config, &compiled) == EC_SUCCESS) {
+            code = compiled.output_code;
+            length = compiled.output_length;
+            compiled.output_code = NULL;
+        }
+        compilation_result_destroy(&compiled);
+    } else {
+        code = compile_to_target(source, level, target);
+        length = code ? strlen(code) : 0;
+    }
+    if (!code) return false;
+
+    FILE *file = fopen(path, "wb");
+    bool ok = file && fwrite(code, 1, length, file) == length;
+    if (file && fclose(file) != 0) ok = false;
+    free(code);
+    return ok;
+}
+
+/* Compile for an x86-64 assembly or object target or for LLVM, build the
+ * program and run it, capturing its output and exit status */
+static bool run_native(const char *source, int level, CodeGenTarget target, PrintBuffer *printed,
+                       int *status, char *error, size_t error_size) {
+    printed->text[0] = '\0';
+    printed->length = 0;
+
+    const char *path = target == TARGET_ELF_X86_64 ? "test_ir_examples_native.o" :
+                       target == TARGET_LLVM ? "test_ir_examples_native.ll" :
+                                               "test_ir_examples_native.s";
+    if (!write_native(source, level, target, path)) {
+        snprintf(error, error_size, "compilation failed");
+        return false;
+    }
+
+    char command[512];
+    if (target == TARGET_LLVM) {
+        snprintf(command, sizeof(command), "%s", llvm_build);
+    } else {
+        snprintf(command, sizeof(command), "cc -o test_ir_examples_native %s", path);
+    }
+    bool built = system(command) == 0;
+    remove(path);
+    remove("test_ir_examples_native.o");
+    if (!built) {
+        snprintf(error, error_size, "cc could not build %s", path);
+        return false;
+    }
+
+    FILE *program = popen("./test_ir_examples_native", "r");
+    if (!program) {
+        snprintf(error, error_size, "cannot run the program");
+        return false;
+    }
+    printed->length = fread(printed->text, 1, sizeof(printed->text) - 1, program);
+    printed->text[printed->length] = '\0';
+
+    int raw = pclose(program);
+    *status = WIFEXITED(raw) ? WEXITSTATUS(raw) : -1;
+
+    remove("test_ir_examples_native");
+    return true;
+}
+
+/* The first LLVM toolchain that builds a probe program: clang, else llc
+ * and cc. LLVM 14 only reads opaque pointers when asked */
+static const char *find_llvm_build(void) {
+    static const char *const commands[] = {
+        "clang -O2 -o test_ir_examples_native test_ir_examples_native.ll 2> /dev/null",
+        "llc -O2 -relocation-model=pic -filetype=obj -o test_ir_examples_native.o "
+            "test_ir_examples_native.ll 2> /dev/null && "
+            "cc -o test_ir_examples_native test_ir_examples_native.o",
+        "llc -O2 -opaque-pointers -relocation-model=pic -filetype=obj -o test_ir_examples_native.o "
+            "test_ir_examples_native.ll 2> /dev/null && "
+            "cc -o test_ir_examples_native test_ir_examples_native.o"
+    };
+    const char *probe = "func main() : int { print(7); return 0; }\n";
+
+    for (size_t i = 0; i < sizeof(commands) / sizeof(commands[0]); i++) {
+        if (i > 0 && !have_cc) break;
+
+        char error[256];
+        PrintBuffer output;
+        int status = -1;
+        llvm_build = commands[i];
+        if (run_native(probe, 0, TARGET_LLVM, &output, &status, error, sizeof(error)) &&
+            strcmp(output.text, "7\n") == 0 && status == 0) {
+            return llvm_build;
+        }
+    }
+    return NULL;
+}
+#endif
+
+static const char *expected_output(const char *title) {
+    for (size_t i = 0; i < sizeof(expected_outputs) / sizeof(expected_outputs[0]); i++) {
+        if (strcmp(expected_outputs[i].title, title) == 0) return expected_outputs[i].output;
+    }
+    return NULL;
+}
+
+/* ==============================================================================
+ * Examples
+ * ==============================================================================
+ */
+
+static void test_example(const Example *example) {
+    static const int levels[] = { 0, 2 };
+    const char *expected = expected_output(example->title);
+
+    for (size_t i = 0; i < sizeof(levels) / sizeof(levels[0]); i++) {
+        char what[128];
+        char *ir = compile_to_ir(example->source, levels[i]);
+        snprintf(what, sizeof(what), "-O%d IR parses and prints identically", levels[i]);
+        if (!ir) {
+            check(false, example->title, what);
+            continue;
+        }
+
+        char error[256];
+        IRModule *module = ir_parse_module(ir, error, sizeof(error));
+        if (!module) printf("  %s\n", error);
+
+        char *printed = module ? ir_print_module(module, true) : NULL;
+        check(printed && strcmp(printed, ir) == 0, example->title, what);
+
+        PrintBuffer output;
+        int32_t result = -1;
+        bool ran = module && run_main(module, &output, &result, error, sizeof(error));
+        if (module && !ran) printf("  %s\n", error);
+
+        snprintf(what, sizeof(what), "-O%d IR interprets to the expected output", levels[i]);
+        check(ran && expected && strcmp(output.text, expected) == 0 && result == 0,
+              example->title, what);
+
+        result = -1;
+        ran = run_bytecode(example->source, levels[i], &output, &result, error, sizeof(error));
+        if (!ran) printf("  %s\n", error);
+
+        snprintf(what, sizeof(what), "-O%d bytecode runs to the expected output", levels[i]);
+        check(ran && expected && strcmp(output.text, expected) == 0 && result == 0,
+              example->title, what);
+
+        if (TEST_JIT) {
+            result = -1;
+            ran = run_jit(example->source, levels[i], &output, &result, error, sizeof(error));
+            if (!ran) printf("  %s\n", error);
+
+            snprintf(what, sizeof(what), "-O%d JIT runs to the expected output", levels[i]);
+            check(ran && expected && strcmp(output.text, expected) == 0 && result == 0,
+                  example->title, what);
+        }
+
+#if TEST_NATIVE
+        static const struct {
+            CodeGenTarget target;
+            const char *name;
+        } natives[] = {
+            { TARGET_ASM_X86_64, "assembly" }, { TARGET_ELF_X86_64, "object" },
+            { TARGET_LLVM, "LLVM IR" }
+        };
+        for (size_t n = 0; n < sizeof(natives) / sizeof(natives[0]); n++) {
+            bool available = natives[n].target == TARGET_LLVM ? llvm_build != NULL
+                                                              : TEST_ASM && have_cc;
+            if (!available) continue;
+
+            int status = -1;
+            ran = run_native(example->source, levels[i], natives[n].target, &output, &status,
+                             error, sizeof(error));
+            if (!ran) printf("  %s\n", error);
+
+            snprintf(what, sizeof(what), "-O%d %s links and runs to the expected output",
+                     levels[i], natives[n].name);
+            check(ran && expected && strcmp(output.text, expected) == 0 && status == 0,
+                  example->title, what);
+        }
+#endif
+
+        free(printed);
+        ir_module_destroy(module);
+        free(ir);
+    }
+}
+
+static void test_interpreter(void) {
+    printf("\nInterpreter\n");
+
+    /* Shadowed variables get their own slots in the IR */
+    const char *shadowing =
+        "func pick(a: int) : int {\n"
+        "    var c = a;\n"
+        "    { var a = 100; print(c + a); }\n"
+        "    var k = 0;\n"
+        "    while (k < 2) { var c = k * 10; print(c); k = k + 1; }\n"
+        "    return c + a;\n"
+        "}\n"
+        "func main() : int { print(pick(1)); return 0; }\n";
+
+    char error[256];
+    for (int level = 0; level <= 2; level += 2) {
+        char *ir = compile_to_ir(shadowing, level);
+        IRModule *module = ir ? ir_parse_module(ir, error, sizeof(error)) : NULL;
+        PrintBuffer output;
+        int32_t result = -1;
+        bool ran = module && run_main(module, &output, &result, error, sizeof(error));
+        check(ran && strcmp(output.text, "101\n0\n10\n2\n") == 0,
+              "interpreter", level == 0 ? "shadowed variables at -O0" : "shadowed variables at -O2");
+        ir_module_destroy(module);
+        free(ir);
+    }
+
+    /* Phis that swap values need their moves done in parallel */
+    IRModule *module = ir_parse_module(
+        "define i32 @main() {\n"
+        "entry:\n"
+        "  %t0 = const i32 1\n"
+        "  %t1 = const i32 2\n"
+        "  %t2 = const i32 0\n"
+        "  br label %L0\n"
+        "\n"
+        "L0:\n"
+        "  %t3 = phi i32 [ %t0, %entry ], [ %t4, %L0 ]\n"
+        "  %t4 = phi i32 [ %t1, %entry ], [ %t3, %L0 ]\n"
+        "  %t5 = phi i32 [ %t2, %entry ], [ %t7, %L0 ]\n"
+        "  call void @print(i32 %t3)\n"
+        "  %t6 = const i32 1\n"
+        "  %t7 = add i32 %t5, %t6\n"
+        "  %t8 = icmp lt i32 %t7, %t1\n"
+        "  br i1 %t8, label %L0, label %L1\n"
+        "\n"
+        "L1:\n"
+        "  ret i32 %t4\n"
+        "}\n", error, sizeof(error));
+    PrintBuffer output;
+    int32_t result = -1;
+    bool ran = module && run_main(module, &output, &result, error, sizeof(error));
+    check(ran && strcmp(output.text, "1\n2\n") == 0 && result == 1, "interpreter",
+          "swapping phis read their old values");
+    ir_module_destroy(module);
+
+    module = ir_parse_module(
+        "define i32 @main() {\n"
+        "entry:\n"
+        "  %t0 = const i32 7\n"
+        "  %t1 = const i32 0\n"
+        "  %t2 = div i32 %t0, %t1\n"
+        "  ret i32 %t2\n"
+        "}\n", error, sizeof(error));
+    ran = module && run_main(module, &output, &result, error, sizeof(error));
+    check(module && !ran && strstr(error, "division by zero") != NULL, "interpreter",
+          "division by zero reported");
+    ir_module_destroy(module);
+
+    module = ir_parse_module(
+        "define i32 @main() {\n"
+        "entry:\n"
+        "  %t0 = call i32 @missing()\n"
+        "  ret i32 %t0\n"
+        "}\n", error, sizeof(error));
+    IRProgram *program = module ? ir_program_create(module, error, sizeof(error)) : NULL;
+    check(module && !program && strstr(error, "@missing") != NULL, "interpreter",
+          "call to an undefined function rejected");
+    ir_program_destroy(program);
+    ir_module_destroy(module);
+}
+
+static size_t count_instructions(const ByteCode *code, InstructionType type) {
+    size_t count = 0;
+    for (size_t i = 0; i < code->count; i++) {
+        if (code->instructions[i].type == type) count++;
+    }
+    return count;
+}
+
+static void test_bytecode(void) {
+    printf("\nBytecode\n");
+
+    const char *source =
+        "func sum(n: int, step: int) : int {\n"
+        "    var total = 0;\n"
+        "    var i = 0;\n"
+        "    while (i < n && total >= 0) { total = total + i; i = i + step; }\n"
+        "    if (!(total == 0) || n < 0) { return total; }\n"
+        "    return 0 - 1;\n"
+        "}\n"
+        "func main() : int { print(sum(10, 1)); print(sum(0, 1)); return 0; }\n";
+
+    CompilerConfig config = example_config(0);
+    EventChain *chain = run_pipeline(source, &config, compiler_bytecode_event, "Bytecode");
+    ByteCode *code = NULL;
+    if (chain) event_context_get(event_chain_get_context(chain), "bytecode", (void **)&code);
+    check(code != NULL, "bytecode", "event stores context[\"bytecode\"]");
+    if (!code) {
+        event_chain_destroy(chain);
+        return;
+    }
+
+    size_t sum = bytecode_find_function(code, "sum");
+    check(sum != (size_t)-1 && code->functions[sum].param_count == 2 &&
+          code->functions[sum].local_count == 4, "bytecode",
+          "parameters and locals share numbered slots");
+    check(count_instructions(code, INSTR_LOAD2_ADD) >= 1, "bytecode",
+          "load+load+add fused");
+    check(count_instructions(code, INSTR_LOAD2) >= 1, "bytecode", "load pair fused");
+    check(count_instructions(code, INSTR_JUMP_IF_LT) + count_instructions(code, INSTR_JUMP_IF_GE) >= 1 &&
+          count_instructions(code, INSTR_LT) == 0, "bytecode",
+          "comparisons feeding jumps become compare-and-branch");
+
+    /* The middleware reads the first fields and opcodes by position */
+    check(INSTR_PUSH == 0 && INSTR_DIV == 4 && sizeof(Instruction) == 2 * sizeof(int) &&
+          offsetof(ByteCode, count) == sizeof(void *), "bytecode",
+          "layout matches the overflow fuzzer's view");
+
+    ByteCodeVM *vm = bytecode_vm_create(code);
+    PrintBuffer output = { .text = "", .length = 0 };
+    int32_t result = -1;
+    char error[256];
+    bytecode_vm_set_print(vm, capture_print, &output);
+    bool ran = bytecode_vm_run(vm, "main", NULL, 0, &result, error, sizeof(error));
+    check(ran && strcmp(output.text, "45\n-1\n") == 0, "bytecode", "short-circuit conditions");
+
+    int32_t args[2] = { 5, 2 };
+    ran = bytecode_vm_run(vm, "sum", args, 2, &result, error, sizeof(error));
+    check(ran && result == 6, "bytecode", "a VM runs any function, reusing its stacks");
+
+    bytecode_vm_destroy(vm);
+    event_chain_destroy(chain);
+
+    /* Shadowing, recursion depth and runtime errors */
+    const char *errors =
+        "func down(n: int) : int { if (n == 0) { return 0; } return down(n - 1) + 1; }\n"
+        "func main() : int {\n"
+        "    var a = 1;\n"
+        "    { var a = a + 10; print(a); }\n"
+        "    print(a);\n"
+        "    print(down(100000));\n"
+        "    var z = a - 1;\n"
+        "    print(7 / z);\n"
+        "    return 0;\n"
+        "}\n";
+    ran = run_bytecode(errors, 0, &output, &result, error, sizeof(error));
+    check(!ran && strcmp(output.text, "11\n1\n100000\n") == 0 &&
+          strstr(error, "division by zero") != NULL, "bytecode",
+          "shadowing, deep recursion and division by zero");
+}
+
+static void test_jit(void) {
+    printf("\nJIT\n");
+
+    const char *source =
+        "func down(n: int) : int { if (n == 0) { return 0; } return down(n - 1) + 1; }\n"
+        "func forever(n: int) : int { return forever(n + 1) + 1; }\n"
+        "func div(a: int, b: int) : int { return a / b; }\n"
+        "func order(a: int, b: int, c: int) : int { return a - b * c; }\n"
+        "func main() : int {\n"
+        "    var a = 1;\n"
+        "    { var a = a + 10; print(a); }\n"
+        "    print(a);\n"
+        "    print(down(100000));\n"
+        "    return 7;\n"
+        "}\n";
+
+    CompilerConfig config = example_config(0);
+    config.jit = true;
+
+    CompilationResult compiled;
+    bool ok = compiler_compile(source, &config, &compiled) == EC_SUCCESS;
+    check(ok && compiled.jit && compiled.main_function && !compiled.output_code, "jit",
+          "compiler_compile returns a callable main");
+    if (!ok || !compiled.main_function) {
+        compilation_result_destroy(&compiled);
+        return;
+    }
+
+    PrintBuffer output = { .text = "", .length = 0 };
+    jit_module_set_print(compiled.jit, capture_print, &output);
+    int32_t result = compiled.main_function();
+    check(result == 7 && strcmp(output.text, "11\n1\n100000\n") == 0 &&
+          !jit_module_error(compiled.jit), "jit", "shadowing and deep recursion");
+
+    char error[256];
+    int32_t args[3] = { 100, 3, 7 };
+    ok = jit_module_run(compiled.jit, "order", args, 3, &result, error, sizeof(error));
+    check(ok && result == 79, "jit", "arguments arrive in order");
+
+    args[0] = 7;
+    args[1] = 0;
+    ok = jit_module_run(compiled.jit, "div", args, 2, &result, error, sizeof(error));
+    check(!ok && strstr(error, "division by zero") != NULL, "jit", "division by zero is reported");
+
+    args[0] = INT32_MIN;
+    args[1] = -1;
+    ok = jit_module_run(compiled.jit, "div", args, 2, &result, error, sizeof(error));
+    check(!ok && strstr(error, "division overflow") != NULL, "jit", "INT_MIN / -1 is reported");
+
+    ok = jit_module_run(compiled.jit, "forever", args, 1, &result, error, sizeof(error));
+    check(!ok && strstr(error, "stack overflow") != NULL, "jit", "runaway recursion is reported");
+
+    args[0] = 84;
+    args[1] = 2;
+    ok = jit_module_run(compiled.jit, "div", args, 2, &result, error, sizeof(error));
+    check(ok && result == 42, "jit", "module is usable after runtime errors");
+
+    compilation_result_destroy(&compiled);
+
+    /* At -O2 strength reduction emits shifts and multiply-high */
+    const char *arithmetic =
+        "func main() : int {\n"
+        "    var i = 0;\n"
+        "    var s = 0;\n"
+        "    while (i < 200) {\n"
+        "        var a = i * 104729 - 7000000;\n"
+        "        var t = a * 8 - a / 4 + a / 7 - a % 16 + a * 10;\n"
+        "        if (t > 100 || !(a != i)) { t = t % 9; }\n"
+        "        s = s + t;\n"
+        "        i = i + 1;\n"
+        "    }\n"
+        "    print(s);\n"
+        "    return 0;\n"
+        "}\n";
+
+    PrintBuffer native;
+    int32_t native_result = -1;
+    ok = run_jit(arithmetic, 2, &native, &native_result, error, sizeof(error));
+    result = -1;
+    ok = run_bytecode(arithmetic, 2, &output, &result, error, sizeof(error)) && ok;
+    check(ok && native_result == 0 && strcmp(native.text, output.text) == 0, "jit",
+          "lowered arithmetic agrees with the VM");
+}
+
+#if TEST_ASM
+static void test_asm(void) {
+    printf("\nx86-64 Assembly\n");
+
+    const char *selection =
+        "func f(a: int, b: int) : int {\n"
+        "    if (a < b) { return a * 12; }\n"
+        "    return a + b * 5;\n"
+        "}\n"
+        "func main() : int { return f(1, 2); }\n";
+
+    char *assembly = compile_to_target(selection, 0, TARGET_ASM_X86_64);
+    check(assembly && strstr(assembly, "\tcmpl\t") && !strstr(assembly, "\tsetl\t"), "asm",
+          "compare fused into the branch");
+    check(assembly && strstr(assembly, "\timull\t$12, ") && strstr(assembly, ",4), "),
+          "asm", "imul with an immediate and lea for a scaled add");
+    free(assembly);
+
+    if (!have_cc) {
+        printf("  (no cc: linked programs not checked)\n");
+        return;
+    }
+
+    /* Nine arguments, more live values than registers across calls, and
+     * phis that rotate each other in a loop */
+    const char *source =
+        "func many(a: int, b: int, c: int, d: int, e: int, f: int, g: int, h: int, i: int) : int {\n"
+        "    return a - b * 2 + c * 3 - d * 4 + e * 5 - f * 6 + g * 7 - h * 8 + i * 9;\n"
+        "}\n"
+        "func rotate(n: int) : int {\n"
+        "    var a = 1; var b = 2; var c = 3; var k = 0;\n"
+        "    while (k < n) { var t = a; a = b; b = c; c = t + k; k = k + 1; }\n"
+        "    return a * 100 + b * 10 + c;\n"
+        "}\n"
+        "func pressure(x: int) : int {\n"
+        "    var a = x + 1; var b = x * 3; var c = x - 7; var d = x / 3; var e = x % 5;\n"
+        "    var f = a * b; var g = c * d; var h = e + f; var i = g - h; var j = a + i;\n"
+        "    var k = many(a, b, c, d, e, f, g, h, i);\n"
+        "    var l = many(b, c, d, e, f, g, h, i, j);\n"
+        "    return a + b + c + d + e + f + g + h + i + j + k + l;\n"
+        "}\n"
+        "func main() : int {\n"
+        "    print(many(1, 2, 3, 4, 5, 6, 7, 8, 9));\n"
+        "    print(rotate(10));\n"
+        "    print(pressure(17));\n"
+        "    print(pressure(0 - 5));\n"
+        "    return 42;\n"
+        "}\n";
+
+    static const int levels[] = { 0, 2 };
+    for (size_t i = 0; i < sizeof(levels) / sizeof(levels[0]); i++) {
+        char error[256], what[128];
+        PrintBuffer output, reference;
+        int status = -1;
+        int32_t result = -1;
+        bool ok = run_native(source, levels[i], TARGET_ASM_X86_64, &output, &status,
+                             error, sizeof(error));
+        if (!ok) printf("  %s\n", error);
+        ok = run_bytecode(source, levels[i], &reference, &result, error, sizeof(error)) && ok;
+
+        snprintf(what, sizeof(what), "-O%d spills, stack arguments and phi cycles", levels[i]);
+        check(ok && strcmp(output.text, reference.text) == 0 && status == 42 && result == 42,
+              "asm", what);
+
+        /* The same program through the integrated assembler */
+        status = -1;
+        ok = run_native(source, levels[i], TARGET_ELF_X86_64, &output, &status,
+                        error, sizeof(error));
+        if (!ok) printf("  %s\n", error);
+
+        snprintf(what, sizeof(what), "-O%d object file links and matches", levels[i]);
+        check(ok && strcmp(output.text, reference.text) == 0 && status == 42, "asm", what);
+    }
+}
+#endif
+
+static void test_llvm(void) {
+    printf("\nLLVM IR\n");
+
+    /* Bools stored alongside call results in one variable, bool
+     * parameters and returns, and arithmetic left for LLVM to lower */
+    const char *source =
+        "func is_even(n: int) : bool { return n % 2 == 0; }\n"
+        "func both(a: bool, b: bool) : bool { return a && b; }\n"
+        "func count(n: int) : int {\n"
+        "    var hits = 0; var flag = false; var i = 0;\n"
+        "    while (i < n) {\n"
+        "        flag = is_even(i);\n"
+        "        if (both(flag, i > 3)) { hits = hits + 1; }\n"
+        "        if (flag) { print(i / 3 + i % 5); }\n"
+        "        i = i + 1;\n"
+        "    }\n"
+        "    if (flag) { print(1); }\n"
+        "    return hits;\n"
+        "}\n"
+        "func main() : int {\n"
+        "    print(count(7));\n"
+        "    var m = 0 - 7;\n"
+        "    print(m / 2); print(m % 3); print(m * 123456789);\n"
+        "    return 3;\n"
+        "}\n";
+
+    char *ll = compile_to_target(source, 0, TARGET_LLVM);
+    check(ll && strstr(ll, "declare i32 @printf(ptr, ...)") &&
+          strstr(ll, "call i32 (ptr, ...) @printf(ptr @.print_format, i32 "), "llvm",
+          "print calls printf through an opaque pointer");
+    check(ll && strstr(ll, "define internal i1 @both(i1 %a.param, i1 %b.param)") &&
+          strstr(ll, "define i32 @main()"), "llvm", "bool signatures and an external main");
+    check(ll && strstr(ll, " = zext i1 ") && !strstr(ll, " = const "), "llvm",
+          "i1 values widened, constants folded into their uses");
+    free(ll);
+
+    ll = compile_to_target(source, 2, TARGET_LLVM);
+    check(ll && strstr(ll, "sdiv i32 ") && strstr(ll, "srem i32 ") && !strstr(ll, "ashr"),
+          "llvm", "division left to LLVM at -O2");
+    free(ll);
+
+#if TEST_NATIVE
+    if (!llvm_build) {
+        printf("  (no clang or llc: LLVM IR not built)\n");
+        return;
+    }
+
+    static const int levels[] = { 0, 2 };
+    for (size_t i = 0; i < sizeof(levels) / sizeof(levels[0]); i++) {
+        char error[256], what[128];
+        PrintBuffer output, reference;
+        int status = -1;
+        int32_t result = -1;
+        bool ok = run_native(source, levels[i], TARGET_LLVM, &output, &status,
+                             error, sizeof(error));
+        if (!ok) printf("  %s\n", error);
+        ok = run_bytecode(source, levels[i], &reference, &result, error, sizeof(error)) && ok;
+
+        snprintf(what, sizeof(what), "-O%d LLVM build matches the VM", levels[i]);
+        check(ok && strcmp(output.text, reference.text) == 0 && status == 3 && result == 3,
+              "llvm", what);
+    }
+#endif
+}
+
+static void test_parse_errors(void) {
+    printf("\nMalformed IR\n");
+
+    char error[256];
+    IRModule *module = ir_parse_module("define i32 @f() {\nentry:\n  br label %L9\n}\n",
+                                       error, sizeof(error));
+    check(!module && strstr(error, "undefined label") != NULL, "errors",
+          "branch to a missing label rejected");
+    ir_module_destroy(module);
+
+    module = ir_parse_module("define i32 @f() {\nentry:\n  %t0 = frob i32 %t1\n}\n",
+                             error, sizeof(error));
+    check(!module && strncmp(error, "line 3:", 7) == 0, "errors",
+          "unknown instruction reported with its line");
+    ir_module_destroy(module);
+}
+
+int main(int argc, char **argv) {
+    printf("=== TinyLLVM IR Example Tests ===\n");
+
+    if (argc < 2) {
+        printf("usage: %s <examples_coretiny.c>\n", argv[0]);
+        return 1;
+    }
+
+    char *text = read_file(argv[1]);
+    if (!text) {
+        printf("❌ cannot read %s\n", argv[1]);
+        return 1;
+    }
+
+    Example examples[MAX_EXAMPLES];
+    size_t count = extract_examples(text, examples, MAX_EXAMPLES);
+    free(text);
+
+    event_chain_initialize();
+#if TEST_NATIVE
+    have_cc = system("cc --version > /dev/null 2>&1") == 0;
+    llvm_build = find_llvm_build();
+#endif
+
+    check(count >= 8, "examples", "example programs found");
+    for (size_t i = 0; i < count; i++) {
+        printf("\n%s\n", examples[i].title);
+        test_example(&examples[i]);
+    }
+    test_interpreter();
+    test_bytecode();
+    if (TEST_JIT) test_jit();
+#if TEST_ASM
+    test_asm();
+#endif
+    test_llvm();
+    test_parse_errors();
+
+    event_chain_cleanup();
+
+    for (size_t i = 0; i < count; i++) {
+        free(examples[i].title);
+        free(examples[i].source);
+    }
+
+    if (failures > 0) {
+        printf("\n❌ %d IR example check(s) failed\n", failures);
+        return 1;
+    }
+
+    printf("\n✅ All IR example checks passed\n");
+    return 0;
+}
@@ -0,0 +1,1359 @@
+/**
+ * ==============================================================================
+ * TinyLLVM Optimizer Test
+ * ==============================================================================
+ *
+ * Runs CoreTiny programs through the pipeline with the Optimizer event:
+ * Source Code → Lexer → Parser → Type Checker → Optimizer → Code Generator
+ *
+ * Each case checks the generated C code (or TinyLLVM IR for lowering passes)
+ * and the optimization statistics.
+ */
+
+#include "include/tinyllvm_compiler.h"
+#include "include/eventchains.h"
+#include "include/tinyllvm_ir.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    char *code;                 /* Generated C code (owned) */
+    OptimizationStats stats;    /* Copy of the counters (remarks not kept) */
+} OptimizedOutput;
+
+static int failures = 0;
+
+static void check(bool condition, const char *test, const char *what) {
+    if (condition) {
+        printf("  ✓ %s\n", what);
+    } else {
+        printf("  ❌ %s: %s\n", test, what);
+        failures++;
+    }
+}
+
+static CompilerConfig test_config(int level, CodeGenTarget target) {
+    CompilerConfig config = {
+        .target = target,
+        .enable_optimization = level > 0,
+        .optimization_level = level,
+        .emit_debug_info = false,
+        .emit_comments = false,
+        .pretty_print = true,
+        .track_memory = false,
+        .max_memory_bytes = EVENTCHAINS_MAX_CONTEXT_MEMORY,
+        .error_detail = ERROR_DETAIL_FULL,
+        .stop_on_first_error = true
+    };
+    return config;
+}
+
+static bool compile_with_config(const char *source, CompilerConfig *config,
+                                OptimizedOutput *out) {
+    memset(out, 0, sizeof(*out));
+
+    EventChain *chain = event_chain_create(FAULT_TOLERANCE_STRICT);
+    event_chain_add_event(chain, chainable_event_create(compiler_lexer_event, NULL, "Lexer"));
+    event_chain_add_event(chain, chainable_event_create(compiler_parser_event, NULL, "Parser"));
+    event_chain_add_event(chain, chainable_event_create(compiler_type_checker_event, NULL, "TypeChecker"));
+    event_chain_add_event(chain, chainable_event_create(compiler_optimizer_event, config, "Optimizer"));
+    event_chain_add_event(chain, chainable_event_create(compiler_codegen_event, config, "CodeGen"));
+
+    EventContext *ctx = event_chain_get_context(chain);
+    event_context_set_with_cleanup(ctx, "source_code", strdup(source), free);
+
+    ChainResult result;
+    event_chain_execute(chain, &result);
+
+    if (result.success) {
+        char *code = NULL;
+        OptimizationStats *stats = NULL;
+        event_context_get(ctx, "output_code", (void **)&code);
+        event_context_get(ctx, "opt_stats", (void **)&stats);
+
+        if (code) out->code = strdup(code);
+        if (stats) {
+            out->stats = *stats;
+            out->stats.remarks = NULL;
+            out->stats.remark_count = 0;
+            out->stats.remark_capacity = 0;
+        }
+    } else if (result.failure_count > 0) {
+        FailureInfo *info = (FailureInfo *)result.failures;
+        printf("  Error in %s: %s\n", info[0].event_name, info[0].error_message);
+    }
+
+    chain_result_destroy(&result);
+    event_chain_destroy(chain);
+    return out->code != NULL;
+}
+
+static bool compile_for_target(const char *source, int level, CodeGenTarget target,
+                               OptimizedOutput *out) {
+    CompilerConfig config = test_config(level, target);
+    return compile_with_config(source, &config, out);
+}
+
+static bool compile_optimized(const char *source, int level, OptimizedOutput *out) {
+    return compile_for_target(source, level, TARGET_C, out);
+}
+
+#define PRINT_LOG_CAPACITY 64
+
+/* Values printed by a program run in the IR interpreter */
+typedef struct {
+    int32_t values[PRINT_LOG_CAPACITY];
+    size_t count;
+} PrintLog;
+
+static void log_print(int32_t value, void *user_data) {
+    PrintLog *log = (PrintLog *)user_data;
+    if (log->count < PRINT_LOG_CAPACITY) {
+        log->values[log->count] = value;
+    }
+    log->count++;
+}
+
+/* Optimize under config and run main() in the IR interpreter */
+static bool run_with_config(const char *source, CompilerConfig *config, PrintLog *log) {
+    memset(log, 0, sizeof(*log));
+
+    EventChain *chain = event_chain_create(FAULT_TOLERANCE_STRICT);
+    event_chain_add_event(chain, chainable_event_create(compiler_lexer_event, NULL, "Lexer"));
+    event_chain_add_event(chain, chainable_event_create(compiler_parser_event, NULL, "Parser"));
+    event_chain_add_event(chain, chainable_event_create(compiler_type_checker_event, NULL, "TypeChecker"));
+    event_chain_add_event(chain, chainable_event_create(compiler_optimizer_event, config, "Optimizer"));
+
+    EventContext *ctx = event_chain_get_context(chain);
+    event_context_set_with_cleanup(ctx, "source_code", strdup(source), free);
+
+    ChainResult result;
+    event_chain_execute(chain, &result);
+
+    IRModule *module = NULL;
+    ASTProgram *program = NULL;
+    if (result.success && event_context_get(ctx, "ast", (void **)&program) == EC_SUCCESS) {
+        module = ir_build_module(program);
+    }
+    chain_result_destroy(&result);
+    event_chain_destroy(chain);
+    if (!module) return false;
+
+    char error[256];
+    IRProgram *ir = ir_program_create(module, error, sizeof(error));
+    ir_module_destroy(module);
+    if (!ir) return false;
+
+    int32_t value;
+    ir_program_set_print(ir, log_print, log);
+    bool ok = ir_program_run(ir, "main", NULL, 0, &value, error, sizeof(error));
+    ir_program_destroy(ir);
+    return ok;
+}
+
+/* Running the program optimized under config prints what it does at -O0 */
+static bool runs_like_unoptimized(const char *source, CompilerConfig *config) {
+    CompilerConfig plain = test_config(0, config->target);
+    PrintLog expected, actual;
+
+    if (!run_with_config(source, &plain, &expected)) return false;
+    if (!run_with_config(source, config, &actual)) return false;
+    return expected.count == actual.count && expected.count > 0 &&
+           memcmp(expected.values, actual.values,
+                  (expected.count < PRINT_LOG_CAPACITY ? expected.count : PRINT_LOG_CAPACITY) *
+                  sizeof(int32_t)) == 0;
+}
+
+/* ==============================================================================
+ * Inlining
+ * ==============================================================================
+ */
+
+static void test_inline_expression_callee(void) {
+    printf("\nInlining: single-return callees\n");
+
+    const char *source =
+        "func is_even(n: int) : bool {\n"
+        "    return n % 2 == 0;\n"
+        "}\n"
+        "func is_in_range(x: int, lo: int, hi: int) : bool {\n"
+        "    return x >= lo && x <= hi;\n"
+        "}\n"
+        "func main() : int {\n"
+        "    var i = 0;\n"
+        "    var count = 0;\n"
+        "    while (i < 10 && is_in_range(i, 0, 8)) {\n"
+        "        if (is_even(i)) {\n"
+        "            count = count + 1;\n"
+        "        }\n"
+        "        i = i + 1;\n"
+        "    }\n"
+        "    print(count);\n"
+        "    return 0;\n"
+        "}\n";
+
+    OptimizedOutput out;
+    check(compile_optimized(source, 2, &out), "inline_expr", "program compiles at -O2");
+    if (!out.code) return;
+
+    check(strstr(out.code, "is_even(i)") == NULL, "inline_expr", "is_even call replaced");
+    check(strstr(out.code, "is_in_range(i,") == NULL, "inline_expr", "call in while condition replaced");
+    check(out.stats.calls_inlined == 2, "inline_expr", "two calls inlined");
+    free(out.code);
+}
+
+static void test_inline_multiple_returns(void) {
+    printf("\nInlining: multiple returns\n");
+
+    const char *source =
+        "func classify(n: int) : int {\n"
+        "    if (n < 0) {\n"
+        "        return 0 - 1;\n"
+        "    }\n"
+        "    var i = 0;\n"
+        "    while (i < n) {\n"
+        "        if (i * i == n) {\n"
+        "            return i;\n"
+        "        }\n"
+        "        i = i + 1;\n"
+        "    }\n"
+        "    return 0;\n"
+        "}\n"
+        "func main() : int {\n"
+        "    var i = 5;\n"
+        "    var r = classify(16) + classify(i);\n"
+        "    print(r);\n"
+        "    return 0;\n"
+        "}\n";
+
+    OptimizedOutput out;
+    check(compile_optimized(source, 2, &out), "inline_flag", "program compiles at -O2");
+    if (!out.code) return;
+
+    check(strstr(out.code, "classify(16)") == NULL, "inline_flag", "first call replaced");
+    check(strstr(out.code, "classify(i)") == NULL, "inline_flag", "second call replaced");
+    check(strstr(out.code, "classify_done") != NULL, "inline_flag", "done flag introduced");
+    check(out.stats.calls_inlined == 2, "inline_flag", "two calls inlined");
+    free(out.code);
+}
+
+static void test_inline_cost_model(void) {
+    printf("\nInlining: cost model\n");
+
+    const char *source =
+        "func fib(n: int) : int {\n"
+        "    if (n <= 1) {\n"
+        "        return n;\n"
+        "    }\n"
+        "    return fib(n - 1) + fib(n - 2);\n"
+        "}\n"
+        "func big(n: int) : int {\n"
+        "    var a = n + 1; var b = a * 2; var c = b - a; var d = c * c;\n"
+        "    var e = d + a; var f = e - b; var g = f * 3; var h = g + d;\n"
+        "    return a + b + c + d + e + f + g + h;\n"
+        "}\n"
+        "func main() : int {\n"
+        "    var k = 0;\n"
+        "    while (k < 5) { k = k + 1; }\n"
+        "    print(fib(k));\n"
+        "    print(big(k));\n"
+        "    return 0;\n"
+        "}\n";
+
+    OptimizedOutput out;
+    check(compile_optimized(source, 2, &out), "inline_cost", "program compiles at -O2");
+    if (!out.code) return;
+
+    check(strstr(out.code, "fib(k)") != NULL, "inline_cost", "recursive callee kept");
+    check(strstr(out.code, "big(k)") != NULL, "inline_cost", "callee above threshold kept");
+    check(out.stats.calls_inlined == 0, "inline_cost", "nothing inlined");
+    free(out.code);
+
+    check(compile_optimized(source, 0, &out), "inline_cost", "program compiles at -O0");
+    if (!out.code) return;
+    check(out.stats.calls_inlined == 0, "inline_cost", "no inlining without optimization");
+    free(out.code);
+}
+
+/* ==============================================================================
+ * Tail Recursion
+ * ==============================================================================
+ */
+
+static void test_tail_recursion(void) {
+    printf("\nTail recursion: loops and accumulators\n");
+
+    const char *source =
+        "func gcd(a: int, b: int) : int {\n"
+        "    if (b == 0) {\n"
+        "        return a;\n"
+        "    }\n"
+        "    return gcd(b, a % b);\n"
+        "}\n"
+        "func factorial(n: int) : int {\n"
+        "    if (n <= 1) {\n"
+        "        return 1;\n"
+        "    }\n"
+        "    return n * factorial(n - 1);\n"
+        "}\n"
+        "func count_down(n: int) : int {\n"
+        "    if (n <= 0) {\n"
+        "        return 0;\n"
+        "    }\n"
+        "    return count_down(n - 1) - 1;\n"
+        "}\n"
+        "func main() : int {\n"
+        "    print(gcd(1071, 462));\n"
+        "    print(factorial(5));\n"
+        "    print(count_down(3));\n"
+        "    return 0;\n"
+        "}\n";
+
+    OptimizedOutput out;
+    check(compile_optimized(source, 1, &out), "tailrec", "program compiles at -O1");
+    if (!out.code) return;
+
+    check(strstr(out.code, "gcd(b,") == NULL, "tailrec", "tail call in gcd removed");
+    check(strstr(out.code, "factorial((n - 1))") == NULL, "tailrec", "factorial uses an accumulator");
+    check(strstr(out.code, "factorial_acc") != NULL, "tailrec", "accumulator introduced");
+    check(strstr(out.code, "count_down((n - 1))") != NULL, "tailrec", "non-tail recursion kept");
+    check(out.stats.tail_calls_eliminated == 2, "tailrec", "two tail calls eliminated");
+    free(out.code);
+}
+
+/* ==============================================================================
+ * Loop-Invariant Code Motion
+ * ==============================================================================
+ */
+
+static void test_loop_invariants(void) {
+    printf("\nLoop-invariant code motion\n");
+
+    const char *source =
+        "func kernel(n: int, d: int) : int {\n"
+        "    var i = 0;\n"
+        "    var s = 0;\n"
+        "    while (i < n * 2) {\n"
+        "        s = s + n * n + i;\n"
+        "        i = i + 1;\n"
+        "    }\n"
+        "    i = 0;\n"
+        "    while (i < 3 && d > 0) {\n"
+        "        s = s + 100 / d;\n"
+        "        i = i + 1;\n"
+        "    }\n"
+        "    i = 0;\n"
+        "    while (i < 3) {\n"
+        "        s = s + n / d;\n"
+        "        i = i + 1;\n"
+        "    }\n"
+        "    return s;\n"
+        "}\n"
+        "func main() : int {\n"
+        "    var k = 0;\n"
+        "    while (k < 10) { k = k + 1; }\n"
+        "    print(kernel(k, 2));\n"
+        "    return 0;\n"
+        "}\n";
+
+    OptimizedOutput out;
+    check(compile_optimized(source, 2, &out), "licm", "program compiles at -O2");
+    if (!out.code) return;
+
+    check(strstr(out.code, "while ((i < (n * 2)))") == NULL, "licm", "invariant loop bound hoisted");
+    check(strstr(out.code, "(s + (n * n))") == NULL, "licm", "invariant product hoisted");
+    check(strstr(out.code, "(n * n)") != NULL && strstr(out.code, "= (n * n);") == NULL, "licm",
+          "product that may overflow computed only when the loop runs");
+    check(strstr(out.code, "if ((d > 0))") != NULL, "licm", "guarded division hoisted under its guard");
+    check(strstr(out.code, "(s + (n / d))") != NULL, "licm", "unguarded division left in the loop");
+    check(out.stats.expressions_hoisted == 4, "licm", "four expressions hoisted");
+    free(out.code);
+
+    /* The substring checks above cannot tell a correct hoist from one that
+     * changes what the program computes */
+    CompilerConfig config = test_config(2, TARGET_C);
+    check(runs_like_unoptimized(source, &config), "licm", "program runs as at -O0");
+
+    /* The guard placed before the loop must not read the temporary it
+     * initialises when the condition and body share an invariant */
+    const char *shared =
+        "func f(a: int, b: int) : int {\n"
+        "    var i = 0;\n"
+        "    var s = 0;\n"
+        "    while (i < a * b) { s = s + a * b; i = i + 1; }\n"
+        "    return s;\n"
+        "}\n"
+        "func main() : int {\n"
+        "    var k = 0;\n"
+        "    while (k < 2) { k = k + 1; }\n"
+        "    print(f(k, k));\n"
+        "    print(f(k + 4, k + 4));\n"
+        "    print(f(k * 2, 3));\n"
+        "    return 0;\n"
+        "}\n";
+
+    check(runs_like_unoptimized(shared, &config), "licm",
+          "invariant shared by condition and body runs as at -O0");
+
+    /* A product under an inner if may never be evaluated, so it must not
+     * run before the loop; the comparison guarding it cannot overflow */
+    const char *branch =
+        "func f(n: int, a: int, b: int) : int {\n"
+        "    var i = 0;\n"
+        "    var s = 0;\n"
+        "    while (i < n) {\n"
+        "        if (a < 1000) { s = s + a * b; }\n"
+        "        i = i + 1;\n"
+        "    }\n"
+        "    return s;\n"
+        "}\n"
+        "func main() : int {\n"
+        "    var k = 0;\n"
+        "    while (k < 100000) { k = k + 1; }\n"
+        "    print(f(k, k, 3));\n"
+        "    print(f(3, 7, 3));\n"
+        "    return 0;\n"
+        "}\n";
+
+    check(compile_optimized(branch, 2, &out), "licm", "branch program compiles at -O2");
+    if (!out.code) return;
+
+    check(strstr(out.code, "= (k * 3);") == NULL && strstr(out.code, "? (k * 3) :") == NULL,
+          "licm", "conditionally evaluated product left in the loop");
+    check(strstr(out.code, "= (k < 1000);") != NULL, "licm", "comparison guarding it hoisted");
+    free(out.code);
+
+    check(runs_like_unoptimized(branch, &config), "licm", "branch program runs as at -O0");
+}
+
+/* ==============================================================================
+ * Loop Unrolling
+ * ==============================================================================
+ */
+
+static void test_loop_unrolling(void) {
+    printf("\nLoop unrolling\n");
+
+    const char *source =
+        "func main() : int {\n"
+        "    var s = 0;\n"
+        "    var i = 0;\n"
+        "    while (i < 4) {\n"
+        "        s = s + i * 10;\n"
+        "        i = i + 1;\n"
+        "    }\n"
+        "    var k = 0;\n"
+        "    while (k < 30) {\n"
+        "        s = s + k;\n"
+        "        k = k + 1;\n"
+        "    }\n"
+        "    print(s);\n"
+        "    return 0;\n"
+        "}\n";
+
+    OptimizedOutput out;
+    check(compile_optimized(source, 3, &out), "unroll", "program compiles at -O3");
+    if (!out.code) return;
+
+    check(strstr(out.code, "(3 * 10)") != NULL, "unroll", "short loop fully unrolled with constants");
+    check(strstr(out.code, "while ((i < 4))") == NULL, "unroll", "short loop removed");
+    check(strstr(out.code, "while ((k < 28))") != NULL, "unroll", "long loop unrolled by four");
+    check(strstr(out.code, "k = (k + 4);") != NULL, "unroll", "single induction update per iteration");
+    check(strstr(out.code, "while ((k < 30))") != NULL, "unroll", "remainder loop kept");
+    check(out.stats.loops_unrolled == 2, "unroll", "two loops unrolled");
+    free(out.code);
+}
+
+/* ==============================================================================
+ * Constant & Copy Propagation
+ * ==============================================================================
+ */
+
+static void test_constant_propagation(void) {
+    printf("\nConstant and copy propagation\n");
+
+    const char *source =
+        "func run(flag: bool, n: int) : int {\n"
+        "    var x = 5;\n"
+        "    var y = x * 2;\n"
+        "    print(y + 1);\n"
+        "    var m = n;\n"
+        "    if (flag) {\n"
+        "        x = 7;\n"
+        "    } else {\n"
+        "        x = 7;\n"
+        "        y = 0;\n"
+        "    }\n"
+        "    print(x + y);\n"
+        "    var i = 0;\n"
+        "    while (i < m) {\n"
+        "        i = i + x;\n"
+        "    }\n"
+        "    if (x > 6) {\n"
+        "        print(i);\n"
+        "    }\n"
+        "    return i;\n"
+        "}\n"
+        "func main() : int {\n"
+        "    print(run(true, 3));\n"
+        "    return 0;\n"
+        "}\n";
+
+    OptimizedOutput out;
+    check(compile_optimized(source, 1, &out), "constprop", "program compiles at -O1");
+    if (!out.code) return;
+
+    check(strstr(out.code, "printf(\"%d\\n\", 11)") != NULL, "constprop", "straight-line chain folded");
+    check(strstr(out.code, "(7 + y)") != NULL, "constprop", "only values both branches agree on kept");
+    check(strstr(out.code, "(i < n)") != NULL, "constprop", "copy propagated into the loop condition");
+    check(strstr(out.code, "(i + 7)") != NULL, "constprop", "constant agreed on by both branches used in the loop");
+    check(strstr(out.code, "(i < 0)") == NULL, "constprop", "loop-carried value not treated as constant");
+    check(strstr(out.code, "if (") != NULL && strstr(out.code, "(x > 6)") == NULL,
+          "constprop", "branch on a known condition removed");
+    check(out.stats.constants_propagated > 0, "constprop", "constants counted");
+    check(out.stats.copies_propagated == 1, "constprop", "one copy propagated");
+    check(out.stats.statements_removed > 0, "constprop", "dead statements removed");
+    free(out.code);
+
+    /* A copy of an outer x must not be substituted into the initializer
+     * of an inner x, where the name refers to the new variable */
+    const char *shadowing =
+        "func main() : int {\n"
+        "    var k = 0;\n"
+        "    while (k < 3) { k = k + 1; }\n"
+        "    var x = k * 2;\n"
+        "    var a = x;\n"
+        "    var i = 0;\n"
+        "    while (i < 2) {\n"
+        "        var x = a + 1;\n"
+        "        print(x);\n"
+        "        i = i + 1;\n"
+        "    }\n"
+        "    return 0;\n"
+        "}\n";
+
+    check(compile_optimized(shadowing, 1, &out), "constprop", "shadowing program compiles at -O1");
+    if (!out.code) return;
+
+    check(strstr(out.code, "int x = (x + 1);") == NULL &&
+          strstr(out.code, "int x = (a + 1);") != NULL, "constprop",
+          "copy not substituted into a shadowing declaration");
+    free(out.code);
+
+    CompilerConfig config = test_config(1, TARGET_C);
+    check(runs_like_unoptimized(shadowing, &config), "constprop",
+          "shadowing program runs as at -O0");
+
+    /* Folding does not depend on statistics being collected */
+    EventChain *chain = event_chain_create(FAULT_TOLERANCE_STRICT);
+    event_chain_add_event(chain, chainable_event_create(compiler_lexer_event, NULL, "Lexer"));
+    event_chain_add_event(chain, chainable_event_create(compiler_parser_event, NULL, "Parser"));
+    event_chain_add_event(chain, chainable_event_create(compiler_type_checker_event, NULL, "TypeChecker"));
+
+    EventContext *ctx = event_chain_get_context(chain);
+    event_context_set_with_cleanup(ctx, "source_code",
+                                   strdup("func main() : int { var x = 2; return x + 3; }\n"), free);
+
+    ChainResult result;
+    event_chain_execute(chain, &result);
+
+    ASTProgram *program = NULL;
+    const ASTExpr *returned = NULL;
+    if (result.success && event_context_get(ctx, "ast", (void **)&program) == EC_SUCCESS) {
+        optimize_constant_propagation(program, NULL, NULL);
+        const ASTStmt *body = program->functions[0]->body;
+        if (body->data.block.stmt_count == 2) {
+            returned = body->data.block.statements[1]->data.return_stmt.expr;
+        }
+    }
+    check(returned && returned->kind == EXPR_INT_LITERAL && returned->data.int_lit.value == 5,
+          "constprop", "folds without statistics");
+
+    chain_result_destroy(&result);
+    event_chain_destroy(chain);
+}
+
+/* ==============================================================================
+ * Dead Function Elimination
+ * ==============================================================================
+ */
+
+static void test_dead_functions(void) {
+    printf("\nDead function elimination\n");
+
+    const char *source =
+        "func unused_leaf(n: int) : int {\n"
+        "    return n * 3;\n"
+        "}\n"
+        "func unused_caller(n: int) : int {\n"
+        "    return unused_leaf(n) + unused_caller(n - 1);\n"
+        "}\n"
+        "func helper(n: int) : int {\n"
+        "    var i = 0;\n"
+        "    while (i < n) {\n"
+        "        print(i);\n"
+        "        i = i + 1;\n"
+        "    }\n"
+        "    return i;\n"
+        "}\n"
+        "func main() : int {\n"
+        "    print(helper(3));\n"
+        "    return 0;\n"
+        "}\n";
+
+    CompilerConfig *config = compiler_config_create_default();
+    check(config != NULL, "dfe", "default configuration created");
+    if (!config) return;
+
+    CompilationResult result;
+    check(compiler_compile(source, config, &result) == EC_SUCCESS, "dfe", "compiler_compile succeeds");
+    check(result.success && result.output_code != NULL, "dfe", "output produced");
+
+    if (result.output_code) {
+        check(strstr(result.output_code, "unused_leaf") == NULL, "dfe", "uncalled function removed");
+        check(strstr(result.output_code, "unused_caller") == NULL, "dfe", "uncalled recursive function removed");
+        check(strstr(result.output_code, "int helper(int n)") != NULL, "dfe", "reachable function kept");
+    }
+    check(result.functions_removed == 2, "dfe", "two functions reported removed");
+    compilation_result_destroy(&result);
+
+    config->optimization_level = 0;
+    config->enable_optimization = false;
+    check(compiler_compile(source, config, &result) == EC_SUCCESS, "dfe", "compiles at -O0");
+    check(result.functions_removed == 0, "dfe", "nothing removed without optimization");
+    compilation_result_destroy(&result);
+
+    check(compiler_compile("func main() : int { return x; }", config, &result) != EC_SUCCESS,
+          "dfe", "type errors reported");
+    check(!result.success && result.error_count > 0, "dfe", "error message collected");
+    compilation_result_destroy(&result);
+
+    free(config);
+}
+
+/* ==============================================================================
+ * Strength Reduction
+ * ==============================================================================
+ */
+
+static void test_strength_reduction(void) {
+    printf("\nStrength reduction\n");
+
+    const char *source =
+        "func scale(x: int) : int {\n"
+        "    return x * 8 + x * 10 + x / 4 + x / 7 + x % 3;\n"
+        "}\n"
+        "func main() : int {\n"
+        "    var i = 0;\n"
+        "    var s = 0;\n"
+        "    while (i < 10) {\n"
+        "        s = s + i * 12;\n"
+        "        i = i + 1;\n"
+        "    }\n"
+        "    print(s + scale(s));\n"
+        "    return 0;\n"
+        "}\n";
+
+    OptimizedOutput out;
+    check(compile_optimized(source, 2, &out), "strength", "program compiles to C at -O2");
+    if (!out.code) return;
+
+    check(strstr(out.code, "(s + (i * 12))") == NULL, "strength", "product in loop removed");
+    check(strstr(out.code, "i_iv") != NULL, "strength", "induction variable introduced");
+    check(strstr(out.code, "(s * 8)") != NULL, "strength", "C target keeps constant multiplies");
+    check(out.stats.strength_reductions == 1, "strength", "one reduction for the C target");
+    free(out.code);
+
+    check(compile_for_target(source, 2, TARGET_TINYLLVM, &out), "strength",
+          "program compiles to IR at -O2");
+    if (!out.code) return;
+
+    check(strstr(out.code, "shl i32") != NULL, "strength", "multiplies lowered to shifts");
+    check(strstr(out.code, "ashr i32") != NULL, "strength", "division by 4 uses an arithmetic shift");
+    check(strstr(out.code, "mulhi i32") != NULL, "strength", "division by 7 uses multiply-high");
+    check(strstr(out.code, "div i32") == NULL, "strength", "no divisions left");
+    check(strstr(out.code, "mod i32") == NULL, "strength", "no modulo left");
+    free(out.code);
+}
+
+/* ==============================================================================
+ * Memoization
+ * ==============================================================================
+ */
+
+static void test_memoization(void) {
+    printf("\nMemoization\n");
+
+    const char *source =
+        "func fib(n: int) : int {\n"
+        "    if (n < 2) { return n; }\n"
+        "    return fib(n - 1) + fib(n - 2);\n"
+        "}\n"
+        "func noisy(n: int) : int {\n"
+        "    print(n);\n"
+        "    if (n < 2) { return n; }\n"
+        "    return noisy(n - 1) + noisy(n - 2);\n"
+        "}\n"
+        "func main() : int {\n"
+        "    print(fib(30) + noisy(3));\n"
+        "    return 0;\n"
+        "}\n";
+
+    OptimizedOutput out;
+    check(compile_optimized(source, 3, &out), "memo", "program compiles at -O3");
+    if (!out.code) return;
+
+    check(strstr(out.code, "fib_memo0_cache[1024]") != NULL, "memo", "fib gets a result cache");
+    check(strstr(out.code, "return (fib((n - 1)) + fib((n - 2)));") != NULL, "memo",
+          "recursive calls go through the cached wrapper");
+    check(strstr(out.code, "noisy_memo") == NULL, "memo", "function that prints is not memoized");
+    check(out.stats.functions_memoized == 1, "memo", "one function memoized");
+    free(out.code);
+
+    check(compile_optimized(source, 2, &out), "memo", "program compiles at -O2");
+    if (!out.code) return;
+
+    check(strstr(out.code, "_cache") == NULL, "memo", "no caches below -O3");
+    free(out.code);
+}
+
+/* ==============================================================================
+ * Compile-Time Evaluation
+ * ==============================================================================
+ */
+
+static void test_compile_time_calls(void) {
+    printf("\nCompile-time evaluation\n");
+
+    const char *source =
+        "func factorial(n: int) : int {\n"
+        "    if (n < 2) { return 1; }\n"
+        "    return n * factorial(n - 1);\n"
+        "}\n"
+        "func ratio(a: int, b: int) : int {\n"
+        "    if (b > 100) { return ratio(a, b - 1) + ratio(a, b - 2); }\n"
+        "    return a / b;\n"
+        "}\n"
+        "func spin(n: int) : int {\n"
+        "    if (n < 0) { return spin(0 - n) + spin(1 - n); }\n"
+        "    var i = 0;\n"
+        "    var s = 0;\n"
+        "    while (i < n) { s = s + i; i = i + 1; }\n"
+        "    return s;\n"
+        "}\n"
+        "func main() : int {\n"
+        "    var fact = factorial(5);\n"
+        "    print(fact);\n"
+        "    print(ratio(7, 0));\n"
+        "    print(spin(10000000));\n"
+        "    return 0;\n"
+        "}\n";
+
+    /* ratio and spin are recursive, so the inliner leaves the calls alone */
+    OptimizedOutput out;
+    check(compile_optimized(source, 2, &out), "eval", "program compiles at -O2");
+    if (!out.code) return;
+
+    check(strstr(out.code, "printf(\"%d\\n\", 120);") != NULL, "eval",
+          "factorial(5) replaced by 120");
+    check(strstr(out.code, "int factorial(") == NULL, "eval", "factorial no longer needed");
+    check(strstr(out.code, "ratio(7, 0)") != NULL, "eval", "trapping call left in place");
+    check(strstr(out.code, "spin(10000000)") != NULL, "eval", "call out of fuel left in place");
+    check(out.stats.calls_evaluated == 1, "eval", "one call evaluated");
+    free(out.code);
+
+    /* The inner call's arguments must read the caller's m, not the
+     * parameter being bound for the outer call */
+    const char *nested =
+        "func ack(m: int, n: int) : int {\n"
+        "    if (m == 0) { return n + 1; }\n"
+        "    if (n == 0) { return ack(m - 1, 1); }\n"
+        "    return ack(m - 1, ack(m, n - 1));\n"
+        "}\n"
+        "func main() : int { print(ack(2, 3)); return 0; }\n";
+
+    check(compile_optimized(nested, 2, &out), "eval", "nested call program compiles at -O2");
+    if (!out.code) return;
+
+    check(strstr(out.code, "printf(\"%d\\n\", 9);") != NULL, "eval",
+          "ack(2, 3) folded to 9");
+    check(out.stats.calls_evaluated == 1, "eval", "nested call evaluated");
+    free(out.code);
+}
+
+/* ==============================================================================
+ * Function Specialization
+ * ==============================================================================
+ */
+
+static void test_specialization(void) {
+    printf("\nFunction specialization\n");
+
+    const char *source =
+        "func walk(step: int, n: int) : int {\n"
+        "    if (n < 2) { return step * n; }\n"
+        "    return walk(step, n - 1) + walk(step, n - 2) + step / 4;\n"
+        "}\n"
+        "func main() : int {\n"
+        "    var k = 0;\n"
+        "    while (k < 10) { k = k + 1; }\n"
+        "    print(walk(8, k));\n"
+        "    print(walk(8, k + 1));\n"
+        "    return 0;\n"
+        "}\n";
+
+    OptimizedOutput out;
+    check(compile_optimized(source, 3, &out), "specialize", "program compiles at -O3");
+    if (!out.code) return;
+
+    check(strstr(out.code, "walk_spec0(k)") != NULL, "specialize",
+          "call with a constant step redirected to a clone");
+    check(strstr(out.code, "walk_spec0((k + 1))") != NULL, "specialize",
+          "call sites with the same constants share the clone");
+    check(strstr(out.code, "(walk_spec0((n - 1)) + walk_spec0((n - 2)))") != NULL,
+          "specialize", "recursive calls stay inside the clone");
+    check(strstr(out.code, "(8 * n)") != NULL, "specialize", "bound constant propagated");
+    check(strstr(out.code, "(step / 4)") == NULL, "specialize", "bound constant folded");
+    check(out.stats.functions_specialized == 1, "specialize", "one clone created");
+    free(out.code);
+
+    check(compile_optimized(source, 2, &out), "specialize", "program compiles at -O2");
+    if (!out.code) return;
+
+    check(out.stats.functions_specialized == 0, "specialize", "no clones below -O3");
+    free(out.code);
+}
+
+/* ==============================================================================
+ * If-Conversion
+ * ==============================================================================
+ */
+
+static void test_if_conversion(void) {
+    printf("\nIf-conversion\n");
+
+    const char *source =
+        "func main() : int {\n"
+        "    var a = 3;\n"
+        "    var b = 0;\n"
+        "    var m = 0;\n"
+        "    var i = 0;\n"
+        "    while (i < 50) {\n"
+        "        if (a > b) { m = a; } else { m = b; }\n"
+        "        if (m < 10) { b = b + 2; }\n"
+        "        if (i > 40) { a = a / i; }\n"
+        "        if (i == 3) { print(m); }\n"
+        "        i = i + 1;\n"
+        "    }\n"
+        "    print(m);\n"
+        "    return 0;\n"
+        "}\n";
+
+    OptimizedOutput out;
+    check(compile_optimized(source, 2, &out), "ifconv", "program compiles at -O2");
+    if (!out.code) return;
+
+    check(strstr(out.code, "m = ((a > b) ? a : b);") != NULL, "ifconv",
+          "two-arm assignment becomes a ternary");
+    check(strstr(out.code, "b = ((m < 10) ? (b + 2) : b);") != NULL, "ifconv",
+          "guarded assignment keeps the old value on the other arm");
+    check(strstr(out.code, "if ((i > 40))") != NULL, "ifconv",
+          "division by a variable not speculated");
+    check(strstr(out.code, "if ((i == 3))") != NULL, "ifconv", "calls not speculated");
+    check(out.stats.branches_converted == 2, "ifconv", "two branches converted");
+    free(out.code);
+
+    check(compile_for_target(source, 2, TARGET_TINYLLVM, &out), "ifconv",
+          "program compiles to IR");
+    if (!out.code) return;
+
+    check(strstr(out.code, "= select i1 ") != NULL, "ifconv", "IR uses select");
+    free(out.code);
+
+    check(compile_optimized(source, 1, &out), "ifconv", "program compiles at -O1");
+    if (!out.code) return;
+
+    check(out.stats.branches_converted == 0, "ifconv", "no conversion below -O2");
+    free(out.code);
+}
+
+/* ==============================================================================
+ * Short-Circuit Lowering
+ * ==============================================================================
+ */
+
+static void test_short_circuit_ir(void) {
+    printf("\nShort-circuit && and || in IR\n");
+
+    const char *source =
+        "func ratio(a: int, b: int) : bool {\n"
+        "    return a > 0 && b / a > 1;\n"
+        "}\n"
+        "func main() : int {\n"
+        "    var x = 3;\n"
+        "    if (ratio(2, 5) || x < 4) { print(1); }\n"
+        "    return 0;\n"
+        "}\n";
+
+    OptimizedOutput out;
+    check(compile_for_target(source, 0, TARGET_TINYLLVM, &out), "short-circuit",
+          "program compiles to IR");
+    if (!out.code) return;
+
+    check(strstr(out.code, "and i1") == NULL, "short-circuit",
+          "division guarded by && not evaluated eagerly");
+    check(strstr(out.code, "phi i1 [ %t1, %entry ], [ %t4, %L0 ]") != NULL,
+          "short-circuit", "&& result joined with a phi");
+    check(strstr(out.code, "or i1") != NULL, "short-circuit",
+          "trivial right operand of || stays eager");
+    free(out.code);
+}
+
+/* ==============================================================================
+ * Loop Rotation
+ * ==============================================================================
+ */
+
+static void test_loop_rotation(void) {
+    printf("\nLoop rotation\n");
+
+    const char *source =
+        "func main() : int {\n"
+        "    var s = 0;\n"
+        "    var i = 0;\n"
+        "    while (i < 10) { s = s + i; i = i + 1; }\n"
+        "    print(s);\n"
+        "    return 0;\n"
+        "}\n";
+
+    OptimizedOutput out;
+    check(compile_optimized(source, 2, &out), "rotate", "program compiles at -O2");
+    if (!out.code) return;
+
+    check(strstr(out.code, "if ((i < 10)) {") != NULL, "rotate", "loop entry guarded");
+    check(strstr(out.code, "} while ((i < 10));") != NULL, "rotate",
+          "condition tested at the bottom");
+    check(out.stats.loops_rotated == 1, "rotate", "one loop rotated");
+    free(out.code);
+
+    check(compile_for_target(source, 2, TARGET_TINYLLVM, &out), "rotate",
+          "program compiles to IR");
+    if (!out.code) return;
+
+    check(strstr(out.code, "br label") == NULL, "rotate", "no unconditional back edge");
+    check(strstr(out.code, "label %L0, label %L1\n\nL1:") != NULL, "rotate",
+          "latch branches back to the body");
+    free(out.code);
+
+    check(compile_optimized(source, 1, &out), "rotate", "program compiles at -O1");
+    if (!out.code) return;
+
+    check(strstr(out.code, "while ((i < 10)) {") != NULL, "rotate",
+          "top-tested loop below -O2");
+    free(out.code);
+}
+
+/* ==============================================================================
+ * Reassociation
+ * ==============================================================================
+ */
+
+static void test_reassociation(void) {
+    printf("\nReassociation\n");
+
+    const char *source =
+        "func sum(a: int, b: int, n: int) : int {\n"
+        "    var s = 0;\n"
+        "    var i = 0;\n"
+        "    while (i < n) {\n"
+        "        s = s + (a + 3) + (i + 4) + b - 2;\n"
+        "        i = i + 1;\n"
+        "    }\n"
+        "    return s * 4 * a * 2;\n"
+        "}\n"
+        "func main() : int {\n"
+        "    var k = 0;\n"
+        "    while (k < 3) { k = k + 1; }\n"
+        "    print(sum(k, k + 1, k * 10));\n"
+        "    print(sum(k + 2, k, 7));\n"
+        "    return 0;\n"
+        "}\n";
+
+    /* Keep sum out of line */
+    CompilerConfig config = test_config(2, TARGET_C);
+    config.inline_threshold = 1;
+
+    OptimizedOutput out;
+    check(compile_with_config(source, &config, &out), "reassoc", "program compiles at -O2");
+    if (!out.code) return;
+
+    /* Regrouped chains are emitted in unsigned so partial sums wrap */
+    check(strstr(out.code, "((int)(((unsigned)s * (unsigned)a) * (unsigned)8))") != NULL,
+          "reassoc", "product constants grouped and folded");
+    check(strstr(out.code, "loop_inv0 = ((int)((unsigned)a + (unsigned)b));") != NULL,
+          "reassoc", "invariant operands grouped and hoisted");
+    check(strstr(out.code,
+                 "((int)(((unsigned)loop_inv0 + ((unsigned)s + (unsigned)i)) + (unsigned)5))") != NULL,
+          "reassoc", "sum constants folded last");
+    check(out.stats.expressions_reassociated == 2, "reassoc", "two chains regrouped");
+    free(out.code);
+
+    config.overflow_checks = true;
+    check(compile_with_config(source, &config, &out), "reassoc",
+          "program compiles with checks");
+    if (!out.code) return;
+
+    check(out.stats.expressions_reassociated == 0, "reassoc",
+          "disabled under overflow checks");
+    free(out.code);
+}
+
+/* ==============================================================================
+ * In-Memory IR
+ * ==============================================================================
+ */
+
+/* Build the IR module for a typed, unoptimized program */
+static IRModule *build_ir(const char *source) {
+    EventChain *chain = event_chain_create(FAULT_TOLERANCE_STRICT);
+    event_chain_add_event(chain, chainable_event_create(compiler_lexer_event, NULL, "Lexer"));
+    event_chain_add_event(chain, chainable_event_create(compiler_parser_event, NULL, "Parser"));
+    event_chain_add_event(chain, chainable_event_create(compiler_type_checker_event, NULL, "TypeChecker"));
+
+    EventContext *ctx = event_chain_get_context(chain);
+    event_context_set_with_cleanup(ctx, "source_code", strdup(source), free);
+
+    ChainResult result;
+    event_chain_execute(chain, &result);
+
+    IRModule *module = NULL;
+    ASTProgram *program = NULL;
+    if (result.success && event_context_get(ctx, "ast", (void **)&program) == EC_SUCCESS) {
+        module = ir_build_module(program);
+    }
+
+    chain_result_destroy(&result);
+    event_chain_destroy(chain);
+    return module;
+}
+
+static void test_ir_module(void) {
+    printf("\nIn-memory IR module\n");
+
+    const char *source =
+        "func main() : int {\n"
+        "    var i = 0;\n"
+        "    while (i < 3) { i = i + 1; }\n"
+        "    if (i > 2) { print(i); }\n"
+        "    return i;\n"
+        "}\n";
+
+    IRModule *module = build_ir(source);
+    check(module != NULL && module->func_count == 1, "ir-module", "module built from the AST");
+    if (!module || module->func_count != 1) {
+        ir_module_destroy(module);
+        return;
+    }
+
+    /* entry, loop cond/body, if cond, then, join */
+    const IRFunction *func = module->functions[0];
+    check(func->block_count == 6, "ir-module", "one block per label plus entry");
+
+    if (func->block_count == 6) {
+        const IRBlock *cond = func->blocks[1];
+        const IRBlock *join = func->blocks[5];
+        check(func->blocks[0]->succ_count == 1 && func->blocks[0]->succs[0] == 1,
+              "ir-module", "entry falls into the loop condition");
+        check(cond->pred_count == 2 && cond->succ_count == 2, "ir-module",
+              "loop condition reached from entry and latch, exits two ways");
+        check(join->pred_count == 2 && join->succ_count == 0 && ir_block_is_terminated(join),
+              "ir-module", "join block has both if arms as predecessors and returns");
+    }
+
+    OptimizedOutput out;
+    char *printed = ir_print_module(module, false);
+    if (compile_for_target(source, 0, TARGET_TINYLLVM, &out)) {
+        check(printed && strcmp(printed, out.code) == 0, "ir-module",
+              "printer reproduces the TinyLLVM IR target output");
+        free(out.code);
+    }
+    free(printed);
+    ir_module_destroy(module);
+}
+
+static void test_ssa_construction(void) {
+    printf("\nSSA construction\n");
+
+    const char *source =
+        "func main() : int {\n"
+        "    var s = 0;\n"
+        "    var i = 0;\n"
+        "    var odd = false;\n"
+        "    while (i < 10) {\n"
+        "        if (i % 3 == 0) { odd = !odd; }\n"
+        "        s = s + i;\n"
+        "        i = i + 1;\n"
+        "    }\n"
+        "    if (odd) { print(s); }\n"
+        "    return 0;\n"
+        "}\n";
+
+    OptimizedOutput out;
+    check(compile_for_target(source, 1, TARGET_TINYLLVM, &out), "ssa",
+          "program compiles to IR at -O1");
+    if (!out.code) return;
+
+    check(strstr(out.code, "alloca") == NULL, "ssa", "no stack slots left");
+    check(strstr(out.code, "load %") == NULL && strstr(out.code, "store ") == NULL,
+          "ssa", "no loads or stores left");
+    check(strstr(out.code, "phi i32 [ ") != NULL, "ssa", "int variables joined with phis");
+    check(strstr(out.code, "phi i1 [ ") != NULL, "ssa", "bool variable phis typed i1");
+    free(out.code);
+
+    check(compile_for_target(source, 0, TARGET_TINYLLVM, &out), "ssa",
+          "program compiles to IR at -O0");
+    if (!out.code) return;
+
+    check(strstr(out.code, "%odd = alloca i32") != NULL, "ssa", "-O0 keeps variables in memory");
+    free(out.code);
+}
+
+static void test_ir_bytecode(void) {
+    printf("\nIR bytecode\n");
+
+    const char *source =
+        "func sq(x: int) : int { return x * x; }\n"
+        "func neg(b: bool) : bool { return !b; }\n"
+        "func main() : int {\n"
+        "    var i = 0 - 3;\n"
+        "    while (i < 100000 && neg(i == 7)) { print(sq(i)); i = i + 1; }\n"
+        "    return 0;\n"
+        "}\n";
+
+    IRModule *module = build_ir(source);
+    check(module != NULL, "bytecode", "module built from the AST");
+    if (!module) return;
+    ir_module_to_ssa(module);
+
+    size_t size = 0;
+    uint8_t *data = ir_bytecode_encode(module, &size);
+    char *text = ir_print_module(module, false);
+    check(data != NULL && text != NULL && size < strlen(text) / 2, "bytecode",
+          "encoding is under half the size of the text");
+
+    IRBytecode *bc = data ? ir_bytecode_from_memory(data, size) : NULL;
+    check(bc != NULL && ir_bytecode_function_count(bc) == 3, "bytecode", "index lists every function");
+    if (bc) {
+        size_t index = ir_bytecode_find_function(bc, "main");
+        const IRFunction *func = ir_bytecode_function(bc, index);
+        check(index == 2 && func && func->block_count == module->functions[2]->block_count,
+              "bytecode", "single function decoded on demand");
+
+        const IRModule *decoded = ir_bytecode_module(bc);
+        char *round_trip = decoded ? ir_print_module(decoded, false) : NULL;
+        check(round_trip && text && strcmp(round_trip, text) == 0, "bytecode",
+              "decoded module prints identically");
+        free(round_trip);
+        ir_bytecode_close(bc);
+    }
+
+    const char *path = "test_ir_bytecode.tlir";
+    IRBytecode *mapped = ir_bytecode_write(module, path) ? ir_bytecode_open(path) : NULL;
+    const IRModule *loaded = mapped ? ir_bytecode_module(mapped) : NULL;
+    char *loaded_text = loaded ? ir_print_module(loaded, false) : NULL;
+    check(loaded_text && text && strcmp(loaded_text, text) == 0, "bytecode",
+          "file written and mapped back");
+    free(loaded_text);
+    ir_bytecode_close(mapped);
+    remove(path);
+
+    bool rejected = true;
+    if (data) {
+        IRBytecode *truncated = ir_bytecode_from_memory(data, size - 1);
+        rejected = !truncated || !ir_bytecode_module(truncated);
+        ir_bytecode_close(truncated);
+    }
+    check(rejected, "bytecode", "truncated data rejected");
+
+    free(text);
+    free(data);
+    ir_module_destroy(module);
+}
+
+/* ==============================================================================
+ * Range Analysis
+ * ==============================================================================
+ */
+
+static void test_checked_folding(void) {
+    printf("\nFolding under overflow checks\n");
+
+    const char *source =
+        "func main() : int {\n"
+        "    var a = 2147483647;\n"
+        "    var b = a + 1;\n"
+        "    print(b);\n"
+        "    return 0;\n"
+        "}\n";
+
+    for (int level = 1; level <= 2; level++) {
+        CompilerConfig config = test_config(level, TARGET_C);
+        config.overflow_checks = true;
+
+        OptimizedOutput out;
+        check(compile_with_config(source, &config, &out), "checked", "program compiles");
+        if (!out.code) return;
+
+        check(strstr(out.code, "tinyllvm_checked_add(2147483647, 1)") != NULL, "checked",
+              "overflowing addition still traps");
+        free(out.code);
+    }
+
+    /* Inlining, compile-time evaluation and the tail-recursion accumulator
+     * must not fold or regroup arithmetic that would trap */
+    const char *calls =
+        "func scale(x: int) : int { return x * 65536; }\n"
+        "func fact(n: int) : int {\n"
+        "    if (n <= 1) { return 1; }\n"
+        "    return n * fact(n - 1);\n"
+        "}\n"
+        "func main() : int { print(scale(65536)); print(fact(5)); return 0; }\n";
+
+    CompilerConfig config = test_config(2, TARGET_C);
+    config.overflow_checks = true;
+
+    OptimizedOutput out;
+    check(compile_with_config(calls, &config, &out), "checked", "call program compiles");
+    if (!out.code) return;
+
+    check(strstr(out.code, "tinyllvm_checked_mul(65536, 65536)") != NULL, "checked",
+          "overflowing callee left to trap");
+    check(out.stats.calls_evaluated == 1, "checked", "safe call still evaluated");
+    check(out.stats.tail_calls_eliminated == 0, "checked", "no accumulator introduced");
+    free(out.code);
+
+    check(compile_optimized(calls, 2, &out), "checked", "call program compiles without checks");
+    if (!out.code) return;
+
+    check(strstr(out.code, "printf(\"%d\\n\", 0);") != NULL, "checked", "wrapping product folded");
+    check(out.stats.calls_evaluated == 1, "checked", "factorial evaluated");
+    check(out.stats.tail_calls_eliminated == 1, "checked", "accumulator introduced");
+    free(out.code);
+
+    /* Arithmetic that may trap is not dead code: an unused store and an
+     * operand absorbed by `|| true` must still be evaluated */
+    const char *dead =
+        "func f(a: int) : int {\n"
+        "    var big = a * a;\n"
+        "    if (a * 12 >= 5 || true) { print(1); }\n"
+        "    return a;\n"
+        "}\n"
+        "func main() : int {\n"
+        "    var k = 0;\n"
+        "    while (k < 10) { k = k + 1; }\n"
+        "    print(f(k));\n"
+        "    return 0;\n"
+        "}\n";
+
+    config = test_config(1, TARGET_C);
+    config.overflow_checks = true;
+    check(compile_with_config(dead, &config, &out), "checked", "dead arithmetic program compiles");
+    if (!out.code) return;
+
+    check(strstr(out.code, "tinyllvm_checked_mul(a, a)") != NULL, "checked",
+          "unused product kept");
+    check(strstr(out.code, "tinyllvm_checked_mul(a, 12)") != NULL, "checked",
+          "product absorbed by || true kept");
+    free(out.code);
+
+    check(compile_optimized(dead, 1, &out), "checked", "dead arithmetic program compiles without checks");
+    if (!out.code) return;
+
+    check(strstr(out.code, "(a * a)") == NULL && strstr(out.code, "(a * 12)") == NULL, "checked",
+          "dead arithmetic removed without checks");
+    free(out.code);
+
+    config = test_config(2, TARGET_C);
+    config.overflow_checks = true;
+    check(runs_like_unoptimized(dead, &config) && runs_like_unoptimized(calls, &config), "checked",
+          "checked -O2 programs run as at -O0");
+}
+
+static void test_range_analysis(void) {
+    printf("\nRange analysis\n");
+
+    const char *source =
+        "func main() : int {\n"
+        "    var s = 0;\n"
+        "    var i = 0;\n"
+        "    while (i < 100) { s = s + i; i = i + 1; }\n"
+        "    var d = 7;\n"
+        "    if (i > 0) { d = s / i; }\n"
+        "    print(s + d);\n"
+        "    return 0;\n"
+        "}\n";
+
+    CompilerConfig config = test_config(1, TARGET_C);
+    config.overflow_checks = true;
+
+    OptimizedOutput out;
+    check(compile_with_config(source, &config, &out), "range", "program compiles with checks");
+    if (!out.code) return;
+
+    check(strstr(out.code, "__builtin_add_overflow") != NULL, "range",
+          "checked arithmetic runtime emitted");
+    check(strstr(out.code, "i = (i + 1);") != NULL, "range",
+          "bounded loop counter left unchecked");
+    check(strstr(out.code, "s = tinyllvm_checked_add(s, i);") != NULL, "range",
+          "accumulator widened to unbounded stays checked");
+    check(strstr(out.code, "d = (s / i);") != NULL, "range",
+          "division guarded by a positive divisor left unchecked");
+    check(out.stats.overflow_checks_elided == 2, "range", "two checks elided");
+    free(out.code);
+
+    check(compile_optimized(source, 1, &out), "range", "program compiles without checks");
+    if (!out.code) return;
+
+    check(strstr(out.code, "tinyllvm_checked") == NULL, "range",
+          "no checks unless requested");
+    free(out.code);
+}
+
+int main(void) {
+    printf("=== TinyLLVM Optimizer Test ===\n");
+
+    event_chain_initialize();
+
+    test_inline_expression_callee();
+    test_inline_multiple_returns();
+    test_inline_cost_model();
+    test_tail_recursion();
+    test_loop_invariants();
+    test_loop_unrolling();
+    test_constant_propagation();
+    test_dead_functions();
+    test_strength_reduction();
+    test_compile_time_calls();
+    test_specialization();
+    test_memoization();
+    test_checked_folding();
+    test_range_analysis();
+    test_if_conversion();
+    test_short_circuit_ir();
+    test_loop_rotation();
+    test_reassociation();
+    test_ir_module();
+    test_ssa_construction();
+    test_ir_bytecode();
+
+    event_chain_cleanup();
+
+    if (failures > 0) {
+        printf("\n❌ %d optimizer check(s) failed\n", failures);
+        return 1;
+    }
+
+    printf("\n✅ All optimizer checks passed\n");
+    return 0;
+}